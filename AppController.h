@@ -24,11 +24,11 @@
 #ifndef APPCONTROLLER_H_INC
 #define APPCONTROLLER_H_INC
 
-#include <AppKit/AppKit.h>
+#include <Foundation/Foundation.h>
 
 #include <Burn/ExternalTools.h>
 
-@class InspectorsWin;
+@class NSPasteboard;
 
 @interface AppController : NSObject
 {
@@ -42,6 +42,7 @@
 
 	BOOL burnerInUse;
 	NSLock *burnerLock;
+	NSMutableSet *devicesInUse;
 }
 
 + (AppController *) appController;
@@ -49,28 +50,6 @@
 - (id) init;
 - (void) dealloc;
 
-//
-// delegate methods
-//
-- (void)applicationWillFinishLaunching: (NSNotification *) not;
-- (void)applicationDidFinishLaunching: (NSNotification *) not;
-- (BOOL)applicationShouldTerminate: (id) sender;
-
-//
-// action methods
-//
-- (void) showPrefPanel: (id) sender;
-- (void) showConsole: (id) sender;
-- (void) showInspector: (id) sender;
-- (void) newProject: (id) sender;
-- (void) openProject: (id) sender;
-- (void) openRecentDoc: (id) sender;
-- (void) closeProject: (id) sender;
-- (void) blankCDRW: (id) sender;
-- (void) showReadmePanel: (id) sender;
-- (void) showBurnHelp: (id) sender;
-- (void) displayWorkInProgress: (id) not;
-
 //
 // access methods
 //
@@ -105,6 +84,14 @@
  */
 - (id) currentAudioConverterBundle;
 
+/**
+ * <p>Returns the audio conversion bundle for files of the given
+ * <var>type</var>, i.e. file name extension. A bundle made for the
+ * type is preferred to one which converts all types. Returns @c nil
+ * if there is none.</p>
+ */
+- (id) audioConverterBundleForType: (NSString *) type;
+
 /**
  * Returns the currently selected writing device. If the user has not
  * selected one, yet, returns the first one found by the current
@@ -112,6 +99,73 @@
  */
 - (NSString *) currentDevice;
 
+- (NSString *) currentWorkingPath;
+- (void) setCurrentWorkingPath: (NSString *) thePath;
+
+/**
+ * <p>Returns the writing devices a burning session with the given
+ * <var>parameters</var> writes to. The first one is the current device.
+ * If the <em>Copies</em> entry of the SessionParameters is greater than
+ * one, further drives found by the current writer bundle are added, up
+ * to the number of copies.</p>
+ */
+- (NSArray *) burnDevicesForParameters: (NSDictionary *) parameters;
+
+/**
+ * <p>Locks all of <var>devices</var> for a burning or blanking process.
+ * Either all devices are locked or none. Returns NO if one of them
+ * is already in use.</p>
+ */
+- (BOOL) lockDevices: (NSArray *) devices;
+- (void) unlockDevices: (NSArray *) devices;
+
+/**
+ * <p>Returns YES if any device is locked by a running process.</p>
+ */
+- (BOOL) burnerInUse;
+
+//
+// other methods
+//
+
+- (void) loadTools;
+
+@end
+
+/**
+ * <p>The methods of AppController which are only used by Burn.app.
+ * They are implemented in AppController+GUI.m, which is not part of
+ * burn-cli.</p>
+ */
+@interface AppController (GUI)
+
+//
+// delegate methods
+//
+- (void)applicationWillFinishLaunching: (NSNotification *) not;
+- (void)applicationDidFinishLaunching: (NSNotification *) not;
+- (BOOL)applicationShouldTerminate: (id) sender;
+- (void)applicationWillTerminate: (NSNotification *) not;
+
+//
+// action methods
+//
+- (void) showPrefPanel: (id) sender;
+- (void) showConsole: (id) sender;
+- (void) showInspector: (id) sender;
+- (void) newProject: (id) sender;
+- (void) openProject: (id) sender;
+- (void) openRecentDoc: (id) sender;
+- (void) closeProject: (id) sender;
+- (void) blankCDRW: (id) sender;
+- (void) clearConversionCache: (id) sender;
+- (void) showReadmePanel: (id) sender;
+- (void) showBurnHelp: (id) sender;
+- (void) displayWorkInProgress: (id) not;
+
+//
+// project windows
+//
 - (NSArray *) allProjectWindows;
 - (void) addProjectWindow: (id) theProjectWindow;
 - (void) removeProjectWindow: (id) theProjectWindow;
@@ -119,13 +173,6 @@
 - (id) lastProjectWindowOnTop;
 - (void) setLastProjectWindowOnTop: (id) aWindow;
 
-- (NSString *) currentWorkingPath;
-- (void) setCurrentWorkingPath: (NSString *) thePath;
-
-- (BOOL) lockBurner;
-- (void) unlockBurner;
-- (BOOL) burnerInUse;
-
 //
 // services methods
 //
@@ -143,7 +190,6 @@
 //
 
 - (void) createMenu;
-- (void) loadTools;
 
 - (BOOL) burnIsoImage: (NSString *) imageFile;
 
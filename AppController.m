@@ -2,7 +2,7 @@
 /*
  *	AppController.m
  *
- *	Copyright (c) 2002-2005, 2011, 2016
+ *	Copyright (c) 2002-2005, 2011, 2016, 2026
  *
  *	Author: Andreas Schik <andreas@schik.de>
  *
@@ -21,24 +21,11 @@
  *	Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
  */
 
-#include <AppKit/NSDocumentController.h>
-
 #include "AppController.h"
 
-#include "Inspectors/InspectorsWin.h"
 #include "Constants.h"
 #include "Functions.h"
-#include "PreferencesWindowController.h"
-#include "ParametersWindowController.h"
-#include "Project.h"
-#include "ProjectWindowController.h"
-#include "BlankPanel.h"
-#include "ReadmePanel.h"
-#include "ConsolePanel.h"
-#include "BurnProgressController.h"
-#include "WorkInProgress.h"
-
-static NSMutableDictionary *worksInProgress = nil;
+
 static AppController *appController = nil;
 
 @implementation AppController
@@ -70,6 +57,7 @@ static AppController *appController = nil;
 	self = [super init];
 
 	burnerLock = [NSLock new];
+	devicesInUse = [NSMutableSet new];
 	
 	// We initialize our mutable array containing all opened windows
 	allProjectWindows = [[NSMutableArray alloc] init];
@@ -79,7 +67,6 @@ static AppController *appController = nil;
 	audioConverters = [NSMutableDictionary new];
 
 	currentWorkingPath = nil;
-    worksInProgress = [NSMutableDictionary new];
 
 	return self;
 }
@@ -90,8 +77,6 @@ static AppController *appController = nil;
 						   name: DisplayWorkInProgress
 						   object: nil];
 
-    RELEASE(worksInProgress);
-
 	// We release our array containing all our windows
 	RELEASE(allProjectWindows);
 	allProjectWindows = nil;
@@ -102,213 +87,11 @@ static AppController *appController = nil;
 	RELEASE(externalTools);
 	RELEASE(audioConverters);
 	RELEASE(burnerLock);
-
-	releaseSharedInspectorsWin();
-    releaseSharedReadme();
-	// we close our console, this should be the very last action here
-	releaseSharedConsole();
+	RELEASE(devicesInUse);
 
 	[super dealloc];
 }
 
-- (void) applicationWillFinishLaunching: (NSNotification *) not
-{
-	[self createMenu];
-
-	[[NSNotificationCenter defaultCenter] addObserver: self
-						   selector: @selector(displayWorkInProgress:)
-						   name: DisplayWorkInProgress
-						   object: nil];
-
-	[self setCurrentWorkingPath: NSHomeDirectory()];
-
-	[[NSDocumentController sharedDocumentController] setShouldCreateUI: YES];
-}
-
-- (void) applicationDidFinishLaunching: (NSNotification *) not
-{
-    NSDictionary *params =
-        [[NSUserDefaults standardUserDefaults] objectForKey: @"GeneralParameters"];
-
-    // we create some panels
-	sharedInspectorsWin();
-
-    // If we don't already have a window open we open one, now
-    if (!lastProjectWindowOnTop) {
-        if ((nil == [params objectForKey: @"OpenCompilationOnStartup"])
-            || (0 != [[params objectForKey: @"OpenCompilationOnStartup"] intValue])) {
-            [self newProject: self];
-        }
-    }
-
-	// now we are ready to tell the system that we can receive service requests
-	[NSApp setServicesProvider: self];
-	logToConsole(MessageStatusInfo, _(@"AppController.svcRegistered"));
-
-	// We load all our bundles
-	[self loadTools];
-
-	logToConsole(MessageStatusInfo, _(@"AppController.loaded"));
-}
-
-- (BOOL) applicationShouldTerminate: (id) sender
-{
-	if (burnerInUse) {
-		NSBeep();
-		return NO;
-	}
-
-	return YES;
-}
-
-
-- (BOOL) validateMenuItem: (NSMenuItem*) item
-{
-	SEL	action = [item action];
-
-	if (sel_isEqual(action, @selector(closeProject:))
-    	|| sel_isEqual(action, @selector(miniaturize:))
-	    || sel_isEqual(action, @selector(saveDocument:))
-    	|| sel_isEqual(action, @selector(saveDocumentAs:))) {
-		if (lastProjectWindowOnTop == nil)
-			return NO;
-	}
-
-	/*
-	 * Disable Media inspector and blanking if either a burning process
-	 * is going on or no burner is present.
-	 */
-	if ((sel_isEqual(action, @selector(showInspector:)) && [[item title] isEqualToString: _(@"Common.media")])
-    	|| sel_isEqual(action, @selector(blankCDRW:))) {
-		NSString *burner;
-
-		// are we started for the first time?
-		burner = [[[NSUserDefaults standardUserDefaults] objectForKey: @"SelectedTools"]
-									objectForKey: @"BurnSW"];
-
-		if (burnerInUse || (!burner && ![burner length]))
-			return NO;
-	}
-
-	return YES;
-}
-
-
-- (void) showPrefPanel: (id) sender
-{
-	[[[PreferencesWindowController singleInstance] window] makeKeyAndOrderFront: self];
-}
-
-- (void) newProject: (id) sender
-{
-	[[NSDocumentController sharedDocumentController]
-			openUntitledDocumentOfType: @"burnprj" display: YES];
-
-	if (burnerInUse) {
-		[[NSNotificationCenter defaultCenter]
-					postNotificationName: BurnerInUse
-					object: nil
-					userInfo: [NSDictionary dictionaryWithObject: @"YES" forKey: @"InUse"]];
-	}
-}
-
-- (void) openProject: (id) sender
-{
-	[[NSDocumentController sharedDocumentController] openDocument: sender];
-
-	if (burnerInUse) {
-		[[NSNotificationCenter defaultCenter]
-					postNotificationName: BurnerInUse
-					object: nil
-					userInfo: [NSDictionary dictionaryWithObject: @"YES" forKey: @"InUse"]];
-	}
-}
-
-- (void) closeProject: (id) sender
-{
-	if (lastProjectWindowOnTop) {
-		[lastProjectWindowOnTop performClose: sender];
-	}
-}
-
-- (void) openRecentDoc: (id) sender
-{
-	[[NSDocumentController sharedDocumentController]
-			openDocumentWithContentsOfFile: [sender title] display: YES];
-}
-
-- (void) showConsole: (id) sender
-{
-	[[ConsolePanel consolePanel] showWindow: self];
-}
-
-- (void) showInspector: (id) sender
-{
-	id inspectorsWin = sharedInspectorsWin();
-	[inspectorsWin orderFront: nil]; 
-
-	[inspectorsWin activateInspectorWithTitle: [(NSMenuItem *)sender title]];
-}
-
-- (void) showReadmePanel: (id) sender
-{
-    [[ReadmePanel readmePanel] showWindow: self];
-}
-
-- (void) blankCDRW: (id) sender
-{
-    [[BlankPanel sharedPanel] activate];
-}
-
-
-- (void) showBurnHelp: (id) sender
-{
-	NSBundle *mb = [NSBundle mainBundle];
-	NSString *file = [mb pathForResource: @"Burn" ofType: @"help"]; 
- 
-	if (file) {
-		[[NSWorkspace sharedWorkspace] openFile: file];
-		return;
-   	}
-	NSBeep();
-}
-
-/** Display a progress window
- * 
- * This method is called when we receive a "DisplayWorkInProgress" notification.
- * Depending on the notification info, we either display or hide the window.
- * The notification must contain the info fields "Start" and "AppName".
- * "Start" is either "YES" or "NO" and tells us whether to start or stop the
- * animated window. "AppName" is a unique identifier for the sender. It will be
- * used as title for the animated window and as identifier to later on close
- * the correct window.
- */
-- (void) displayWorkInProgress: (id) not
-{
-    BOOL start = [[[not userInfo] objectForKey: @"Start"] intValue];
-    NSString *appname = [[not userInfo] objectForKey: @"AppName"];
-    WorkInProgress *workInProgress = [worksInProgress objectForKey: appname];
- 
-    if (start && appname && !workInProgress) {
-        NSString *string = [[not userInfo] objectForKey: @"DisplayString"];
-
-        workInProgress = [WorkInProgress new];
-        if (!workInProgress)
-            return;
-
-        [worksInProgress setObject: workInProgress forKey: appname];
-        [workInProgress startAnimationWithString: string
-                                         appName: appname];
-        RELEASE(workInProgress);
-    }
-
-    if (!start && appname && workInProgress) {
-        [workInProgress stopAnimation];
-        [worksInProgress removeObjectForKey: appname];
-    }
-}
-
-
 //
 // access methods
 //
@@ -369,31 +152,58 @@ static AppController *appController = nil;
 
 - (id) currentCDGrabberBundle
 {
-    // Return the first one from the dictionary.
+    // Prefer the bundle which reads the CD in process.
     NSEnumerator *e = [externalTools objectEnumerator];
-    id o;
+    id o, found = nil;
     while (nil != (o = [e nextObject])) {
         if ([[o class] conformsToProtocol: @protocol(AudioConverter)]
                 && ([(id<AudioConverter>)o isCDGrabber] == YES)) {
-            return o;
+            if ([[(id<BurnTool>)o name] isEqualToString: @"libparanoia"]) {
+                return o;
+            }
+            if (nil == found) {
+                found = o;
+            }
         }
     }
-    // Nothing found
-    return nil;
+    return found;
 }
 
 - (id) currentAudioConverterBundle
 {
-    // Return the first one from the dictionary.
+    // Prefer the bundle which converts all types.
     NSEnumerator *e = [externalTools objectEnumerator];
-    id o;
+    id o, found = nil;
     while (nil != (o = [e nextObject])) {
         if ([[o class] conformsToProtocol: @protocol(AudioConverter)]
                 && ([(id<AudioConverter>)o isCDGrabber] == NO)) {
+            if (nil == [(id<AudioConverter>)o fileTypes]) {
+                return o;
+            }
+            if (nil == found) {
+                found = o;
+            }
+        }
+    }
+    return found;
+}
+
+- (id) audioConverterBundleForType: (NSString *) type
+{
+    NSEnumerator *e = [externalTools objectEnumerator];
+    id o;
+    while (nil != (o = [e nextObject])) {
+        if ([[o class] conformsToProtocol: @protocol(AudioConverter)]
+                && ([(id<AudioConverter>)o isCDGrabber] == NO)
+                && [[(id<AudioConverter>)o fileTypes] containsObject: type]) {
             return o;
         }
     }
-    // Nothing found
+    // No specialised bundle, take the generic one.
+    o = [self currentAudioConverterBundle];
+    if ((nil != o) && (nil == [(id<AudioConverter>)o fileTypes])) {
+        return o;
+    }
     return nil;
 }
 
@@ -418,11 +228,6 @@ static AppController *appController = nil;
     return NOT_FOUND;
 }
 
-- (NSArray *) allProjectWindows
-{
-	return allProjectWindows;
-}
-
 - (NSString *) currentWorkingPath
 {
 	return currentWorkingPath;
@@ -435,14 +240,52 @@ static AppController *appController = nil;
 	currentWorkingPath = thePath;
 }
 
-- (BOOL) lockBurner
+- (NSArray *) burnDevicesForParameters: (NSDictionary *) parameters
 {
+	int copies;
+	NSString *device = [self currentDevice];
+	NSMutableArray *devices;
+	NSEnumerator *e;
+
+	if ([device isEqualToString: NOT_FOUND]) {
+		return [NSArray array];
+	}
+	devices = [NSMutableArray arrayWithObject: device];
+
+	copies = [[[parameters objectForKey: @"SessionParameters"]
+							objectForKey: NumberOfCopies] intValue];
+	if (copies <= 1) {
+		return devices;
+	}
+
+	e = [[[self currentWriterBundle] availableDrives] objectEnumerator];
+	while (([devices count] < copies) && (nil != (device = [e nextObject]))) {
+		if (![devices containsObject: device]) {
+			[devices addObject: device];
+		}
+	}
+
+	if ([devices count] < copies) {
+		logToConsole(MessageStatusWarning, [NSString stringWithFormat:
+							_(@"AppController.notEnoughDrives"),
+							copies, [devices count]]);
+	}
+	return devices;
+}
+
+- (BOOL) lockDevices: (NSArray *) devices
+{
+	int i, count = [devices count];
+
 	[burnerLock lock];
-	if (burnerInUse) {
-		[burnerLock unlock];
-		return NO;
+	for (i = 0; i < count; i++) {
+		if ([devicesInUse containsObject: [devices objectAtIndex: i]]) {
+			[burnerLock unlock];
+			return NO;
+		}
 	}
 
+	[devicesInUse addObjectsFromArray: devices];
 	burnerInUse = YES;
 	[[NSNotificationCenter defaultCenter]
 				postNotificationName: BurnerInUse
@@ -452,14 +295,22 @@ static AppController *appController = nil;
 	return YES;
 }
 
-- (void) unlockBurner
+- (void) unlockDevices: (NSArray *) devices
 {
+	int i, count = [devices count];
+
 	[burnerLock lock];
-	burnerInUse = NO;
-	[[NSNotificationCenter defaultCenter]
-				postNotificationName: BurnerInUse
-				object: nil
-				userInfo: [NSDictionary dictionaryWithObject: @"NO" forKey: @"InUse"]];
+	for (i = 0; i < count; i++) {
+		[devicesInUse removeObject: [devices objectAtIndex: i]];
+	}
+
+	if (burnerInUse && ([devicesInUse count] == 0)) {
+		burnerInUse = NO;
+		[[NSNotificationCenter defaultCenter]
+					postNotificationName: BurnerInUse
+					object: nil
+					userInfo: [NSDictionary dictionaryWithObject: @"NO" forKey: @"InUse"]];
+	}
 	[burnerLock unlock];
 }
 
@@ -468,310 +319,6 @@ static AppController *appController = nil;
 	return burnerInUse;
 }
 
-
-//
-// other methods
-//
-
-- (void) createMenu
-{
-	int i;
-	NSMenu *menu;
-	NSMenu *project;
-	NSMenu *info;
-	NSMenu *edit;
-	NSMenu *inspectors;
-	NSMenu *tools;
-	NSMenu *services;
-	NSMenu *windows;
-	id<NSMenuItem> menuItem;
-	NSArray *recentDocs;
-
-	SEL action = @selector(method:);
-
-	menu = AUTORELEASE([NSMenu new]);
-
-	/* Info
-	 *		-> Info Panel...
-	 *		-> Preferences
-	 *		-> Help
-	 */
-	menuItem = [menu addItemWithTitle:_(@"Info")
-		action: action
-		keyEquivalent:@""];
-
-	info = AUTORELEASE([NSMenu new]);
-	[menu setSubmenu:info forItem: menuItem];
-	[info addItemWithTitle:_(@"AppController.infoItem") 
-		action:@selector(orderFrontStandardInfoPanel:)
-		keyEquivalent:@""];
-	[info addItemWithTitle:_(@"AppController.prefsItem") 
-		action:@selector(showPrefPanel:)
-		keyEquivalent:@""];
-	[info addItemWithTitle:_(@"AppController.readmeItem")
-		action: @selector (showReadmePanel:)
-		keyEquivalent:@""];
-	[info addItemWithTitle:_(@"AppController.helpItem")
-		action: @selector (showBurnHelp:)
-		keyEquivalent:@"?"];
-
-	/* CD Compilation
-	 *		-> Open
-	 *		-> New
-	 *		-> Save
-	 *		-> Save As...
-	 *		-> Close
-	 *		-> Burn CD
-	 *		-> Recent Files
-	 *			-> Recent 1 ...
-	 */
-	menuItem = [menu addItemWithTitle:_(@"AppController.compilMenu")
-		action: action
-		keyEquivalent:@""];
-
-	project = AUTORELEASE([NSMenu new]);
-	[menu setSubmenu:project forItem: menuItem];
-	[project addItemWithTitle:_(@"AppController.openItem") 
-		action:@selector(openProject:) 
-		keyEquivalent:@"o"];
-	[project addItemWithTitle:_(@"AppController.newItem") 
-		action:@selector(newProject:) 
-		keyEquivalent:@"n"];
-	[project addItemWithTitle:_(@"AppController.saveItem") 
-		action:@selector(saveDocument:)
-		keyEquivalent:@"s"];
-	[project addItemWithTitle:_(@"AppController.saveAsItem") 
-		action:@selector(saveDocumentAs:)
-		keyEquivalent:@"S"];
-	[project addItemWithTitle:_(@"AppController.burnCDItem") 
-		action:@selector(runCDrecorder:)
-		keyEquivalent:@"B"];
-	[project addItemWithTitle:_(@"AppController.createISOItem") 
-		action:@selector(createISOImage:)
-		keyEquivalent:@""];
-	recentDocs = [[NSDocumentController sharedDocumentController] recentDocumentURLs];
-	{
-		NSMenu *recent;
-
-		menuItem = [project addItemWithTitle:_(@"AppController.recentItem")
-			action: action
-			keyEquivalent: @""];
-
-		recent = AUTORELEASE([NSMenu new]);
-		[project setSubmenu: recent forItem: menuItem];
-
-		[recent addItemWithTitle: _(@"AppController.clearItem")
-			action: @selector(clearRecentDocuments:)
-			keyEquivalent: @""];
-
-		for (i = 0; i < [recentDocs count]; i++) {
-			if ([[[recentDocs objectAtIndex: i] path] length]) {
-				[recent addItemWithTitle: [[recentDocs objectAtIndex: i] path]
-									action: @selector(openRecentDoc:)
-							keyEquivalent:@""];
-			}
-		}
-	}
-
-	/* Edit
-	 *		-> Cut
-	 *		-> Copy
-	 *		-> Paste
-	 *		-> Delete
-	 */
-	menuItem = [menu addItemWithTitle:_(@"AppController.editMenu")
-		action: action
-		keyEquivalent:@""];
-
-	edit=AUTORELEASE([NSMenu new]);
-	[menu setSubmenu: edit forItem: menuItem];
-	[edit addItemWithTitle: _(@"AppController.cutItem")
-		action: @selector(cut:)
-		keyEquivalent: @"x"];
-	[edit addItemWithTitle: _(@"AppController.copyItem")
-		action: @selector(copy:)
-		keyEquivalent: @"c"];
-	[edit addItemWithTitle: _(@"AppController.pasteItem")
-		action: @selector(paste:)
-		keyEquivalent: @"v"];
-	[edit addItemWithTitle: _(@"AppController.deleteItem")
-		action: @selector(deleteFile:)
-		keyEquivalent: @"d"];
-
-	/* Tools
-	 *      -> Inspectors
-	 *		      -> Track
-	 *		      -> Media
-	 *		      -> Audio CDs
-     *      -> Burn ISO Image
-	 *		-> Blank CD-RW
-	 *		-> Console
-	 */
-	menuItem = [menu addItemWithTitle:_(@"AppController.toolsMenu")
-		action:action
-		keyEquivalent:@""];
-
-	tools = AUTORELEASE([NSMenu new]);
-	[menu setSubmenu:tools forItem: menuItem];
-
-	menuItem = [tools addItemWithTitle:_(@"AppController.inspMenu")
-		action: action
-		keyEquivalent: @""];
-
-	inspectors = AUTORELEASE([NSMenu new]);
-	[tools setSubmenu: inspectors forItem: menuItem];
-
-	[inspectors addItemWithTitle:_(@"TrackInspector.name")
-		action: @selector(showInspector:)
-		keyEquivalent: @"1"];
-	[inspectors addItemWithTitle:_(@"MediaInspector.name")
-		action: @selector(showInspector:)
-		keyEquivalent: @"2"];
-	[inspectors addItemWithTitle:_(@"AudioCDInspector.name")
-		action: @selector(showInspector:)
-		keyEquivalent: @"3"];
-
-	[tools addItemWithTitle:_(@"AppController.burnISOItem")
-		action: @selector(burnISOImage:)
-		keyEquivalent: @""];
-
-	[tools addItemWithTitle:_(@"AppController.blankItem")
-		action: @selector(blankCDRW:)
-		keyEquivalent: @""];
-
-	[tools addItemWithTitle:_(@"AppController.consoleItem")
-		action:@selector(showConsole:)
-		keyEquivalent:@""];
-
-	/* Windows
-	 *		-> Arrange
-	 *		-> Miniaturize
-	 *		-> Close
-	 */
-	menuItem = [menu addItemWithTitle:_(@"Common.windows")
-		action:action
-		keyEquivalent:@""];
-
-	windows = AUTORELEASE([NSMenu new]);
-	[menu setSubmenu:windows forItem: menuItem];
-	[windows addItemWithTitle:_(@"AppController.arrange")
-		action:@selector(arrangeInFront:)
-		keyEquivalent:@""];
-	[windows addItemWithTitle:_(@"AppController.miniaturize")
-		action:@selector(performMiniaturize:)
-		keyEquivalent:@"m"];
-	[windows addItemWithTitle:_(@"Common.close")
-		action:@selector(performClose:)
-		keyEquivalent:@"w"];
-
-	/* Services
-	 */
-	menuItem = [menu addItemWithTitle:_(@"Common.services")
-		action:action
-		keyEquivalent:@""];
-
-	services = AUTORELEASE([NSMenu new]);
-	[menu setSubmenu:services forItem: menuItem];
-
-	/* Burn.app
-	 *		-> Hide
-	 *		-> Quit
-	 */
-	[menu addItemWithTitle:_(@"Common.hide")
-		action:@selector(hide:)
-		keyEquivalent:@"h"];
-	[menu addItemWithTitle:_(@"Common.quit")
-		action:@selector(terminate:)
-		keyEquivalent:@"q"];
-
-	[NSApp setServicesMenu: services];
-	[NSApp setWindowsMenu: windows];
-	[NSApp setMainMenu: menu];
-}
-
-
-//
-// services methods
-//
-
-- (void) newProject: (NSPasteboard *) pboard
-		   userData: (NSString *) userData
-			  error: (NSString **) error
-{
-	NSArray *types = [pboard types];
-	ProjectWindowController *controller = nil;
-
-	/*
-	 * Do we have at least one valid pasteboard type?
-	 */
-	if (![types containsObject: NSFilenamesPboardType] &&
-		![types containsObject: AudioCDPboardType]) {
-        *error = _(@"AppController.noValidType");
-        return;
-
-    }
-
-	controller = [lastProjectWindowOnTop delegate];
-
-	/*
-	 * We open a new compilation and add the files/tracks.
-     * We do this if either no compilation window exists or if the top most
-     * window is already populated.
-	 */
-    if (!lastProjectWindowOnTop || [controller totalTime])
-        [self newProject: self];
-
-    [self addToProject: pboard userData: userData error: error];
-}
-
-- (void) addToProject: (NSPasteboard *) pboard
-			 userData: (NSString *) userData
-				error: (NSString **) error
-{
-	ProjectWindowController *controller = nil;
-	NSArray *types = [pboard types];
-
-	/*
-	 * Do we have at least one valid pasteboard type?
-	 */
-	if (![types containsObject: NSFilenamesPboardType] &&
-		![types containsObject: AudioCDPboardType]) {
-        *error = _(@"AppController.noValidType");
-        return;
-
-    }
-
-	/*
-	 * check whether we have a top project window and whether
-	 * it is of the correct class
-	 */
-	if (!lastProjectWindowOnTop) {
-		/*
-		 * If it is not, we open a new compilation and
-		 * add the files/tracks.
-		 */
-		[self newProject: self];
-	}
-
-	controller = [lastProjectWindowOnTop delegate];
-
-	/*
-	 * Try to add as much as possible, i.e. even if one pasteboard
-	 * type fails try the other one (if it exists in the pasteboard).
-	 */
-	if ([types containsObject: NSFilenamesPboardType] &&
-		![controller acceptFilenames: pboard byOperation: NSDragOperationPrivate
-							forIndex: -1 andItem: nil]) {
-		*error = _(@"AppController.couldNotAddFiles");
-	}
-	if ([types containsObject: AudioCDPboardType] &&
-		![controller acceptAudioCDTracks: pboard
-							forIndex: -1 andItem: nil]) {
-		*error = _(@"AppController.couldNotAddTracks");
-	}
-}
-
-
 //
 // Method used to load all bundles in $GNUSTEP_USER_ROOT/Library/Burn
 //
@@ -835,90 +382,4 @@ static AppController *appController = nil;
 	}
 }
 
-
-- (BOOL) burnIsoImage: (NSString *) imageFile
-{
-    int rc = NSOKButton;
-    BurnProgressController *bpcPanel;
-
-    ParametersWindowController *paramsPanel;
-
-    paramsPanel = [[ParametersWindowController alloc]
-                    initWithWindowNibName: @"ParametersWindow"];
-
-    [[NSNotificationCenter defaultCenter]
-                postNotificationName: AlwaysKeepISOImages
-                              object: nil
-                            userInfo: nil];
-
-    rc = [NSApp runModalForWindow: [paramsPanel window]];
-
-    [[paramsPanel window] performClose: self];
-    [paramsPanel release];
-
-    if (rc != NSOKButton)
-        return NO;
-
-    logToConsole(MessageStatusInfo, [NSString stringWithFormat:
-                                                @"Start burning ISO image %@.",
-                                                imageFile]);
-    bpcPanel = [[BurnProgressController alloc] initWithIsoImage: imageFile];
-
-    if (bpcPanel != nil) {
-        [[bpcPanel window] makeKeyAndOrderFront: self];
-        [bpcPanel startProcess];
-        /* If we get here we are finished. */
-        return YES;
-    }
-
-    return NO;
-}
-
-- (void) addProjectWindow: (id) theProjectWindow
-{
-	if (allProjectWindows && theProjectWindow) {
-		[allProjectWindows addObject: theProjectWindow];
-	}
-}
-
-- (void) removeProjectWindow: (id) theProjectWindow
-{
-	if (allProjectWindows && theProjectWindow) {
-		[allProjectWindows removeObject: theProjectWindow];
-	}
-	if (![allProjectWindows count]) {
-	    NSDictionary *parameters =
-			[[NSUserDefaults standardUserDefaults] objectForKey: @"GeneralParameters"];
-
-		lastProjectWindowOnTop = nil;
-
-		// inform the audio CD panel that the last window went away
-		[[NSNotificationCenter defaultCenter]
-			postNotificationName: AudioCDMessage
-			object: nil
-			userInfo: nil];
-
-		// tell the track inspector
-		[[NSNotificationCenter defaultCenter]
-			postNotificationName: TrackSelectionChanged
-			object: nil
-			userInfo: nil];
-
-	    if ([[parameters objectForKey: @"CloseOnLastWindow"] boolValue]) {
-            [NSApp terminate: self];
-        }
-	}
-}
-
-- (id) lastProjectWindowOnTop
-{ 
-	return lastProjectWindowOnTop;
-}
-
-
-- (void) setLastProjectWindowOnTop: (id) aWindow
-{
-	lastProjectWindowOnTop = aWindow;
-}
-
 @end
@@ -0,0 +1,85 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  AudioDecoder.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef AUDIODECODER_H_INC
+#define AUDIODECODER_H_INC
+
+#include <Foundation/Foundation.h>
+
+#include "ParallelConverter.h"
+#include "Resampler.h"
+#include "WavWriter.h"
+
+/**
+ * <p>AudioDecodeJob holds the state of one track while it is
+ * decoded by one of the worker threads of an AudioDecoder.</p>
+ */
+@interface AudioDecodeJob : ConversionJob
+{
+@public
+    /* Both counted in sample frames of the output. */
+    unsigned long long framesTotal;
+    volatile unsigned long long framesDone;
+}
+
+/**
+ * <p>Tells how many sample frames have been written so far. The
+ * decoder calls this to report its progress.</p>
+ */
+- (void) setFramesDone: (unsigned long long) frames;
+
+@end
+
+/**
+ * <p>AudioDecoder is the base class for audio converter bundles that
+ * decode the files in process instead of running an external program.
+ * The tracks are decoded by the worker threads of ParallelConverter.
+ * AudioDecoder takes care of the output files and measures the
+ * loudness while they are written.</p>
+ * <p>A subclass implements -name, -fileTypes, -duration: and
+ * -decodeJob:toWriter:. The latter is called in a worker thread and
+ * must write the samples as 16 bit stereo at 44100 Hz.</p>
+ */
+@interface AudioDecoder : ParallelConverter <LoudnessMeasurer>
+{
+    ResampleQuality resampleQuality;
+}
+
+/**
+ * <p>Decodes the source of <var>job</var>'s track into
+ * <var>writer</var>. Returns NO if the file could not be decoded
+ * or the job was cancelled. Must be implemented by subclasses.</p>
+ */
+- (BOOL) decodeJob: (AudioDecodeJob *) job
+          toWriter: (WavWriter *) writer;
+
+/**
+ * <p>Returns the quality a subclass should use to resample files
+ * which are not at 44100 Hz. It is taken from the parameters of the
+ * current conversion.</p>
+ */
+- (ResampleQuality) resampleQuality;
+
+@end
+
+#endif
@@ -0,0 +1,144 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  AudioDecoder.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "AudioDecoder.h"
+
+#include "Constants.h"
+#include "Functions.h"
+#include "LoudnessMeter.h"
+#include "Track.h"
+
+/* Sample frames per CD frame (44100 / 75) */
+#define SAMPLES_PER_FRAME 588
+
+
+@implementation AudioDecodeJob
+
+- (id) initWithTrack: (Track *) aTrack outFile: (NSString *) aFile
+{
+    self = [super initWithTrack: aTrack outFile: aFile];
+    if (self) {
+        framesTotal = (unsigned long long)duration * SAMPLES_PER_FRAME;
+        framesDone = 0;
+    }
+    return self;
+}
+
+- (void) setFramesDone: (unsigned long long) frames
+{
+    framesDone = frames;
+}
+
+@end
+
+
+@implementation AudioDecoder
+
++ (Class) jobClass
+{
+    return [AudioDecodeJob class];
+}
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        resampleQuality = ResampleQualityBest;
+    }
+    return self;
+}
+
+- (ResampleQuality) resampleQuality
+{
+    return resampleQuality;
+}
+
+- (BOOL) decodeJob: (AudioDecodeJob *) job
+          toWriter: (WavWriter *) writer
+{
+    [self subclassResponsibility: _cmd];
+    return NO;
+}
+
+- (BOOL) runJob: (ConversionJob *) aJob
+{
+    AudioDecodeJob *job = (AudioDecodeJob *)aJob;
+    BOOL ret;
+    WavWriter *writer;
+
+    [self sendOutputString: [NSString stringWithFormat: _(@"AudioDecoder.converting"),
+                                [job->track description], job->outFile]];
+
+    writer = [[WavWriter alloc] initWithPath: job->outFile
+                                  sampleRate: 44100
+                                    channels: 2
+                              expectedFrames: job->framesTotal];
+    if (nil == writer) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"AudioDecoder.writeFail"),
+                                    job->outFile]];
+        return NO;
+    }
+
+    /*
+     * The loudness is measured while the samples are written.
+     */
+    [LoudnessMeter prepareWriter: writer
+                        forTrack: job->track
+                      parameters: convParameters];
+    ret = [self decodeJob: job toWriter: writer];
+    if (ret && ![job isCancelled]
+            && ![LoudnessMeter finishWriter: writer
+                                   forTrack: job->track
+                                 parameters: convParameters]) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"AudioDecoder.writeFail"),
+                                    job->outFile]];
+        ret = NO;
+    }
+    if (![writer close] && ret) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"AudioDecoder.writeFail"),
+                                    job->outFile]];
+        ret = NO;
+    }
+    RELEASE(writer);
+
+    return ret;
+}
+
+- (double) progressOfJob: (ConversionJob *) aJob
+{
+    AudioDecodeJob *job = (AudioDecodeJob *)aJob;
+
+    if (job->framesTotal == 0) {
+        return 0.;
+    }
+    return job->framesDone * 100. / job->framesTotal;
+}
+
+- (BOOL) convertTracks: (NSArray *) tracks
+        withParameters: (NSDictionary *) parameters
+{
+    resampleQuality = [Resampler qualityForParameters: parameters];
+    return [super convertTracks: tracks withParameters: parameters];
+}
+
+@end
@@ -0,0 +1,273 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  AuToWavBenchmark.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <Foundation/Foundation.h>
+
+#include "PCMFile.h"
+#include "WavWriter.h"
+
+/*
+ * Converts a large .au file to .wav like the Cdrdao bundle does it
+ * for .au files it cannot pass to cdrdao directly: PCMFile reads and
+ * byte swaps blocks of samples, WavWriter collects them in a large
+ * buffer. The result is checked sample by sample.
+ *
+ * For comparison, the start of the file is converted the way the
+ * bundle did it before, with one NSData and one write for each
+ * sample. That would take far too long for the whole file, so the
+ * time is extrapolated.
+ *
+ * Usage: au-to-wav-benchmark [megabytes [old-megabytes [directory]]]
+ *
+ * The defaults are 700 MB, 8 MB and the temporary directory. The files
+ * are removed afterwards. The .au file has just been written, so it is
+ * read from the page cache.
+ */
+
+#define AU_HEADER_SIZE 24
+#define BLOCK_SIZE (1024 * 1024)
+
+
+static inline int16_t sampleAt(unsigned long long frame, unsigned channel)
+{
+    return (int16_t)(frame * 31 + channel * 17);
+}
+
+static void putBigEndian32(unsigned char *p, uint32_t value)
+{
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+static BOOL writeAuFile(NSString *path, unsigned long long frames)
+{
+    unsigned char *block = malloc(BLOCK_SIZE);
+    unsigned long long frame = 0;
+    int fd = open([path fileSystemRepresentation], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    BOOL ok = (fd >= 0) && (NULL != block);
+
+    if (ok) {
+        putBigEndian32(block, 0x2e736e64);      // ".snd"
+        putBigEndian32(block + 4, AU_HEADER_SIZE);
+        putBigEndian32(block + 8, (uint32_t)(frames * 4));
+        putBigEndian32(block + 12, 3);          // 16 bit linear
+        putBigEndian32(block + 16, 44100);
+        putBigEndian32(block + 20, 2);
+        ok = (write(fd, block, AU_HEADER_SIZE) == AU_HEADER_SIZE);
+    }
+    while (ok && (frame < frames)) {
+        unsigned n = MIN(frames - frame, BLOCK_SIZE / 4), i;
+
+        for (i = 0; i < n; i++, frame++) {
+            int16_t left = sampleAt(frame, 0), right = sampleAt(frame, 1);
+
+            block[4 * i] = (unsigned char)(left >> 8);
+            block[4 * i + 1] = (unsigned char)left;
+            block[4 * i + 2] = (unsigned char)(right >> 8);
+            block[4 * i + 3] = (unsigned char)right;
+        }
+        ok = (write(fd, block, n * 4) == (ssize_t)(n * 4));
+    }
+
+    if (fd >= 0) {
+        ok = (close(fd) == 0) && ok;
+    }
+    free(block);
+    return ok;
+}
+
+/*
+ * The loop of the Cdrdao bundle's -convertAuToWav:.
+ */
+static BOOL convertStreaming(NSString *auPath, NSString *wavPath)
+{
+    PCMFile *pcm = AUTORELEASE([[PCMFile alloc] initWithPath: auPath]);
+    WavWriter *writer;
+    BOOL ok = YES;
+
+    if ((nil == pcm) || ![pcm canRead]) {
+        return NO;
+    }
+    writer = [[WavWriter alloc] initWithPath: wavPath
+                                  sampleRate: 44100
+                                    channels: 2
+                              expectedFrames: [pcm frames]];
+    if (nil == writer) {
+        return NO;
+    }
+    for (;;) {
+        int16_t *out = (int16_t *)[writer bytesForAppending: PCM_READ_FRAMES * 4];
+        long n;
+
+        if (NULL == out) {
+            ok = NO;
+            break;
+        }
+        n = [pcm readFrames: PCM_READ_FRAMES into: out];
+        if (n <= 0) {
+            ok = (n == 0);
+            break;
+        }
+        [writer appendedBytes: n * 4];
+    }
+    ok = [writer close] && ok;
+    RELEASE(writer);
+    return ok;
+}
+
+/*
+ * The loop the Cdrdao bundle used before, for the first bytes of the
+ * samples.
+ */
+static BOOL convertPerSample(NSString *auPath, NSString *wavPath, unsigned long length)
+{
+    NSFileHandle *inFile, *outFile;
+    NSData *rawData;
+    unsigned long i;
+
+    if (![[NSFileManager defaultManager] createFileAtPath: wavPath contents: nil attributes: nil]) {
+        return NO;
+    }
+    inFile = [NSFileHandle fileHandleForReadingAtPath: auPath];
+    outFile = [NSFileHandle fileHandleForWritingAtPath: wavPath];
+
+    [inFile seekToFileOffset: AU_HEADER_SIZE];
+    rawData = [inFile readDataOfLength: length];
+    for (i = 0; i + 1 < [rawData length]; i += 2) {
+        short data;
+
+        [rawData getBytes: &data range: NSMakeRange(i, 2)];
+        data = GSSwapI16(data);
+        [outFile writeData: [NSData dataWithBytes: &data length: 2]];
+    }
+    [inFile closeFile];
+    [outFile closeFile];
+    return YES;
+}
+
+static BOOL checkWavFile(NSString *wavPath, unsigned long long frames)
+{
+    PCMFile *wav = AUTORELEASE([[PCMFile alloc] initWithPath: wavPath]);
+    static int16_t samples[2 * PCM_READ_FRAMES];
+    unsigned long long frame = 0;
+
+    if ((nil == wav) || ([wav frames] != frames)) {
+        fprintf(stderr, "the .wav file has the wrong length\n");
+        return NO;
+    }
+    for (;;) {
+        long n = [wav readFrames: PCM_READ_FRAMES into: samples];
+        long i;
+
+        if (n < 0) {
+            fprintf(stderr, "cannot read the .wav file\n");
+            return NO;
+        }
+        if (n == 0) {
+            break;
+        }
+        for (i = 0; i < n; i++, frame++) {
+            if ((samples[2 * i] != sampleAt(frame, 0))
+                    || (samples[2 * i + 1] != sampleAt(frame, 1))) {
+                fprintf(stderr, "frame %llu differs\n", frame);
+                return NO;
+            }
+        }
+    }
+    return (frame == frames);
+}
+
+int main(int argc, const char *argv[])
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    unsigned long megabytes = 700, oldMegabytes = 8;
+    NSString *dir = NSTemporaryDirectory();
+    NSString *auPath, *wavPath, *oldWavPath;
+    unsigned long long frames;
+    NSDate *start;
+    double seconds, oldSeconds;
+    PCMFile *pcm;
+    BOOL ok;
+
+    if (argc > 1) {
+        megabytes = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        oldMegabytes = strtoul(argv[2], NULL, 10);
+    }
+    if (argc > 3) {
+        dir = [NSString stringWithUTF8String: argv[3]];
+    }
+    if ((megabytes == 0) || (oldMegabytes > megabytes)) {
+        fprintf(stderr, "Usage: %s [megabytes [old-megabytes [directory]]]\n", argv[0]);
+        return 2;
+    }
+
+    auPath = [dir stringByAppendingPathComponent:
+                [NSString stringWithFormat: @"au-to-wav-benchmark-%d.au", getpid()]];
+    wavPath = [[auPath stringByDeletingPathExtension] stringByAppendingPathExtension: @"wav"];
+    oldWavPath = [[auPath stringByDeletingPathExtension] stringByAppendingString: @"-old.wav"];
+    frames = (unsigned long long)megabytes * 1024 * 1024 / 4;
+
+    printf("Writing %lu MB to %s\n", megabytes, [auPath fileSystemRepresentation]);
+    if (!writeAuFile(auPath, frames)) {
+        fprintf(stderr, "cannot write %s\n", [auPath fileSystemRepresentation]);
+        RELEASE(pool);
+        return 1;
+    }
+
+    /*
+     * Such a file is put into cdrdao's TOC as it is.
+     */
+    pcm = AUTORELEASE([[PCMFile alloc] initWithPath: auPath]);
+    printf("burnable without conversion: %s\n", [pcm isBurnable] ? "yes" : "no");
+
+    start = [NSDate date];
+    ok = convertStreaming(auPath, wavPath);
+    seconds = -[start timeIntervalSinceNow];
+    printf("streaming conversion:  %7.2f s  %7.1f MB/s\n", seconds, megabytes / seconds);
+    ok = ok && checkWavFile(wavPath, frames);
+    printf("samples: %s\n", ok ? "ok" : "FAILED");
+
+    if (oldMegabytes > 0) {
+        start = [NSDate date];
+        convertPerSample(auPath, oldWavPath, oldMegabytes * 1024 * 1024);
+        oldSeconds = -[start timeIntervalSinceNow];
+        printf("one write per sample:  %7.2f s for %lu MB, about %.0f s for %lu MB\n",
+               oldSeconds, oldMegabytes, oldSeconds * megabytes / oldMegabytes, megabytes);
+    }
+
+    unlink([auPath fileSystemRepresentation]);
+    unlink([wavPath fileSystemRepresentation]);
+    unlink([oldWavPath fileSystemRepresentation]);
+
+    RELEASE(pool);
+    return ok ? 0 : 1;
+}
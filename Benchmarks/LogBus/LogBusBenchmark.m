@@ -0,0 +1,273 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  LogBusBenchmark.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+
+#include <Foundation/Foundation.h>
+
+#include "Constants.h"
+#include "LogBus.h"
+
+/*
+ * Several producer threads post lines like cdrecord's progress output,
+ * the main thread collects them like the console does. The time is
+ * taken from the first post until the last line has been received.
+ *
+ * Usage: logbus-benchmark [lines [threads [distributed-lines]]]
+ *
+ * The distributed notifications need a running gdnc. Pass 0 as
+ * distributed-lines to skip them.
+ */
+
+static int numThreads = 4;
+static int linesPerThread = 0;
+static volatile unsigned long busRetries = 0;
+
+
+static NSString *makeLine(int thread, int line)
+{
+    return [NSString stringWithFormat:
+                @"Track %02d: %4d of %4d MB written (fifo 100%%) [buf  99%%]  16.0x.",
+                thread + 1, line % 700, 700];
+}
+
+@interface Producer : NSObject
++ (void) postToBus: (id) number;
++ (void) postDistributed: (id) number;
+@end
+
+@implementation Producer
+
++ (void) postToBus: (id) number
+{
+    int thread = [number intValue];
+    int i;
+
+    for (i = 0; i < linesPerThread; i++) {
+        id pool = [NSAutoreleasePool new];
+        NSString *line = makeLine(thread, i);
+
+        /*
+         * The tools drop lines if the console does not keep up. We want
+         * to know how many lines can be passed, so we try again.
+         */
+        while (!logBusPost(MessageStatusToolOutput, line)) {
+            __sync_fetch_and_add(&busRetries, 1);
+            sched_yield();
+        }
+        RELEASE(pool);
+    }
+}
+
++ (void) postDistributed: (id) number
+{
+    NSDistributedNotificationCenter *center =
+        (NSDistributedNotificationCenter *)[NSDistributedNotificationCenter defaultCenter];
+    int thread = [number intValue];
+    int i;
+
+    for (i = 0; i < linesPerThread; i++) {
+        id pool = [NSAutoreleasePool new];
+
+        [center postNotificationName: ExternalToolOutput
+                              object: nil
+                            userInfo: [NSDictionary dictionaryWithObject: makeLine(thread, i)
+                                                                  forKey: @"Output"]];
+        RELEASE(pool);
+    }
+}
+
+@end
+
+
+@interface Receiver : NSObject
+{
+@public
+    NSMutableString *batch;
+    unsigned long received;
+}
+- (void) toolOutput: (NSNotification *) notif;
+@end
+
+@implementation Receiver
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        batch = [NSMutableString new];
+        received = 0;
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    RELEASE(batch);
+    [super dealloc];
+}
+
+- (void) toolOutput: (NSNotification *) notif
+{
+    [batch appendString: [[notif userInfo] objectForKey: @"Output"]];
+    [batch appendString: @"\n"];
+    received++;
+}
+
+@end
+
+static void collect(NSString *priority, NSString *message, void *context)
+{
+    Receiver *receiver = (Receiver *)context;
+
+    [receiver->batch appendString: message];
+    [receiver->batch appendString: @"\n"];
+    receiver->received++;
+}
+
+static void startProducers(SEL selector)
+{
+    int i;
+
+    for (i = 0; i < numThreads; i++) {
+        [NSThread detachNewThreadSelector: selector
+                                 toTarget: [Producer class]
+                               withObject: [NSNumber numberWithInt: i]];
+    }
+}
+
+static void report(const char *name, unsigned long lines, NSTimeInterval seconds)
+{
+    printf("%-24s %9lu lines in %7.3f s  %12.0f lines/s\n",
+           name, lines, seconds, (seconds > 0.) ? lines / seconds : 0.);
+}
+
+static void benchmarkBus(void)
+{
+    Receiver *receiver = AUTORELEASE([Receiver new]);
+    unsigned long total = (unsigned long)numThreads * linesPerThread;
+    NSTimeInterval start;
+
+    busRetries = 0;
+    logBusDropped();
+    start = [NSDate timeIntervalSinceReferenceDate];
+    startProducers(@selector(postToBus:));
+
+    while (receiver->received < total) {
+        id pool = [NSAutoreleasePool new];
+
+        if (logBusDrain(collect, receiver, LOG_BUS_SIZE) == 0) {
+            sched_yield();
+        }
+        // The console passes each batch to the text view at once.
+        [receiver->batch setString: @""];
+        RELEASE(pool);
+    }
+
+    report("log bus", receiver->received,
+           [NSDate timeIntervalSinceReferenceDate] - start);
+    printf("%-24s %9lu posts found the bus full\n", "", busRetries);
+}
+
+static void benchmarkDistributed(void)
+{
+    NSDistributedNotificationCenter *center =
+        (NSDistributedNotificationCenter *)[NSDistributedNotificationCenter defaultCenter];
+    Receiver *receiver = AUTORELEASE([Receiver new]);
+    unsigned long total = (unsigned long)numThreads * linesPerThread;
+    unsigned long last = 0;
+    NSTimeInterval start, lastProgress;
+
+    [center addObserver: receiver
+               selector: @selector(toolOutput:)
+                   name: ExternalToolOutput
+                 object: nil];
+
+    start = lastProgress = [NSDate timeIntervalSinceReferenceDate];
+    startProducers(@selector(postDistributed:));
+
+    /*
+     * gdnc may drop notifications if we do not keep up. Stop after
+     * five seconds without any.
+     */
+    while (receiver->received < total) {
+        id pool = [NSAutoreleasePool new];
+        NSTimeInterval now;
+
+        [[NSRunLoop currentRunLoop] runMode: NSDefaultRunLoopMode
+                                 beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+        [receiver->batch setString: @""];
+        now = [NSDate timeIntervalSinceReferenceDate];
+        if (receiver->received != last) {
+            last = receiver->received;
+            lastProgress = now;
+        } else if (now - lastProgress > 5.) {
+            RELEASE(pool);
+            break;
+        }
+        RELEASE(pool);
+    }
+
+    report("distributed notification", receiver->received,
+           lastProgress - start);
+    if (receiver->received < total) {
+        printf("%-24s %9lu lines were lost\n", "", total - receiver->received);
+    }
+    [center removeObserver: receiver];
+}
+
+int main(int argc, const char *argv[])
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    int lines = 400000;
+    int distributedLines = 20000;
+
+    if (argc > 1) {
+        lines = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        numThreads = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        distributedLines = atoi(argv[3]);
+    }
+    if ((lines <= 0) || (numThreads <= 0) || (distributedLines < 0)) {
+        fprintf(stderr, "Usage: %s [lines [threads [distributed-lines]]]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%d producer threads\n", numThreads);
+
+    linesPerThread = lines / numThreads;
+    benchmarkBus();
+
+    if (distributedLines > 0) {
+        linesPerThread = distributedLines / numThreads;
+        benchmarkDistributed();
+    }
+
+    RELEASE(pool);
+    return 0;
+}
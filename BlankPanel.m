@@ -177,10 +177,14 @@ static BOOL blanking = NO;
 {
     EBlankingMode value;
     id<Burner> writer;
+    NSString *device;
+    NSArray *devices;
     id pool;
     pool = [NSAutoreleasePool new];
 
-    if (![[AppController appController] lockBurner]) {
+    device = [[writersPopup selectedItem] title];
+    devices = [NSArray arrayWithObjects: device, nil];
+    if (![[AppController appController] lockDevices: devices]) {
         logToConsole(MessageStatusError, _(@"Common.burnerLocked"));
         goto blank_end;
     }
@@ -199,7 +203,7 @@ static BOOL blanking = NO;
 
     if (nil != writer) {
         if ([writer blankCDRW: value
-                     inDevice: [[writersPopup selectedItem] title]
+                     inDevice: device
                withParameters: [[NSUserDefaults standardUserDefaults] dictionaryRepresentation]]) {
             [progressLabel setTextColor: [NSColor blueColor]];
             [progressLabel setStringValue: _(@"BlankPanel.success")];
@@ -210,7 +214,7 @@ static BOOL blanking = NO;
             logToConsole(MessageStatusError, _(@"BlankPanel.error"));
         }
     }
-    [[AppController appController] unlockBurner];
+    [[AppController appController] unlockDevices: devices];
 
     blanking = NO;
 
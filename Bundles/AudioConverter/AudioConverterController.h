@@ -26,20 +26,14 @@
 
 #include <Foundation/Foundation.h>
 
-#include "ExternalTools.h"
-
-@interface AudioConverterController : NSObject <BurnTool, AudioConverter>
-{
-	NSTask *avconvTask;
-
-	ToolStatus convStatus;
-	NSLock *statusLock;
-
-	NSArray *allTracks;
-	int currentTrack;
-	unsigned long trackSize;
-}
+#include "ParallelConverter.h"
+#include "ToolProcess.h"
 
+/*
+ * The tracks are converted by the worker threads of ParallelConverter,
+ * each one running its own avconv process.
+ */
+@interface AudioConverterController : ParallelConverter <ToolProcessDelegate>
 @end
 
 #endif
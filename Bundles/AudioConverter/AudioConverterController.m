@@ -22,13 +22,14 @@
  */
 
 #include <sys/types.h>
-#include <sys/wait.h>
+#include <string.h>
 
 #include "AudioConverterController.h"
 #include "AudioConverterSettingsView.h"
 
 #include "Constants.h"
 #include "Functions.h"
+#include "ProgressParser.h"
 #include "Track.h"
 
 #ifdef _
@@ -41,15 +42,51 @@
 
 
 static AudioConverterController *singleInstance = nil;
-static NSFileManager *fileMan = nil;
+
+
+/**
+ * <p>FFmpegJob adds the avconv process of a track and the position
+ * it has reached.</p>
+ */
+@interface FFmpegJob : ConversionJob
+{
+@public
+	ToolProcess *process;
+	double length;
+	double position;
+	NSTimeInterval startTime;
+	double progress;
+}
+@end
+
+@implementation FFmpegJob
+
+- (id) initWithTrack: (Track *)aTrack outFile: (NSString *)aFile
+{
+	self = [super initWithTrack: aTrack outFile: aFile];
+	if (self) {
+		process = nil;
+		length = duration / 75.;
+		position = 0.;
+		startTime = 0.;
+		progress = 0.;
+	}
+	return self;
+}
+
+- (void) dealloc
+{
+	RELEASE(process);
+	[super dealloc];
+}
+
+@end
+
 
 @interface AudioConverterController (Private)
 - (void) initializeFromDefaults;
-- (void) waitForTaskExit;
-- (void) sendOutputString: (NSString *) outString;
-- (void) setStatus: (ProcessStatus) status;
-- (NSString *) makeOutfileNameForTrack: (NSString *)trackName
-                               tempDir: (NSString *)tempDir;
+- (NSString *) probeProgramFor: (NSString *) program;
+- (FFmpegJob *) jobForProcess: (ToolProcess *) process;
 @end
 
 //
@@ -97,62 +134,86 @@ static NSFileManager *fileMan = nil;
 	[[NSUserDefaults standardUserDefaults] synchronize];
 }
 
-- (NSString *) makeOutfileNameForTrack: (NSString *)trackName
-                               tempDir: (NSString *)tempDir
+/**
+ * Returns the path of the ffprobe which belongs to the ffmpeg at
+ * <var>program</var> or nil if there is none. avconv's avprobe
+ * does not understand ffprobe's options, so we do not use it.
+ */
+- (NSString *) probeProgramFor: (NSString *) program
 {
-	NSString *outName;
-    NSString *baseName = [[trackName lastPathComponent] stringByDeletingPathExtension];
-
-	outName = [tempDir stringByAppendingPathComponent:
-                           [NSString stringWithFormat: @"%@.wav", baseName]];
+    NSString *probe;
 
-	return outName;
+    if (![[program lastPathComponent] hasPrefix: @"ffmpeg"]) {
+        return nil;
+    }
+    probe = [[program stringByDeletingLastPathComponent]
+                stringByAppendingPathComponent: @"ffprobe"];
+    if (![[NSFileManager defaultManager] isExecutableFileAtPath: probe]) {
+        return nil;
+    }
+    return probe;
 }
 
-- (void) waitForTaskExit
+/**
+ * <p>ffmpeg reports the position in the input file it has reached.
+ * Together with the track's length this gives the track's progress.
+ * The lines of the -progress output are not shown.</p>
+ */
+- (BOOL) toolProcess: (ToolProcess *) process
+    didReadLineBytes: (const char *) bytes
+              length: (unsigned) length
 {
-	while ([avconvTask isRunning]) {
-		NSData *inData;
-        while ((inData = [[[avconvTask standardError] fileHandleForReading] availableData]) && [inData length]) {
-			int i, count;
-			NSString *aLine;
-			NSArray *theOutput;
-
-			theOutput = [[[NSString alloc] initWithData: inData
-									encoding: NSISOLatin1StringEncoding]
-									componentsSeparatedByString: @"\n"];
-
-			count = [theOutput count];
-
-			for (i = 0; i < count; i++) {
-				aLine = [theOutput objectAtIndex: i];
-
-				[[NSDistributedNotificationCenter defaultCenter]
-					postNotificationName: ExternalToolOutput
-					object: nil
-					userInfo: [NSDictionary dictionaryWithObject: aLine forKey: @"Output"]];
+	ProgressEvent event;
+	FFmpegJob *job;
+
+	switch (parseFFmpegLine(bytes, length, &event)) {
+	case ProgressTime:
+		[statusLock lock];
+		job = [self jobForProcess: process];
+		if ((nil != job) && (event.value >= 0.)) {
+			job->position = event.value;
+			if (job->length > 0.) {
+				job->progress = MIN(100., event.value * 100. / job->length);
 			}
 		}
+		[statusLock unlock];
+		return YES;
+	case ProgressDuration:
+		// We may not have known the track's length, yet.
+		[statusLock lock];
+		job = [self jobForProcess: process];
+		if ((nil != job) && (job->length <= 0.)) {
+			job->length = event.value;
+		}
+		[statusLock unlock];
+		return NO;
+	case ProgressReport:
+		return YES;
+	default:
+		return NO;
 	}
 }
 
-- (void) sendOutputString: (NSString *) outString
+- (void) toolProcess: (ToolProcess *) process
+         didReadLine: (NSString *) aLine
 {
-	NSString *outLine;
-
-	outLine = [NSString stringWithFormat: @"%@", outString];
-
-	[[NSDistributedNotificationCenter defaultCenter]
-					postNotificationName: ExternalToolOutput
-					object: nil
-					userInfo: [NSDictionary dictionaryWithObject: outLine forKey: @"Output"]];
+	logToolOutput(aLine);
 }
 
-- (void) setStatus: (ProcessStatus) status
+/*
+ * Must be called with statusLock held.
+ */
+- (FFmpegJob *) jobForProcess: (ToolProcess *) process
 {
-	[statusLock lock];
-	convStatus.processStatus = status;
-	[statusLock unlock];
+	int i, count = [allJobs count];
+
+	for (i = 0; i < count; i++) {
+		FFmpegJob *job = [allJobs objectAtIndex: i];
+		if (job->process == process) {
+			return job;
+		}
+	}
+	return nil;
 }
 
 @end
@@ -168,10 +229,6 @@ static NSFileManager *fileMan = nil;
 	self = [super init];
 
 	if (self) {
-		if (!fileMan) {
-			fileMan = [NSFileManager defaultManager];
-		}
-		statusLock = [NSLock new];
         [self initializeFromDefaults];
 	}
 
@@ -182,36 +239,119 @@ static NSFileManager *fileMan = nil;
 - (void) dealloc
 {
 	singleInstance = nil;
-	RELEASE(statusLock);
-
 	[super dealloc];
 }
 
 //
-// BurnTool methods
+// ParallelConverter methods
 //
 
-- (NSString *) name
++ (Class) jobClass
 {
-	return @"audioconverter";
+	return [FFmpegJob class];
 }
 
-- (id<PreferencesModule>) preferences;
+- (BOOL) runJob: (ConversionJob *) aJob
 {
-	return AUTORELEASE([AudioConverterSettingsView singleInstance]);
+	FFmpegJob *job = (FFmpegJob *)aJob;
+	BOOL ret = YES;
+	NSString *avconv;
+	NSMutableArray *args;
+	ToolProcess *process;
+    NSDictionary *acDefaults = [convParameters objectForKey: @"AudioConverterParameters"];
+
+	avconv = [acDefaults objectForKey: @"Program"];
+
+	args = [NSMutableArray arrayWithObjects: @"-y", nil];
+	/*
+	 * ffmpeg reports its progress in a machine readable form. avconv
+	 * does not know these options. We take the progress from its
+	 * statistics line instead.
+	 */
+	if (![[avconv lastPathComponent] hasPrefix: @"avconv"]) {
+		[args addObjectsFromArray: [NSArray arrayWithObjects:
+										@"-nostats", @"-progress", @"pipe:1", nil]];
+	}
+	[args addObjectsFromArray: [NSArray arrayWithObjects:
+									@"-i", [job->track source], @"-vn", @"-ar", @"44100", nil]];
+	[args addObject: job->outFile];
+
+	process = [[ToolProcess alloc] initWithPath: avconv arguments: args];
+	[process setDelegate: self];
+
+	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
+										avconv, [args componentsJoinedByString: @" "]]];
+
+	/*
+	 * Launch the process while holding the lock, so that -stop: either
+	 * sees the process or we see the cancelled state.
+	 */
+	[statusLock lock];
+	if (convStatus.processStatus == isConverting) {
+		job->process = RETAIN(process);
+		job->position = 0.;
+		job->startTime = [NSDate timeIntervalSinceReferenceDate];
+		ret = [process launch];
+	} else {
+		ret = NO;
+	}
+	[statusLock unlock];
+
+	/*
+	 * Now we wait until the avconv process is over and process its output.
+	 * If avconv did not terminate gracefully we stop the whole affair.
+	 */
+	if (ret) {
+		ret = [process waitUntilExit];
+	}
+	RELEASE(process);
+
+	return ret;
 }
 
-- (id<PreferencesModule>) parameters;
+- (void) cancelJob: (ConversionJob *) job
 {
-	return nil;
+	[super cancelJob: job];
+	[((FFmpegJob *)job)->process cancel];
 }
 
-- (void) cleanUp
+- (double) progressOfJob: (ConversionJob *) job
 {
-    /*
-     * No need to clean anything, as we forget about what
-     * we ripped.
-     */
+	return ((FFmpegJob *)job)->progress;
+}
+
+/*
+ * The amount of audio converted per second of wall clock time.
+ */
+- (double) speedOfJob: (ConversionJob *) aJob
+{
+	FFmpegJob *job = (FFmpegJob *)aJob;
+	NSTimeInterval elapsed = [NSDate timeIntervalSinceReferenceDate] - job->startTime;
+
+	if (elapsed > 0.5) {
+		return job->position / elapsed;
+	}
+	return 0.;
+}
+
+- (void) finishJob: (ConversionJob *) job
+{
+	((FFmpegJob *)job)->progress = 0.;
+	DESTROY(((FFmpegJob *)job)->process);
+}
+
+//
+// BurnTool methods
+//
+
+- (NSString *) name
+{
+	return @"audioconverter";
+}
+
+- (id<PreferencesModule>) preferences;
+{
+	return AUTORELEASE([AudioConverterSettingsView singleInstance]);
 }
 
 
@@ -231,18 +371,29 @@ static NSFileManager *fileMan = nil;
 //
 // AudioConverter methods
 //
-- (BOOL) isCDGrabber
+
+/*
+ * ffmpeg converts everything we know.
+ */
+- (NSArray *) fileTypes
 {
-    return NO;
+    return nil;
 }
 
+/**
+ * <p>If ffprobe is installed next to ffmpeg, it tells us the duration
+ * exactly. Otherwise we take the duration ffmpeg prints when it is
+ * given only an input file. It is rounded to hundredths of a second,
+ * which is still more precise than a frame.</p>
+ */
 - (long) duration: (NSString *)fileName
 {
 	int i, count;
     long duration = 0;
 	NSString *avconv;
+	NSString *probe;
 	NSMutableArray *args;
-	NSPipe *stdOut;
+	ToolProcess *process;
 	NSArray *output;
 	NSString *outLine;
     NSDictionary *acDefaults = [[NSUserDefaults standardUserDefaults] objectForKey: @"AudioConverterParameters"];
@@ -252,29 +403,44 @@ static NSFileManager *fileMan = nil;
     if (!checkProgram(avconv))
         return duration;
 
-    args = [NSMutableArray arrayWithObjects: @"-i", fileName, nil];
+	probe = [self probeProgramFor: avconv];
+	if (nil != probe) {
+		args = [NSMutableArray arrayWithObjects: @"-v", @"error",
+					@"-show_entries", @"format=duration",
+					@"-of", @"default=noprint_wrappers=1:nokey=1",
+					fileName, nil];
 
-    avconvTask = [[NSTask alloc] init];
-    stdOut = [[NSPipe alloc] init];
+		process = [ToolProcess processWithPath: probe arguments: args];
+
+		[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
+											probe, [args componentsJoinedByString: @" "]]];
+
+		if ([process run]) {
+			output = [process outputLines];
+			count = [output count];
+			for (i = 0; i < count; i++) {
+				double seconds = [[output objectAtIndex: i] doubleValue];
+
+				if (seconds > 0) {
+					return secondsToFrames(seconds);
+				}
+			}
+		}
+	}
+
+    args = [NSMutableArray arrayWithObjects: @"-i", fileName, nil];
 
-    [avconvTask setLaunchPath: avconv];
-    [avconvTask setArguments: args];
-   	[avconvTask setStandardOutput: stdOut];
-   	[avconvTask setStandardError: stdOut];
+    process = [ToolProcess processWithPath: avconv arguments: args];
 
    	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
 										avconv, [args componentsJoinedByString: @" "]]];
 
-    [avconvTask launch];
-
    	/*
-   	 * Now we wait until the avconv task is over and process its output.
+   	 * Now we wait until the avconv process is over and process its output.
    	 */
-   	[avconvTask waitUntilExit];
+   	[process run];
 
-	output = [[[NSString alloc] initWithData: [[stdOut fileHandleForReading] availableData]
-									encoding: NSISOLatin1StringEncoding]
-					componentsSeparatedByString: @"\n"];
+	output = [process outputLines];
 
 	count = [output count];
 
@@ -282,156 +448,32 @@ static NSFileManager *fileMan = nil;
 	 * Skip the first line in output. It contains only header data.
 	 */
 	for (i = 1; i < count; i++) {
-		NSRange range;
-		outLine = [output objectAtIndex: i];
+		ProgressEvent event;
+		const char *bytes;
 
-		range = [outLine rangeOfString: @"Duration:"];
-		if (range.location != NSNotFound) {
-			if ([outLine length] > range.location+9) {
-				NSString *time = [outLine substringWithRange: NSMakeRange(range.location+10, 11)];
-                NSArray *parts = [time componentsSeparatedByString: @":"];
-                duration = [[parts objectAtIndex: 0] intValue] * 3600;
-                duration += [[parts objectAtIndex: 1] intValue] * 60;
-                duration += [[parts objectAtIndex: 2] intValue];
-                duration *= 75;
-            } else {
-    			continue;
-            }
+		outLine = [output objectAtIndex: i];
+		bytes = [outLine cStringUsingEncoding: NSISOLatin1StringEncoding];
+		if ((NULL != bytes)
+				&& (parseFFmpegLine(bytes, strlen(bytes), &event) == ProgressDuration)) {
+			duration = secondsToFrames(event.value);
 		}
 	}
 
-	RELEASE(stdOut);
-	RELEASE(avconvTask);
     return duration;
 }
 
-- (unsigned) size: (NSString *)fileName
-{
-    long duration = [self duration: fileName];
-    unsigned size = framesToAudioSize(duration);
-    return size;
-}
-
-
-- (ToolStatus) getStatus
-{
-	ToolStatus status;
-    Track *track = [allTracks objectAtIndex: currentTrack];
-    int count = [allTracks count];
-
-    [statusLock lock];
-    convStatus.trackName = [track description];
-    convStatus.trackProgress = 0;
-    if (0 == count) {
-        convStatus.entireProgress = 0;
-    } else {
-        convStatus.entireProgress = currentTrack * 100. / count;
-    }
-	status = convStatus;
-	[statusLock unlock];
-
-	return status;
-
-}
-
+/*
+ * Without avconv no job can be run.
+ */
 - (BOOL) convertTracks: (NSArray *)tracks
 	    withParameters: (NSDictionary *) parameters
 {
-	BOOL ret = YES;
-	int termStatus;
-	NSString *avconv;
-	NSMutableArray *args;
-    NSString *fileName;
-	NSPipe *stdOut;
-    Track *track;
     NSDictionary *acDefaults = [parameters objectForKey: @"AudioConverterParameters"];
-    NSDictionary *sesDefaults = [parameters objectForKey: @"SessionParameters"];
 
-	// set up avconv task
-	avconv = [acDefaults objectForKey: @"Program"];
-    if (!checkProgram(avconv))
+    if (!checkProgram([acDefaults objectForKey: @"Program"]))
         return NO;
 
-    allTracks = tracks;
-
-    convStatus.entireProgress = 0;
-    convStatus.trackProgress = 0;
-
-    [self setStatus: isConverting];
-
-    for (currentTrack = 0; (currentTrack < [allTracks count]) && (NO != ret); currentTrack++) {
-        /*
-         * Did the user click abort?
-         */
-	    if (convStatus.processStatus == isCancelled) {
-            break;
-        }
-
-        track = [allTracks objectAtIndex: currentTrack];
-
-    	args = [NSMutableArray arrayWithObjects: @"-y", @"-i", [track source], @"-vn", @"-ar", @"44100", nil];
-
-        fileName = [self makeOutfileNameForTrack: [track source]
-                                         tempDir: [sesDefaults objectForKey: @"TempDirectory"]];
-
-    	[args addObject: fileName];
-        [track setStorage: fileName];
-
-	    avconvTask = [[NSTask alloc] init];
-    	stdOut = [[NSPipe alloc] init];
-
-	    [avconvTask setLaunchPath: avconv];
-	    [avconvTask setArguments: args];
-   	    [avconvTask setStandardOutput: stdOut];
-    	[avconvTask setStandardError: stdOut];
-
-    	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
-											avconv, [args componentsJoinedByString: @" "]]];
-
-        [avconvTask launch];
-
-    	/*
-    	 * Now we wait until the avconv task is over and process its output.
-    	 */
-    	[self waitForTaskExit];
-
-    	/*
-    	 * If avconv did not terminate gracefully we stop the whole affair.
-    	 * We delete in any case the actual (not finished) file.
-    	 */
-    	termStatus = [avconvTask terminationStatus];	// FreeBSD needs an lvalue for the WIF* macros
-    	if ((WIFEXITED(termStatus) == 0)
-    			|| WIFSIGNALED(termStatus)
-    			|| (convStatus.processStatus == isCancelled)) {
-    		[self sendOutputString: [NSString stringWithFormat: _(@"Removing temporary file %@."), [track storage]]];
-    		if (![fileMan removeFileAtPath: [track storage] handler: nil]) {
-    			[self sendOutputString: _(@"Removing file failed.")];
-    		}
-    		convStatus.processStatus = isCancelled;
-    		ret = NO;
-    	}
-
-    	RELEASE(stdOut);
-    	RELEASE(avconvTask);
-    	avconvTask = nil;
-    }
-
-	if (convStatus.processStatus == isConverting) {
-        [self setStatus: isStopped];
-	}
-
-    allTracks = nil;
-	return ret;
-}
-
-- (BOOL) stop: (BOOL)immediately
-{
-	if (convStatus.processStatus == isConverting) {
-		[self sendOutputString: _(@"Terminating process.")];
-        [self setStatus: isCancelled];
-		[avconvTask terminate];
-	}
-	return YES;
+	return [super convertTracks: tracks withParameters: parameters];
 }
 
 @end
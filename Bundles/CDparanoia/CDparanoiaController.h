@@ -27,19 +27,45 @@
 #include <AppKit/AppKit.h>
 
 #include "ExternalTools.h"
+#include "ToolProcess.h"
 
-@interface CDparanoiaController : NSObject <BurnTool, AudioConverter>
+@interface CDparanoiaController : NSObject <BurnTool, AudioConverter, ParallelGrabber,
+                                            ToolProcessDelegate>
 {
 	short processStatus;
 
-	NSTask *cdpTask;
+	ToolProcess *cdpProcess;
 
 	ToolStatus ripStatus;
 	NSLock *statusLock;
 
 	NSArray *allTracks;
 	int currentTrack;
+	int tracksDone;
+	unsigned long firstSector;
 	unsigned long trackSize;
+
+	/*
+	 * The table of contents from cdparanoia -Q, indexed by the
+	 * track number: first sector and length in sectors.
+	 */
+	long tocBegin[100];
+	long tocLength[100];
+
+	/*
+	 * The state of the thread which splits the output of a
+	 * single pass over several tracks into the .wav files.
+	 */
+	BOOL splitting;
+	int splitFd;
+	int splitFirst;
+	int splitLast;
+	NSArray *splitFiles;
+	NSDictionary *splitTracks;
+	BOOL splitOk;
+	NSConditionLock *splitLock;
+	unsigned long long trackBytes;
+	volatile unsigned long long trackBytesDone;
 }
 
 @end
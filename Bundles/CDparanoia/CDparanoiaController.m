@@ -22,8 +22,10 @@
  */
 
 #include <sys/types.h>
-#include <sys/wait.h>
-
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "CDparanoiaController.h"
 #include "CDparanoiaSettingsView.h"
@@ -31,7 +33,9 @@
 
 #include "Constants.h"
 #include "Functions.h"
+#include "ProgressParser.h"
 #include "Track.h"
+#include "WavWriter.h"
 
 #ifdef _
 #undef _
@@ -42,6 +46,11 @@
 
 
 
+/* The size of a sector in the raw output */
+#define SECTOR_BYTES 2352
+/* How much the splitting thread reads at once */
+#define SPLIT_READ_SIZE (64 * SECTOR_BYTES)
+
 static CDparanoiaController *singleInstance = nil;
 static NSFileManager *fileMan = nil;
 
@@ -53,8 +62,22 @@ static NSFileManager *fileMan = nil;
 - (NSString *) makeOutfileNameForTrack: (int)index
                                   onCD: (NSString *)cddbId
                                tempDir: (NSString *)tempDir;
+- (NSMutableArray *) argumentsWithParameters: (NSDictionary *) parameters;
+- (BOOL) readTocWithParameters: (NSDictionary *) parameters;
+- (BOOL) ripTrack: (Track *) track
+   withParameters: (NSDictionary *) parameters;
+- (BOOL) ripTracks: (NSDictionary *) tracksByNumber
+              from: (int) first
+                to: (int) last
+    withParameters: (NSDictionary *) parameters;
+- (void) splitThread: (id) anObject;
 @end
 
+static int trackNumber(Track *track)
+{
+	return [[[track source] substringFromIndex: 14] intValue];
+}
+
 //
 // private interface
 //
@@ -111,45 +134,45 @@ static NSFileManager *fileMan = nil;
 
 - (void) waitForTaskExit
 {
+	firstSector = 0;
 	trackSize = 0xffffffff;
 
-	while ([cdpTask isRunning]) {
-		NSData *inData;
-        while ((inData = [[[cdpTask standardError] fileHandleForReading] availableData]) && [inData length]) {
-			int i, count;
-			unsigned long from = 0, to = 0;
-			NSString *aLine;
-			NSArray *theOutput;
-			NSRange aRange;
-
-			theOutput = [[[NSString alloc] initWithData: inData
-									encoding: NSISOLatin1StringEncoding]
-									componentsSeparatedByString: @"\n"];
-
-			count = [theOutput count];
-
-			for (i = 0; i < count; i++) {
-				aLine = [theOutput objectAtIndex: i];
-
-				[[NSDistributedNotificationCenter defaultCenter]
-					postNotificationName: ExternalToolOutput
-					object: nil
-					userInfo: [NSDictionary dictionaryWithObject: aLine forKey: @"Output"]];
-
-				aRange = [aLine rangeOfString: @"from sector "];
-				if (aRange.location != NSNotFound) {
-					[statusLock lock];
-					from = [[aLine substringWithRange: NSMakeRange(aRange.location+11,8)] intValue];
-					[statusLock unlock];
-				}
-				aRange = [aLine rangeOfString: @"to sector "];
-				if (aRange.location != NSNotFound) {
-					to = [[aLine substringWithRange: NSMakeRange(aRange.location+11,8)] intValue];
-					trackSize = (to + 1 - from) * 2352;
-				}
-			}
+	[cdpProcess waitUntilExit];
+}
+
+- (BOOL) toolProcess: (ToolProcess *) process
+    didReadLineBytes: (const char *) bytes
+              length: (unsigned) length
+{
+	ProgressEvent event;
+
+	switch (parseCDparanoiaLine(bytes, length, &event)) {
+	case ProgressFirstSector:
+		[statusLock lock];
+		firstSector = event.current;
+		[statusLock unlock];
+		break;
+	case ProgressLastSector:
+		trackSize = (event.current + 1 - firstSector) * SECTOR_BYTES;
+		break;
+	case ProgressTocEntry:
+		if ((event.current > 0) && (event.current < 100)) {
+			tocBegin[event.current] = event.total;
+			tocLength[event.current] = (long)event.value;
 		}
+		break;
+	default:
+		break;
 	}
+
+	// The lines are shown in any case.
+	return NO;
+}
+
+- (void) toolProcess: (ToolProcess *) process
+         didReadLine: (NSString *) aLine
+{
+	logToolOutput(aLine);
 }
 
 - (void) sendOutputString: (NSString *) outString
@@ -158,10 +181,7 @@ static NSFileManager *fileMan = nil;
 
 	outLine = [NSString stringWithFormat: @"**** %@ ****", outString];
 
-	[[NSDistributedNotificationCenter defaultCenter]
-					postNotificationName: ExternalToolOutput
-					object: nil
-					userInfo: [NSDictionary dictionaryWithObject: outLine forKey: @"Output"]];
+	logToolOutput(outLine);
 }
 
 - (void) setStatus: (ProcessStatus) status
@@ -171,6 +191,307 @@ static NSFileManager *fileMan = nil;
 	[statusLock unlock];
 }
 
+/*
+ * The arguments common to all runs of cdparanoia: the device and
+ * the paranoia switches.
+ */
+- (NSMutableArray *) argumentsWithParameters: (NSDictionary *) parameters
+{
+	NSMutableArray *cdpArgs = [NSMutableArray array];
+	NSDictionary *cdpDefaults = [parameters objectForKey: @"CDparanoiaParameters"];
+
+	// which device to use?
+	[cdpArgs addObject: @"-d"];
+	[cdpArgs addObject: [NSString stringWithFormat: @"%@", [parameters objectForKey: @"SourceDevice"]]];
+
+	// any extra parameters? The parameters view stores 0 or 1.
+	if ([[cdpDefaults objectForKey: @"DisableParanoia"] intValue]) {
+		[cdpArgs addObject: @"-Z"];
+	}
+	if ([[cdpDefaults objectForKey: @"DisableExtraParanoia"] intValue]) {
+		[cdpArgs addObject: @"-Y"];
+	}
+	if ([[cdpDefaults objectForKey: @"DisableScratchRepair"] intValue]) {
+		[cdpArgs addObject: @"-W"];
+	}
+
+	return cdpArgs;
+}
+
+/*
+ * Runs cdparanoia -Q to get the sectors of all tracks.
+ */
+- (BOOL) readTocWithParameters: (NSDictionary *) parameters
+{
+	NSString *cdparanoia = [[parameters objectForKey: @"CDparanoiaParameters"]
+									objectForKey: @"Program"];
+	NSMutableArray *cdpArgs = [self argumentsWithParameters: parameters];
+	ToolProcess *process;
+	BOOL ret;
+
+	memset(tocBegin, 0, sizeof(tocBegin));
+	memset(tocLength, 0, sizeof(tocLength));
+
+	[cdpArgs insertObject: @"-Q" atIndex: 0];
+	process = [ToolProcess processWithPath: cdparanoia arguments: cdpArgs];
+	[process setDelegate: self];
+	ret = [process run];
+
+	return ret;
+}
+
+/*
+ * Rips one track to a .wav file of its own. cdparanoia writes the
+ * file itself.
+ */
+- (BOOL) ripTrack: (Track *) track
+   withParameters: (NSDictionary *) parameters
+{
+	NSString *cdparanoia;
+	NSString *fileName;
+	NSMutableArray *cdpArgs;
+	NSDictionary *sesDefaults = [parameters objectForKey: @"SessionParameters"];
+	BOOL ret = YES;
+
+	cdparanoia = [[parameters objectForKey: @"CDparanoiaParameters"] objectForKey: @"Program"];
+
+	cdpArgs = [self argumentsWithParameters: parameters];
+	[cdpArgs insertObject: @"-w" atIndex: 0];
+
+	// add track number and outfile name to args list
+	[cdpArgs addObject: [NSString stringWithFormat: @"%d", trackNumber(track)]];
+
+	fileName = [self makeOutfileNameForTrack: trackNumber(track)
+										onCD: [parameters objectForKey: @"CddbId"]
+									 tempDir: [sesDefaults objectForKey: @"TempDirectory"]];
+
+	[cdpArgs addObject: fileName];
+	[track setStorage: fileName];
+
+	[statusLock lock];
+	currentTrack = [allTracks indexOfObjectIdenticalTo: track];
+	cdpProcess = [[ToolProcess alloc] initWithPath: cdparanoia arguments: cdpArgs];
+	[statusLock unlock];
+	[cdpProcess setDelegate: self];
+
+	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
+										cdparanoia, [cdpArgs componentsJoinedByString: @" "]]];
+
+	ripStatus.processStatus = isConverting;
+
+	/*
+	 * Now we wait until the cdparanoia process is over and process its output.
+	 */
+	if ([cdpProcess launch]) {
+		[self waitForTaskExit];
+	}
+
+	/*
+	 * If cdparanoia did not terminate gracefully we stop the whole affair.
+	 * We delete in any case the actual (not finished) file.
+	 */
+	if (![cdpProcess exitedNormally]
+			|| (ripStatus.processStatus == isCancelled)) {
+		[self sendOutputString: [NSString stringWithFormat: _(@"Removing temporary file %@."), [track storage]]];
+		if (![fileMan removeFileAtPath: [track storage] handler: nil]) {
+			[self sendOutputString: _(@"Removing file failed.")];
+		}
+		ripStatus.processStatus = isCancelled;
+		ret = NO;
+	} else {
+		tracksDone++;
+	}
+
+	[statusLock lock];
+	DESTROY(cdpProcess);
+	[statusLock unlock];
+
+	return ret;
+}
+
+/*
+ * Rips the tracks first to last in a single run of cdparanoia, which
+ * writes the raw samples to a pipe. -splitThread: cuts them into the
+ * .wav files at the track boundaries of the table of contents, while
+ * cdparanoia is still reading. Returns NO if anything failed. The
+ * files are removed then.
+ */
+- (BOOL) ripTracks: (NSDictionary *) tracksByNumber
+              from: (int) first
+                to: (int) last
+    withParameters: (NSDictionary *) parameters
+{
+	NSString *cdparanoia;
+	NSMutableArray *cdpArgs;
+	NSMutableArray *files = [NSMutableArray array];
+	NSDictionary *sesDefaults = [parameters objectForKey: @"SessionParameters"];
+	NSPipe *pipe = [NSPipe pipe];
+	BOOL ret = NO;
+	int i;
+
+	cdparanoia = [[parameters objectForKey: @"CDparanoiaParameters"] objectForKey: @"Program"];
+
+	for (i = first; i <= last; i++) {
+		NSString *fileName = [self makeOutfileNameForTrack: i
+													  onCD: [parameters objectForKey: @"CddbId"]
+												   tempDir: [sesDefaults objectForKey: @"TempDirectory"]];
+		[files addObject: fileName];
+		[[tracksByNumber objectForKey: [NSNumber numberWithInt: i]]
+			makeObjectsPerformSelector: @selector(setStorage:) withObject: fileName];
+	}
+
+	// -p writes raw samples in native byte order, - is stdout.
+	cdpArgs = [self argumentsWithParameters: parameters];
+	[cdpArgs insertObject: @"-p" atIndex: 0];
+	[cdpArgs addObject: [NSString stringWithFormat: @"%d-%d", first, last]];
+	[cdpArgs addObject: @"-"];
+
+	[statusLock lock];
+	cdpProcess = [[ToolProcess alloc] initWithPath: cdparanoia arguments: cdpArgs];
+	splitFirst = first;
+	splitLast = last;
+	splitFiles = files;
+	splitTracks = tracksByNumber;
+	splitOk = NO;
+	trackBytes = 0;
+	trackBytesDone = 0;
+	splitting = YES;
+	[statusLock unlock];
+	[cdpProcess setDelegate: self];
+	[cdpProcess setStandardOutput: pipe];
+
+	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
+										cdparanoia, [cdpArgs componentsJoinedByString: @" "]]];
+
+	ripStatus.processStatus = isConverting;
+
+	if ([cdpProcess launch]) {
+		splitFd = [[pipe fileHandleForReading] fileDescriptor];
+		splitLock = [[NSConditionLock alloc] initWithCondition: 1];
+		[NSThread detachNewThreadSelector: @selector(splitThread:)
+								 toTarget: self
+							   withObject: nil];
+
+		[self waitForTaskExit];
+
+		[splitLock lockWhenCondition: 0];
+		[splitLock unlock];
+		DESTROY(splitLock);
+
+		ret = splitOk && [cdpProcess exitedNormally]
+				&& ([cdpProcess terminationStatus] == 0) && ![cdpProcess isCancelled];
+	}
+
+	[statusLock lock];
+	splitting = NO;
+	splitFiles = nil;
+	splitTracks = nil;
+	DESTROY(cdpProcess);
+	[statusLock unlock];
+
+	if (!ret) {
+		for (i = 0; i < [files count]; i++) {
+			[fileMan removeFileAtPath: [files objectAtIndex: i] handler: nil];
+		}
+	}
+	return ret;
+}
+
+- (void) splitThread: (id) anObject
+{
+	id pool = [NSAutoreleasePool new];
+	unsigned char *scratch = malloc(SPLIT_READ_SIZE);
+	unsigned long long position = 0;
+	BOOL ok = (NULL != scratch);
+	ssize_t n;
+	int i;
+
+	for (i = splitFirst; (i <= splitLast) && ok; i++) {
+		unsigned long long start = (unsigned long long)(tocBegin[i] - tocBegin[splitFirst]) * SECTOR_BYTES;
+		unsigned long long end = start + (unsigned long long)tocLength[i] * SECTOR_BYTES;
+		NSArray *tracks = [splitTracks objectForKey: [NSNumber numberWithInt: i]];
+		WavWriter *writer;
+
+		// Sectors between the tracks, if there are any, are dropped.
+		while (ok && (position < start)) {
+			n = read(splitFd, scratch, MIN(SPLIT_READ_SIZE, start - position));
+			if ((n < 0) && (errno == EINTR))
+				continue;
+			ok = (n > 0);
+			if (ok)
+				position += n;
+		}
+		if (!ok)
+			break;
+
+		writer = [[WavWriter alloc] initWithPath: [splitFiles objectAtIndex: i - splitFirst]
+									  sampleRate: 44100
+										channels: 2
+								  expectedFrames: (end - start) / 4];
+		if (nil == writer) {
+			ok = NO;
+			break;
+		}
+
+		[statusLock lock];
+		currentTrack = [allTracks indexOfObjectIdenticalTo: [tracks objectAtIndex: 0]];
+		trackBytes = end - start;
+		trackBytesDone = 0;
+		[statusLock unlock];
+
+		while (ok && (position < end)) {
+			unsigned length = MIN(SPLIT_READ_SIZE, end - position);
+			unsigned char *out = [writer bytesForAppending: length];
+
+			if (NULL == out) {
+				ok = NO;
+				break;
+			}
+			n = read(splitFd, out, length);
+			if ((n < 0) && (errno == EINTR))
+				continue;
+			if (n <= 0) {
+				ok = NO;
+				break;
+			}
+			[writer appendedBytes: n];
+			position += n;
+			trackBytesDone += n;
+		}
+
+		ok = [writer close] && ok;
+		RELEASE(writer);
+		if (ok) {
+			[statusLock lock];
+			tracksDone += [tracks count];
+			[statusLock unlock];
+		}
+	}
+
+	/*
+	 * cdparanoia must not block on a full pipe. If we failed, it is
+	 * stopped, otherwise the rest is read, which must be nothing.
+	 */
+	if (!ok) {
+		[statusLock lock];
+		[cdpProcess cancel];
+		[statusLock unlock];
+	}
+	while ((NULL != scratch) && ((n = read(splitFd, scratch, SPLIT_READ_SIZE)) != 0)) {
+		if ((n < 0) && (errno != EINTR))
+			break;
+		if (n > 0)
+			ok = NO;
+	}
+	free(scratch);
+
+	splitOk = ok;
+	[splitLock lock];
+	[splitLock unlockWithCondition: 0];
+
+	RELEASE(pool);
+}
+
 @end
 
 //
@@ -194,10 +515,27 @@ static NSFileManager *fileMan = nil;
 	return self;
 }
 
+/*
+ * An instance for ripping in parallel. The defaults have been
+ * read by the single instance already.
+ */
+- (id) initWithGrabber: (CDparanoiaController *) aGrabber
+{
+	self = [super init];
+
+	if (self) {
+		statusLock = [NSLock new];
+	}
+
+	return self;
+}
+
 
 - (void) dealloc
 {
-	singleInstance = nil;
+	if (self == singleInstance) {
+		singleInstance = nil;
+	}
 	RELEASE(statusLock);
 
 	[super dealloc];
@@ -252,16 +590,24 @@ static NSFileManager *fileMan = nil;
     return YES;
 }
 
+- (NSArray *) fileTypes
+{
+    return [NSArray arrayWithObject: @"cd"];
+}
+
 
 - (ToolStatus) getStatus
 {
 	ToolStatus status;
-    Track *track = [allTracks objectAtIndex: currentTrack];
     int count = [allTracks count];
+    Track *track;
 
 	[statusLock lock];
+    track = (currentTrack < count) ? [allTracks objectAtIndex: currentTrack] : nil;
     ripStatus.trackName = [track description];
-    if (track != nil)
+    if (splitting) {
+        ripStatus.trackProgress = (trackBytes > 0) ? (double)trackBytesDone * 100 / trackBytes : 0;
+    } else if (track != nil)
     	ripStatus.trackProgress = [[[fileMan fileAttributesAtPath: [track storage] traverseLink: NO]
 	    									objectForKey: NSFileSize] doubleValue] * 100 / trackSize;
     else {
@@ -270,7 +616,7 @@ static NSFileManager *fileMan = nil;
     if (count == 0) {
         ripStatus.entireProgress = 0;
     } else {
-	    ripStatus.entireProgress = currentTrack * 100 / count;
+	    ripStatus.entireProgress = tracksDone * 100 / count;
         ripStatus.entireProgress += ripStatus.trackProgress / count;
     }
 
@@ -280,19 +626,20 @@ static NSFileManager *fileMan = nil;
 	return status;
 }
 
+/**
+ * <p>Unless <em>SinglePass</em> in the CDparanoiaParameters is off,
+ * each run of consecutive tracks is ripped by a single cdparanoia
+ * process, so that the drive is spun up and the paranoia cache warmed
+ * up only once. If that fails, the tracks are ripped one by one.</p>
+ */
 - (BOOL) convertTracks: (NSArray *)tracks
 	    withParameters: (NSDictionary *) parameters
 {
 	BOOL ret = YES;
-	int termStatus;
 	NSString *cdparanoia;
-    NSString *fileName;
-	NSMutableArray *cdpArgs;
-	NSString *cdpParam;
-	NSPipe *stdOut;
-    Track *track;
     NSDictionary *cdpDefaults = [parameters objectForKey: @"CDparanoiaParameters"];
-    NSDictionary *sesDefaults = [parameters objectForKey: @"SessionParameters"];
+    id singlePass = [cdpDefaults objectForKey: @"SinglePass"];
+    int i;
 
 	// set up cdparanoia task
 	cdparanoia = [cdpDefaults objectForKey: @"Program"];
@@ -300,81 +647,72 @@ static NSFileManager *fileMan = nil;
         return NO;
 
     allTracks = tracks;
+    currentTrack = 0;
+    tracksDone = 0;
 
     ripStatus.entireProgress = 0;
     ripStatus.trackProgress = 0;
-
-    for (currentTrack = 0; (currentTrack < [allTracks count]) && (ret != NO); currentTrack++) {
-        track = [tracks objectAtIndex: currentTrack];
-
-    	cdpArgs = [NSMutableArray arrayWithObjects: @"-w", nil];
-
-    	// which device to use?
-	    [cdpArgs addObject: [NSString stringWithFormat: @"-d"]];
-    	[cdpArgs addObject: [NSString stringWithFormat: @"%@", [parameters objectForKey: @"SourceDevice"]]];
-
-	    // any extra parameters?
-    	cdpParam = [cdpDefaults objectForKey: @"DisableParanoia"];
-	    if (cdpParam) {
-		    [cdpArgs addObject: @"-Z"];
-    	}
-	    cdpParam = [cdpDefaults objectForKey: @"DisableExtraParanoia"];
-    	if (cdpParam) {
-	    	[cdpArgs addObject: @"-Y"];
-    	}
-	    cdpParam = [cdpDefaults objectForKey: @"DisableScratchRepair"];
-    	if (cdpParam) {
-	    	[cdpArgs addObject: @"-W"];
-    	}
-
-        // add track number and outfile name to args list
- 	    [cdpArgs addObject: [[track source] substringFromIndex: 14]];
-
-        fileName = [self makeOutfileNameForTrack: [[[track source] substringFromIndex: 14] intValue]
-                                            onCD: [parameters objectForKey: @"CddbId"]
-                                         tempDir: [sesDefaults objectForKey: @"TempDirectory"]];
-
-    	[cdpArgs addObject: fileName];
-        [track setStorage: fileName];
-
-	    cdpTask = [[NSTask alloc] init];
-    	stdOut = [[NSPipe alloc] init];
-
-	    [cdpTask setLaunchPath: cdparanoia];
-	    [cdpTask setArguments: cdpArgs];
-    	[cdpTask setStandardError: stdOut];
-
-    	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
-											cdparanoia, [cdpArgs componentsJoinedByString: @" "]]];
-
-	    [cdpTask launch];
-
-	    ripStatus.processStatus = isConverting;
-
-    	/*
-    	 * Now we wait until the cdparanoia task is over and process its output.
-    	 */
-    	[self waitForTaskExit];
-
-    	/*
-    	 * If cdparanoia did not terminate gracefully we stop the whole affair.
-    	 * We delete in any case the actual (not finished) file.
-    	 */
-    	termStatus = [cdpTask terminationStatus];	// FreeBSD needs an lvalue for the WIF* macros
-    	if ((WIFEXITED(termStatus) == 0)
-    			|| WIFSIGNALED(termStatus)
-    			|| (ripStatus.processStatus == isCancelled)) {
-    		[self sendOutputString: [NSString stringWithFormat: _(@"Removing temporary file %@."), [track storage]]];
-    		if (![fileMan removeFileAtPath: [track storage] handler: nil]) {
-    			[self sendOutputString: _(@"Removing file failed.")];
-    		}
-    		ripStatus.processStatus = isCancelled;
-    		ret = NO;
-    	}
-
-    	RELEASE(stdOut);
-    	RELEASE(cdpTask);
-    	cdpTask = nil;
+    ripStatus.processStatus = isConverting;
+
+    if (((nil == singlePass) || [singlePass boolValue]) && ([tracks count] > 1)
+            && [self readTocWithParameters: parameters]) {
+        NSMutableDictionary *tracksByNumber = [NSMutableDictionary dictionary];
+        NSArray *numbers;
+        int first, last;
+
+        for (i = 0; i < [tracks count]; i++) {
+            Track *track = [tracks objectAtIndex: i];
+            NSNumber *number = [NSNumber numberWithInt: trackNumber(track)];
+            NSMutableArray *same = [tracksByNumber objectForKey: number];
+
+            if (nil == same) {
+                same = [NSMutableArray array];
+                [tracksByNumber setObject: same forKey: number];
+            }
+            [same addObject: track];
+        }
+        numbers = [[tracksByNumber allKeys] sortedArrayUsingSelector: @selector(compare:)];
+
+        i = 0;
+        while ((i < [numbers count]) && (ret != NO)) {
+            int j, run = 1;
+
+            // Find the run of consecutive tracks which starts here.
+            first = [[numbers objectAtIndex: i] intValue];
+            while ((i + run < [numbers count])
+                    && ([[numbers objectAtIndex: i + run] intValue] == first + run)) {
+                run++;
+            }
+            last = first + run - 1;
+            i += run;
+
+            if ((last > first) && (first > 0) && (last < 100) && (tocLength[first] > 0)
+                    && (tocLength[last] > 0)) {
+                if ([self ripTracks: tracksByNumber from: first to: last withParameters: parameters]) {
+                    continue;
+                }
+                if (ripStatus.processStatus == isCancelled) {
+                    ret = NO;
+                    break;
+                }
+                [self sendOutputString: [NSString stringWithFormat:
+                            _(@"Reading tracks %d to %d in one pass failed. Ripping them one by one."),
+                            first, last]];
+            }
+
+            for (j = first; (j <= last) && (ret != NO); j++) {
+                NSArray *same = [tracksByNumber objectForKey: [NSNumber numberWithInt: j]];
+                int k;
+
+                for (k = 0; (k < [same count]) && (ret != NO); k++) {
+                    ret = [self ripTrack: [same objectAtIndex: k] withParameters: parameters];
+                }
+            }
+        }
+    } else {
+        for (i = 0; (i < [tracks count]) && (ret != NO); i++) {
+            ret = [self ripTrack: [tracks objectAtIndex: i] withParameters: parameters];
+        }
     }
 
 	if (ripStatus.processStatus == isConverting) {
@@ -387,10 +725,12 @@ static NSFileManager *fileMan = nil;
 
 - (BOOL) stop: (BOOL)immediately
 {
-	if (cdpTask && (ripStatus.processStatus == isConverting)) {
+	if (cdpProcess && (ripStatus.processStatus == isConverting)) {
 		[self sendOutputString: _(@"Terminating process.")];
         [self setStatus: isCancelled];
-		[cdpTask terminate];
+		[statusLock lock];
+		[cdpProcess cancel];
+		[statusLock unlock];
 	}
 	return YES;
 }
@@ -400,9 +740,22 @@ static NSFileManager *fileMan = nil;
     return 0;
 }
 
+- (NSArray *) durations: (NSArray *) fileNames
+{
+    return probeDurations(self, fileNames);
+}
+
 - (unsigned) size: (NSString *)fileName
 {
     return 0;
 }
 
+//
+// ParallelGrabber methods
+//
+- (id) parallelGrabber
+{
+	return AUTORELEASE([[CDparanoiaController alloc] initWithGrabber: self]);
+}
+
 @end
@@ -22,13 +22,14 @@
  */
 
 #include <sys/types.h>
-#include <sys/wait.h>
+#include <sys/stat.h>
 
 
 #include "CDrecordController.h"
 
 #include "Constants.h"
 #include "Functions.h"
+#include "ProgressParser.h"
 #include "Track.h"
 
 #ifdef _
@@ -148,7 +149,7 @@ NSString *writemodes[] = {
      */ 
     for (i = 0; (i < numTransports) && ([drives count] == 0); i++) {
         int count, j;
-        NSPipe *stdOut = [[NSPipe alloc] init];
+        ToolProcess *scan;
         NSMutableArray* cdrArgs = [[NSMutableArray alloc] init];
         NSArray *output;
         
@@ -157,18 +158,11 @@ NSString *writemodes[] = {
         }
         [cdrArgs addObject: [NSString stringWithFormat: @"-scanbus"]];
 
-        cdrTask = [[NSTask alloc] init];
-        [cdrTask setLaunchPath: cdrecord];
-        [cdrTask setArguments: cdrArgs];
-        [cdrTask setStandardOutput: stdOut];
-        [cdrTask setStandardError: stdOut];
+        scan = [ToolProcess processWithPath: cdrecord arguments: cdrArgs];
+        [scan run];
+        RELEASE(cdrArgs);
 
-        [cdrTask launch];
-
-        [cdrTask waitUntilExit];
-
-        output = [[[NSString alloc] initWithData: [[stdOut fileHandleForReading] availableData]
-                                    encoding: NSISOLatin1StringEncoding] componentsSeparatedByString: @"\n"];
+        output = [scan outputLines];
 
         count = [output count];
 
@@ -233,10 +227,8 @@ NSString *writemodes[] = {
  */
 - (void) getCDrecordDrivers
 {
-    int termStatus;
     NSString *cdrecord;
-    NSPipe *cdrStdout;
-    NSFileHandle *hdl;
+    ToolProcess *cdrHelp;
     NSArray *cdrOutput;
     NSString *outLine;
     NSArray *cdrArgs;
@@ -252,27 +244,13 @@ NSString *writemodes[] = {
     if (!checkProgram(cdrecord))
         return;
 
-    cdrStdout = [[NSPipe alloc] init];
-    cdrTask = [[NSTask alloc] init];
-
     cdrArgs = [NSArray arrayWithObjects:
                     [NSString stringWithString: @"driver=help"],
                     nil];
 
-    [cdrTask setLaunchPath: cdrecord];
-    [cdrTask setArguments: cdrArgs];
-
-    [cdrTask setStandardError: cdrStdout];
-    [cdrTask launch];
-    [cdrTask waitUntilExit];
-
-    // FreeBSD needs an lvalue for the WEXITSTATUS macros
-    termStatus = [cdrTask terminationStatus];
-    if (WEXITSTATUS(termStatus) == 0) {
-        hdl = [cdrStdout fileHandleForReading];
-        cdrOutput = [[[NSString alloc] initWithData: [hdl availableData]
-                                        encoding: NSISOLatin1StringEncoding]
-                        componentsSeparatedByString: @"\n"];
+    cdrHelp = [ToolProcess processWithPath: cdrecord arguments: cdrArgs];
+    if ([cdrHelp run]) {
+        cdrOutput = [cdrHelp outputLines];
 
         count = [cdrOutput count];
         /*
@@ -287,126 +265,102 @@ NSString *writemodes[] = {
             }
         }
     }
-
-    RELEASE(cdrTask);
-    RELEASE(cdrStdout);
 }
 
 
 /**
  * <p>waitForEndOfBurning waits until the current burning process
  * is finished.</p>
- * <p>The method reads the output from <strong>cdrecord</strong>
- * and processes it. This means that waitForEndOfBurning updates
- * the different progress values (entire progress, track progress,...)
- * and sends <strong>cdrecord</strong>'s output to the console.</p>
+ * <p>The output from <strong>cdrecord</strong> is passed line by line
+ * to toolProcess:didReadLineBytes:length:, which updates the different
+ * progress values (entire progress, track progress,...). All other lines
+ * are sent to the console by toolProcess:didReadLine:.</p>
  */
 - (void) waitForEndOfBurning
 {
-    BOOL sendLine;
-    int actCDProgress;
-    int maxCDProgress;
-    int maxTrackProgress, curTrackProgress;
-
     maxCDProgress = 0;
     actCDProgress = 0;
     maxTrackProgress = 0;
     curTrackProgress = 0;
 
-    while ([cdrTask isRunning]) {
-        NSData *inData;
-        while ((inData = [[[cdrTask standardError] fileHandleForReading] availableData])
-                 && [inData length]) {
-            int i, count;
-            NSString *aLine;
-            NSArray *theOutput;
-
-            theOutput = [[[NSString alloc] initWithData: inData
-                                    encoding: NSISOLatin1StringEncoding]
-                                    componentsSeparatedByString: @"\n"];
-
-            count = [theOutput count];
-
-            for (i = 0; i < count; i++) {
-                aLine = [theOutput objectAtIndex: i];
-                if (aLine && [aLine length])
-                    sendLine = YES;
-                else
-                    sendLine = NO;  // don't send empty lines
-
-                if (burnStatus.processStatus == isWaiting) {
-                    NSRange aRange = [aLine rangeOfString: @"No disk / Wrong disk!"];
-                    if (aRange.location != NSNotFound) {
-                        [statusLock lock];
-                        burnStatus.processStatus = isCancelled;
-                        [statusLock unlock];
-                        break;
-                    }
-
-                    aRange = [aLine rangeOfString: @"Total size:"];
-                    if (aRange.location != NSNotFound) {
-                        maxCDProgress = [[aLine substringFromIndex: aRange.location + aRange.length] intValue];
-                    }
-
-                    aRange = [aLine rangeOfString: @"Operation starts."];
-                    if (aRange.location != NSNotFound) {
-                        [statusLock lock];
-                        burnStatus.processStatus = isPreparing;
-                        [statusLock unlock];
-                    }
-                } else if ((burnStatus.processStatus == isPreparing)
-                            || (burnStatus.processStatus == isBurning)) {
-                    NSRange aRange = [aLine rangeOfString: @"Starting new track"];
-                    if (aRange.location != NSNotFound) {
-                        [statusLock lock];
-                        actCDProgress += curTrackProgress;
-                        burnStatus.trackProgress = 0.;
-                        curTrackProgress = 0.;
-                        burnStatus.trackNumber++;
-                        [statusLock unlock];
-                        sendLine = NO;
-                    }
-                    aRange = [aLine rangeOfString: @"MB written (fifo"];
-                    if (aRange.location != NSNotFound) {
-                        [statusLock lock];
-                        aRange = [aLine rangeOfString: @"of"];
-                        if (burnStatus.processStatus == isPreparing) {
-                            maxTrackProgress = [[aLine substringFromIndex: aRange.location + aRange.length] intValue];
-                            burnStatus.processStatus = isBurning;
-                        }
-
-                        curTrackProgress = [[aLine substringWithRange: NSMakeRange(aRange.location-5, 5)] intValue];
-                        burnStatus.trackProgress = curTrackProgress * 100. / maxTrackProgress;
-                        aRange = [aLine rangeOfString: @"[buf"];
-                        // if cdrecord does not report the buffer level, we simply assume 100%
-                        if (aRange.location != NSNotFound) {
-                            burnStatus.bufferLevel = [[aLine substringFromIndex: aRange.location + aRange.length] doubleValue];
-                        } else {
-                            burnStatus.bufferLevel = 100;
-                        }
-                        burnStatus.entireProgress = (actCDProgress + curTrackProgress) * 100. / maxCDProgress;
-                        [statusLock unlock];
-                        sendLine = NO;
-                    } else {
-                        aRange = [aLine rangeOfString: @"Fixating"];
-                        if (aRange.location != NSNotFound) {
-                            [statusLock lock];
-                            burnStatus.processStatus = isFixating;
-                            burnStatus.trackProgress = 0.;
-                            burnStatus.bufferLevel = 0.;
-                            burnStatus.entireProgress = 0.;
-                            [statusLock unlock];
-                        }
-                    }
-                }
+    [cdrProcess waitUntilExit];
+}
 
-                // post the oputput to the progress panel
-                if (sendLine) {
-                    [self sendOutputString: aLine raw: YES];
-                }
-            }   // for (i = 0; i < count; i++)
-        }   // while ((inData = 
-    }   // while ([cdrTask isRunning])
+- (BOOL) toolProcess: (ToolProcess *) process
+    didReadLineBytes: (const char *) bytes
+              length: (unsigned) length
+{
+    ProgressEvent event;
+
+    if (nil == burnTracks) {
+        // We are blanking. There is no progress to parse.
+        return NO;
+    }
+
+    parseCDrecordLine(bytes, length, &event);
+
+    if (burnStatus.processStatus == isWaiting) {
+        switch (event.type) {
+        case ProgressNoMedium:
+            [statusLock lock];
+            burnStatus.processStatus = isCancelled;
+            [statusLock unlock];
+            return YES;
+        case ProgressTotalSize:
+            maxCDProgress = event.total;
+            break;
+        case ProgressOperationStarts:
+            [statusLock lock];
+            burnStatus.processStatus = isPreparing;
+            [statusLock unlock];
+            break;
+        default:
+            break;
+        }
+    } else if ((burnStatus.processStatus == isPreparing)
+                || (burnStatus.processStatus == isBurning)) {
+        switch (event.type) {
+        case ProgressNewTrack:
+            [statusLock lock];
+            actCDProgress += curTrackProgress;
+            burnStatus.trackProgress = 0.;
+            curTrackProgress = 0.;
+            burnStatus.trackNumber++;
+            [statusLock unlock];
+            return YES;
+        case ProgressWritten:
+            [statusLock lock];
+            if (burnStatus.processStatus == isPreparing) {
+                maxTrackProgress = event.total;
+                burnStatus.processStatus = isBurning;
+            }
+
+            curTrackProgress = event.current;
+            burnStatus.trackProgress = curTrackProgress * 100. / maxTrackProgress;
+            burnStatus.bufferLevel = event.value;
+            burnStatus.entireProgress = (actCDProgress + curTrackProgress) * 100. / maxCDProgress;
+            [statusLock unlock];
+            return YES;
+        case ProgressFixating:
+            [statusLock lock];
+            burnStatus.processStatus = isFixating;
+            burnStatus.trackProgress = 0.;
+            burnStatus.bufferLevel = 0.;
+            burnStatus.entireProgress = 0.;
+            [statusLock unlock];
+            break;
+        default:
+            break;
+        }
+    }
+    return NO;
+}
+
+- (void) toolProcess: (ToolProcess *) process
+         didReadLine: (NSString *) aLine
+{
+    // post the oputput to the progress panel
+    [self sendOutputString: aLine raw: YES];
 }
 
 - (NSString *) idForDevice: (NSString *) device
@@ -590,6 +544,12 @@ NSString *writemodes[] = {
     if (isCDROM) {
         [args addObject: @"-data"];
         track = [burnTracks objectAtIndex: 0];
+        /*
+         * cdrecord must know the size of a track read from stdin.
+         */
+        if ([[track storage] isEqualToString: @"-"]) {
+            [args addObject: [NSString stringWithFormat: @"tsize=%us", [track size] / 2048]];
+        }
         [args addObject: [track storage]];
         if (count > 1) {
             [args addObject: @"-audio"];
@@ -604,7 +564,15 @@ NSString *writemodes[] = {
     for (; i < count; i++) {
         track = [burnTracks objectAtIndex: i];
         NSString *storage = [track storage];
+        struct stat st;
 
+        /*
+         * Neither can cdrecord tell the size of an audio track read
+         * from a FIFO when a CD is copied on-the-fly.
+         */
+        if ((stat([storage fileSystemRepresentation], &st) == 0) && S_ISFIFO(st.st_mode)) {
+            [args addObject: [NSString stringWithFormat: @"tsize=%u", [track size]]];
+        }
         [args addObject: storage];
     }
 }
@@ -618,10 +586,7 @@ NSString *writemodes[] = {
     else
         outLine = outString;
 
-    [[NSDistributedNotificationCenter defaultCenter]
-                    postNotificationName: ExternalToolOutput
-                    object: nil
-                    userInfo: [NSDictionary dictionaryWithObject: outLine forKey: @"Output"]];
+    logToolOutput(outLine);
 }
 
 - (NSDictionary *) atipInformationForDevice: (NSString *) device
@@ -630,7 +595,7 @@ NSString *writemodes[] = {
 	int i, count;
 	NSString *cdrecord;
 	NSMutableArray *cdrArgs;
-	NSPipe *stdOut;
+	ToolProcess *query;
 	NSArray *cdrOutput;
 	NSString *outLine;
 
@@ -668,38 +633,23 @@ NSString *writemodes[] = {
 
     [cdrArgs addObject: @"-atip"];
 
-	// set up cdrecord task
-	cdrTask = [[NSTask alloc] init];
-	stdOut = [[NSPipe alloc] init];
-
-	[cdrTask setLaunchPath: cdrecord];
-
-	[cdrTask setArguments: cdrArgs];
-	[cdrTask setStandardOutput: stdOut];
-	[cdrTask setStandardError: stdOut];
+	// set up cdrecord process
+	query = [ToolProcess processWithPath: cdrecord arguments: cdrArgs];
 
 	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
 										cdrecord, [cdrArgs componentsJoinedByString: @" "]] raw: NO];
-	[cdrTask launch];
-
-	[cdrTask waitUntilExit];
+	[query run];
 
 	/*
 	 * If cdrecord did not terminate gracefully we stop the whole affair.
 	 * We delete in any case the actual (not finished) file.
 	 */
-	{
-        int termStatus = [cdrTask terminationStatus];	// FreeBSD needs an lvalue for the WIF* macros
-    	if ((WIFEXITED(termStatus) == 0)
-	    		|| WIFSIGNALED(termStatus)) {
-		    [info setObject: _(@"Unknown") forKey: @"type"];
-    		return info;
-        }
+	if (![query exitedNormally]) {
+		[info setObject: _(@"Unknown") forKey: @"type"];
+		return info;
 	}
 
-	cdrOutput = [[[NSString alloc] initWithData: [[stdOut fileHandleForReading] availableData]
-									encoding: NSISOLatin1StringEncoding]
-					componentsSeparatedByString: @"\n"];
+	cdrOutput = [query outputLines];
 
 	count = [cdrOutput count];
 
@@ -768,9 +718,6 @@ NSString *writemodes[] = {
 		}
 	}
 
-	RELEASE(stdOut);
-	RELEASE(cdrTask);
-
 	return info;
 }
 
@@ -780,7 +727,7 @@ NSString *writemodes[] = {
     int i, count;
     NSString *cdrecord;
     NSMutableArray *cdrArgs;
-    NSPipe *stdOut;
+    ToolProcess *query;
     NSArray *cdrOutput;
     NSString *outLine;
 
@@ -818,38 +765,23 @@ NSString *writemodes[] = {
 
     [cdrArgs addObject: @"-minfo"];
 
-    // set up cdrecord task
-    cdrTask = [[NSTask alloc] init];
-    stdOut = [[NSPipe alloc] init];
-
-    [cdrTask setLaunchPath: cdrecord];
-
-    [cdrTask setArguments: cdrArgs];
-    [cdrTask setStandardOutput: stdOut];
-    [cdrTask setStandardError: stdOut];
+    // set up cdrecord process
+    query = [ToolProcess processWithPath: cdrecord arguments: cdrArgs];
 
     [self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
                                         cdrecord, [cdrArgs componentsJoinedByString: @" "]] raw: NO];
-    [cdrTask launch];
-
-    [cdrTask waitUntilExit];
+    [query run];
 
     /*
      * If cdrecord did not terminate gracefully we stop the whole affair.
      * We delete in any case the actual (not finished) file.
      */
-    {
-        int termStatus = [cdrTask terminationStatus];   // FreeBSD needs an lvalue for the WIF* macros
-        if ((WIFEXITED(termStatus) == 0)
-                || WIFSIGNALED(termStatus)) {
-            [info setObject: _(@"Unknown") forKey: @"type"];
-            return info;
-        }
+    if (![query exitedNormally]) {
+        [info setObject: _(@"Unknown") forKey: @"type"];
+        return info;
     }
 
-    cdrOutput = [[[NSString alloc] initWithData: [[stdOut fileHandleForReading] availableData]
-                                    encoding: NSISOLatin1StringEncoding]
-                    componentsSeparatedByString: @"\n"];
+    cdrOutput = [query outputLines];
 
     count = [cdrOutput count];
 
@@ -916,9 +848,6 @@ NSString *writemodes[] = {
         }
     }
 
-    RELEASE(stdOut);
-    RELEASE(cdrTask);
-
     return info;
 }
 
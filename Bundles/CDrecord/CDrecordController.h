@@ -27,6 +27,7 @@
 #include <AppKit/AppKit.h>
 
 #include "ExternalTools.h"
+#include "ToolProcess.h"
 
 typedef enum {
     TaskBurn,
@@ -41,14 +42,20 @@ typedef enum {
     Raw16
 } WriteMode;
 
-@interface CDrecordController : NSObject <BurnTool, Burner>
+@interface CDrecordController : NSObject <BurnTool, Burner, ToolProcessDelegate>
 {
     // burn parameters
     NSMutableArray *burnTracks;
 
     short processStatus;
 
-    NSTask *cdrTask;
+    ToolProcess *cdrProcess;
+
+    // progress of the current burn process
+    int maxCDProgress;
+    int actCDProgress;
+    int maxTrackProgress;
+    int curTrackProgress;
 
     NSLock *statusLock;
     ToolStatus burnStatus;
@@ -57,6 +64,8 @@ typedef enum {
     NSMutableArray *drivers;
 }
 
+- (id) initWithBurner: (CDrecordController *) aBurner;
+
 @end
 
 //
@@ -22,7 +22,6 @@
  */
 
 #include <sys/types.h>
-#include <sys/wait.h>
 
 
 #include "CDrecordController.h"
@@ -65,10 +64,29 @@ static CDrecordController *singleInstance = nil;
     return self;
 }
 
+/**
+ * <p>Creates a burner which shares the drive list of <var>aBurner</var>.
+ * Thus, we need not scan the bus again.</p>
+ */
+- (id) initWithBurner: (CDrecordController *) aBurner
+{
+    self = [super init];
+
+    if (self) {
+        statusLock = [NSLock new];
+        drivers = [aBurner->drivers mutableCopy];
+        drives = [aBurner->drives mutableCopy];
+    }
+
+    return self;
+}
+
 
 - (void) dealloc
 {
-    singleInstance = nil;
+    if (self == singleInstance) {
+        singleInstance = nil;
+    }
     RELEASE(drives);
     RELEASE(drivers);
     RELEASE(statusLock);
@@ -151,6 +169,16 @@ static CDrecordController *singleInstance = nil;
                                parameters: parameters];
 }
 
+- (BOOL) canBurnOnTheFly
+{
+    return YES;
+}
+
+- (id) parallelBurner
+{
+    return AUTORELEASE([[CDrecordController alloc] initWithBurner: self]);
+}
+
 - (BOOL) isWritableMediumInDevice: (NSString *) device
                        parameters: (NSDictionary *)parameters
 {
@@ -170,7 +198,7 @@ static CDrecordController *singleInstance = nil;
 {
     NSString *cdrecord;
     NSMutableArray *cdrArgs;
-    NSPipe *stdOut;
+    BOOL ret;
 
     cdrecord = [[parameters objectForKey: @"CDrecordParameters"]
                     objectForKey: @"Program"];
@@ -190,62 +218,37 @@ static CDrecordController *singleInstance = nil;
         NS_VALRETURN(NO);
     NS_ENDHANDLER
 
-    [cdrArgs addObject: @"-eject"];
+    // Keep the medium if it is going to be burned right away.
+    if (nil == [parameters objectForKey: @"KeepMediumLoaded"]) {
+        [cdrArgs addObject: @"-eject"];
+    }
     [cdrArgs addObject: [NSString stringWithFormat: @"blank=%@",mode==fullBlank?@"all":@"fast"]];
 
-    // set up cdrecord task
-    cdrTask = [[NSTask alloc] init];
-    stdOut = [[NSPipe alloc] init];
-
-    [cdrTask setLaunchPath: cdrecord];
-
-    [cdrTask setArguments: cdrArgs];
-    [cdrTask setStandardOutput: stdOut];
-    [cdrTask setStandardError: stdOut];
+    // set up cdrecord process
+    cdrProcess = [[ToolProcess alloc] initWithPath: cdrecord
+                                         arguments: cdrArgs];
 
     [self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
                                         cdrecord, [cdrArgs componentsJoinedByString: @" "]] raw: NO];
 
-    [cdrTask launch];
-
-    while ([cdrTask isRunning]) {
-        NSData *inData;
-        while ((inData = [[[cdrTask standardError] fileHandleForReading] availableData]) &&
-                [inData length]) {
-            int i, count;
-            NSString *aLine;
-            NSArray *theOutput;
-
-            theOutput = [[[NSString alloc] initWithData: inData
-                                    encoding: NSISOLatin1StringEncoding]
-                                    componentsSeparatedByString: @"\n"];
-
-            count = [theOutput count];
-
-            for (i = 0; i < count; i++) {
-                aLine = [theOutput objectAtIndex: i];
-                if (aLine && [aLine length])
-                    [self sendOutputString: aLine raw: YES];
-            }   // for (i = 0; i < count; i++)
-        }   // while ((inData = 
-    }   // while ([cdrTask isRunning])
+    /*
+     * We are not interested in the progress of the blanking process,
+     * hence the output simply goes to the console.
+     */
+    [cdrProcess setDelegate: self];
+    [cdrProcess launch];
+    [cdrProcess waitUntilExit];
 
     /*
      * If cdrecord did not terminate gracefully we stop the whole affair.
-     * We delete in any case the actual (not finished) file.
      */
-    {
-        int termStatus = [cdrTask terminationStatus];   // FreeBSD needs an lvalue for the WIF* macros
-        if ((WIFEXITED(termStatus) == 0)
-                || WIFSIGNALED(termStatus)) {
-            return NO;
-        }
-    }
+    ret = [cdrProcess exitedNormally];
 
-    RELEASE(stdOut);
-    RELEASE(cdrTask);
+    [statusLock lock];
+    DESTROY(cdrProcess);
+    [statusLock unlock];
 
-    return YES;
+    return ret;
 }
 
 - (BOOL) burnCDFromImage: (id) image
@@ -255,7 +258,6 @@ static CDrecordController *singleInstance = nil;
     BOOL ret = YES;
     NSString *cdrecord;
     NSMutableArray *cdrArgs;
-    NSPipe *stdOut;
 
     if (!image && (!trackArray || ![trackArray count])) {
         [self sendOutputString: _(@"No tracks to burn on CD.") raw: NO];
@@ -272,6 +274,13 @@ static CDrecordController *singleInstance = nil;
         return NO;
     }
 
+    if (image && [[image storage] isEqualToString: @"-"]
+            && (nil == [parameters objectForKey: @"ImagePipe"])) {
+        [self sendOutputString: _(@"No pipe to read the image from.") raw: NO];
+        burnStatus.processStatus = isCancelled;
+        return NO;
+    }
+
     // set image file as first entry, if there is one
     burnTracks = [[NSMutableArray alloc] init];
     if (image)
@@ -296,41 +305,40 @@ static CDrecordController *singleInstance = nil;
     burnStatus.entireProgress = 0;
     burnStatus.bufferLevel = 0;
 
-    // set up cdrecord task
-    cdrTask = [[NSTask alloc] init];
-    stdOut = [[NSPipe alloc] init];
-
-    [cdrTask setLaunchPath: cdrecord];
+    // set up cdrecord process
+    cdrProcess = [[ToolProcess alloc] initWithPath: cdrecord
+                                         arguments: cdrArgs];
+    [cdrProcess setDelegate: self];
 
-    [cdrTask setArguments: cdrArgs];
-    [cdrTask setStandardOutput: stdOut];
-    [cdrTask setStandardError: stdOut];
+    /*
+     * When burning on-the-fly the image is read from stdin.
+     */
+    if (image && [[image storage] isEqualToString: @"-"]) {
+        [cdrProcess setStandardInput: [parameters objectForKey: @"ImagePipe"]];
+    }
 
     [self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
                                         cdrecord, [cdrArgs componentsJoinedByString: @" "]] raw: NO];
 
-    [cdrTask launch];
-
-    [self waitForEndOfBurning];
+    if ([cdrProcess launch]) {
+        [self waitForEndOfBurning];
+    }
 
     /*
      * If cdrecord did not terminate gracefully we stop the whole affair.
      * We delete in any case the actual (not finished) file.
      */
-    {
-        int termStatus = [cdrTask terminationStatus];   // FreeBSD needs an lvalue for the WIF* macros
-        if ((WIFEXITED(termStatus) == 0)
-                || WIFSIGNALED(termStatus)
-                || (burnStatus.processStatus == isCancelled)) {
-            burnStatus.processStatus = isCancelled;
-            ret = NO;
-        }
+    if (![cdrProcess exitedNormally]
+            || (burnStatus.processStatus == isCancelled)) {
+        burnStatus.processStatus = isCancelled;
+        ret = NO;
     }
 
-    RELEASE(stdOut);
-    RELEASE(cdrTask);
+    [statusLock lock];
+    DESTROY(cdrProcess);
+    [statusLock unlock];
 
-    RELEASE(burnTracks);
+    DESTROY(burnTracks);
 
     if (burnStatus.processStatus != isCancelled) {
         [statusLock lock];
@@ -358,15 +366,14 @@ static CDrecordController *singleInstance = nil;
 
 - (BOOL) stop: (BOOL)immediately
 {
-    if (cdrTask && (burnStatus.processStatus == isBurning)) {
-        [cdrTask terminate];
-        [self sendOutputString: _(@"Terminating process.") raw: NO];
-        burnStatus.processStatus = isCancelled;
-    } else if (cdrTask && (burnStatus.processStatus == isWaiting)) {
-        [cdrTask terminate];
+    [statusLock lock];
+    if (cdrProcess && ((burnStatus.processStatus == isBurning)
+                        || (burnStatus.processStatus == isWaiting))) {
+        [cdrProcess cancel];
         [self sendOutputString: _(@"Terminating process.") raw: NO];
         burnStatus.processStatus = isCancelled;
     }
+    [statusLock unlock];
     return YES;
 }
 
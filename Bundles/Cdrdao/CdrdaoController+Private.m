@@ -22,14 +22,18 @@
  */
 
 #include <sys/types.h>
-#include <sys/wait.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "CdrdaoController.h"
 
 #include "Constants.h"
 #include "Functions.h"
+#include "PCMFile.h"
+#include "ProgressParser.h"
 #include "Track.h"
+#include "WavWriter.h"
 
 
 #undef CDRDAO_DEBUG
@@ -90,7 +94,7 @@
 {
 	NSString *cdrdao;
 	int		 count, i;
-	NSPipe *stdOut;
+	ToolProcess *scan;
 	NSMutableArray *cdrArgs;
 	NSArray *cdrOutput;
 	NSDictionary *parameters =
@@ -118,23 +122,14 @@
     DESTROY(drives);
     drives = [NSMutableDictionary new];
 
-	cdrTask = [[NSTask alloc] init];  
-	stdOut = [[NSPipe alloc] init];
 	cdrArgs = [[NSMutableArray alloc] init];
 	[cdrArgs addObject: [NSString stringWithFormat: @"scanbus"]];
 
-	[cdrTask setLaunchPath: cdrdao];
-	[cdrTask setArguments: cdrArgs];
-	[cdrTask setStandardOutput: stdOut];
-	[cdrTask setStandardError: stdOut];
+	scan = [ToolProcess processWithPath: cdrdao arguments: cdrArgs];
+	[scan run];
+	RELEASE(cdrArgs);
 
-	[cdrTask launch];
-
-	[cdrTask waitUntilExit];
-
-	cdrOutput = [[[NSString alloc] initWithData: [[stdOut fileHandleForReading] availableData]
-									encoding: NSISOLatin1StringEncoding]
-					componentsSeparatedByString: @"\n"];
+	cdrOutput = [scan outputLines];
 
 	count = [cdrOutput count];
 
@@ -207,124 +202,102 @@
 
 - (void) waitForEndOfBurning
 {
-	BOOL sendLine;
-	double maxCDProgress;
-	int maxTrackProgress, curTrackProgress;
-
 	maxCDProgress = 0.;
 	maxTrackProgress = 0;
 	curTrackProgress = 0;
 
-	while ([cdrTask isRunning]) {
-		NSData *inData;
-        NSFileHandle *fh = [[cdrTask standardError] fileHandleForReading];
-        while ((inData = [fh availableData]) && [inData length]) {
-			int i, count;
-			NSString *aLine;
-			NSString *temp;
-			NSArray *theOutput;
-
-			temp = [[NSString alloc] initWithData: inData
-									encoding: NSISOLatin1StringEncoding];
-
-			theOutput = [temp componentsSeparatedByCharactersInSet: [NSCharacterSet newlineCharacterSet]];
-
-			count = [theOutput count];
-
-			for (i = 0; i < count; i++) {
-				aLine = [theOutput objectAtIndex: i];
-				if (aLine && [aLine length])
-					sendLine = YES;
-				else
-					sendLine = NO;	// don't send empty lines
-
-				if (burnStatus.processStatus == isWaiting) {
-					NSRange r = [aLine rangeOfString: @"Unit not ready, giving up"];
-					if (r.location != NSNotFound) {
-						[statusLock lock];
-						burnStatus.processStatus = isCancelled;
-						[statusLock unlock];
-						break;
-					}
-					r = [aLine rangeOfString: @"Writing lead-in"];
-					if (r.location == NSNotFound) {
-						[statusLock lock];
-						burnStatus.processStatus = isPreparing;
-						[statusLock unlock];
-					}
-					r = [aLine rangeOfString: @"Starting write"];
-					if (r.location != NSNotFound) {
-						[statusLock lock];
-						burnStatus.processStatus = isPreparing;
-						[statusLock unlock];
-					}
-				} else if ((burnStatus.processStatus == isPreparing)
-							|| (burnStatus.processStatus == isBurning)) {
-					if (YES == [aLine hasPrefix: @"Writing track"]) {
-                        Track *track = nil;
-						[statusLock lock];
-                        burnStatus.trackNumber = [[aLine substringFromIndex: 13] integerValue];
-                        // cdrdao reports 1-based track numbers
-                        track = [burnTracks objectAtIndex: burnStatus.trackNumber - 1];
-						burnStatus.trackProgress = 0.;
-						curTrackProgress = 0;
-						maxTrackProgress = (long)[track duration] * 2352 / (1024*1024);
-						[statusLock unlock];
-						sendLine = NO;
-					}
-					if (YES == [aLine hasPrefix: @"Wrote"]) {
-    					NSArray *parts = [aLine componentsSeparatedByString: @" "];
-						[statusLock lock];
-					    if (burnStatus.processStatus == isPreparing) {
-							burnStatus.processStatus = isBurning;
-							maxCDProgress = [[parts objectAtIndex: 3] doubleValue];
-					    }
-						curTrackProgress++;
-						burnStatus.trackProgress = curTrackProgress * 100. / maxTrackProgress;
-						burnStatus.entireProgress = [[parts objectAtIndex: 1] doubleValue] * 100. / maxCDProgress;
-						burnStatus.bufferLevel = [[parts objectAtIndex: 6] doubleValue];
-						[statusLock unlock];
-						sendLine = NO;
-                    }
-
-					if ((YES == [aLine hasPrefix: @"Writing lead-out"])
-                            || (YES == [aLine hasPrefix: @"Flushing cache"])) {
-						[statusLock lock];
-						burnStatus.processStatus = isFixating;
-						burnStatus.trackProgress = 0.;
-						burnStatus.bufferLevel = 0.;
-						burnStatus.entireProgress = 0.;
-						maxTrackProgress = 0;
-						maxCDProgress = 0.;
-						[statusLock unlock];
-					}
-				} else if (burnStatus.processStatus == isFixating) {
-                    NSRange r;
-					if (YES == [aLine hasPrefix: @"Wrote"]) {
-						NSArray *parts = [aLine componentsSeparatedByString: @" "];
-
-						[statusLock lock];
-						if (0. == maxCDProgress) {
-							maxCDProgress = [[parts objectAtIndex: 3] doubleValue];
-						}
-						burnStatus.entireProgress = [[parts objectAtIndex: 1] doubleValue] * 100. / maxCDProgress;
-						[statusLock unlock];
-						sendLine = NO;
-					}
-					r = [aLine rangeOfString: @"failed"];
-					if (r.location != NSNotFound) {
-						[statusLock lock];
-						burnStatus.processStatus = isCancelled;
-						[statusLock unlock];
-					}
-				}
-				// post the oputput to the progress panel
-				if (sendLine) {
-					[self sendOutputString: aLine raw: YES];
-				}
-			}	// for (i = 0; i < count; i++)
-		}	//  while ((inData = 
-	}	// while ([cdrTask isRunning])
+	[cdrProcess waitUntilExit];
+}
+
+- (BOOL) toolProcess: (ToolProcess *) process
+    didReadLineBytes: (const char *) bytes
+              length: (unsigned) length
+{
+	ProgressEvent event;
+
+	if (nil == burnTracks) {
+		// We are blanking. There is no progress to parse.
+		return NO;
+	}
+
+	parseCdrdaoLine(bytes, length, &event);
+
+	if (burnStatus.processStatus == isWaiting) {
+		if (event.type == ProgressNoMedium) {
+			[statusLock lock];
+			burnStatus.processStatus = isCancelled;
+			[statusLock unlock];
+			return YES;
+		}
+		if (event.type != ProgressLeadIn) {
+			[statusLock lock];
+			burnStatus.processStatus = isPreparing;
+			[statusLock unlock];
+		}
+	} else if ((burnStatus.processStatus == isPreparing)
+				|| (burnStatus.processStatus == isBurning)) {
+		switch (event.type) {
+		case ProgressNewTrack: {
+			Track *track = nil;
+			[statusLock lock];
+			burnStatus.trackNumber = event.current;
+			// cdrdao reports 1-based track numbers
+			track = [burnTracks objectAtIndex: burnStatus.trackNumber - 1];
+			burnStatus.trackProgress = 0.;
+			curTrackProgress = 0;
+			maxTrackProgress = (long)[track duration] * 2352 / (1024*1024);
+			[statusLock unlock];
+			return YES;
+		}
+		case ProgressWritten:
+			[statusLock lock];
+			if (burnStatus.processStatus == isPreparing) {
+				burnStatus.processStatus = isBurning;
+				maxCDProgress = event.total;
+			}
+			curTrackProgress++;
+			burnStatus.trackProgress = curTrackProgress * 100. / maxTrackProgress;
+			burnStatus.entireProgress = event.current * 100. / maxCDProgress;
+			burnStatus.bufferLevel = event.value;
+			[statusLock unlock];
+			return YES;
+		case ProgressFixating:
+			[statusLock lock];
+			burnStatus.processStatus = isFixating;
+			burnStatus.trackProgress = 0.;
+			burnStatus.bufferLevel = 0.;
+			burnStatus.entireProgress = 0.;
+			maxTrackProgress = 0;
+			maxCDProgress = 0.;
+			[statusLock unlock];
+			break;
+		default:
+			break;
+		}
+	} else if (burnStatus.processStatus == isFixating) {
+		if (event.type == ProgressWritten) {
+			[statusLock lock];
+			if (0. == maxCDProgress) {
+				maxCDProgress = event.total;
+			}
+			burnStatus.entireProgress = event.current * 100. / maxCDProgress;
+			[statusLock unlock];
+			return YES;
+		}
+		if (event.type == ProgressFailed) {
+			[statusLock lock];
+			burnStatus.processStatus = isCancelled;
+			[statusLock unlock];
+		}
+	}
+	return NO;
+}
+
+- (void) toolProcess: (ToolProcess *) process
+         didReadLine: (NSString *) aLine
+{
+	// post the oputput to the progress panel
+	[self sendOutputString: aLine raw: YES];
 }
 
 - (NSString *) idForDevice: (NSString *) device
@@ -469,9 +442,9 @@
 	 * Now, we must create the .toc file for cdrdao.
 	 * We want it to be temporary.
 	 */
-	tocFile = [tempDir stringByAppendingPathComponent: [NSString stringWithFormat: @"burn_%@.toc",
+	tocFile = [tempDir stringByAppendingPathComponent: [NSString stringWithFormat: @"burn_%@_%p.toc",
 														[[NSDate date] descriptionWithCalendarFormat: @"%H_%M_%S"
-																		timeZone: nil locale: nil]]];
+																		timeZone: nil locale: nil], self]];
 
 	// The first entry is the name of an image file (NSString*) if we burn a CD-ROM.
 	count = [burnTracks count];
@@ -503,9 +476,33 @@
 		burnStatus.trackProgress = 0.;
 
 		if ([[File pathExtension] isEqual: @"au"]) {
-			[self convertAuToWav: File];
-			[tocContents appendString: [NSString stringWithFormat: @"FILE \"%@\" 0\n",
-				[[File stringByDeletingPathExtension] stringByAppendingPathExtension: @"wav"]]];
+			PCMFile *pcm = [[PCMFile alloc] initWithPath: File];
+
+			if ((nil != pcm) && [pcm isBurnable]) {
+				/*
+				 * cdrdao takes files not ending in .wav as raw big endian
+				 * samples, which is what .au files hold. So the file is
+				 * used as it is, skipping the header.
+				 */
+				[tocContents appendString: [NSString stringWithFormat: @"FILE \"%@\" #%llu 0 %llu\n",
+					File, [pcm dataOffset], [pcm frames]]];
+			} else {
+				NSString *wavFile;
+
+				/*
+				 * A parallel burner may be converting the same file. Wait
+				 * until it is complete.
+				 */
+				[convertLock lock];
+				wavFile = [self convertAuToWav: File];
+				[convertLock unlock];
+				if (nil == wavFile) {
+					burnStatus.processStatus = isCancelled;
+				} else {
+					[tocContents appendString: [NSString stringWithFormat: @"FILE \"%@\" 0\n", wavFile]];
+				}
+			}
+			RELEASE(pcm);
 		} else {
 			[tocContents appendString: [NSString stringWithFormat: @"FILE \"%@\" 0\n", File]];
 		}
@@ -520,92 +517,95 @@
     return tocFile;
 }
 
-- (BOOL) convertAuToWav: (NSString *)auFile
+/**
+ * <p>Converts <var>auFile</var> to a .wav file in the temporary
+ * directory and returns the path of the latter. The file is read and
+ * written in large blocks, which are byte swapped by PCMFile. Returns
+ * nil if the file cannot be converted or the process was cancelled.</p>
+ * <p>The samples are written to a file with the suffix .part, which
+ * is renamed when it is complete. A .wav file which is there already
+ * is only used if it holds as many samples as <var>auFile</var>.</p>
+ */
+- (NSString *) convertAuToWav: (NSString *)auFile
 {
-	unsigned int temp, i, rest;
-	int dataLength, dataOffset;
-	NSString *wavFile;
-	NSFileHandle *inFile, *outFile;
-	NSData *rawData;
-	char _wavHeader[] = {'R','I','F','F',0x0,0x0,0x0,0x0,'W','A','V','E',
-						'f','m','t',' ',0x10,0x0,0x0,0x0,0x01,0x0,0x02,0x0,0x44,0xac,0x0,0x0,
-						0x10,0xB1,0x02,0x0,0x04,0x0,0x10,0x0,'d','a','t','a',0x0,0x0,0x0,0x0};
-
-	// if it is a .wav file already, we don't do anything
-	if ([[auFile pathExtension] isEqual: @"wav"])
-		return YES;
-
-	// if it is not an .au file we indicate an error
-	if (![[auFile pathExtension] isEqual: @"au"])
-		return NO;
-
-	// does the file exist?
-	if (![fileMan fileExistsAtPath: auFile])
-		return NO;
+	NSString *wavFile, *partFile;
+	PCMFile *pcm, *existing;
+	WavWriter *writer;
+	unsigned long long total, done = 0;
+	BOOL ok = YES;
 
 	// create the wav file name by using the temporary directory
 	wavFile = [[auFile lastPathComponent] stringByDeletingPathExtension];
 	wavFile = [wavFile stringByAppendingPathExtension: @"wav"];
 	wavFile = [tempDir stringByAppendingPathComponent: wavFile];
+	partFile = [wavFile stringByAppendingPathExtension: @"part"];
+
+	pcm = AUTORELEASE([[PCMFile alloc] initWithPath: auFile]);
+	if ((nil == pcm) || ![pcm canRead] || ([pcm sampleRate] != 44100)) {
+		[self sendOutputString: [NSString stringWithFormat: @"Cannot convert %@.", auFile] raw: NO];
+		return nil;
+	}
+	total = [pcm frames];
 
 	// check whether the .wav file already exists
-	if ([fileMan fileExistsAtPath: wavFile])
-		return YES;
+	if ([fileMan fileExistsAtPath: wavFile]) {
+		existing = AUTORELEASE([[PCMFile alloc] initWithPath: wavFile]);
+		if ((nil != existing) && ([existing container] == PCMContainerWAV)
+				&& [existing isBurnable] && ([existing frames] == total)) {
+			return wavFile;
+		}
+		[self sendOutputString: [NSString stringWithFormat: @"Removing incomplete %@.", wavFile] raw: NO];
+		[fileMan removeFileAtPath: wavFile handler: nil];
+	}
 
-	if(![fileMan createFileAtPath: wavFile contents: nil attributes: nil])
-		return NO;
+	writer = [[WavWriter alloc] initWithPath: partFile
+								  sampleRate: 44100
+									channels: 2
+							  expectedFrames: total];
+	if (nil == writer) {
+		[self sendOutputString: [NSString stringWithFormat: @"Cannot create %@.", partFile] raw: NO];
+		return nil;
+	}
 
 	[self sendOutputString: [NSString stringWithFormat: @"Converting %@ to %@.", auFile, wavFile] raw: NO];
 
-	inFile = [NSFileHandle fileHandleForReadingAtPath: auFile];
-	outFile = [NSFileHandle fileHandleForWritingAtPath: wavFile];
-
-	// read header and calculate data length, remember we have Motorole byte order!!
-	[inFile seekToFileOffset: 4];
-	[[inFile readDataOfLength: sizeof(unsigned int)] getBytes: &dataOffset length: sizeof(dataOffset)];
-	dataOffset = GSSwapBigI32ToHost(dataOffset);
-	dataLength = [[fileMan fileAttributesAtPath: auFile
-									traverseLink: YES] fileSize]; // - dataOffset;
-	dataLength -= dataOffset;
-
-	// we assume here that the file is 2 channel 16-bit PCM data and don't check this!!!
-
-	// write .wav Header
-	temp = GSSwapHostI32ToLittle(dataLength);
-	memcpy(_wavHeader+40, &temp, sizeof(temp));
-	temp += 36;
-	memcpy(_wavHeader+4, &temp, sizeof(temp));
-	[outFile writeData: [NSData dataWithBytes: _wavHeader length: 44]];
-
-	// write the swapped data
-	[inFile seekToFileOffset: dataOffset];
-	rawData = [inFile readDataOfLength: dataLength];
-
-	rest = dataLength % 2;
-	for (i = 0; i < dataLength-rest; i+= 2) {
-		short data;
-		[rawData getBytes: &data range: NSMakeRange(i,2)];
-		data = GSSwapI16(data);
-		[outFile writeData: [NSData dataWithBytes: &data length: 2]];
-		burnStatus.trackProgress = i * 100 / dataLength;
+	while (burnStatus.processStatus != isCancelled) {
+		int16_t *out = (int16_t *)[writer bytesForAppending: PCM_READ_FRAMES * 4];
+		long n;
 
-		if (burnStatus.processStatus == isCancelled)
+		if (NULL == out) {
+			ok = NO;
 			break;
+		}
+		n = [pcm readFrames: PCM_READ_FRAMES into: out];
+		if (n <= 0) {
+			ok = (n == 0);
+			break;
+		}
+		[writer appendedBytes: n * 4];
+		done += n;
+		burnStatus.trackProgress = done * 100 / total;
 	}
-	// write the last byte
-	if (rest)
-		[outFile writeData: [inFile readDataOfLength: 1]];
-
-	// close the files
-	[inFile closeFile];
-	[outFile closeFile];
 
-	if (!tempFiles) {
-		tempFiles = [[NSMutableArray alloc] init];
+	ok = [writer close] && ok && (done == total);
+	RELEASE(writer);
+
+	if (ok && (burnStatus.processStatus != isCancelled)) {
+		ok = (rename([partFile fileSystemRepresentation], [wavFile fileSystemRepresentation]) == 0);
+		if (ok) {
+			if (!tempFiles) {
+				tempFiles = [[NSMutableArray alloc] init];
+			}
+			[tempFiles addObject: wavFile];
+			return wavFile;
+		}
 	}
-	[tempFiles addObject: wavFile];
 
-	return YES;
+	unlink([partFile fileSystemRepresentation]);
+	if (!ok) {
+		[self sendOutputString: [NSString stringWithFormat: @"Cannot convert %@.", auFile] raw: NO];
+	}
+	return nil;
 }
 
 - (void) sendOutputString: (NSString *)outString raw: (BOOL)raw
@@ -617,10 +617,7 @@
 	else
 		outLine = outString;
 
-	[[NSDistributedNotificationCenter defaultCenter]
-					postNotificationName: ExternalToolOutput
-					object: nil
-					userInfo: [NSDictionary dictionaryWithObject: outLine forKey: @"Output"]];
+	logToolOutput(outLine);
 }
 
 @end
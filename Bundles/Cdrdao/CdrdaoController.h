@@ -27,8 +27,9 @@
 #include <AppKit/AppKit.h>
 
 #include "ExternalTools.h"
+#include "ToolProcess.h"
 
-@interface CdrdaoController : NSObject <BurnTool, Burner>
+@interface CdrdaoController : NSObject <BurnTool, Burner, ToolProcessDelegate>
 {
 	// burn parameters
 	NSMutableArray *burnTracks;
@@ -37,15 +38,28 @@
 
 	NSString *tempDir;
 
-	NSTask *cdrTask;
+	ToolProcess *cdrProcess;
+
+	// progress of the current burn process
+	double maxCDProgress;
+	int maxTrackProgress;
+	int curTrackProgress;
 
 	NSLock *statusLock;
 	ToolStatus burnStatus;
 
+	/*
+	 * Shared by all parallel burners, which must not convert
+	 * the same file at the same time.
+	 */
+	NSLock *convertLock;
+
 	NSMutableDictionary *drives;
 	NSFileManager *fileMan;
 }
 
+- (id) initWithBurner: (CdrdaoController *) aBurner;
+
 @end
 
 //
@@ -65,7 +79,7 @@
      andParameters: (NSDictionary *) parameters
        toArguments: (NSMutableArray *) args;
 - (NSString *) createTOC: (BOOL) isCDROM;
-- (BOOL) convertAuToWav: (NSString *) auFile;
+- (NSString *) convertAuToWav: (NSString *) auFile;
 @end
 
 
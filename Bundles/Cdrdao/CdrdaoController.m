@@ -22,7 +22,6 @@
  */
 
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <stdlib.h>
 
 #include "CdrdaoController.h"
@@ -54,6 +53,7 @@ static CdrdaoController *singleInstance = nil;
 			fileMan = [NSFileManager defaultManager];
 		}
 		statusLock = [NSLock new];
+		convertLock = [NSLock new];
 
         [self initializeFromDefaults];
 		[self checkForDrives];
@@ -62,12 +62,35 @@ static CdrdaoController *singleInstance = nil;
 	return self;
 }
 
+/**
+ * <p>Creates a burner which shares the drive list of <var>aBurner</var>.
+ * Thus, we need not scan for drives again.</p>
+ */
+- (id) initWithBurner: (CdrdaoController *) aBurner
+{
+	self = [super init];
+
+	if (self) {
+		if (!fileMan) {
+			fileMan = [NSFileManager defaultManager];
+		}
+		statusLock = [NSLock new];
+		convertLock = RETAIN(aBurner->convertLock);
+		drives = [aBurner->drives mutableCopy];
+	}
+
+	return self;
+}
+
 
 - (void) dealloc
 {
-	singleInstance = nil;
+	if (self == singleInstance) {
+		singleInstance = nil;
+	}
     RELEASE(drives);
 	RELEASE(statusLock);
+	RELEASE(convertLock);
 
 	[super dealloc];
 }
@@ -149,7 +172,7 @@ static CdrdaoController *singleInstance = nil;
 	int i, count;
 	NSString *cdrdao;
 	NSMutableArray *cdrArgs;
-	NSPipe *stdOut;
+	ToolProcess *query;
 	NSArray *cdrOutput;
 	NSString *outLine;
 
@@ -182,37 +205,23 @@ static CdrdaoController *singleInstance = nil;
 		NS_VALRETURN(nil);
 	NS_ENDHANDLER
 
-	// set up cdrdao task
-	cdrTask = [[NSTask alloc] init];
-	stdOut = [[NSPipe alloc] init];
-
-	[cdrTask setLaunchPath: cdrdao];
-	[cdrTask setArguments: cdrArgs];
-	[cdrTask setStandardOutput: stdOut];
-	[cdrTask setStandardError: stdOut];
+	// set up cdrdao process
+	query = [ToolProcess processWithPath: cdrdao arguments: cdrArgs];
 
 	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
 										cdrdao, [cdrArgs componentsJoinedByString: @" "]] raw: NO];
-	[cdrTask launch];
-
-	[cdrTask waitUntilExit];
+	[query run];
 
 	/*
 	 * If cdrdao did not terminate gracefully we stop the whole affair.
 	 * We delete in any case the actual (not finished) file.
 	 */
-    {
-    	int termStatus = [cdrTask terminationStatus];	// FreeBSD needs an lvalue for the WIF* macros
-    	if ((WIFEXITED(termStatus) == 0)
-    			|| WIFSIGNALED(termStatus)) {
-    		[info setObject: _(@"Unknown") forKey: @"type"];
-    		return info;
-    	}
-    }
+	if (![query exitedNormally]) {
+		[info setObject: _(@"Unknown") forKey: @"type"];
+		return info;
+	}
 
-	cdrOutput = [[[NSString alloc] initWithData: [[stdOut fileHandleForReading] availableData]
-									encoding: NSISOLatin1StringEncoding]
-					componentsSeparatedByString: @"\n"];
+	cdrOutput = [query outputLines];
 
 	count = [cdrOutput count];
 
@@ -285,12 +294,22 @@ static CdrdaoController *singleInstance = nil;
 		}
 	}
 
-	RELEASE(stdOut);
-	RELEASE(cdrTask);
-
 	return info;
 }
 
+- (BOOL) canBurnOnTheFly
+{
+    /*
+     * The TOC file needs real file names.
+     */
+    return NO;
+}
+
+- (id) parallelBurner
+{
+	return AUTORELEASE([[CdrdaoController alloc] initWithBurner: self]);
+}
+
 - (BOOL) isWritableMediumInDevice: (NSString *) device
                        parameters: (NSDictionary *)parameters
 {
@@ -310,7 +329,7 @@ static CdrdaoController *singleInstance = nil;
 {
 	NSString *cdrdao;
 	NSMutableArray *cdrArgs;
-	NSPipe *stdOut;
+	BOOL ret;
 
 	cdrdao = [[parameters objectForKey: @"CdrdaoParameters"]
 					objectForKey: @"Program"];
@@ -330,70 +349,34 @@ static CdrdaoController *singleInstance = nil;
 		NS_VALRETURN(NO);
 	NS_ENDHANDLER
 
-    [cdrArgs addObject: @"--eject"];
+    // Keep the medium if it is going to be burned right away.
+    if (nil == [parameters objectForKey: @"KeepMediumLoaded"]) {
+        [cdrArgs addObject: @"--eject"];
+    }
     [cdrArgs addObject: @"--blank-mode"];
     [cdrArgs addObject: mode==fullBlank?@"full":@"minimal"];
 
-	// set up cdrdao task
-	cdrTask = [[NSTask alloc] init];
-	stdOut = [[NSPipe alloc] init];
-
-	[cdrTask setLaunchPath: cdrdao];
-
-	[cdrTask setArguments: cdrArgs];
-	[cdrTask setStandardOutput: stdOut];
-	[cdrTask setStandardError: stdOut];
+	// set up cdrdao process
+	cdrProcess = [[ToolProcess alloc] initWithPath: cdrdao arguments: cdrArgs];
+	[cdrProcess setDelegate: self];
 
 	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
 										cdrdao, [cdrArgs componentsJoinedByString: @" "]] raw: NO];
 
-	[cdrTask launch];
-
-	// read cdrdao's output and send it to the display
-	while ([cdrTask isRunning]) {
-		NSData *inData;
-        while ((inData = [[[cdrTask standardError] fileHandleForReading] availableData]) &&
-				 [inData length]) {
-			int i, count;
-			NSString *aLine;
-			NSString *temp;
-			NSArray *theOutput;
-
-			temp = [[NSString alloc] initWithData: inData
-									encoding: NSISOLatin1StringEncoding];
-
-			theOutput = [temp componentsSeparatedByString: @"\n"];
-
-			count = [theOutput count];
-
-			for (i = 0; i < count; i++) {
-				aLine = [theOutput objectAtIndex: i];
-				if (aLine && [aLine length]) {
-					// post the oputput to the progress panel
-					[[NSDistributedNotificationCenter defaultCenter]
-								postNotificationName: ExternalToolOutput
-										object: nil
-										userInfo: [NSDictionary dictionaryWithObject: aLine forKey: @"Output"]];
-				}
-			}	// for (i = 0; i < count; i++)
-		}	//  while ((inData = 
-	}	// while ([cdrTask isRunning])
+	// cdrdao's output is sent to the display by toolProcess:didReadLine:
+	[cdrProcess launch];
+	[cdrProcess waitUntilExit];
 
 	/*
 	 * If cdrdao did not terminate gracefully we stop the whole affair.
-	 * We delete in any case the actual (not finished) file.
 	 */
-    {
-    	int termStatus = [cdrTask terminationStatus];	// FreeBSD needs an lvalue for the WIF* macros
-    	if ((WIFEXITED(termStatus) == 0)
-    			|| WIFSIGNALED(termStatus)) {
-    		return NO;
-    	}
-    }
-	RELEASE(stdOut);
-	RELEASE(cdrTask);
+	ret = [cdrProcess exitedNormally];
 
-	return YES;
+	[statusLock lock];
+	DESTROY(cdrProcess);
+	[statusLock unlock];
+
+	return ret;
 }
 
 - (BOOL) burnCDFromImage: (id) image
@@ -403,7 +386,6 @@ static CdrdaoController *singleInstance = nil;
 	BOOL ret = YES;
 	NSString *cdrdao;
 	NSMutableArray *cdrArgs;
-	NSPipe *stdOut;
 	NSString *tocFile;
 
 	if (!image && (!trackArray || ![trackArray count])) {
@@ -443,7 +425,7 @@ static CdrdaoController *singleInstance = nil;
 	// if this was cancelled by the user we stop here
 	if (burnStatus.processStatus == isCancelled) {
 		[fileMan removeFileAtPath: tocFile handler: nil];
-		RELEASE(burnTracks);
+		DESTROY(burnTracks);
 		return NO;
 	}
 
@@ -465,37 +447,30 @@ static CdrdaoController *singleInstance = nil;
 	burnStatus.bufferLevel = 0;
 	burnStatus.processStatus = isWaiting;
 
-	// set up cdrdao task
-	cdrTask = [[NSTask alloc] init];
-	stdOut = [[NSPipe alloc] init];
-
-	[cdrTask setLaunchPath: cdrdao];
-
-	[cdrTask setArguments: cdrArgs];
-	[cdrTask setStandardError: stdOut];
+	// set up cdrdao process
+	cdrProcess = [[ToolProcess alloc] initWithPath: cdrdao arguments: cdrArgs];
+	[cdrProcess setDelegate: self];
 
 	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
 										cdrdao, [cdrArgs componentsJoinedByString: @" "]] raw: NO];
 
-	[cdrTask launch];
-
-	[self waitForEndOfBurning];
+	if ([cdrProcess launch]) {
+		[self waitForEndOfBurning];
+	}
 
 	/*
 	 * If cdrdao did not terminate gracefully we stop the whole affair.
 	 * We delete in any case the actual (not finished) file.
 	 */
-       {
-   		int termStatus = [cdrTask terminationStatus];	// FreeBSD needs an lvalue for the WIF* macros
-   		if ((WIFEXITED(termStatus) == 0)
-   				|| WIFSIGNALED(termStatus)
-   				|| (burnStatus.processStatus == isCancelled)) {
-   			burnStatus.processStatus = isCancelled;
-   			ret = NO;
-   		}
-       } 
-	RELEASE(stdOut);
-	RELEASE(cdrTask);
+	if (![cdrProcess exitedNormally]
+			|| (burnStatus.processStatus == isCancelled)) {
+		burnStatus.processStatus = isCancelled;
+		ret = NO;
+	}
+
+	[statusLock lock];
+	DESTROY(cdrProcess);
+	[statusLock unlock];
 
 	if (burnStatus.processStatus != isCancelled) {
 		[statusLock lock];
@@ -506,7 +481,7 @@ static CdrdaoController *singleInstance = nil;
 	[fileMan removeFileAtPath: tocFile handler: nil];
     RELEASE(tocFile);
 	
-	RELEASE(burnTracks);
+	DESTROY(burnTracks);
 
 	return ret;
 }
@@ -523,20 +498,19 @@ static CdrdaoController *singleInstance = nil;
  
 - (BOOL) stop: (BOOL)immediately
 {
-	if (cdrTask && (burnStatus.processStatus == isBurning)) {
-		[cdrTask terminate];
-		[self sendOutputString: _(@"Terminating process.") raw: NO];
-		burnStatus.processStatus = isCancelled;
-	} else if (cdrTask && (burnStatus.processStatus == isWaiting)) {
-		[cdrTask terminate];
+	[statusLock lock];
+	if (cdrProcess && ((burnStatus.processStatus == isBurning)
+						|| (burnStatus.processStatus == isWaiting))) {
+		[cdrProcess cancel];
 		[self sendOutputString: _(@"Terminating process.") raw: NO];
 		burnStatus.processStatus = isCancelled;
 	} else if (burnStatus.processStatus == isPreparing) {
-		if (cdrTask)
-			[cdrTask terminate];
+		if (cdrProcess)
+			[cdrProcess cancel];
 		[self sendOutputString: _(@"Terminating process.") raw: NO];
 		burnStatus.processStatus = isCancelled;
 	}
+	[statusLock unlock];
 	return YES;
 }
 
@@ -0,0 +1,244 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  FLACToWavController.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <FLAC/metadata.h>
+#include <FLAC/stream_decoder.h>
+
+#include "FLACToWavController.h"
+
+#include "Constants.h"
+#include "Functions.h"
+#include "Track.h"
+
+#ifdef _
+#undef _
+#endif
+
+#define _(X) \
+    [[NSBundle bundleForClass: [FLACToWavController class]] localizedStringForKey:(X) value:@"" table:nil]
+
+
+static FLACToWavController *singleInstance = nil;
+
+/*
+ * The state of one decoder, passed to the libFLAC callbacks.
+ */
+typedef struct {
+    AudioDecodeJob *job;
+    WavWriter *writer;
+    unsigned long long frames;
+    unsigned sampleRate;
+    unsigned channels;
+    BOOL unsupported;
+    BOOL writeFailed;
+    unsigned errors;
+} DecoderContext;
+
+
+static inline int16_t toSample16(FLAC__int32 sample, unsigned bps)
+{
+    if (bps > 16) {
+        // Round to the nearest 16 bit value.
+        unsigned shift = bps - 16;
+        sample = (sample + (1 << (shift - 1))) >> shift;
+        if (sample > 32767)
+            sample = 32767;
+    } else if (bps < 16) {
+        sample <<= 16 - bps;
+    }
+    return (int16_t)sample;
+}
+
+static FLAC__StreamDecoderWriteStatus writeCallback(const FLAC__StreamDecoder *decoder,
+                                                    const FLAC__Frame *frame,
+                                                    const FLAC__int32 * const buffer[],
+                                                    void *clientData)
+{
+    DecoderContext *ctx = (DecoderContext *)clientData;
+    unsigned n = frame->header.blocksize;
+    unsigned bps = frame->header.bits_per_sample;
+    const FLAC__int32 *left, *right;
+    int16_t *out;
+    unsigned i;
+
+    if ([ctx->job isCancelled]) {
+        return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+    }
+
+    /*
+     * We write CD audio. Other rates cannot be converted, yet.
+     */
+    if ((frame->header.sample_rate != 44100)
+            || (frame->header.channels > 2)) {
+        ctx->sampleRate = frame->header.sample_rate;
+        ctx->channels = frame->header.channels;
+        ctx->unsupported = YES;
+        return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+    }
+
+    out = (int16_t *)[ctx->writer bytesForAppending: n * 4];
+    if (NULL == out) {
+        ctx->writeFailed = YES;
+        return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+    }
+
+    // A mono file is written to both channels.
+    left = buffer[0];
+    right = (frame->header.channels == 2) ? buffer[1] : buffer[0];
+
+    if (bps == 16) {
+        for (i = 0; i < n; i++) {
+            out[2*i] = (int16_t)left[i];
+            out[2*i+1] = (int16_t)right[i];
+        }
+    } else {
+        for (i = 0; i < n; i++) {
+            out[2*i] = toSample16(left[i], bps);
+            out[2*i+1] = toSample16(right[i], bps);
+        }
+    }
+    [ctx->writer appendedBytes: n * 4];
+
+    ctx->frames += n;
+    [ctx->job setFramesDone: ctx->frames];
+
+    return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+}
+
+static void errorCallback(const FLAC__StreamDecoder *decoder,
+                          FLAC__StreamDecoderErrorStatus status,
+                          void *clientData)
+{
+    DecoderContext *ctx = (DecoderContext *)clientData;
+
+    /*
+     * libFLAC skips the broken data and goes on. We report the
+     * first error only.
+     */
+    if (0 == ctx->errors++) {
+        logToolOutput([NSString stringWithFormat: _(@"Error in %@: %s"),
+                            [[ctx->job track] source],
+                            FLAC__StreamDecoderErrorStatusString[status]]);
+    }
+}
+
+
+@implementation FLACToWavController
+
++ (id) singleInstance
+{
+    if (! singleInstance) {
+        singleInstance = [[FLACToWavController alloc] init];
+    }
+
+    return singleInstance;
+}
+
+- (void) dealloc
+{
+    singleInstance = nil;
+    [super dealloc];
+}
+
+- (NSString *) name
+{
+    return @"flactowav";
+}
+
+- (NSArray *) fileTypes
+{
+    return [NSArray arrayWithObject: @"flac"];
+}
+
+/**
+ * <p>The duration is taken from the STREAMINFO block, which
+ * holds the number of samples and the sample rate. The file's
+ * audio data is not read.</p>
+ */
+- (long) duration: (NSString *) fileName
+{
+    FLAC__StreamMetadata streamInfo;
+    FLAC__uint64 samples;
+    unsigned rate;
+
+    if (!FLAC__metadata_get_streaminfo([fileName fileSystemRepresentation], &streamInfo)) {
+        return 0;
+    }
+
+    samples = streamInfo.data.stream_info.total_samples;
+    rate = streamInfo.data.stream_info.sample_rate;
+    if (0 == rate) {
+        return 0;
+    }
+    return (long)(samples * FramesPerSecond / rate);
+}
+
+- (BOOL) decodeJob: (AudioDecodeJob *) job
+          toWriter: (WavWriter *) writer
+{
+    BOOL ret = YES;
+    FLAC__StreamDecoder *decoder;
+    FLAC__StreamDecoderInitStatus initStatus;
+    DecoderContext ctx;
+    NSString *source = [[job track] source];
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.job = job;
+    ctx.writer = writer;
+
+    decoder = FLAC__stream_decoder_new();
+    if (NULL == decoder) {
+        return NO;
+    }
+
+    initStatus = FLAC__stream_decoder_init_file(decoder, [source fileSystemRepresentation],
+                                                writeCallback, NULL, errorCallback, &ctx);
+    if (initStatus != FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"Cannot decode %@: %s"),
+                                    source, FLAC__StreamDecoderInitStatusString[initStatus]]];
+        FLAC__stream_decoder_delete(decoder);
+        return NO;
+    }
+
+    if (!FLAC__stream_decoder_process_until_end_of_stream(decoder)) {
+        ret = NO;
+    }
+
+    if (ctx.unsupported) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"Cannot convert %@: %u Hz, %u channels."),
+                                    source, ctx.sampleRate, ctx.channels]];
+    } else if (!ret && !ctx.writeFailed && ![job isCancelled]) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"Cannot decode %@: %s"),
+                                    source, FLAC__stream_decoder_get_resolved_state_string(decoder)]];
+    }
+
+    FLAC__stream_decoder_finish(decoder);
+    FLAC__stream_decoder_delete(decoder);
+
+    return ret && ![job isCancelled];
+}
+
+@end
@@ -0,0 +1,62 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  LibParanoiaController.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef LIBPARANOIACONTROLLER_H_INC
+#define LIBPARANOIACONTROLLER_H_INC
+
+#include <Foundation/Foundation.h>
+
+#include "ExternalTools.h"
+
+@class ParanoiaReader;
+
+/**
+ * <p>LibParanoiaController grabs the tracks of an audio CD with
+ * libcdio-paranoia, without running an external program. The sectors
+ * are read in a thread of their own and written to the .wav file by
+ * the converting thread.</p>
+ * <p>The options DisableParanoia, DisableExtraParanoia and
+ * DisableScratchRepair are taken from the CDparanoiaParameters, so
+ * that they mean the same for both grabbers. MaxRetries in the same
+ * dictionary limits the reads of a sector which does not verify.</p>
+ * <p>When an audio CD is copied on-the-fly, the tracks are streamed
+ * into the burner's FIFOs through a ring of <em>CopyBufferSize</em>
+ * MB, taken from the SessionParameters (64 MB by default).</p>
+ */
+@interface LibParanoiaController : NSObject <BurnTool, AudioConverter, AudioCDStreamer,
+                                        ParallelGrabber, LoudnessMeasurer>
+{
+    ToolStatus ripStatus;
+    NSLock *statusLock;
+
+    ParanoiaReader *reader;
+    NSArray *allTracks;
+    int currentTrack;
+    long trackSectors;
+    volatile long sectorsWritten;
+}
+
+@end
+
+#endif
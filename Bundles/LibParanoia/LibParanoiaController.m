@@ -0,0 +1,632 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  LibParanoiaController.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "LibParanoiaController.h"
+#include "ParanoiaReader.h"
+
+#include "Constants.h"
+#include "Functions.h"
+#include "LoudnessMeter.h"
+#include "Track.h"
+#include "WavWriter.h"
+
+#ifdef _
+#undef _
+#endif
+
+#define _(X) \
+	[[NSBundle bundleForClass: [self class]] localizedStringForKey:(X) value:@"" table:nil]
+
+/* cdparanoia's default for --never-skip */
+#define DEFAULT_RETRIES 20
+
+/* The ring between the drive and the burner when copying on-the-fly, in MB */
+#define DEFAULT_COPY_BUFFER 64
+
+#define CHUNK_BYTES (READER_CHUNK_SECTORS * CDIO_CD_FRAMESIZE_RAW)
+
+
+static LibParanoiaController *singleInstance = nil;
+static NSFileManager *fileMan = nil;
+
+/*
+ * Translates the switches of the CDparanoia bundle the way
+ * cdparanoia does for -Z, -Y and -W. The parameters view stores
+ * them as 0 or 1.
+ */
+static int paranoiaModeForParameters(NSDictionary *cdpDefaults)
+{
+    int mode = PARANOIA_MODE_FULL ^ PARANOIA_MODE_NEVERSKIP;
+
+    if ([[cdpDefaults objectForKey: @"DisableParanoia"] intValue]) {
+        return PARANOIA_MODE_DISABLE;
+    }
+    if ([[cdpDefaults objectForKey: @"DisableExtraParanoia"] intValue]) {
+        mode |= PARANOIA_MODE_OVERLAP;
+        mode &= ~PARANOIA_MODE_VERIFY;
+    }
+    if ([[cdpDefaults objectForKey: @"DisableScratchRepair"] intValue]) {
+        mode &= ~PARANOIA_MODE_REPAIR;
+    }
+    return mode;
+}
+
+@interface LibParanoiaController (Private)
+- (void) sendOutputString: (NSString *) outString;
+- (void) setStatus: (ProcessStatus) status;
+- (BOOL) grabTrack: (Track *) track
+            toFile: (NSString *) fileName
+              mode: (int) mode
+           retries: (int) retries
+        parameters: (NSDictionary *) parameters;
+- (BOOL) writeBytes: (const unsigned char *) bytes
+             length: (size_t) length
+             toFifo: (int) fd;
+@end
+
+//
+// private interface
+//
+
+@implementation LibParanoiaController (Private)
+
+- (void) sendOutputString: (NSString *) outString
+{
+	NSString *outLine;
+
+	outLine = [NSString stringWithFormat: @"**** %@ ****", outString];
+
+	logToolOutput(outLine);
+}
+
+- (void) setStatus: (ProcessStatus) status
+{
+	[statusLock lock];
+	ripStatus.processStatus = status;
+	[statusLock unlock];
+}
+
+/*
+ * Reads one track into fileName. The reader thread fills the ring,
+ * while this thread writes the chunks to the file. The loudness is
+ * measured on the way, like the decoders do it.
+ */
+- (BOOL) grabTrack: (Track *) track
+            toFile: (NSString *) fileName
+              mode: (int) mode
+           retries: (int) retries
+        parameters: (NSDictionary *) parameters
+{
+    int number = [[[track source] substringFromIndex: 14] intValue];
+    WavWriter *writer;
+    ParanoiaStats stats;
+    const unsigned char *data;
+    long n;
+    BOOL ok = YES;
+
+    trackSectors = [reader sectorsOfTrack: number];
+    sectorsWritten = 0;
+    if (trackSectors <= 0) {
+        [self sendOutputString: [NSString stringWithFormat:
+                        _(@"Track %d is not an audio track."), number]];
+        return NO;
+    }
+
+    writer = [[WavWriter alloc] initWithPath: fileName
+                                  sampleRate: 44100
+                                    channels: 2
+                              expectedFrames: trackSectors * CDIO_CD_FRAMESIZE_RAW / 4];
+    if (nil == writer) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"Cannot create %@."), fileName]];
+        return NO;
+    }
+    [LoudnessMeter prepareWriter: writer forTrack: track parameters: parameters];
+
+    [self sendOutputString: [NSString stringWithFormat: _(@"Reading track %d from %@."),
+                                        number, [reader device]]];
+
+    if (![reader startTrack: number mode: mode retries: retries]) {
+        [writer close];
+        RELEASE(writer);
+        return NO;
+    }
+
+    while ((n = [reader nextChunk: &data]) > 0) {
+        unsigned char *out = [writer bytesForAppending: n * CDIO_CD_FRAMESIZE_RAW];
+
+        if (NULL == out) {
+            [reader cancel];
+            ok = NO;
+            break;
+        }
+        memcpy(out, data, n * CDIO_CD_FRAMESIZE_RAW);
+        [writer appendedBytes: n * CDIO_CD_FRAMESIZE_RAW];
+        [reader releaseChunk];
+        sectorsWritten += n;
+    }
+    if (n < 0) {
+        ok = NO;
+    }
+
+    [reader finishTrack];
+    ok = ok && [LoudnessMeter finishWriter: writer forTrack: track parameters: parameters];
+    ok = [writer close] && ok;
+    RELEASE(writer);
+
+    stats = [reader stats];
+    [self sendOutputString: [NSString stringWithFormat:
+                    _(@"Track %d: %ld of %ld sectors, %lu read errors, %lu repaired, %lu skipped."),
+                    number, [reader sectorsRead], trackSectors,
+                    stats.readErrors, stats.fixups, stats.skips]];
+
+    return ok;
+}
+
+/*
+ * The FIFO is non-blocking. While it is full we wait for the burner,
+ * but give up as soon as streaming is stopped. Otherwise a burner
+ * which died would leave us waiting forever.
+ */
+- (BOOL) writeBytes: (const unsigned char *) bytes
+             length: (size_t) length
+             toFifo: (int) fd
+{
+    while (length > 0) {
+        ssize_t n = write(fd, bytes, length);
+
+        if (n > 0) {
+            bytes += n;
+            length -= n;
+        } else if ((n < 0) && (errno == EAGAIN)) {
+            struct pollfd pfd;
+
+            if (ripStatus.processStatus == isCancelled) {
+                return NO;
+            }
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            poll(&pfd, 1, 200);
+        } else if ((n < 0) && (errno != EINTR)) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+@end
+
+//
+// public interface
+//
+
+@implementation LibParanoiaController
+
+- (id) init
+{
+	self = [super init];
+
+	if (self) {
+		if (!fileMan) {
+			fileMan = [NSFileManager defaultManager];
+		}
+		statusLock = [NSLock new];
+	}
+
+	return self;
+}
+
+
+- (void) dealloc
+{
+	if (self == singleInstance) {
+		singleInstance = nil;
+	}
+	RELEASE(statusLock);
+
+	[super dealloc];
+}
+
+//
+// BurnTool methods
+//
+
+- (NSString *) name
+{
+	return @"libparanoia";
+}
+
+- (id<PreferencesModule>) preferences;
+{
+	return nil;
+}
+
+- (id<PreferencesModule>) parameters;
+{
+	return nil;
+}
+
+- (void) cleanUp
+{
+    /*
+     * No need to clean anything, as we forget about what
+     * we ripped.
+     */
+}
+
+
+//
+// class methods
+//
++ (id) singleInstance
+{
+	if (! singleInstance) {
+		singleInstance = [[LibParanoiaController alloc] init];
+	}
+
+	return singleInstance;
+}
+
+
+//
+// AudioConverter methods
+//
+- (BOOL) isCDGrabber
+{
+    return YES;
+}
+
+- (NSArray *) fileTypes
+{
+    return [NSArray arrayWithObject: @"cd"];
+}
+
+
+- (ToolStatus) getStatus
+{
+	ToolStatus status;
+    int count = [allTracks count];
+    Track *track = (currentTrack < count) ? [allTracks objectAtIndex: currentTrack] : nil;
+
+	[statusLock lock];
+    ripStatus.trackName = [track description];
+    if ((track != nil) && (trackSectors > 0))
+        ripStatus.trackProgress = (double)sectorsWritten * 100 / trackSectors;
+    else {
+        ripStatus.trackProgress = 0;
+    }
+    if (count == 0) {
+        ripStatus.entireProgress = 0;
+    } else {
+	    ripStatus.entireProgress = currentTrack * 100 / count;
+        ripStatus.entireProgress += ripStatus.trackProgress / count;
+    }
+
+	status = ripStatus;
+	[statusLock unlock];
+
+	return status;
+}
+
+- (BOOL) convertTracks: (NSArray *)tracks
+	    withParameters: (NSDictionary *) parameters
+{
+	BOOL ret = YES;
+    NSString *device = [parameters objectForKey: @"SourceDevice"];
+    NSDictionary *cdpDefaults = [parameters objectForKey: @"CDparanoiaParameters"];
+    NSDictionary *sesDefaults = [parameters objectForKey: @"SessionParameters"];
+    int mode = paranoiaModeForParameters(cdpDefaults);
+    int retries = DEFAULT_RETRIES;
+    ParanoiaReader *aReader;
+
+    if (nil != [cdpDefaults objectForKey: @"MaxRetries"]) {
+        retries = [[cdpDefaults objectForKey: @"MaxRetries"] intValue];
+    }
+
+    aReader = [[ParanoiaReader alloc] initWithDevice: device];
+    if (nil == aReader) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"Cannot open %@."), device]];
+        return NO;
+    }
+
+    [statusLock lock];
+    reader = aReader;
+    allTracks = tracks;
+    currentTrack = 0;
+    trackSectors = 0;
+    sectorsWritten = 0;
+    ripStatus.entireProgress = 0;
+    ripStatus.trackProgress = 0;
+    ripStatus.processStatus = isConverting;
+    [statusLock unlock];
+
+    for (currentTrack = 0; (currentTrack < [allTracks count]) && (ret != NO); currentTrack++) {
+        Track *track = [tracks objectAtIndex: currentTrack];
+        NSString *fileName;
+
+        fileName = [[sesDefaults objectForKey: @"TempDirectory"] stringByAppendingPathComponent:
+                        [NSString stringWithFormat: @"%@_track%d.wav",
+                            [parameters objectForKey: @"CddbId"],
+                            [[[track source] substringFromIndex: 14] intValue]]];
+        [track setStorage: fileName];
+
+        /*
+         * If the track could not be read completely we stop the whole
+         * affair. The unfinished file is deleted.
+         */
+    	if (![self grabTrack: track toFile: fileName mode: mode retries: retries
+                   parameters: parameters]
+    			|| (ripStatus.processStatus == isCancelled)) {
+    		[self sendOutputString: [NSString stringWithFormat: _(@"Removing temporary file %@."), fileName]];
+    		if (![fileMan removeFileAtPath: fileName handler: nil]) {
+    			[self sendOutputString: _(@"Removing file failed.")];
+    		}
+    		[self setStatus: isCancelled];
+    		ret = NO;
+    	}
+    }
+
+	if (ripStatus.processStatus == isConverting) {
+        [self setStatus: isStopped];
+	}
+
+    [statusLock lock];
+    reader = nil;
+    allTracks = nil;
+    [statusLock unlock];
+    RELEASE(aReader);
+
+	return ret;
+}
+
+//
+// ParallelGrabber methods
+//
+- (id) parallelGrabber
+{
+    return AUTORELEASE([[LibParanoiaController alloc] init]);
+}
+
+//
+// AudioCDStreamer methods
+//
+- (NSArray *) sectorsOfTracks: (NSArray *) tracks
+               withParameters: (NSDictionary *) parameters
+{
+    NSString *device = [parameters objectForKey: @"SourceDevice"];
+    NSMutableArray *sectors = [NSMutableArray arrayWithCapacity: [tracks count]];
+    ParanoiaReader *aReader;
+    int i;
+
+    aReader = [[ParanoiaReader alloc] initWithDevice: device];
+    if (nil == aReader) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"Cannot open %@."), device]];
+        return nil;
+    }
+
+    for (i = 0; i < [tracks count]; i++) {
+        Track *track = [tracks objectAtIndex: i];
+        int number = [[[track source] substringFromIndex: 14] intValue];
+        long n = [aReader sectorsOfTrack: number];
+
+        if (n <= 0) {
+            [self sendOutputString: [NSString stringWithFormat:
+                            _(@"Track %d is not an audio track."), number]];
+            sectors = nil;
+            break;
+        }
+        [sectors addObject: [NSNumber numberWithLong: n]];
+    }
+
+    RELEASE(aReader);
+    return sectors;
+}
+
+/*
+ * The tracks are read in one go into a large ring, so that the
+ * re-reads of a scratched sector do not stall the burner. Each
+ * chunk is swapped to big endian and written to the FIFO of its
+ * track.
+ */
+- (BOOL) streamTracks: (NSArray *) tracks
+       withParameters: (NSDictionary *) parameters
+{
+    BOOL ret = YES;
+    NSString *device = [parameters objectForKey: @"SourceDevice"];
+    NSDictionary *cdpDefaults = [parameters objectForKey: @"CDparanoiaParameters"];
+    NSDictionary *sesDefaults = [parameters objectForKey: @"SessionParameters"];
+    int mode = paranoiaModeForParameters(cdpDefaults);
+    int retries = DEFAULT_RETRIES;
+    int bufferSize = DEFAULT_COPY_BUFFER;
+    int count = [tracks count];
+    NSMutableArray *numbers = [NSMutableArray arrayWithCapacity: count];
+    const unsigned char *data;
+    uint16_t *swapped;
+    int *fds;
+    int i, index;
+    long n;
+    ParanoiaStats stats;
+    ParanoiaReader *aReader;
+
+    if (nil != [cdpDefaults objectForKey: @"MaxRetries"]) {
+        retries = [[cdpDefaults objectForKey: @"MaxRetries"] intValue];
+    }
+    if ([[sesDefaults objectForKey: @"CopyBufferSize"] intValue] > 0) {
+        bufferSize = [[sesDefaults objectForKey: @"CopyBufferSize"] intValue];
+    }
+    if (count == 0) {
+        return YES;
+    }
+
+    aReader = [[ParanoiaReader alloc] initWithDevice: device
+                                              chunks: bufferSize * 1024 * 1024 / CHUNK_BYTES];
+    if (nil == aReader) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"Cannot open %@."), device]];
+        return NO;
+    }
+
+    swapped = malloc(CHUNK_BYTES);
+    fds = malloc(count * sizeof(int));
+    if ((NULL == swapped) || (NULL == fds)) {
+        free(swapped);
+        free(fds);
+        RELEASE(aReader);
+        return NO;
+    }
+    for (i = 0; i < count; i++) {
+        Track *track = [tracks objectAtIndex: i];
+
+        [numbers addObject: [NSNumber numberWithInt:
+                                [[[track source] substringFromIndex: 14] intValue]]];
+        /*
+         * Opening a FIFO for reading and writing does not block on
+         * Linux, whether the burner has opened it yet or not. cdrecord
+         * opens all track files before it writes the first one, so
+         * opening them one by one for writing only would dead-lock.
+         * The burner must not inherit them, or it would never see the
+         * end of a track we could not read.
+         */
+        fds[i] = open([[track storage] fileSystemRepresentation],
+                      O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fds[i] < 0) {
+            [self sendOutputString: [NSString stringWithFormat: _(@"Cannot open %@."),
+                                                [track storage]]];
+            ret = NO;
+        }
+    }
+
+    [statusLock lock];
+    reader = aReader;
+    allTracks = tracks;
+    currentTrack = 0;
+    trackSectors = [aReader sectorsOfTrack: [[numbers objectAtIndex: 0] intValue]];
+    sectorsWritten = 0;
+    ripStatus.entireProgress = 0;
+    ripStatus.trackProgress = 0;
+    ripStatus.processStatus = isConverting;
+    [statusLock unlock];
+
+    if (!ret || ![aReader startTracks: numbers mode: mode retries: retries]) {
+        ret = NO;
+    } else {
+        [self sendOutputString: [NSString stringWithFormat:
+                        _(@"Copying %d tracks from %@ on-the-fly with a %d MB buffer."),
+                        count, device, bufferSize]];
+
+        while ((n = [aReader nextChunk: &data track: &index]) > 0) {
+            const uint16_t *samples = (const uint16_t *)data;
+            long j, words = n * CDIO_CD_FRAMESIZE_RAW / 2;
+
+            if (index != currentTrack) {
+                [statusLock lock];
+                currentTrack = index;
+                trackSectors = [aReader sectorsOfTrack: [[numbers objectAtIndex: index] intValue]];
+                sectorsWritten = 0;
+                [statusLock unlock];
+            }
+
+            for (j = 0; j < words; j++) {
+                swapped[j] = NSSwapHostShortToBig(samples[j]);
+            }
+            if (![self writeBytes: (const unsigned char *)swapped
+                           length: n * CDIO_CD_FRAMESIZE_RAW
+                           toFifo: fds[index]]) {
+                [aReader cancel];
+                n = -1;
+                break;
+            }
+            [aReader releaseChunk];
+            sectorsWritten += n;
+        }
+        if (n < 0) {
+            ret = NO;
+        }
+        [aReader finishTrack];
+
+        stats = [aReader stats];
+        [self sendOutputString: [NSString stringWithFormat:
+                        _(@"%ld sectors, %lu read errors, %lu repaired, %lu skipped."),
+                        [aReader sectorsRead], stats.readErrors, stats.fixups, stats.skips]];
+    }
+
+    /*
+     * The burner keeps what is still in the FIFOs. If we failed, it
+     * sees the end of a track too early and gives up.
+     */
+    for (i = 0; i < count; i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+    free(fds);
+    free(swapped);
+
+    if (!ret || (ripStatus.processStatus == isCancelled)) {
+        [self setStatus: isCancelled];
+        ret = NO;
+    } else {
+        [self setStatus: isStopped];
+    }
+
+    [statusLock lock];
+    reader = nil;
+    allTracks = nil;
+    [statusLock unlock];
+    RELEASE(aReader);
+
+    return ret;
+}
+
+- (BOOL) stop: (BOOL)immediately
+{
+	[statusLock lock];
+	if ((nil != reader) && (ripStatus.processStatus == isConverting)) {
+		[self sendOutputString: _(@"Terminating process.")];
+		ripStatus.processStatus = isCancelled;
+		[reader cancel];
+	}
+	[statusLock unlock];
+	return YES;
+}
+
+- (long) duration: (NSString *)fileName
+{
+    return 0;
+}
+
+- (NSArray *) durations: (NSArray *) fileNames
+{
+    return probeDurations(self, fileNames);
+}
+
+- (unsigned) size: (NSString *)fileName
+{
+    return 0;
+}
+
+@end
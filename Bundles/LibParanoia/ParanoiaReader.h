@@ -0,0 +1,177 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ParanoiaReader.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef PARANOIAREADER_H_INC
+#define PARANOIAREADER_H_INC
+
+#include <Foundation/Foundation.h>
+
+#include <cdio/cdio.h>
+#include <cdio/paranoia/cdda.h>
+#include <cdio/paranoia/paranoia.h>
+
+/* One second of audio, the unit handed from the reader to the writer */
+#define READER_CHUNK_SECTORS 75
+/* The default number of chunks buffered between the reader and the writer */
+#define READER_CHUNKS 8
+
+/**
+ * <p>The counters the paranoia callback keeps while a track is read.</p>
+ */
+typedef struct {
+    unsigned long readErrors;
+    unsigned long fixups;
+    unsigned long skips;
+} ParanoiaStats;
+
+/**
+ * <p>ParanoiaReader reads the audio tracks of one drive with
+ * libcdio-paranoia. <var>device</var> may be a device node or a disc
+ * image, e.g. a .cue or .toc file, which libcdio opens with its image
+ * drivers.</p>
+ * <p>-startTrack:... starts a reader thread, which puts the sectors
+ * into a ring of READER_CHUNKS chunks. The caller takes them with
+ * -nextChunk: and gives them back with -releaseChunk. Thus, reading
+ * the drive and writing the file overlap, while the memory used stays
+ * bounded.</p>
+ * <p>-startTracks:... reads several tracks in one go. The reader then
+ * goes on with the next track while the caller still works on the
+ * previous one, so a large ring never runs dry at a track
+ * boundary.</p>
+ */
+@interface ParanoiaReader : NSObject
+{
+    NSString *device;
+    CdIo_t *cdio;
+    cdrom_drive_t *drive;
+    cdrom_paranoia_t *paranoia;
+
+    NSCondition *ringLock;
+    unsigned char *ring;
+    int chunks;
+    long *chunkSectors;
+    int *chunkTracks;
+    int head;
+    int fill;
+    BOOL readerDone;
+    BOOL readerFailed;
+    BOOL readerRunning;
+    volatile BOOL cancelled;
+
+    lsn_t *firstSectors;
+    lsn_t *lastSectors;
+    int trackCount;
+    volatile long sectorsRead;
+    int paranoiaMode;
+    int maxRetries;
+    ParanoiaStats stats;
+}
+
+/**
+ * <p>Opens the drive or image <var>aDevice</var>. Returns nil if it
+ * cannot be opened or holds no audio CD.</p>
+ */
+- (id) initWithDevice: (NSString *) aDevice;
+
+/**
+ * <p>Like -initWithDevice:, but the ring holds <var>count</var>
+ * chunks of READER_CHUNK_SECTORS sectors each.</p>
+ */
+- (id) initWithDevice: (NSString *) aDevice
+               chunks: (int) count;
+
+- (NSString *) device;
+
+/**
+ * <p>Returns the number of sectors of track <var>track</var> or -1
+ * if it is no audio track.</p>
+ */
+- (long) sectorsOfTrack: (int) track;
+
+/**
+ * <p>Starts reading track <var>track</var> in a new thread.
+ * <var>mode</var> holds the PARANOIA_MODE_* flags.
+ * <var>retries</var> limits the reads of a sector which does not
+ * verify. Returns NO if the track cannot be read.</p>
+ */
+- (BOOL) startTrack: (int) track
+               mode: (int) mode
+            retries: (int) retries;
+
+/**
+ * <p>Starts reading the tracks whose numbers are in <var>tracks</var>
+ * one after the other in a new thread. A chunk never holds sectors of
+ * two tracks.</p>
+ */
+- (BOOL) startTracks: (NSArray *) tracks
+                mode: (int) mode
+             retries: (int) retries;
+
+/**
+ * <p>Waits for the next chunk of the track and sets <var>data</var>
+ * to its samples, in native byte order. Returns the number of sectors
+ * in the chunk, 0 at the end of the track and -1 if reading failed or
+ * was cancelled.</p>
+ */
+- (long) nextChunk: (const unsigned char **) data;
+
+/**
+ * <p>Like -nextChunk:, but also sets <var>index</var> to the index of
+ * the chunk's track in the array passed to -startTracks:... Returns 0
+ * after the last track.</p>
+ */
+- (long) nextChunk: (const unsigned char **) data
+             track: (int *) index;
+
+/**
+ * <p>Gives the chunk returned by -nextChunk: back to the reader.</p>
+ */
+- (void) releaseChunk;
+
+/**
+ * <p>Waits until the reader thread has finished. Must be called after
+ * each track or list of tracks, before the next one is started.</p>
+ */
+- (void) finishTrack;
+
+/**
+ * <p>Stops reading. May be called from any thread.</p>
+ */
+- (void) cancel;
+
+/**
+ * <p>Returns the number of sectors the reader thread has read so far
+ * of the current track or tracks.</p>
+ */
+- (long) sectorsRead;
+
+/**
+ * <p>Returns the counts of read errors, repaired sectors and skipped
+ * sectors for the current track or tracks.</p>
+ */
+- (ParanoiaStats) stats;
+
+@end
+
+#endif
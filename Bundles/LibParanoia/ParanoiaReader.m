@@ -0,0 +1,352 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ParanoiaReader.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ParanoiaReader.h"
+
+#define CHUNK_BYTES (READER_CHUNK_SECTORS * CDIO_CD_FRAMESIZE_RAW)
+
+
+/*
+ * The paranoia callback gets no context. Each reader thread points
+ * this to the counters of its own reader, so that several drives may
+ * be read at the same time.
+ */
+static __thread ParanoiaStats *threadStats = NULL;
+
+static void paranoiaCallback(long int inpos, paranoia_cb_mode_t mode)
+{
+    if (NULL == threadStats) {
+        return;
+    }
+
+    switch (mode) {
+    case PARANOIA_CB_READERR:
+        threadStats->readErrors++;
+        break;
+    case PARANOIA_CB_SKIP:
+        threadStats->skips++;
+        break;
+    case PARANOIA_CB_FIXUP_EDGE:
+    case PARANOIA_CB_FIXUP_ATOM:
+    case PARANOIA_CB_FIXUP_DROPPED:
+    case PARANOIA_CB_FIXUP_DUPED:
+    case PARANOIA_CB_SCRATCH:
+    case PARANOIA_CB_REPAIR:
+        threadStats->fixups++;
+        break;
+    default:
+        break;
+    }
+}
+
+
+@interface ParanoiaReader (Private)
+- (void) readerThread: (id) anObject;
+@end
+
+@implementation ParanoiaReader (Private)
+
+- (void) readerThread: (id) anObject
+{
+    id pool = [NSAutoreleasePool new];
+    BOOL failed = NO;
+    int t;
+
+    threadStats = &stats;
+
+    cdio_paranoia_modeset(paranoia, paranoiaMode);
+
+    for (t = 0; (t < trackCount) && !failed && !cancelled; t++) {
+        lsn_t sector = firstSectors[t];
+
+        cdio_paranoia_seek(paranoia, sector, SEEK_SET);
+
+        while ((sector <= lastSectors[t]) && !failed) {
+            unsigned char *chunk;
+            long n = 0;
+            int slot;
+
+            [ringLock lock];
+            while ((fill == chunks) && !cancelled) {
+                [ringLock wait];
+            }
+            // The slot after the filled ones belongs to the reader alone.
+            slot = (head + fill) % chunks;
+            [ringLock unlock];
+
+            if (cancelled) {
+                break;
+            }
+
+            chunk = ring + (size_t)slot * CHUNK_BYTES;
+            while ((n < READER_CHUNK_SECTORS) && (sector <= lastSectors[t]) && !cancelled) {
+                int16_t *samples = cdio_paranoia_read_limited(paranoia, paranoiaCallback,
+                                                              maxRetries);
+
+                if (NULL == samples) {
+                    failed = YES;
+                    break;
+                }
+                memcpy(chunk + n * CDIO_CD_FRAMESIZE_RAW, samples, CDIO_CD_FRAMESIZE_RAW);
+                n++;
+                sector++;
+                sectorsRead++;
+            }
+
+            [ringLock lock];
+            if (failed) {
+                readerFailed = YES;
+            } else if (n > 0) {
+                chunkSectors[slot] = n;
+                chunkTracks[slot] = t;
+                fill++;
+            }
+            [ringLock broadcast];
+            [ringLock unlock];
+        }
+    }
+
+    threadStats = NULL;
+
+    [ringLock lock];
+    readerDone = YES;
+    readerRunning = NO;
+    [ringLock broadcast];
+    [ringLock unlock];
+
+    RELEASE(pool);
+}
+
+@end
+
+
+@implementation ParanoiaReader
+
+- (id) initWithDevice: (NSString *) aDevice
+{
+    return [self initWithDevice: aDevice chunks: READER_CHUNKS];
+}
+
+- (id) initWithDevice: (NSString *) aDevice
+               chunks: (int) count
+{
+    self = [super init];
+    if (nil == self) {
+        return nil;
+    }
+
+    device = [aDevice copy];
+    ringLock = [NSCondition new];
+    readerRunning = NO;
+    cancelled = NO;
+
+    /*
+     * cdio_open() recognizes disc images by their contents, so a .cue
+     * or .toc file may be read just like a drive.
+     */
+    cdio = cdio_open([aDevice fileSystemRepresentation], DRIVER_UNKNOWN);
+    if (NULL != cdio) {
+        drive = cdio_cddap_identify_cdio(cdio, CDDA_MESSAGE_FORGETIT, NULL);
+    }
+    if ((NULL == drive) || (cdio_cddap_open(drive) != 0)) {
+        DESTROY(self);
+        return nil;
+    }
+    cdio_cddap_verbose_set(drive, CDDA_MESSAGE_FORGETIT, CDDA_MESSAGE_FORGETIT);
+
+    paranoia = cdio_paranoia_init(drive);
+    chunks = (count > 0) ? count : READER_CHUNKS;
+    ring = malloc((size_t)chunks * CHUNK_BYTES);
+    chunkSectors = malloc(chunks * sizeof(long));
+    chunkTracks = malloc(chunks * sizeof(int));
+    if ((NULL == paranoia) || (NULL == ring)
+            || (NULL == chunkSectors) || (NULL == chunkTracks)) {
+        DESTROY(self);
+        return nil;
+    }
+
+    return self;
+}
+
+- (void) dealloc
+{
+    if (NULL != paranoia) {
+        cdio_paranoia_free(paranoia);
+    }
+    if (NULL != drive) {
+        cdio_cddap_close_no_free_cdio(drive);
+    }
+    if (NULL != cdio) {
+        cdio_destroy(cdio);
+    }
+    free(ring);
+    free(chunkSectors);
+    free(chunkTracks);
+    free(firstSectors);
+    free(lastSectors);
+    RELEASE(ringLock);
+    RELEASE(device);
+    [super dealloc];
+}
+
+- (NSString *) device
+{
+    return device;
+}
+
+- (long) sectorsOfTrack: (int) track
+{
+    if ((track < 1) || (track > cdio_cddap_tracks(drive))
+            || !cdio_cddap_track_audiop(drive, track)) {
+        return -1;
+    }
+    return cdio_cddap_track_lastsector(drive, track)
+        - cdio_cddap_track_firstsector(drive, track) + 1;
+}
+
+- (BOOL) startTrack: (int) track
+               mode: (int) mode
+            retries: (int) retries
+{
+    return [self startTracks: [NSArray arrayWithObject: [NSNumber numberWithInt: track]]
+                        mode: mode
+                     retries: retries];
+}
+
+- (BOOL) startTracks: (NSArray *) tracks
+                mode: (int) mode
+             retries: (int) retries
+{
+    int i, count = [tracks count];
+
+    if (cancelled || readerRunning || (count == 0)) {
+        return NO;
+    }
+    for (i = 0; i < count; i++) {
+        if ([self sectorsOfTrack: [[tracks objectAtIndex: i] intValue]] <= 0) {
+            return NO;
+        }
+    }
+
+    free(firstSectors);
+    free(lastSectors);
+    firstSectors = malloc(count * sizeof(lsn_t));
+    lastSectors = malloc(count * sizeof(lsn_t));
+    if ((NULL == firstSectors) || (NULL == lastSectors)) {
+        return NO;
+    }
+    for (i = 0; i < count; i++) {
+        int track = [[tracks objectAtIndex: i] intValue];
+
+        firstSectors[i] = cdio_cddap_track_firstsector(drive, track);
+        lastSectors[i] = cdio_cddap_track_lastsector(drive, track);
+    }
+    trackCount = count;
+    paranoiaMode = mode;
+    maxRetries = retries;
+
+    head = 0;
+    fill = 0;
+    readerDone = NO;
+    readerFailed = NO;
+    readerRunning = YES;
+    sectorsRead = 0;
+    memset(&stats, 0, sizeof(stats));
+
+    [NSThread detachNewThreadSelector: @selector(readerThread:)
+                             toTarget: self
+                           withObject: nil];
+    return YES;
+}
+
+- (long) nextChunk: (const unsigned char **) data
+{
+    return [self nextChunk: data track: NULL];
+}
+
+- (long) nextChunk: (const unsigned char **) data
+             track: (int *) index
+{
+    long n;
+
+    [ringLock lock];
+    while ((fill == 0) && !readerDone && !readerFailed && !cancelled) {
+        [ringLock wait];
+    }
+    if (cancelled || readerFailed) {
+        n = -1;
+    } else if (fill == 0) {
+        n = 0;
+    } else {
+        *data = ring + (size_t)head * CHUNK_BYTES;
+        n = chunkSectors[head];
+        if (NULL != index) {
+            *index = chunkTracks[head];
+        }
+    }
+    [ringLock unlock];
+
+    return n;
+}
+
+- (void) releaseChunk
+{
+    [ringLock lock];
+    head = (head + 1) % chunks;
+    fill--;
+    [ringLock broadcast];
+    [ringLock unlock];
+}
+
+- (void) finishTrack
+{
+    [ringLock lock];
+    while (readerRunning) {
+        [ringLock wait];
+    }
+    [ringLock unlock];
+}
+
+- (void) cancel
+{
+    [ringLock lock];
+    cancelled = YES;
+    [ringLock broadcast];
+    [ringLock unlock];
+}
+
+- (long) sectorsRead
+{
+    return sectorsRead;
+}
+
+- (ParanoiaStats) stats
+{
+    return stats;
+}
+
+@end
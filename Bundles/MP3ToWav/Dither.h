@@ -0,0 +1,59 @@
+/* vim: set ft=objc ts=4 nowrap: */
+/*
+ *  Dither.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef DITHER_H_INC
+#define DITHER_H_INC
+
+#include <mad.h>
+
+/*
+ * The state of the noise shaping and of the random number generator
+ * for one channel.
+ */
+struct audio_dither {
+  mad_fixed_t error[3];
+  mad_fixed_t random;
+};
+
+/*
+ * Quantizes a single sample to the given number of bits. This is the
+ * reference implementation. dither_pcm16() gives exactly the same
+ * results for 16 bits.
+ */
+signed long audio_linear_dither(unsigned int bits, mad_fixed_t sample,
+                                struct audio_dither *dither);
+
+/*
+ * Quantizes and dithers a whole block of decoded samples to 16 bits
+ * and stores them as interleaved stereo in native byte order. A mono
+ * block is written to both channels. Each channel has its own dither
+ * state. out must have room for 4 * pcm->length bytes. Returns the
+ * number of bytes written.
+ *
+ * When built with -DDITHER_REFERENCE each sample is passed through
+ * audio_linear_dither() instead.
+ */
+unsigned dither_pcm16(struct mad_pcm const *pcm, struct audio_dither dither[2],
+                      unsigned char *out);
+
+#endif
@@ -0,0 +1,224 @@
+/* vim: set ft=objc ts=4 nowrap: */
+/*
+ *  Dither.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdint.h>
+
+#include "Dither.h"
+
+enum {
+  MIN = -MAD_F_ONE,
+  MAX =  MAD_F_ONE - 1
+};
+
+/* The following two routines are from the ever-brilliant Rob Leslie. */
+
+/*
+* NAME:        prng()
+* DESCRIPTION: 32-bit pseudo-random number generator
+*/
+static inline
+unsigned long prng(unsigned long state)
+{
+  return (state * 0x0019660dL + 0x3c6ef35fL) & 0xffffffffL;
+}
+
+/*
+* NAME:        audio_linear_dither()
+* DESCRIPTION: generic linear sample quantize and dither routine
+*/
+signed long audio_linear_dither(unsigned int bits, mad_fixed_t sample,
+                                struct audio_dither *dither)
+{
+  unsigned int scalebits;
+  mad_fixed_t output, mask, random;
+
+  /* noise shape */
+  sample += dither->error[0] - dither->error[1] + dither->error[2];
+
+  dither->error[2] = dither->error[1];
+  dither->error[1] = dither->error[0] / 2;
+
+  /* bias */
+  output = sample + (1L << (MAD_F_FRACBITS + 1 - bits - 1));
+
+  scalebits = MAD_F_FRACBITS + 1 - bits;
+  mask = (1L << scalebits) - 1;
+
+  /* dither */
+  random  = prng(dither->random);
+  output += (random & mask) - (dither->random & mask);
+
+  dither->random = random;
+
+  /* clip */
+  if (output > MAX) {
+    output = MAX;
+
+    if (sample > MAX)
+      sample = MAX;
+  }
+  else if (output < MIN) {
+    output = MIN;
+
+    if (sample < MIN)
+      sample = MIN;
+  }
+
+  /* quantize */
+  output &= ~mask;
+
+  /* error feedback */
+  dither->error[0] = sample - output;
+
+  /* scale */
+  return output >> scalebits;
+}
+
+#ifndef DITHER_REFERENCE
+
+#define SCALEBITS_16 (MAD_F_FRACBITS + 1 - 16)
+#define MASK_16 ((1L << SCALEBITS_16) - 1)
+#define BIAS_16 (1L << (SCALEBITS_16 - 1))
+
+/*
+ * The state of one channel, kept in registers while a block is
+ * processed.
+ */
+typedef struct {
+  mad_fixed_t e0, e1, e2;
+  mad_fixed_t random;
+} dither_state;
+
+/*
+ * audio_linear_dither() for 16 bits with the constants folded in.
+ * The error feedback makes each sample depend on the previous one,
+ * so a channel cannot be split across vector lanes. Interleaving the
+ * two independent channels in one loop keeps the CPU busy instead.
+ */
+static inline
+int16_t dither16(mad_fixed_t sample, dither_state *d)
+{
+  mad_fixed_t output, random;
+
+  sample += d->e0 - d->e1 + d->e2;
+  d->e2 = d->e1;
+  d->e1 = d->e0 / 2;
+
+  random = (mad_fixed_t)prng(d->random);
+  output = sample + BIAS_16 + (random & MASK_16) - (d->random & MASK_16);
+  d->random = random;
+
+  /* Clipping is rare, so the branches are well predicted. */
+  if (output > MAX) {
+    output = MAX;
+    if (sample > MAX)
+      sample = MAX;
+  }
+  else if (output < MIN) {
+    output = MIN;
+    if (sample < MIN)
+      sample = MIN;
+  }
+
+  output &= ~MASK_16;
+  d->e0 = sample - output;
+
+  return (int16_t)(output >> SCALEBITS_16);
+}
+
+static inline
+void load_state(dither_state *d, struct audio_dither const *dither)
+{
+  d->e0 = dither->error[0];
+  d->e1 = dither->error[1];
+  d->e2 = dither->error[2];
+  d->random = dither->random;
+}
+
+static inline
+void store_state(struct audio_dither *dither, dither_state const *d)
+{
+  dither->error[0] = d->e0;
+  dither->error[1] = d->e1;
+  dither->error[2] = d->e2;
+  dither->random = d->random;
+}
+
+unsigned dither_pcm16(struct mad_pcm const *pcm, struct audio_dither dither[2],
+                      unsigned char *out)
+{
+  unsigned nsamples = pcm->length;
+  mad_fixed_t const *left_ch = pcm->samples[0];
+  int16_t *ptr = (int16_t *)out;
+  dither_state left;
+  unsigned i;
+
+  load_state(&left, &dither[0]);
+
+  if (pcm->channels == 2) {
+    mad_fixed_t const *right_ch = pcm->samples[1];
+    dither_state right;
+
+    load_state(&right, &dither[1]);
+    for (i = 0; i < nsamples; i++) {
+      ptr[2*i]   = dither16(left_ch[i], &left);
+      ptr[2*i+1] = dither16(right_ch[i], &right);
+    }
+    store_state(&dither[1], &right);
+  } else {
+    /* Just duplicate the sample across both channels. */
+    for (i = 0; i < nsamples; i++) {
+      int16_t sample = dither16(left_ch[i], &left);
+      ptr[2*i]   = sample;
+      ptr[2*i+1] = sample;
+    }
+  }
+  store_state(&dither[0], &left);
+
+  return nsamples * 4;
+}
+
+#else
+
+unsigned dither_pcm16(struct mad_pcm const *pcm, struct audio_dither dither[2],
+                      unsigned char *out)
+{
+  unsigned nsamples = pcm->length;
+  mad_fixed_t const *left_ch = pcm->samples[0];
+  mad_fixed_t const *right_ch = pcm->samples[1];
+  int16_t *ptr = (int16_t *)out;
+
+  while (nsamples--) {
+    int16_t sample = (int16_t)audio_linear_dither(16, *left_ch++, &dither[0]);
+
+    *ptr++ = sample;
+    if (pcm->channels == 2) {
+      sample = (int16_t)audio_linear_dither(16, *right_ch++, &dither[1]);
+    }
+    *ptr++ = sample;
+  }
+
+  return pcm->length * 4;
+}
+
+#endif
@@ -28,20 +28,14 @@
 
 #include <Foundation/Foundation.h>
 
-#include "ExternalTools.h"
+#include "ParallelConverter.h"
 #include "PlayBuffer.h"
 
-@interface MP3ToWavController : NSObject <BurnTool, AudioConverter>
-{
-	ToolStatus convStatus;
-	NSLock *statusLock;
-
-	NSArray *allTracks;
-	unsigned long trackSize;
-
-	PlayBuffer *playBuffer;
-}
-
+/*
+ * The tracks are decoded by the worker threads of ParallelConverter,
+ * each one running its own decoder.
+ */
+@interface MP3ToWavController : ParallelConverter <LoudnessMeasurer>
 @end
 
 #endif
@@ -22,8 +22,6 @@
  */
 
 #include <sys/types.h>
-#include <sys/wait.h>
-#include <ao/ao.h>
 
 #include "MP3ToWavController.h"
 #include "MadFunctions.h"
@@ -43,104 +41,172 @@
 
 static MP3ToWavController *singleInstance = nil;
 
-@interface MP3ToWavController (Private)
-- (void) sendOutputString: (NSString *) outString;
-- (void) setStatus: (ProcessStatus) status;
-- (NSString *) makeOutfileNameForTrack: (NSString *)trackName
-                               tempDir: (NSString *)tempDir;
-@end
-
-//
-// private interface
-//
+/*
+ * A track is not split into parts shorter than a minute.
+ */
+#define MIN_PART_DURATION (60 * FramesPerSecond)
 
-@implementation MP3ToWavController (Private)
 
-- (NSString *) makeOutfileNameForTrack: (NSString *)trackName
-                               tempDir: (NSString *)tempDir
+/**
+ * <p>MP3DecodeJob adds the decoder of a track and the number of parts
+ * it is decoded in.</p>
+ */
+@interface MP3DecodeJob : ConversionJob
 {
-	NSString *outName;
-    NSString *baseName = [[trackName lastPathComponent] stringByDeletingPathExtension];
-
-	outName = [tempDir stringByAppendingPathComponent:
-                           [NSString stringWithFormat: @"%@.wav", baseName]];
-
-	return outName;
+@public
+	PlayBuffer *buffer;
+	int parts;
 }
+@end
 
-- (void) sendOutputString: (NSString *) outString
-{
-	NSString *outLine;
-
-	outLine = [NSString stringWithFormat: @"%@", outString];
+@implementation MP3DecodeJob
 
-	[[NSDistributedNotificationCenter defaultCenter]
-					postNotificationName: ExternalToolOutput
-					object: nil
-					userInfo: [NSDictionary dictionaryWithObject: outLine forKey: @"Output"]];
+- (id) initWithTrack: (Track *)aTrack outFile: (NSString *)aFile
+{
+	self = [super initWithTrack: aTrack outFile: aFile];
+	if (self) {
+		buffer = nil;
+		parts = 1;
+	}
+	return self;
 }
 
-- (void) setStatus: (ProcessStatus) status
+- (void) dealloc
 {
-	[statusLock lock];
-	convStatus.processStatus = status;
-	[statusLock unlock];
+	RELEASE(buffer);
+	[super dealloc];
 }
 
 @end
 
+
 //
 // public interface
 //
 
 @implementation MP3ToWavController
 
-- (id) init
+- (void) dealloc
 {
-	self = [super init];
+	singleInstance = nil;
+	[super dealloc];
+}
 
-	if (self) {
-		statusLock = [NSLock new];
-        playBuffer = nil;
-	}
+//
+// ParallelConverter methods
+//
 
-	return self;
++ (Class) jobClass
+{
+	return [MP3DecodeJob class];
 }
 
-
-- (void) dealloc
+/*
+ * With fewer tracks than jobs, the tracks are decoded in several
+ * parts at once, so that a single long track does not keep all
+ * but one processor idle. The longest tracks get the most parts.
+ */
+- (void) prepareJobs
 {
-	singleInstance = nil;
-	RELEASE(statusLock);
+	int i, jobs = numberOfJobs(convParameters);
+	int count = [allJobs count];
 
-	[super dealloc];
+	if ((count > 0) && (count < jobs)) {
+		for (i = 0; i < count; i++) {
+			MP3DecodeJob *job = [allJobs objectAtIndex: i];
+			int parts = jobs / count + ((i < jobs % count) ? 1 : 0);
+
+			job->parts = MAX(1, MIN(parts, (int)(job->duration / MIN_PART_DURATION)));
+		}
+	}
 }
 
-//
-// BurnTool methods
-//
+- (BOOL) runJob: (ConversionJob *) aJob
+{
+	MP3DecodeJob *job = (MP3DecodeJob *)aJob;
+	BOOL ret = YES;
+	NSString *error;
+	PlayBuffer *buffer;
+	struct mad_decoder decoder;
+
+	[self sendOutputString: [NSString stringWithFormat: _(@"Converting track %@ to %@"),
+									[job->track description], job->outFile]];
+
+	buffer = [PlayBuffer new];
+	[buffer setResampleQuality: [Resampler qualityForParameters: convParameters]];
+	[buffer setTrack: job->track parameters: convParameters];
+	error = [buffer setInFile: [job->track source] outFile: job->outFile];
+	if (nil != error) {
+		[self sendOutputString: error];
+		ret = NO;
+	}
 
-- (NSString *) name
+	/*
+	 * Publish the buffer while holding the lock, so that -stop: either
+	 * sees the buffer or we see the cancelled state.
+	 */
+	[statusLock lock];
+	if (convStatus.processStatus == isConverting) {
+		job->buffer = RETAIN(buffer);
+	} else {
+		ret = NO;
+	}
+	[statusLock unlock];
+
+	if (ret) {
+		if (job->parts > 1) {
+			[self sendOutputString: [NSString stringWithFormat: _(@"Decoding %@ in %d parts."),
+											[job->track description], job->parts]];
+
+			if (![buffer decodeInParts: job->parts] || [buffer isStopped]) {
+				ret = NO;
+			}
+		} else {
+			mad_decoder_init(&decoder, buffer, read_from_mmap, read_header, /*filter*/0,
+								output, /*error*/0, /* message */ 0);
+
+			if ((mad_decoder_run(&decoder, MAD_DECODER_MODE_SYNC) != 0)
+					|| [buffer isStopped]) {
+				ret = NO;
+			}
+
+			mad_decoder_finish(&decoder);
+		}
+
+		if (![buffer closeOutput: ret] && ret) {
+			[self sendOutputString: [NSString stringWithFormat: _(@"Could not write %@."),
+											job->outFile]];
+			ret = NO;
+		}
+	}
+	RELEASE(buffer);
+
+	return ret;
+}
+
+- (void) cancelJob: (ConversionJob *) job
 {
-	return @"mp3towav";
+	[super cancelJob: job];
+	[((MP3DecodeJob *)job)->buffer stop];
 }
 
-- (id<PreferencesModule>) preferences;
+- (double) progressOfJob: (ConversionJob *) job
 {
-	return nil;
+	return [((MP3DecodeJob *)job)->buffer percentDone];
 }
 
-- (id<PreferencesModule>) parameters;
+- (void) finishJob: (ConversionJob *) job
 {
-	return nil;
+	DESTROY(((MP3DecodeJob *)job)->buffer);
 }
 
-- (void) cleanUp
+//
+// BurnTool methods
+//
+
+- (NSString *) name
 {
-    /*
-     * No need to clean anything, as we forget about what
-     * we ripped.
-     */
+	return @"mp3towav";
 }
 
 
@@ -160,9 +226,10 @@ static MP3ToWavController *singleInstance = nil;
 //
 // AudioConverter methods
 //
-- (NSString *) fileType
+
+- (NSArray *) fileTypes
 {
-    return @"mp3";
+    return [NSArray arrayWithObject: @"mp3"];
 }
 
 /**
@@ -180,116 +247,4 @@ static MP3ToWavController *singleInstance = nil;
     return duration;
 }
 
-/*
- * <p>Calculate the size in bytes by converting the number of
- * frames into audio CD size.</p>
- */
-- (unsigned) size: (NSString *)fileName
-{
-    long duration = [self duration: fileName];
-    unsigned size = framesToAudioSize(duration);
-    return size;
-}
-
-
-- (ToolStatus) getStatus
-{
-	ToolStatus status;
-
-	[statusLock lock];
-	status = convStatus;
-	[statusLock unlock];
-
-	return status;
-
-}
-
-- (BOOL) convertTracks: (NSArray *)tracks
-	    withParameters: (NSDictionary *) parameters
-{
-	BOOL ret = YES;
-    NSString *fileName;
-    Track *track;
-    NSDictionary *sesDefaults = [parameters objectForKey: @"SessionParameters"];
-    struct mad_decoder decoder;
-    int trackIndex;
-    int trackCount;
-
-    allTracks = tracks;
-    trackCount = [allTracks count];
-
-    convStatus.entireProgress = 0;
-    convStatus.trackProgress = 0;
-
-    /*
-     * Initialize the audio output library.
-     */
-    ao_initialize();
-
-    [self setStatus: isConverting];
-
-    for (trackIndex = 0; (trackIndex < trackCount) && (NO != ret); trackIndex++) {
-        /*
-         * Did the user click abort?
-         */
-	    if (convStatus.processStatus == isCancelled) {
-            break;
-        }
-
-        track = [allTracks objectAtIndex: trackIndex];
-
-        [statusLock lock];
-        convStatus.trackName = [track description];
-        if (nil != track) {
-            convStatus.trackProgress = [playBuffer percentDone];
-        } else {
-            convStatus.trackProgress = 0;
-        }
-        if (0 == trackCount) {
-            convStatus.entireProgress = 0;
-        } else {
-            convStatus.entireProgress = trackIndex * 100. / trackCount;
-        }
-        [statusLock unlock];
-
-        fileName = [self makeOutfileNameForTrack: [track source]
-                                         tempDir: [sesDefaults objectForKey: @"TempDirectory"]];
-
-        [track setStorage: fileName];
-
-        [self sendOutputString: [NSString stringWithFormat: _(@"Converting track %@ to %@"),
-										[track description], fileName]];
-
-        playBuffer = [PlayBuffer new];
-        [playBuffer setInFile: [track source] outFile: fileName];
-            
-        mad_decoder_init(&decoder, playBuffer, read_from_mmap, read_header, /*filter*/0,
-                            output, /*error*/0, /* message */ 0);
-
-        mad_decoder_run(&decoder, MAD_DECODER_MODE_SYNC);
-
-        mad_decoder_finish(&decoder);
-        DESTROY(playBuffer);
-    }
-
-    ao_shutdown();
-
-	if (convStatus.processStatus == isConverting) {
-        [self setStatus: isStopped];
-	}
-
-    allTracks = nil;
-	return ret;
-}
-
-- (BOOL) stop: (BOOL)immediately
-{
-	if (convStatus.processStatus == isConverting) {
-		[self sendOutputString: _(@"Terminating process.")];
-        [self setStatus: isCancelled];
-        [playBuffer stop];
-	}
-	return YES;
-}
-
 @end
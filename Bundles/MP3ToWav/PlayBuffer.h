@@ -25,11 +25,20 @@
 #define PLAYBUFFER_H_INC
 
 #include <sys/types.h>
-#include <ao/ao.h>
 #include <mad.h>
 
 #include <Foundation/Foundation.h>
 
+#include "Dither.h"
+#include "Track.h"
+#include "Resampler.h"
+#include "WavWriter.h"
+
+/*
+ * A PlayBuffer decodes one mp3 file. All decoder and output state is
+ * kept in the instance, so that several files may be decoded by
+ * different threads at the same time.
+ */
 @interface PlayBuffer : NSObject
 {
     int fd;
@@ -50,12 +59,32 @@
     mad_timer_t duration;
 
     unsigned long currentFrame;
+
+    /*
+     * The offsets of all frames in the file. Only built
+     * for decoding a file in several parts.
+     */
+    unsigned long *frameIndex;
+    unsigned long indexedFrames;
+    unsigned samplesPerFrame;
+    NSConditionLock *partsLock;
     
     /*
      * Output related ivars.
      */
     NSString *outputFile;
-    ao_device *playDevice;
+    WavWriter *writer;
+    unsigned int sampleRate;
+    int channels;
+    struct audio_dither dither[2];
+
+    /* Only set if the file is not at 44100 Hz */
+    Resampler *resampler;
+    ResampleQuality resampleQuality;
+
+    /* The track decoded and the conversion's parameters */
+    Track *track;
+    NSDictionary *parameters;
    
     BOOL stopPlaying;
 }
@@ -72,6 +101,34 @@
 - (BOOL) calcLength: (NSString *)file;
 - (NSString *) setInFile: (NSString *)inFile outFile: (NSString *)outFile;
 - (double) percentDone;
+- (BOOL) isStopped;
+
+/*
+ * Sets the quality used if the file must be resampled to 44100 Hz.
+ * Must be called before decoding starts.
+ */
+- (void) setResampleQuality: (ResampleQuality) quality;
+
+/*
+ * Sets the track decoded, whose loudness is measured and normalized
+ * according to the parameters of the conversion.
+ */
+- (void) setTrack: (Track *) aTrack parameters: (NSDictionary *) params;
+
+/*
+ * Decodes the file in up to parts pieces at once, each one in a thread
+ * of its own, and writes the samples to the output file in their
+ * original order. Does not need a mad_decoder, but -closeOutput: must
+ * be called afterwards. Returns NO if decoding failed or was stopped.
+ */
+- (BOOL) decodeInParts: (unsigned) parts;
+
+/*
+ * Completes the output file. complete tells whether the whole file
+ * has been decoded, only then its loudness is stored. Returns NO if
+ * the output could not be written or nothing was decoded.
+ */
+- (BOOL) closeOutput: (BOOL) complete;
 
 - (enum mad_flow) readFromMmap: (struct mad_stream *)stream;
 - (enum mad_flow) readHeader: (struct mad_header const *) header;
@@ -34,11 +34,16 @@
 
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <mad.h>
 
 #include "PlayBuffer.h"
+#include "LoudnessMeter.h"
 
 
 /* XING parsing is from the MAD winamp input plugin */
@@ -59,113 +64,102 @@ enum {
 
 # define XING_MAGIC     (('X' << 24) | ('i' << 16) | ('n' << 8) | 'g')
 
-
-/* The following two routines and data structure are from the ever-brilliant
-   Rob Leslie.
-*/
-
-struct audio_dither {
-  mad_fixed_t error[3];
-  mad_fixed_t random;
-};
-
-/*
-* NAME:        prng()
-* DESCRIPTION: 32-bit pseudo-random number generator
-*/
-static inline
-unsigned long prng(unsigned long state)
-{
-  return (state * 0x0019660dL + 0x3c6ef35fL) & 0xffffffffL;
-}
-
 /*
-* NAME:        audio_linear_dither()
-* DESCRIPTION: generic linear sample quantize and dither routine
-*/
-inline
-signed long audio_linear_dither(unsigned int bits, mad_fixed_t sample,
-                                struct audio_dither *dither)
-{
-  unsigned int scalebits;
-  mad_fixed_t output, mask, random;
-
-  enum {
-    MIN = -MAD_F_ONE,
-    MAX =  MAD_F_ONE - 1
-  };
-
-  /* noise shape */
-  sample += dither->error[0] - dither->error[1] + dither->error[2];
-
-  dither->error[2] = dither->error[1];
-  dither->error[1] = dither->error[0] / 2;
-
-  /* bias */
-  output = sample + (1L << (MAD_F_FRACBITS + 1 - bits - 1));
-
-  scalebits = MAD_F_FRACBITS + 1 - bits;
-  mask = (1L << scalebits) - 1;
-
-  /* dither */
-  random  = prng(dither->random);
-  output += (random & mask) - (dither->random & mask);
+ * A part of a file does not start decoding at its first frame. Layer
+ * III frames take up to 511 bytes of their data from the frames
+ * before, and the first samples of a frame depend on the filter bank
+ * state left by the two frames before it. Thus, we start at least
+ * PRIME_FRAMES frames and RESERVOIR_BYTES bytes earlier and throw the
+ * samples of these frames away. The frames of each part then decode
+ * to the same samples as if the file were decoded in one go.
+ */
+#define PRIME_FRAMES 2
+#define RESERVOIR_BYTES 2048
 
-  dither->random = random;
+/* Parts are not made smaller than this number of frames. */
+#define MIN_PART_FRAMES 1000
 
-  /* clip */
-  if (output > MAX) {
-    output = MAX;
+/* The number of sample frames of a part resampled at once */
+#define RESAMPLE_FRAMES 8192
 
-    if (sample > MAX)
-      sample = MAX;
-  }
-  else if (output < MIN) {
-    output = MIN;
+/* The number of samples per channel in a block decoded by libmad */
+#define MAX_BLOCK_SAMPLES 1152
 
-    if (sample < MIN)
-      sample = MIN;
-  }
 
-  /* quantize */
-  output &= ~mask;
+/*
+ * One part of a file decoded by -decodeInParts:.
+ */
+@interface DecodePart : NSObject
+{
+@public
+	unsigned long first;
+	unsigned long last;
+	WavWriter *writer;
+	BOOL result;
+}
+@end
 
-  /* error feedback */
-  dither->error[0] = sample - output;
+@implementation DecodePart
 
-  /* scale */
-  return output >> scalebits;
+- (void) dealloc
+{
+	RELEASE(writer);
+	[super dealloc];
 }
 
+@end
+
 
 @interface PlayBuffer (Private)
-- (void) openPlayDevice: (struct mad_header const *)header;
+- (void) openOutput;
 - (void) scanFile: (void *) ptr length: (ssize_t) len;
+- (BOOL) indexFrames;
+- (unsigned long) primingFrameFor: (unsigned long) first;
+- (BOOL) decodeFrom: (unsigned long) first
+                 to: (unsigned long) last
+             writer: (WavWriter *) aWriter;
+- (void) decodePart: (DecodePart *) part;
+- (void) decodePartThread: (DecodePart *) part;
+- (BOOL) appendPart: (DecodePart *) part;
 - (int) parseXing: (struct xing *)xing bits: (struct mad_bitptr) ptr bitlen: (unsigned int) bitlen;
 @end
 
 @implementation PlayBuffer (Private)
 
-- (void) openPlayDevice: (struct mad_header const *)header
+- (void) openOutput
 {
-    ao_sample_format format;
-    int driver_id = ao_driver_id("wav");
-    ao_option *ao_options = NULL;
-
-    format.bits = 16;
-    format.rate = header->samplerate;
-    format.channels = 2;
+	unsigned long frames;
+
+	/*
+	 * Samples at other rates are resampled to 44100 Hz before they
+	 * are written.
+	 */
+	if (sampleRate != RESAMPLE_OUTPUT_RATE) {
+		resampler = [[Resampler alloc] initWithInputRate: sampleRate
+												 quality: resampleQuality];
+		if (nil == resampler)
+			return;
+	}
 
-    /* mad gives us little-endian data; we swap it on big-endian targets, to
-       big-endian format, because that's what most drivers expect. */
-    format.byte_format = AO_FMT_NATIVE; 
-        
-    /*
-     * Open theoutput file for overwriting.
-     */
-    if((playDevice = ao_open_file(driver_id, [outputFile cString], 1, &format, ao_options))==NULL) {
-	    playDevice = NULL;
-    }
+	/*
+	 * The duration was calculated by -calcLength:. It tells the
+	 * writer how much space to reserve.
+	 */
+	frames = mad_timer_count(duration, (enum mad_units)RESAMPLE_OUTPUT_RATE);
+
+	/*
+	 * Open the output file for overwriting. We always write stereo,
+	 * mono input is duplicated to both channels.
+	 */
+	writer = [[WavWriter alloc] initWithPath: outputFile
+								  sampleRate: RESAMPLE_OUTPUT_RATE
+									channels: 2
+							  expectedFrames: frames];
+	if (nil != writer) {
+		[LoudnessMeter prepareWriter: writer
+							forTrack: track
+						  parameters: parameters];
+	}
 }
 
 - (void) scanFile: (void *) ptr length: (ssize_t) len;
@@ -259,6 +253,254 @@ signed long audio_linear_dither(unsigned int bits, mad_fixed_t sample,
 	mad_stream_finish(&stream);
 }
 
+/*
+ * Unlike -scanFile:length:, which stops as early as possible, this
+ * walks the headers of all frames and records where they start.
+ * Only the headers are decoded, so it is fast compared to decoding
+ * the file.
+ */
+- (BOOL) indexFrames
+{
+	struct mad_stream stream;
+	struct mad_header header;
+	unsigned long capacity = 4096;
+
+	frameIndex = malloc(capacity * sizeof(unsigned long));
+	if (NULL == frameIndex) {
+		return NO;
+	}
+	indexedFrames = 0;
+
+	mad_stream_init(&stream);
+	mad_header_init(&header);
+	mad_stream_buffer(&stream, buf, length);
+
+	while (!stopPlaying) {
+		if (mad_header_decode(&header, &stream) == -1) {
+			if (MAD_RECOVERABLE(stream.error))
+				continue;
+			else
+				break;
+		}
+
+		if (0 == indexedFrames) {
+			sampleRate = header.samplerate;
+			samplesPerFrame = 32 * MAD_NSBSAMPLES(&header);
+		}
+		if (indexedFrames == capacity) {
+			unsigned long *newIndex;
+
+			capacity *= 2;
+			newIndex = realloc(frameIndex, capacity * sizeof(unsigned long));
+			if (NULL == newIndex) {
+				break;
+			}
+			frameIndex = newIndex;
+		}
+		frameIndex[indexedFrames++] = stream.this_frame - (unsigned char *)buf;
+	}
+
+	mad_header_finish(&header);
+	mad_stream_finish(&stream);
+
+	return (indexedFrames > 0) && !stopPlaying;
+}
+
+- (unsigned long) primingFrameFor: (unsigned long) first
+{
+	unsigned long start;
+
+	if (first <= PRIME_FRAMES) {
+		return 0;
+	}
+	start = first - PRIME_FRAMES;
+	while ((start > 0)
+			&& (frameIndex[first - PRIME_FRAMES] - frameIndex[start] < RESERVOIR_BYTES)) {
+		start--;
+	}
+	return start;
+}
+
+/*
+ * Decodes the frames first up to but not including last into aWriter.
+ * Does the same as mad_decoder_run() with our callbacks, but skips the
+ * samples of the priming frames. Each part has its own dither state.
+ */
+- (BOOL) decodeFrom: (unsigned long) first
+                 to: (unsigned long) last
+             writer: (WavWriter *) aWriter
+{
+	struct mad_stream stream;
+	struct mad_frame frame;
+	struct mad_synth synth;
+	struct audio_dither partDither[2];
+	unsigned long start = [self primingFrameFor: first];
+	unsigned char const *begin = (unsigned char *)buf + frameIndex[first];
+	unsigned char const *end = (unsigned char *)buf
+					+ ((last < indexedFrames) ? frameIndex[last] : length);
+	int badLastFrame = 0;
+	BOOL ret = YES;
+
+	memset(partDither, 0, sizeof(partDither));
+	mad_stream_init(&stream);
+	mad_frame_init(&frame);
+	mad_synth_init(&synth);
+	mad_stream_buffer(&stream, (unsigned char *)buf + frameIndex[start],
+						length - frameIndex[start]);
+
+	while (!stopPlaying) {
+		unsigned char *out;
+
+		if (mad_frame_decode(&frame, &stream) == -1) {
+			if (!MAD_RECOVERABLE(stream.error))
+				break;
+			if (stream.this_frame >= end)
+				break;
+			/*
+			 * This is what libmad's default error handler does.
+			 */
+			if (stream.error != MAD_ERROR_BADCRC)
+				continue;
+			if (badLastFrame)
+				mad_frame_mute(&frame);
+			else
+				badLastFrame = 1;
+		} else {
+			badLastFrame = 0;
+		}
+		if (stream.this_frame >= end)
+			break;
+
+		mad_synth_frame(&synth, &frame);
+		if (stream.this_frame < begin)
+			continue;
+
+		out = [aWriter bytesForAppending: synth.pcm.length * 4];
+		if (NULL == out) {
+			ret = NO;
+			break;
+		}
+		[aWriter appendedBytes: dither_pcm16(&synth.pcm, partDither, out)];
+		__sync_fetch_and_add(&currentFrame, 1);
+	}
+
+	mad_synth_finish(&synth);
+	mad_frame_finish(&frame);
+	mad_stream_finish(&stream);
+
+	return ret && !stopPlaying;
+}
+
+- (void) decodePart: (DecodePart *) part
+{
+	part->result = [self decodeFrom: part->first
+								 to: part->last
+							 writer: part->writer];
+	if (!part->result) {
+		// Do not waste time on the other parts.
+		stopPlaying = YES;
+	}
+
+	[partsLock lock];
+	[partsLock unlockWithCondition: [partsLock condition] - 1];
+}
+
+- (void) decodePartThread: (DecodePart *) part
+{
+	id pool = [NSAutoreleasePool new];
+
+	[self decodePart: part];
+
+	RELEASE(pool);
+	[NSThread exit];
+}
+
+/*
+ * Appends the samples of a part, which has been written to a file of
+ * its own, to the output file and removes the part's file. The parts
+ * are resampled here, one after the other, so that the resampler sees
+ * the samples without gaps.
+ */
+- (BOOL) appendPart: (DecodePart *) part
+{
+	NSString *partFile = [part->writer path];
+	BOOL ret = [part->writer close];
+	int partFd = -1;
+	int16_t *samples = NULL;
+
+	if (ret) {
+		partFd = open([partFile fileSystemRepresentation], O_RDONLY);
+		ret = (partFd >= 0) && (lseek(partFd, WAV_HEADER_SIZE, SEEK_SET) == WAV_HEADER_SIZE);
+	}
+	if (ret && (nil != resampler)) {
+		samples = malloc(RESAMPLE_FRAMES * 4);
+		ret = (NULL != samples);
+	}
+
+	while (ret) {
+		unsigned char *out;
+		size_t size;
+		ssize_t count;
+
+		/*
+		 * Without resampling, the samples are read right into the
+		 * writer's buffer.
+		 */
+		if (nil == resampler) {
+			size = WAV_BUFFER_SIZE - WAV_HEADER_SIZE;
+			out = [writer bytesForAppending: size];
+		} else {
+			size = RESAMPLE_FRAMES * 4;
+			out = (unsigned char *)samples;
+		}
+		if (NULL == out) {
+			ret = NO;
+			break;
+		}
+		count = read(partFd, out, size);
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+			ret = NO;
+			break;
+		}
+		if (count == 0)
+			break;
+#ifdef WORDS_BIGENDIAN
+		{
+			// The part's file is little endian, the writer wants native samples.
+			ssize_t i;
+			for (i = 0; i + 1 < count; i += 2) {
+				unsigned char c = out[i];
+				out[i] = out[i + 1];
+				out[i + 1] = c;
+			}
+		}
+#endif
+		if (nil == resampler) {
+			[writer appendedBytes: count];
+		} else {
+			unsigned frames = count / 4;
+
+			out = [writer bytesForAppending: [resampler maxOutputFrames: frames] * 4];
+			if (NULL == out) {
+				ret = NO;
+				break;
+			}
+			[writer appendedBytes: [resampler resample: samples
+												frames: frames
+												  into: (int16_t *)out] * 4];
+		}
+	}
+
+	free(samples);
+	if (partFd >= 0)
+		close(partFd);
+	unlink([partFile fileSystemRepresentation]);
+
+	return ret;
+}
+
 - (int) parseXing: (struct xing *)xing bits: (struct mad_bitptr) ptr bitlen: (unsigned int) bitlen
 {
 	if (bitlen < 64 || mad_bit_read(&ptr, 32) != XING_MAGIC)
@@ -326,7 +568,19 @@ fail:
 		totalFrames = 0;
 		stopPlaying = NO;
 		currentFrame = 0;
+		frameIndex = NULL;
+		indexedFrames = 0;
+		samplesPerFrame = 0;
+		partsLock = nil;
 		outputFile = nil;
+		writer = nil;
+		sampleRate = 0;
+		channels = 0;
+		memset(dither, 0, sizeof(dither));
+		resampler = nil;
+		resampleQuality = ResampleQualityBest;
+		track = nil;
+		parameters = nil;
 		mad_timer_reset(&duration);
 	}
 	return self;
@@ -340,6 +594,13 @@ fail:
 	if (fd >= 0)
 		close (fd);
 
+	if (NULL != frameIndex)
+		free(frameIndex);
+
+	RELEASE(writer);
+	RELEASE(resampler);
+	RELEASE(track);
+	RELEASE(parameters);
 	RELEASE(outputFile);
 	[super dealloc];
 }
@@ -349,6 +610,53 @@ fail:
 	stopPlaying = YES;
 }
 
+- (BOOL) isStopped
+{
+	return stopPlaying;
+}
+
+- (void) setResampleQuality: (ResampleQuality) quality
+{
+	resampleQuality = quality;
+}
+
+- (void) setTrack: (Track *) aTrack parameters: (NSDictionary *) params
+{
+	ASSIGN(track, aTrack);
+	ASSIGN(parameters, params);
+}
+
+- (BOOL) closeOutput: (BOOL) complete
+{
+	BOOL ret = NO;
+
+	if (nil != writer) {
+		BOOL flushed = YES;
+
+		/*
+		 * The resampler keeps back the last few samples until it
+		 * knows that no more follow.
+		 */
+		if (nil != resampler) {
+			unsigned char *out = [writer bytesForAppending: [resampler maxFlushFrames] * 4];
+
+			if (NULL == out) {
+				flushed = NO;
+			} else {
+				[writer appendedBytes: [resampler flush: (int16_t *)out] * 4];
+			}
+		}
+		if (complete && flushed) {
+			flushed = [LoudnessMeter finishWriter: writer
+										 forTrack: track
+									   parameters: parameters];
+		}
+		ret = [writer close] && flushed;
+		DESTROY(writer);
+	}
+	return ret;
+}
+
 
 /*
  * Access methods
@@ -452,6 +760,92 @@ fail:
 	return nil;
 }
 
+- (BOOL) decodeInParts: (unsigned) parts
+{
+	NSMutableArray *allParts;
+	unsigned long framesPerPart;
+	unsigned i;
+	BOOL ret = YES;
+
+	if (![self indexFrames]) {
+		return NO;
+	}
+	totalFrames = indexedFrames;
+
+	if (parts > indexedFrames / MIN_PART_FRAMES) {
+		parts = indexedFrames / MIN_PART_FRAMES;
+	}
+	if (parts < 1) {
+		parts = 1;
+	}
+	framesPerPart = (indexedFrames + parts - 1) / parts;
+
+	[self openOutput];
+	if (nil == writer) {
+		return NO;
+	}
+
+	/*
+	 * The first part goes right into the output file, the others
+	 * into files of their own, which are appended afterwards. If the
+	 * file must be resampled, the first part gets a file, too.
+	 */
+	allParts = [NSMutableArray arrayWithCapacity: parts];
+	for (i = 0; i < parts; i++) {
+		DecodePart *part = AUTORELEASE([DecodePart new]);
+
+		part->first = i * framesPerPart;
+		part->last = MIN(part->first + framesPerPart, indexedFrames);
+		part->result = NO;
+		if ((0 == i) && (nil == resampler)) {
+			part->writer = RETAIN(writer);
+		} else {
+			part->writer = [[WavWriter alloc] initWithPath:
+										[NSString stringWithFormat: @"%@.part%u", outputFile, i]
+												sampleRate: sampleRate
+												  channels: 2
+											expectedFrames: (part->last - part->first) * samplesPerFrame];
+			if (nil == part->writer) {
+				ret = NO;
+			}
+		}
+		[allParts addObject: part];
+	}
+
+	if (ret) {
+		/*
+		 * The calling thread decodes the first part. The lock's
+		 * condition counts the threads still running.
+		 */
+		partsLock = [[NSConditionLock alloc] initWithCondition: parts];
+		for (i = 1; i < parts; i++) {
+			[NSThread detachNewThreadSelector: @selector(decodePartThread:)
+									 toTarget: self
+								   withObject: [allParts objectAtIndex: i]];
+		}
+		[self decodePart: [allParts objectAtIndex: 0]];
+		[partsLock lockWhenCondition: 0];
+		[partsLock unlock];
+		DESTROY(partsLock);
+	}
+
+	for (i = 0; i < parts; i++) {
+		DecodePart *part = [allParts objectAtIndex: i];
+
+		ret = ret && part->result;
+		if (part->writer != writer) {
+			if (ret) {
+				ret = [self appendPart: part];
+			} else if (nil != part->writer) {
+				[part->writer close];
+				unlink([[part->writer path] fileSystemRepresentation]);
+			}
+		}
+	}
+
+	return ret;
+}
+
 - (double) percentDone
 {
 	double ret = 0.;
@@ -492,74 +886,37 @@ fail:
 
 - (enum mad_flow) writeOutput: (struct mad_header const *) header pcmData: (struct mad_pcm *)pcm
 {
-	register int nsamples = pcm->length;
-	mad_fixed_t const *left_ch = pcm->samples[0], *right_ch = pcm->samples[1];
-    
-	static unsigned char stream[1152*4]; /* 1152 because that's what mad has as a max; *4 because
-	there are 4 distinct bytes per sample (in 2 channel case) */
-	static unsigned int rate = 0;
-	static int channels = 0;
-	static struct audio_dither dither;
-
-	register char * ptr = stream;
-	register signed int sample;
-	register mad_fixed_t tempsample;
+	unsigned char *out;
 
-	/* We need to know information about the file before we can open the playdevice
+	/* We need to know information about the file before we can open the output
 	in some cases. So, we do it here. */
-	if (!playDevice) {
+	if (!writer) {
 		channels = MAD_NCHANNELS(header);
-		rate = header->samplerate;
-		[self openPlayDevice: header];
+		sampleRate = header->samplerate;
+		[self openOutput];
 	}
-	if (!playDevice)
-		return MAD_FLOW_STOP;
-
-	if (pcm->channels == 2) {
-		while (nsamples--) {
-			tempsample = (mad_fixed_t)(*left_ch++);
-			sample = (signed int) audio_linear_dither(16, tempsample, &dither);
-
-#ifndef WORDS_BIGENDIAN
-			*ptr++ = (unsigned char) (sample >> 0);
-			*ptr++ = (unsigned char) (sample >> 8);
-#else
-			*ptr++ = (unsigned char) (sample >> 8);
-			*ptr++ = (unsigned char) (sample >> 0);
-#endif
-            
-			tempsample = (mad_fixed_t)(*right_ch++);
-			sample = (signed int) audio_linear_dither(16, tempsample, &dither);
-#ifndef WORDS_BIGENDIAN
-			*ptr++ = (unsigned char) (sample >> 0);
-			*ptr++ = (unsigned char) (sample >> 8);
-#else
-			*ptr++ = (unsigned char) (sample >> 8);
-			*ptr++ = (unsigned char) (sample >> 0);
-#endif
-		}
-
-		ao_play(playDevice, stream, pcm->length * 4);
+	if (!writer)
+		return MAD_FLOW_BREAK;
+
+	/*
+	 * The samples are dithered right into the writer's buffer, unless
+	 * they must be resampled.
+	 */
+	if (nil == resampler) {
+		out = [writer bytesForAppending: pcm->length * 4];
+		if (NULL == out)
+			return MAD_FLOW_BREAK;
+		[writer appendedBytes: dither_pcm16(pcm, dither, out)];
 	} else {
-		while (nsamples--) {
-			tempsample = (mad_fixed_t)(*left_ch++);
-			sample = (signed int) audio_linear_dither(16, tempsample, &dither);
-            
-			/* Just duplicate the sample across both channels. */
-#ifndef WORDS_BIGENDIAN
-			*ptr++ = (unsigned char) (sample >> 0);
-			*ptr++ = (unsigned char) (sample >> 8);
-			*ptr++ = (unsigned char) (sample >> 0);
-			*ptr++ = (unsigned char) (sample >> 8);
-#else
-			*ptr++ = (unsigned char) (sample >> 8);
-			*ptr++ = (unsigned char) (sample >> 0);
-			*ptr++ = (unsigned char) (sample >> 8);
-			*ptr++ = (unsigned char) (sample >> 0);
-#endif
-		}
-
-		ao_play(playDevice, stream, pcm->length * 4);
+		int16_t samples[MAX_BLOCK_SAMPLES * 2];
+		unsigned frames = dither_pcm16(pcm, dither, (unsigned char *)samples) / 4;
+
+		out = [writer bytesForAppending: [resampler maxOutputFrames: frames] * 4];
+		if (NULL == out)
+			return MAD_FLOW_BREAK;
+		[writer appendedBytes: [resampler resample: samples
+											frames: frames
+											  into: (int16_t *)out] * 4];
 	}
 
 	return MAD_FLOW_CONTINUE;        
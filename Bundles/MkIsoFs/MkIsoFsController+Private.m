@@ -22,13 +22,13 @@
  */
 
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <stdlib.h>
 
 #include "MkIsoFsController.h"
 
 #include "Constants.h"
 #include "Functions.h"
+#include "ProgressParser.h"
 #include "Track.h"
 
 
@@ -83,63 +83,114 @@
 
 - (void) waitForEndOfTask
 {
-	BOOL sendLine;
-
-	while ([mkiTask isRunning]) {
-		NSData *inData;
-        while ((inData = [[[mkiTask standardError] fileHandleForReading] availableData]) && [inData length]) {
-			int i, count;
-			NSString *aLine;
-			NSString *temp;
-			NSArray *theOutput;
+	[mkiProcess waitUntilExit];
+}
 
-			temp = [[NSString alloc] initWithData: inData
-									encoding: NSISOLatin1StringEncoding];
+- (BOOL) toolProcess: (ToolProcess *) process
+    didReadLineBytes: (const char *) bytes
+              length: (unsigned) length
+{
+	ProgressEvent event;
 
-			theOutput = [temp componentsSeparatedByString: @"\n"];
+	if ((toolStatus.processStatus != isPreparing)
+			&& (toolStatus.processStatus != isCreatingImage)) {
+		return NO;
+	}
+	if (parseMkIsoFsLine(bytes, length, &event) != ProgressPercent) {
+		return NO;
+	}
 
-			count = [theOutput count];
+	[statusLock lock];
+	toolStatus.processStatus = isCreatingImage;
+	toolStatus.entireProgress = event.value;
+	[statusLock unlock];
+	return YES;
+}
 
-			for (i = 0; i < count; i++) {
-				aLine = [theOutput objectAtIndex: i];
-				if (aLine && [aLine length])
-					sendLine = YES;
-				else
-					sendLine = NO;	// don't send empty lines
-
-				if (toolStatus.processStatus == isPreparing) {
-					NSRange aRange = [aLine rangeOfString: @"done, estimate finish"];
-					if (aRange.location != NSNotFound) {
-						NSArray *parts = [aLine componentsSeparatedByString: @"%"];
-						[statusLock lock];
-						toolStatus.processStatus = isCreatingImage;
-						toolStatus.entireProgress = [[parts objectAtIndex: 0] doubleValue];
-						[statusLock unlock];
-						sendLine = NO;
-					}
-				} else if (toolStatus.processStatus == isCreatingImage) {
-					NSRange aRange;
-
-					aRange = [aLine rangeOfString: @"done, estimate finish"];
-					if (aRange.location != NSNotFound) {
-						NSArray *parts = [aLine componentsSeparatedByString: @"%"];
-						[statusLock lock];
-						toolStatus.entireProgress = [[parts objectAtIndex: 0] doubleValue];
-						[statusLock unlock];
-						sendLine = NO;
-					}
-				}
-
-				// post the oputput to the progress panel
-				if (sendLine) {
-					[self sendOutputString: aLine raw: YES];
-				}
-			}	// for (i = 0; i < count; i++)
-		}	//  while ((inData = 
-	}	// while ([mkiTask isRunning])
+- (void) toolProcess: (ToolProcess *) process
+         didReadLine: (NSString *) aLine
+{
+	// post the oputput to the progress panel
+	[self sendOutputString: aLine raw: YES];
 }
 
 
+- (BOOL) createISOImage: (NSString *) volumeId
+			 withTracks: (NSArray *) trackArray
+				 toFile: (NSString *) outFile
+				 orPipe: (NSPipe *) pipe
+		 withParameters: (NSDictionary *) parameters
+{
+	BOOL ret = YES;
+	NSString *mkisofs;
+	NSArray *mkiArgs;
+    NSFileManager *fileMan = [NSFileManager defaultManager];
+
+
+	// set up mkisofs task
+	mkisofs = [[parameters objectForKey: @"MkIsofsParameters"]
+						objectForKey: @"Program"];
+
+    if (!checkProgram(mkisofs))
+        return NO;
+
+	mkiArgs = [self makeParamsForVolumeId: volumeId
+								fileList: trackArray
+                                 outFile: outFile
+                          withParameters: parameters];
+
+	[statusLock lock];
+	mkiProcess = [[ToolProcess alloc] initWithPath: mkisofs arguments: mkiArgs];
+	[statusLock unlock];
+	[mkiProcess setDelegate: self];
+	/*
+	 * Without an output file, mkisofs writes the image to stdout.
+	 * ToolProcess closes our copy of the pipe's write end after launch,
+	 * so the reader sees EOF when mkisofs is done.
+	 */
+	if (nil != pipe) {
+		[mkiProcess setStandardOutput: pipe];
+	}
+
+	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
+											mkisofs, [mkiArgs componentsJoinedByString: @" "]] raw: NO];
+
+	/*
+	 * Now we wait until the mkisofs process is over and process its output.
+	 */
+	if ([mkiProcess launch]) {
+		[self waitForEndOfTask];
+	}
+
+	/*
+	 * If mkisofs did not terminate gracefully we stop the whole affair.
+	 * We delete in any case the actual (not finished) file.
+	 */
+	if (![mkiProcess exitedNormally]
+			|| (toolStatus.processStatus == isCancelled)) {
+		if (nil != outFile) {
+			[self sendOutputString: [NSString stringWithFormat: _(@"Removing temporary file %@."), outFile] raw: NO];
+			if (![fileMan removeFileAtPath: outFile handler: nil]) {
+				[self sendOutputString: _(@"Removing file failed.") raw: NO];
+			}
+		}
+		toolStatus.processStatus = isCancelled;
+		ret = NO;
+	}
+
+	[statusLock lock];
+	DESTROY(mkiProcess);
+	[statusLock unlock];
+
+	if (toolStatus.processStatus != isCancelled) {
+		[statusLock lock];
+		toolStatus.processStatus = isStopped;
+		[statusLock unlock];
+	}
+
+	return ret;
+}
+
 - (NSMutableArray *) makeParamsForVolumeId: (NSString *) volumeId
 								  fileList: (NSArray *) files
 								   outFile: (NSString *) outFile
@@ -155,7 +206,12 @@
 	toolStatus.processStatus = isPreparing;
 
 	/* The array is autoreleased! Don't release it here!!! */
-	mkiArgs = [NSMutableArray arrayWithObjects: @"-o", outFile, @"-gui", @"-graft-points", nil];
+	mkiArgs = [NSMutableArray arrayWithObjects: @"-gui", @"-graft-points", nil];
+	// No output file means the image goes to stdout.
+	if (nil != outFile) {
+		[mkiArgs insertObject: outFile atIndex: 0];
+		[mkiArgs insertObject: @"-o" atIndex: 0];
+	}
 	[mkiArgs addObject: @"-V"];
 	[mkiArgs addObject: volumeId];
 
@@ -224,10 +280,7 @@
 	else
 		outLine = outString;
 
-	[[NSDistributedNotificationCenter defaultCenter]
-					postNotificationName: ExternalToolOutput
-					object: nil
-					userInfo: [NSDictionary dictionaryWithObject: outLine forKey: @"Output"]];
+	logToolOutput(outLine);
 }
 
 @end
@@ -27,10 +27,11 @@
 #include <AppKit/AppKit.h>
 
 #include "ExternalTools.h"
+#include "ToolProcess.h"
 
-@interface MkIsoFsController : NSObject <BurnTool, IsoImageCreator>
+@interface MkIsoFsController : NSObject <BurnTool, IsoImageCreator, ToolProcessDelegate>
 {
-	NSTask *mkiTask;
+	ToolProcess *mkiProcess;
 
 	NSLock *statusLock;
 	ToolStatus toolStatus;
@@ -44,6 +45,11 @@
 @interface MkIsoFsController (Private)
 - (void) initializeFromDefaults;
 - (void) waitForEndOfTask;
+- (BOOL) createISOImage: (NSString *) volumeId
+             withTracks: (NSArray *) trackArray
+                 toFile: (NSString *) outFile
+                 orPipe: (NSPipe *) pipe
+         withParameters: (NSDictionary *) parameters;
 - (NSMutableArray *) makeParamsForVolumeId: (NSString *) volumeId
                                   fileList: (NSArray *) files
                                    outFile: (NSString *) outFile
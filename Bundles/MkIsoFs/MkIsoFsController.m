@@ -22,7 +22,6 @@
  */
 
 #include <sys/types.h>
-#include <sys/wait.h>
 
 
 #include "MkIsoFsController.h"
@@ -121,79 +120,114 @@ static MkIsoFsController *singleInstance = nil;
 				 toFile: (NSString *) outFile
 		 withParameters: (NSDictionary *) parameters
 {
-	BOOL ret = YES;
-	int termStatus;
-	NSString *mkisofs;
-	NSArray *mkiArgs;
-	NSPipe *stdOut;
-    NSFileManager *fileMan = [NSFileManager defaultManager];
+	return [self createISOImage: volumeId
+					 withTracks: trackArray
+						 toFile: outFile
+						 orPipe: nil
+				 withParameters: parameters];
+}
+
+- (BOOL) createISOImage: (NSString *) volumeId
+			 withTracks: (NSArray *) trackArray
+				 toPipe: (NSPipe *) pipe
+		 withParameters: (NSDictionary *) parameters
+{
+	return [self createISOImage: volumeId
+					 withTracks: trackArray
+						 toFile: nil
+						 orPipe: pipe
+				 withParameters: parameters];
+}
 
+- (long) sizeOfISOImage: (NSString *) volumeId
+			 withTracks: (NSArray *) trackArray
+		 withParameters: (NSDictionary *) parameters
+{
+	int i, count;
+	long size = -1;
+	NSString *mkisofs;
+	NSMutableArray *mkiArgs;
+	NSArray *theOutput;
 
-	// set up mkisofs task
 	mkisofs = [[parameters objectForKey: @"MkIsofsParameters"]
 						objectForKey: @"Program"];
 
     if (!checkProgram(mkisofs))
-        return NO;
-
-	mkiTask = [[NSTask alloc] init];
-	stdOut = [[NSPipe alloc] init];
+        return -1;
 
 	mkiArgs = [self makeParamsForVolumeId: volumeId
 								fileList: trackArray
-                                 outFile: outFile
+                                 outFile: nil
                           withParameters: parameters];
+	[mkiArgs insertObject: @"-print-size" atIndex: 0];
+	[mkiArgs insertObject: @"-quiet" atIndex: 1];
 
-	[mkiTask setLaunchPath: mkisofs];
-	[mkiTask setArguments: mkiArgs];
-	[mkiTask setStandardError: stdOut];
+	/*
+	 * Without a delegate, the process collects the output lines
+	 * for us.
+	 */
+	[statusLock lock];
+	mkiProcess = [[ToolProcess alloc] initWithPath: mkisofs arguments: mkiArgs];
+	[statusLock unlock];
 
 	[self sendOutputString: [NSString stringWithFormat: _(@"Launching %@ %@"),
 											mkisofs, [mkiArgs componentsJoinedByString: @" "]] raw: NO];
 
-	[mkiTask launch];
+	[mkiProcess run];
 
-	/*
-	 * Now we wait until the mkisofs task is over and process its output.
-	 */
-	[self waitForEndOfTask];
+	theOutput = [mkiProcess outputLines];
 
 	/*
-	 * If mkisofs did not terminate gracefully we stop the whole affair.
-	 * We delete in any case the actual (not finished) file.
+	 * With -quiet, mkisofs prints the number of sectors on a line
+	 * of its own. Older versions print a sentence instead.
 	 */
-	termStatus = [mkiTask terminationStatus];	// FreeBSD needs an lvalue for the WIF* macros
-	if ((WIFEXITED(termStatus) == 0)
-			|| WIFSIGNALED(termStatus)
-			|| (toolStatus.processStatus == isCancelled)) {
-		[self sendOutputString: [NSString stringWithFormat: _(@"Removing temporary file %@."), outFile] raw: NO];
-		if (![fileMan removeFileAtPath: outFile handler: nil]) {
-			[self sendOutputString: _(@"Removing file failed.") raw: NO];
+	count = [theOutput count];
+	for (i = 0; i < count; i++) {
+		NSString *aLine = [[theOutput objectAtIndex: i] stringByTrimmingSpaces];
+		NSRange aRange = [aLine rangeOfString: @"Total extents scheduled to be written ="];
+
+		if (aRange.location != NSNotFound) {
+			size = [[aLine substringFromIndex: NSMaxRange(aRange)] intValue];
+		} else if ([aLine length]
+					&& ([[aLine stringByTrimmingCharactersInSet:
+							[NSCharacterSet decimalDigitCharacterSet]] length] == 0)) {
+			size = [aLine intValue];
+		} else if ([aLine length]) {
+			[self sendOutputString: aLine raw: YES];
 		}
-		toolStatus.processStatus = isCancelled;
-		ret = NO;
 	}
 
-	RELEASE(stdOut);
-	RELEASE(mkiTask);
-	mkiTask = nil;
+	if (![mkiProcess exitedNormally]
+			|| ([mkiProcess terminationStatus] != 0)
+			|| (toolStatus.processStatus == isCancelled)) {
+		size = -1;
+	}
 
-	if (toolStatus.processStatus != isCancelled) {
-		[statusLock lock];
-		toolStatus.processStatus = isStopped;
-		[statusLock unlock];
+	[statusLock lock];
+	DESTROY(mkiProcess);
+	[statusLock unlock];
+
+	[statusLock lock];
+	toolStatus.processStatus = (size > 0) ? isStopped : isCancelled;
+	[statusLock unlock];
+
+	if (size > 0) {
+		[self sendOutputString: [NSString stringWithFormat: _(@"Image size is %ld sectors."), size] raw: NO];
 	}
 
-	return ret;
+	return size;
 }
 
 - (BOOL) stop: (BOOL) immediately
 {
-	if (mkiTask && (toolStatus.processStatus == isCreatingImage)) {
+	[statusLock lock];
+	if (mkiProcess && ((toolStatus.processStatus == isCreatingImage)
+					|| (toolStatus.processStatus == isPreparing))) {
 		[self sendOutputString: _(@"Terminating process.") raw: NO];
-		[mkiTask terminate];
+		[mkiProcess cancel];
 		toolStatus.processStatus = isCancelled;
 	}
+	[statusLock unlock];
 	return YES;
 }
 
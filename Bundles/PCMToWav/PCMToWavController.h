@@ -0,0 +1,43 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  PCMToWavController.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef PCMTOWAVCONTROLLER_H_INC
+#define PCMTOWAVCONTROLLER_H_INC
+
+#include <Foundation/Foundation.h>
+
+#include "AudioDecoder.h"
+
+/**
+ * <p>PCMToWavController converts uncompressed WAV, AIFF and AU files,
+ * which cannot be burned as they are, into CD audio. It handles the
+ * tracks of type audio:pcm.</p>
+ */
+@interface PCMToWavController : AudioDecoder
+{
+}
+
+@end
+
+#endif
@@ -0,0 +1,175 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  PCMToWavController.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "PCMToWavController.h"
+
+#include "Constants.h"
+#include "Functions.h"
+#include "PCMFile.h"
+#include "Resampler.h"
+#include "Track.h"
+
+#ifdef _
+#undef _
+#endif
+
+#define _(X) \
+    [[NSBundle bundleForClass: [self class]] localizedStringForKey:(X) value:@"" table:nil]
+
+
+static PCMToWavController *singleInstance = nil;
+
+
+@implementation PCMToWavController
+
++ (id) singleInstance
+{
+    if (! singleInstance) {
+        singleInstance = [[PCMToWavController alloc] init];
+    }
+
+    return singleInstance;
+}
+
+- (void) dealloc
+{
+    singleInstance = nil;
+    [super dealloc];
+}
+
+- (NSString *) name
+{
+    return @"pcmtowav";
+}
+
+/*
+ * Track gives the type pcm to all uncompressed files which must
+ * be converted, whatever their extension.
+ */
+- (NSArray *) fileTypes
+{
+    return [NSArray arrayWithObject: @"pcm"];
+}
+
+- (long) duration: (NSString *) fileName
+{
+    PCMFile *pcm = AUTORELEASE([[PCMFile alloc] initWithPath: fileName]);
+
+    return [pcm duration];
+}
+
+- (BOOL) decodeJob: (AudioDecodeJob *) job
+          toWriter: (WavWriter *) writer
+{
+    NSString *source = [[job track] source];
+    PCMFile *pcm = AUTORELEASE([[PCMFile alloc] initWithPath: source]);
+    Resampler *resampler = nil;
+    int16_t *samples = NULL;
+    unsigned long long frames = 0;
+    BOOL ret = YES;
+
+    if (nil == pcm) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"Cannot open %@."), source]];
+        return NO;
+    }
+
+    /*
+     * Files at other rates are read into a buffer of our own and
+     * resampled into the writer's buffer.
+     */
+    if ([pcm canRead] && ([pcm sampleRate] != RESAMPLE_OUTPUT_RATE)) {
+        resampler = AUTORELEASE([[Resampler alloc] initWithInputRate: [pcm sampleRate]
+                                                             quality: [self resampleQuality]]);
+        samples = malloc(PCM_READ_FRAMES * 4);
+    }
+    if (![pcm canRead]
+            || (([pcm sampleRate] != RESAMPLE_OUTPUT_RATE) && (nil == resampler))) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"Cannot convert %@: %u Hz, %u channels."),
+                                    source, [pcm sampleRate], [pcm channels]]];
+        free(samples);
+        return NO;
+    }
+    if ((nil != resampler) && (NULL == samples)) {
+        return NO;
+    }
+
+    /*
+     * Otherwise, the samples are converted right into the writer's
+     * buffer.
+     */
+    while (![job isCancelled]) {
+        int16_t *out;
+        long n;
+
+        if (nil == resampler) {
+            out = (int16_t *)[writer bytesForAppending: PCM_READ_FRAMES * 4];
+            if (NULL == out) {
+                ret = NO;
+                break;
+            }
+            n = [pcm readFrames: PCM_READ_FRAMES into: out];
+        } else {
+            n = [pcm readFrames: PCM_READ_FRAMES into: samples];
+        }
+        if (n < 0) {
+            [self sendOutputString: [NSString stringWithFormat: _(@"Cannot read %@."), source]];
+            ret = NO;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        if (nil != resampler) {
+            out = (int16_t *)[writer bytesForAppending: [resampler maxOutputFrames: n] * 4];
+            if (NULL == out) {
+                ret = NO;
+                break;
+            }
+            n = [resampler resample: samples frames: n into: out];
+        }
+        [writer appendedBytes: n * 4];
+
+        frames += n;
+        [job setFramesDone: frames];
+    }
+
+    if (ret && (nil != resampler) && ![job isCancelled]) {
+        int16_t *out = (int16_t *)[writer bytesForAppending: [resampler maxFlushFrames] * 4];
+
+        if (NULL == out) {
+            ret = NO;
+        } else {
+            [writer appendedBytes: [resampler flush: out] * 4];
+        }
+    }
+
+    free(samples);
+
+    return ret && ![job isCancelled];
+}
+
+@end
@@ -0,0 +1,178 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  VorbisToWavController.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vorbis/vorbisfile.h>
+
+#include "VorbisToWavController.h"
+
+#include "Constants.h"
+#include "Functions.h"
+#include "Track.h"
+
+#ifdef _
+#undef _
+#endif
+
+#define _(X) \
+    [[NSBundle bundleForClass: [self class]] localizedStringForKey:(X) value:@"" table:nil]
+
+#ifdef WORDS_BIGENDIAN
+#define NATIVE_BIG_ENDIAN 1
+#else
+#define NATIVE_BIG_ENDIAN 0
+#endif
+
+/* The number of sample frames read at once */
+#define READ_FRAMES 4096
+
+
+static VorbisToWavController *singleInstance = nil;
+
+
+@implementation VorbisToWavController
+
++ (id) singleInstance
+{
+    if (! singleInstance) {
+        singleInstance = [[VorbisToWavController alloc] init];
+    }
+
+    return singleInstance;
+}
+
+- (void) dealloc
+{
+    singleInstance = nil;
+    [super dealloc];
+}
+
+- (NSString *) name
+{
+    return @"vorbistowav";
+}
+
+- (NSArray *) fileTypes
+{
+    return [NSArray arrayWithObject: @"ogg"];
+}
+
+/**
+ * <p>libvorbisfile takes the duration from the granule positions
+ * of the last page of each logical stream. Only the headers and
+ * a few pages at the file's end are read.</p>
+ */
+- (long) duration: (NSString *) fileName
+{
+    OggVorbis_File vf;
+    double seconds;
+
+    if (ov_fopen((char *)[fileName fileSystemRepresentation], &vf) != 0) {
+        return 0;
+    }
+    seconds = ov_time_total(&vf, -1);
+    ov_clear(&vf);
+
+    if (seconds <= 0.) {
+        return 0;
+    }
+    return (long)(seconds * FramesPerSecond);
+}
+
+- (BOOL) decodeJob: (AudioDecodeJob *) job
+          toWriter: (WavWriter *) writer
+{
+    BOOL ret = YES;
+    OggVorbis_File vf;
+    NSString *source = [[job track] source];
+    char pcm[READ_FRAMES * 2 * 2];
+    unsigned long long frames = 0;
+    int section = 0;
+
+    if (ov_fopen((char *)[source fileSystemRepresentation], &vf) != 0) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"Cannot open %@."), source]];
+        return NO;
+    }
+
+    while (![job isCancelled]) {
+        vorbis_info *vi;
+        long bytes, n, i;
+        int16_t *in, *out;
+
+        bytes = ov_read(&vf, pcm, sizeof(pcm), NATIVE_BIG_ENDIAN, 2, 1, &section);
+        if (bytes == 0) {
+            break;
+        }
+        if (bytes == OV_HOLE) {
+            // Some data is missing. Go on with what follows.
+            continue;
+        }
+        if (bytes < 0) {
+            [self sendOutputString: [NSString stringWithFormat: _(@"Cannot decode %@."), source]];
+            ret = NO;
+            break;
+        }
+
+        /*
+         * The logical streams of a chained file may have different
+         * formats. We get the data of one stream at a time.
+         */
+        vi = ov_info(&vf, section);
+        if ((NULL == vi) || (vi->rate != 44100)
+                || (vi->channels < 1) || (vi->channels > 2)) {
+            [self sendOutputString: [NSString stringWithFormat: _(@"Cannot convert %@: %ld Hz, %d channels."),
+                                        source, vi ? vi->rate : 0, vi ? vi->channels : 0]];
+            ret = NO;
+            break;
+        }
+
+        n = bytes / (2 * vi->channels);
+        out = (int16_t *)[writer bytesForAppending: n * 4];
+        if (NULL == out) {
+            ret = NO;
+            break;
+        }
+        in = (int16_t *)pcm;
+        if (vi->channels == 2) {
+            memcpy(out, in, n * 4);
+        } else {
+            // A mono stream is written to both channels.
+            for (i = 0; i < n; i++) {
+                out[2*i] = in[i];
+                out[2*i+1] = in[i];
+            }
+        }
+        [writer appendedBytes: n * 4];
+
+        frames += n;
+        [job setFramesDone: frames];
+    }
+
+    ov_clear(&vf);
+
+    return ret && ![job isCancelled];
+}
+
+@end
@@ -60,6 +60,8 @@ typedef enum {
  * <item>trackProgress:  The progress of the current track in percent (0 to 100).</item>
  * <item>entireProgress: The progress of the entire process in percent (0 to 100).</item>
  * <item>bufferLevel:    The fill level of the burn buffer in percent (0 to 100).</item>
+ * <item>speed:          The speed of the process as a multiple of real time,
+ *                       0 if unknown.</item>
  * </list>
  */
 typedef struct {
@@ -69,6 +71,7 @@ typedef struct {
     double trackProgress;
     double entireProgress;
     double bufferLevel;
+    double speed;
 } ToolStatus;
 
 /**
@@ -167,6 +170,14 @@ typedef enum {
  */
 - (BOOL) isCDGrabber;
 
+/**
+ * <p>Returns the file types, i.e. the file name extensions, the
+ * bundle converts. A bundle which returns @c nil converts all types.
+ * Burn.app uses a bundle for a certain type in favour of one
+ * which converts all types.</p>
+ */
+- (NSArray *) fileTypes;
+
 /**
  * <p>Returns the duration of the track in frames.</p>
  * <br />
@@ -179,6 +190,22 @@ typedef enum {
  */
 - (long) duration: (NSString *) fileName;
 
+/**
+ * <p>Returns the durations of several tracks in frames as NSNumbers,
+ * in the order of <var>fileNames</var>. A duration is 0 if it cannot
+ * be determined. The files may be examined in parallel, so that
+ * importing many files at once does not take longer than
+ * necessary.</p>
+ * <br />
+ * <strong>Inputs</strong><br />
+ * <deflist>
+ * <term>fileNames</term>
+ * <desc>The names of the files whose durations must be
+ * calculated.</desc>
+ * </deflist>
+ */
+- (NSArray *) durations: (NSArray *) fileNames;
+
 /**
  * <p>Returns the size of the track in bytes.</p>
  * <br />
@@ -209,6 +236,65 @@ typedef enum {
 @end
 
 
+/**
+ * <p>AudioCDStreamer may be implemented by a CD grabber in addition
+ * to the AudioConverter protocol. Such a grabber can copy an audio CD
+ * on-the-fly: The tracks are not ripped to .wav files first, but the
+ * samples are written into FIFOs the burner reads from while it
+ * writes the medium.</p>
+ */
+@protocol AudioCDStreamer
+
+/**
+ * <p>Returns the exact lengths in sectors of the CD tracks in
+ * <var>tracks</var> as NSNumbers, or nil if the CD in the
+ * <em>SourceDevice</em> of <var>parameters</var> cannot be read.</p>
+ */
+- (NSArray *) sectorsOfTracks: (NSArray *) tracks
+               withParameters: (NSDictionary *) parameters;
+
+/**
+ * <p>Reads the CD tracks in <var>tracks</var> and writes the samples
+ * of each track to the FIFO [track storage], as raw 16 bit stereo
+ * data in big endian byte order. The tracks are written in the order
+ * given, each with exactly as many sectors as returned by
+ * -sectorsOfTracks:withParameters:. Returns NO if a track cannot be
+ * read or the burner stopped reading. May be stopped by -stop:.</p>
+ */
+- (BOOL) streamTracks: (NSArray *) tracks
+       withParameters: (NSDictionary *) parameters;
+
+@end
+
+
+/**
+ * <p>ParallelGrabber may be implemented by a CD grabber in addition
+ * to the AudioConverter protocol. Such a grabber can rip several CDs
+ * at once, one per drive.</p>
+ */
+@protocol ParallelGrabber
+
+/**
+ * <p>Returns a new, autoreleased instance of the tool which has its
+ * own ripping process and status. One instance is used per drive.
+ * The drive is taken from the <em>SourceDevice</em> entry of the
+ * parameters passed to the instance.</p>
+ */
+- (id) parallelGrabber;
+
+@end
+
+
+
+/**
+ * <p>LoudnessMeasurer may be implemented by an AudioConverter which
+ * writes the .wav files itself through a WavWriter. Such a converter
+ * measures the loudness of the tracks while it writes them and
+ * normalizes them if requested, see LoudnessMeter. The files of the
+ * other converters are read once more to normalize them.</p>
+ */
+@protocol LoudnessMeasurer
+@end
 
 /**
  * <p>IsoImageCreator describes the interface for a class
@@ -252,6 +338,50 @@ typedef enum {
                  toFile: (NSString *) outFile
          withParameters: (NSDictionary *) parameters;
 
+/**
+ * <p>Writes an ISO image created from the given track list into a pipe
+ * instead of a file. This is used for burning on-the-fly, where the
+ * burning program reads the image from the other end of the pipe.</p>
+ * <br />
+ * <strong>Inputs</strong><br />
+ * <deflist>
+ * <term>volumeID</term>
+ * <desc>The identifier for the volume to be created.</desc>
+ * <term>trackArray</term>
+ * <desc>An array of data tracks to be contained in the image.</desc>
+ * <term>pipe</term>
+ * <desc>The pipe to write the image to. The tool must use it as the
+ * standard output of its task, so that the writing end is closed
+ * when the task exits.</desc>
+ * <term>parameters</term>
+ * <desc>A static snapshot of the usr defaults taken when the user
+ * started the action.</desc>
+ * </deflist>
+ */
+- (BOOL) createISOImage: (NSString *) volumeID
+             withTracks: (NSArray *) trackArray
+                 toPipe: (NSPipe *) pipe
+         withParameters: (NSDictionary *) parameters;
+
+/**
+ * <p>Returns the size of the ISO image which would be created from the
+ * given track list in sectors of 2048 bytes, or -1 on error. The image
+ * itself is not created.</p>
+ * <br />
+ * <strong>Inputs</strong><br />
+ * <deflist>
+ * <term>volumeID</term>
+ * <desc>The identifier for the volume to be created.</desc>
+ * <term>trackArray</term>
+ * <desc>An array of data tracks to be contained in the image.</desc>
+ * <term>parameters</term>
+ * <desc>A static snapshot of the usr defaults taken when the user
+ * started the action.</desc>
+ * </deflist>
+ */
+- (long) sizeOfISOImage: (NSString *) volumeID
+             withTracks: (NSArray *) trackArray
+         withParameters: (NSDictionary *) parameters;
 
 @end
 
@@ -342,6 +472,24 @@ typedef enum {
 - (NSDictionary *) mediaInformationForDevice: (NSString *) device
                                   parameters: (NSDictionary *)parameters;
 
+/**
+ * <p>Returns whether the tool can burn a data track read from a pipe.
+ * If so, -burnCDFromImage:andAudioTracks:withParameters: may be passed
+ * an image whose storage is <code>-</code>. The pipe is then found in
+ * the parameters under the key <em>ImagePipe</em> and the image's size
+ * is the exact size of the data that will be read from it.</p>
+ */
+- (BOOL) canBurnOnTheFly;
+
+/**
+ * <p>Returns a new, autoreleased instance of the tool which shares the
+ * receiver's drive list but has its own burning process and status. It
+ * is used to burn the same tracks to several drives at once, one
+ * instance per drive. The drive is taken from the <em>BurnDevice</em>
+ * entry of the parameters passed to the instance.</p>
+ */
+- (id) parallelBurner;
+
 /**
  * <p>Returns whether a writable medium is inserted in the writing device.</p>
  * <br />
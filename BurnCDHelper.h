@@ -24,31 +24,65 @@
 #ifndef BURNCDHELPER_H_INC
 #define BURNCDHELPER_H_INC
 
-#include <AppKit/AppKit.h>
+#include <Foundation/Foundation.h>
 
-#include "BurnProgressController.h"
+#include "BurnSession.h"
 #include "Burn/ExternalTools.h"
 
+@class CreateISOHelper;
+@class ConvertAudioHelper;
+
+/**
+ * <p>BurnCDHelper writes the prepared tracks to the medium. If the
+ * session writes to several devices, one burner per device is run
+ * in its own thread. All of them read the same image and audio files.</p>
+ */
 @interface BurnCDHelper : NSObject
 {
-    BurnProgressController *controller;
+    BurnSession *controller;
 
 	id<BurnTool> currentTool;
+
+    /*
+     * One burner per device. The first one is currentTool.
+     */
+    NSArray *devices;
+    NSMutableArray *burners;
+
+    NSLock *threadLock;
+    int runningThreads;
+    NSMutableArray *failedDevices;
+
+    ConvertAudioHelper *audioHelper;
 }
 
-- (id) initWithController: (BurnProgressController *)aController;
+- (id) initWithController: (BurnSession *)aController;
 
 - (enum StartHelperStatus) start: (NSString *) isoImageFile audioTracks: (NSArray *) audioTracks;
+- (enum StartHelperStatus) startOnTheFly: (CreateISOHelper *) isoHelper audioTracks: (NSArray *) audioTracks;
 - (void) stop: (BOOL) immediately;
 
+/**
+ * <p>Sets the helper which streams the CD tracks into their FIFOs
+ * when an audio CD is copied on-the-fly. Must be called before
+ * burning is started.</p>
+ */
+- (void) setAudioHelper: (ConvertAudioHelper *) helper;
+
 //
 // private methods
 //
 - (void) cleanUp: (BOOL) success;
 
+- (enum StartHelperStatus) start: (NSString *) isoImageFile
+                     audioTracks: (NSArray *) audioTracks
+                       isoHelper: (CreateISOHelper *) isoHelper;
+
 
 - (void) burnTrackThread: (id) anObject;
 - (void) updateStatus: (id) timer;
+- (void) updateDevicesStatus: (id) timer;
+- (BOOL) threadsRunning;
 
 @end
 
@@ -26,8 +26,9 @@
 #include "Constants.h"
 #include "Functions.h"
 #include "Track.h"
-#include "Project.h"
 #include "AppController.h"
+#include "CreateISOHelper.h"
+#include "ConvertAudioHelper.h"
 
 #include "Burn/ExternalTools.h"
 
@@ -35,66 +36,68 @@
 
 @implementation BurnCDHelper
 
-- (id) initWithController: (BurnProgressController *)aController
+- (id) initWithController: (BurnSession *)aController
 {
     self = [super init];
     if (self) {
         controller = aController;
+        devices = nil;
+        burners = [NSMutableArray new];
+        threadLock = [NSLock new];
+        runningThreads = 0;
+        failedDevices = [NSMutableArray new];
     }
     return self;
 }
 
 - (void) dealloc
 {
+    RELEASE(devices);
+    RELEASE(burners);
+    RELEASE(threadLock);
+    RELEASE(failedDevices);
+    RELEASE(audioHelper);
     [super dealloc];
 }
 
-- (BOOL) isMediumInserted
+- (void) setAudioHelper: (ConvertAudioHelper *) helper
 {
-	BOOL isInserted = NO;
-    NSString *device = [[AppController appController] currentDevice];
-    id writer = [[AppController appController] currentWriterBundle];
-
-	if ([device isEqualToString: NOT_FOUND]) {
-		return NO;
-	}
+    ASSIGN(audioHelper, helper);
+}
 
-	// We check first, whether we have the right CD and then rip the stuff.
-	while (isInserted == NO) {
-		if (![writer isWritableMediumInDevice: device
-                                   parameters: [controller burnParameters]]) {
-			int result = NSRunInformationalAlertPanel(APP_NAME,
-				_(@"BurnCDHelper.insertCD"),
-				_(@"Common.OK"), _(@"Common.cancel"), nil);
-			if (result == NSAlertAlternateReturn) {
-				if (NSRunAlertPanel(APP_NAME, _(@"GrabAudioCDHelper.reallyStop"),
-							_(@"Common.no"), _(@"Common.yes"), nil) == NSAlertAlternateReturn) {
-					break;
-				}
-			}
-		} else {
-			isInserted = YES;
-		}
-	};
+- (enum StartHelperStatus) start: (NSString *) isoImageFile audioTracks: (NSArray *) audioTracks
+{
+    return [self start: isoImageFile audioTracks: audioTracks isoHelper: nil];
+}
 
-	return isInserted;
+/**
+ * <p>Burns the image created by <var>isoHelper</var> on-the-fly, i.e.
+ * the ISO image is piped from the image creator directly into
+ * the burner.</p>
+ */
+- (enum StartHelperStatus) startOnTheFly: (CreateISOHelper *) isoHelper audioTracks: (NSArray *) audioTracks
+{
+    return [self start: [[isoHelper onTheFlyImage] description]
+           audioTracks: audioTracks
+             isoHelper: isoHelper];
 }
 
-- (enum StartHelperStatus) start: (NSString *) isoImageFile audioTracks: (NSArray *) audioTracks
+- (enum StartHelperStatus) start: (NSString *) isoImageFile
+                     audioTracks: (NSArray *) audioTracks
+                       isoHelper: (CreateISOHelper *) isoHelper
 {
 	int i, count;
 	NSMutableArray *burnTracks = [NSMutableArray arrayWithCapacity: 5];
 	NSMutableArray *missingTracks = [NSMutableArray arrayWithCapacity: 5];
 	NSMutableDictionary * threadObject;
 	NSFileManager *fileMan = [NSFileManager defaultManager];
+    SEL statusSelector;
 
 	currentTool = [[AppController appController] currentWriterBundle];
 	if (nil == currentTool) {
-        NSRunAlertPanel(APP_NAME,
-						[NSString stringWithFormat: @"%@\n%@",
+        [controller showError: [NSString stringWithFormat: @"%@\n%@",
 									_(@"BurnCDHelper.noProgram"),
-									_(@"Common.stopProcess")],
-						_(@"Common.OK"), nil, nil);
+									_(@"Common.stopProcess")]];
         return Failed;
 	}
 
@@ -114,24 +117,34 @@
 	}
 
 	if ([missingTracks count] != 0) {
-		NSRunAlertPanel(APP_NAME,
-						[NSString stringWithFormat: @"%@\n%@\n%@",
+		[controller showError: [NSString stringWithFormat: @"%@\n%@\n%@",
 								_(@"BurnCDHelper.noFiles"),
 								[missingTracks componentsJoinedByString: @"\n"],
-								_(@"Common.stopProcess")],
-						 _(@"Common.OK"), nil, nil);
+								_(@"Common.stopProcess")]];
 		
 		return Failed;
 	}
 
+    /*
+     * Each device gets a burner of its own. They all read the
+     * same files.
+     */
+    ASSIGN(devices, [controller burnDevices]);
+    if ([devices count] == 0) {
+        return Failed;
+    }
+    [burners removeAllObjects];
+    [failedDevices removeAllObjects];
+    [burners addObject: currentTool];
+    for (i = 1; i < [devices count]; i++) {
+        [burners addObject: [(id<Burner>)currentTool parallelBurner]];
+    }
+
 	[controller setTitle: _(@"BurnCDHelper.title")];
     [controller setTrackProgress: 0. andLabel: @""];
     [controller hideTrackProgress: YES];
     [controller setEntireProgress: 0. andLabel: _(@"BurnCDHelper.settingUp")];
-
-    if (![self isMediumInserted]) {
-		return Failed;
-    }
+    [controller showDeviceProgress];
 
 	threadObject = AUTORELEASE([[NSMutableDictionary alloc] initWithCapacity: 2]);
 
@@ -140,15 +153,34 @@
     	[threadObject setObject: isoImageFile forKey: @"image"];
     if (audioTracks != nil)
     	[threadObject setObject: audioTracks forKey: @"audio"];
+    if (isoHelper != nil)
+    	[threadObject setObject: isoHelper forKey: @"isoHelper"];
+
+
+    [threadLock lock];
+    runningThreads = [devices count];
+    [threadLock unlock];
+
+    for (i = 0; i < [devices count]; i++) {
+        NSMutableDictionary *deviceObject =
+            [NSMutableDictionary dictionaryWithDictionary: threadObject];
 
+        [deviceObject setObject: [devices objectAtIndex: i] forKey: @"device"];
+        [deviceObject setObject: [burners objectAtIndex: i] forKey: @"burner"];
 
-	[NSThread detachNewThreadSelector: @selector(burnTrackThread:)
-							 toTarget: self
-						   withObject: threadObject];
+    	[NSThread detachNewThreadSelector: @selector(burnTrackThread:)
+	    						 toTarget: self
+		    				   withObject: deviceObject];
+    }
 
+    if ([devices count] > 1) {
+        statusSelector = @selector(updateDevicesStatus:);
+    } else {
+        statusSelector = @selector(updateStatus:);
+    }
 	[NSTimer scheduledTimerWithTimeInterval: 0.2
 									 target: self
-								   selector: @selector(updateStatus:)
+								   selector: statusSelector
 								   userInfo: threadObject
 									repeats: NO];
 
@@ -158,7 +190,11 @@
 - (void) stop: (BOOL) immediately
 {
     if (currentTool != nil) {
-        [(id<BurnTool>)currentTool stop: immediately];
+        int i;
+
+        for (i = 0; i < [burners count]; i++) {
+            [(id<BurnTool>)[burners objectAtIndex: i] stop: immediately];
+        }
 		logToConsole(MessageStatusError, _(@"Common.cancelled"));
     }
 }
@@ -167,7 +203,7 @@
 - (void) cleanUp: (BOOL) success
 {
     if (currentTool != nil) {
-        [(id<BurnTool>)currentTool cleanUp];
+        [burners makeObjectsPerformSelector: @selector(cleanUp)];
     }
 }
 
@@ -175,16 +211,74 @@
 {
 	Track *isoImage = nil;
 	id pool = [NSAutoreleasePool new];
-	id<Burner> burner = (id<Burner>)currentTool;
-	NSDictionary *burnParameters = [controller burnParameters];
+	id<Burner> burner = [anObject objectForKey: @"burner"];
+    NSString *device = [anObject objectForKey: @"device"];
+	NSMutableDictionary *burnParameters;
+    NSMutableDictionary *tools;
     NSString *isoImageFile = [anObject objectForKey: @"image"];
-
-	if (isoImageFile)
+    CreateISOHelper *isoHelper = [anObject objectForKey: @"isoHelper"];
+    NSPipe *pipe = nil;
+    BOOL result;
+
+    /*
+     * The burner takes the device from the parameters. Each thread
+     * gets a copy with its own device.
+     */
+    burnParameters = [NSMutableDictionary dictionaryWithDictionary:
+                                            [controller burnParameters]];
+    tools = [NSMutableDictionary dictionaryWithDictionary:
+                                    [burnParameters objectForKey: @"SelectedTools"]];
+    [tools setObject: device forKey: BurnDevice];
+    [burnParameters setObject: tools forKey: @"SelectedTools"];
+
+	if (isoHelper != nil) {
+        /*
+         * On-the-fly: The image creator writes into the pipe, the
+         * burner reads from it.
+         */
+        pipe = [NSPipe pipe];
+        [burnParameters setObject: pipe forKey: @"ImagePipe"];
+        isoImage = [isoHelper onTheFlyImage];
+        [isoHelper streamImageToPipe: pipe];
+    } else if (isoImageFile) {
 		isoImage = [[[Track alloc] initWithDataFile: isoImageFile] autorelease];
+    }
 
-	[burner burnCDFromImage: isoImage
-             andAudioTracks: [anObject objectForKey: @"tracks"]
-             withParameters: burnParameters];
+    if (audioHelper != nil) {
+        /*
+         * Copying an audio CD on-the-fly: The grabber writes the
+         * tracks into the FIFOs the burner reads from.
+         */
+        [audioHelper streamTracks];
+    }
+
+	result = [burner burnCDFromImage: isoImage
+                      andAudioTracks: [anObject objectForKey: @"tracks"]
+                      withParameters: burnParameters];
+
+    if (isoHelper != nil) {
+        /*
+         * If the burner stopped early, the image creator must not
+         * block on a pipe nobody reads from.
+         */
+        NS_DURING
+            [[pipe fileHandleForReading] closeFile];
+        NS_HANDLER
+            // already closed by ToolProcess
+        NS_ENDHANDLER
+        result = [isoHelper finishStreaming: result] && result;
+    }
+
+    if (audioHelper != nil) {
+        result = [audioHelper finishStreaming: result] && result;
+    }
+
+    [threadLock lock];
+    if (!result) {
+        [failedDevices addObject: device];
+    }
+    runningThreads--;
+    [threadLock unlock];
 
 	RELEASE(pool);
 	[NSThread exit];
@@ -253,6 +347,9 @@
 
 	default:
 		// otherwise we are stopped
+        if ([self threadsRunning]) {
+            break;
+        }
 		reFire = NO;
     	[controller setTrackProgress: 0. andLabel: nil];
     	[controller setEntireProgress: 0. andLabel: nil];
@@ -260,10 +357,11 @@
         [controller makeEntireProgressIndeterminate: NO];
 
 		// did we stop by 'Cancel' or by terminated thread?
-		if (status.processStatus == isCancelled) {
-			[controller nextStage: NO];
+		if ((status.processStatus == isCancelled)
+                || ([failedDevices count] != 0)) {
+			[controller stage: BurnCD finished: NO];
 		} else {
-			[controller nextStage: YES];
+			[controller stage: BurnCD finished: YES];
 		}
 	}
 	processStatus = status.processStatus;
@@ -278,4 +376,107 @@
 	}
 }
 
+/**
+ * <p>Shows the status of each burner in the device's progress row
+ * and the average progress in the progress bar for the entire CD.</p>
+ */
+- (void) updateDevicesStatus: (id)timer
+{
+    int i, count = [burners count];
+    double entire = 0.;
+    BOOL fixating = NO;
+    BOOL running = [self threadsRunning];
+    NSArray *audioTracks = [[timer userInfo] objectForKey: @"audio"];
+    NSString *isoImageFile = [[timer userInfo] objectForKey: @"image"];
+
+    for (i = 0; i < count; i++) {
+        ToolStatus status = [[burners objectAtIndex: i] getStatus];
+        NSString *device = [devices objectAtIndex: i];
+        NSString *label = nil;
+        int track = status.trackNumber - 1;
+
+        switch (status.processStatus) {
+        case isWaiting:
+        case isPreparing:
+            label = _(@"BurnCDHelper.settingUp");
+            break;
+
+        case isBurning:
+            if (isoImageFile) {
+                track--;
+            }
+            if (track < 0) {
+                label = isoImageFile;
+            } else if (track < [audioTracks count]) {
+                label = [[audioTracks objectAtIndex: track] description];
+            }
+            if (label != nil) {
+                label = [NSString stringWithFormat: _(@"Common.trackTitle"), label];
+            }
+            break;
+
+        case isFixating:
+            label = _(@"BurnCDHelper.fixatingCD");
+            fixating = YES;
+            break;
+
+        default:
+            if (running) {
+                break;
+            }
+            if ([failedDevices containsObject: device]) {
+                label = _(@"Common.cancelled");
+            } else {
+                label = _(@"Common.finished");
+                status.entireProgress = 100.;
+            }
+        }
+
+        [controller setProgress: status.entireProgress
+                       andLabel: label
+                      forDevice: device];
+        entire += status.entireProgress;
+    }
+    entire /= count;
+
+    if (running) {
+        [controller setAbortEnabled: !fixating];
+        [controller setEntireProgress: entire andLabel: _(@"BurnCDHelper.CDTotal")];
+		[controller setMiniwindowToTrack: 0. Entire: entire];
+
+		[NSTimer scheduledTimerWithTimeInterval: 0.2
+										 target: self
+									   selector: @selector(updateDevicesStatus:)
+									   userInfo: [timer userInfo]
+									    repeats: NO];
+        return;
+    }
+
+   	[controller setEntireProgress: 0. andLabel: nil];
+
+    /*
+     * Copies burned successfully are kept, but the session
+     * fails if a single one failed.
+     */
+    if ([failedDevices count] != 0) {
+        logToConsole(MessageStatusError, [NSString stringWithFormat:
+                        _(@"BurnCDHelper.devicesFailed"),
+                        [failedDevices componentsJoinedByString: @", "]]);
+        [controller stage: BurnCD finished: NO];
+    } else {
+        [controller stage: BurnCD finished: YES];
+    }
+}
+
+- (BOOL) threadsRunning
+{
+    BOOL running;
+
+    [threadLock lock];
+    running = (runningThreads > 0);
+    [threadLock unlock];
+
+    return running;
+}
+
 @end
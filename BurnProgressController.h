@@ -26,21 +26,16 @@
 
 #include <AppKit/AppKit.h>
 
-#include "Burn/ExternalTools.h"
+#include "BurnSession.h"
 
-@class ConvertAudioHelper;
-@class CreateISOHelper;
-@class BurnCDHelper;
-
-enum StartHelperStatus {
-    Failed,
-    Started,
-    Done
-};
-
-@interface BurnProgressController : NSWindowController
+/**
+ * <p>BurnProgressController shows the progress of a burning session
+ * in a window and asks the user by means of alert panels.</p>
+ */
+@interface BurnProgressController : BurnSession
 {
     // ivars
+    NSWindow *window;
     id closeButton;
     id abortButton;
     id entireLabel;
@@ -48,42 +43,21 @@ enum StartHelperStatus {
     id entireProgress;
     id trackProgress;
 
-	// data
-	NSString *volumeId;
-	NSArray *dataTracks;
-	NSArray *audioTracks;
-	NSDictionary *cdList;
-    BOOL isoImageOnly;
-
-	NSMutableDictionary *burnParameters;
-
-	NSString *isoImageFile;
-
-	// current status
-	short processStatus;
+    /*
+     * One progress row per drive if there are several of them.
+     */
+    NSMutableDictionary *deviceRows;
+    NSRect windowFrame;
 
     double mwTrack;
     double mwEntire;
-
-    int stage;
-
-    ConvertAudioHelper *convertHelper;
-    BurnCDHelper *burnHelper;
-    CreateISOHelper *createIsoHelper;
 }
 
 - (id) init;
 
-- (id) initWithVolumeId: (NSString *) volId
-             dataTracks: (NSArray *) dTracks
-            audioTracks: (NSArray *) aTracks
-                 cdList: (NSDictionary *) cds
-                isoOnly: (BOOL) isoOnly;
-
-- (id) initWithIsoImage: (NSString *) isoImage;
-
-- (void) startProcess;
-- (void) nextStage: (BOOL)success;
+- (NSWindow *) window;
+- (void) setWindow: (NSWindow *) aWindow;
+- (void) close;
 
 //
 // action methods
@@ -91,29 +65,6 @@ enum StartHelperStatus {
 - (void) closeClicked: (id) sender;
 - (void) abortClicked: (id) sender;
 
-//
-// access methods
-//
-- (NSDictionary *) burnParameters;
-- (NSString *)isoImageFile;
-- (NSDictionary *) cdList;
-- (void) setTitle: (NSString *)title;
-- (void) setTrackProgress: (double) value andLabel: (NSString *) label;
-- (void) hideTrackProgress: (BOOL) hide;
-- (void) setEntireProgress: (double) value andLabel: (NSString *) label;
-- (void) hideEntireProgress: (BOOL) hide;
-- (void) makeEntireProgressIndeterminate: (BOOL) ind;
-- (void) setAbortEnabled: (BOOL) enabled;
-- (void) setMiniwindowToTrack: (double) track Entire: (double) entire;
-
-//
-// private methods
-//
-- (void) cleanUp: (BOOL) success;
-- (BOOL) createTempDirectory;
-
-
 @end
 
-
 #endif
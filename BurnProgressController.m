@@ -2,7 +2,7 @@
 /*
  *	BurnProgressController.m
  *
- *	Copyright (c) 2002-2005, 2011
+ *	Copyright (c) 2002-2005, 2011, 2026
  *
  *	Author: Andreas Schik <andreas@schik.de>
  *
@@ -25,23 +25,13 @@
 
 #include "Constants.h"
 #include "Functions.h"
-#include "Track.h"
-#include "Project.h"
 #include "AppController.h"
-#include "ConvertAudioHelper.h"
-#include "CreateISOHelper.h"
-#include "BurnCDHelper.h"
 #include "ConsolePanel.h"
 
 
-enum BurnStage {
-    None,
-    ConvertAudio,
-    GrabCD,
-    CreateISO,
-    BurnCD
-};
-    
+#define DEVICE_ROW_HEIGHT 40
+#define DEVICE_ROW_MARGIN 8
+
 @interface BurnProgressController (Private)
 
 - (void) setMiniwindowImage;
@@ -58,7 +48,7 @@ enum BurnStage {
     NSImageRep *rep;
     NSImage *image;
     
-    if (![[self window] isMiniaturized])
+    if (![window isMiniaturized])
         return;
 
     if (mwTrack < 0)
@@ -71,7 +61,7 @@ enum BurnStage {
                                                 delegate: self];
     [rep setSize: NSMakeSize(48,48)];
     [image addRepresentation: rep];
-    [[self window] setMiniwindowImage: image];
+    [window setMiniwindowImage: image];
     DESTROY(image);
 }
 
@@ -115,43 +105,16 @@ enum BurnStage {
 
 - (id) init
 {
-    self = [self initWithWindowNibName: @"BurnProgress"];
-
-	return self;
-}
+    NSString *nibName = @"BurnProgress";
 
-- (id) initWithVolumeId: (NSString *)volId
-             dataTracks: (NSArray *)dTracks
-            audioTracks: (NSArray *)aTracks
-                 cdList: (NSDictionary *)cds
-                isoOnly: (BOOL) isoOnly
-{
-    self = [self init];
-
-    if (self != nil) {
-    	ASSIGN(volumeId, volId);
-	    ASSIGN(dataTracks, dTracks);
-    	ASSIGN(audioTracks, aTracks);
-	    ASSIGN(cdList, cds);
-        isoImageOnly=isoOnly;
+    self = [super init];
+    if (self == nil) {
+        return nil;
     }
-    return self;
-}
-
 
-- (id) initWithIsoImage: (NSString *)isoImage
-{
-    self = [self init];
+    window = nil;
+    deviceRows = nil;
 
-    if (self != nil) {
-        ASSIGN(isoImageFile, isoImage);
-    }
-    return self;
-}
-
-- (id) initWithWindowNibName: (NSString *) nibName
-{
-	self = [super initWithWindowNibName: nibName];
 	if (![NSBundle loadNibNamed: nibName owner: self]) {
 		logToConsole(MessageStatusError, [NSString stringWithFormat:
 							_(@"Common.loadNibFail"), nibName]);
@@ -159,23 +122,11 @@ enum BurnStage {
 	    NSDictionary *params = nil;
         BOOL openConsole = NO;
 
-        [[self window] setExcludedFromWindowsMenu: YES];
+        [window setReleasedWhenClosed: NO];
+        [window setExcludedFromWindowsMenu: YES];
 		[trackProgress setDoubleValue: 0];
 		[entireProgress setDoubleValue: 0];
 
-        stage = None;
-        convertHelper = nil;
-        createIsoHelper = nil;
-        burnHelper = nil;
-
-        /*
-         * We take a snap shot of the current parameter set. Thus,
-         * another session may already override the parameters while
-         * this process is taking place.
-         * autoreleased!!!
-         */
-   	    burnParameters = [NSMutableDictionary new];
-        [burnParameters setDictionary: [[NSUserDefaults standardUserDefaults] dictionaryRepresentation]];
         // check whether the console should be opened
 	    params = [burnParameters objectForKey: @"SessionParameters"];
         openConsole = [[params objectForKey: @"OpenConsole"] boolValue];
@@ -183,9 +134,8 @@ enum BurnStage {
 	        [[ConsolePanel consolePanel] showWindow: self];
         }
 
-        isoImageFile = nil;
-        [[self window] setFrameAutosaveName: @"BurnProgress"];
-        [[self window] setFrameUsingName: @"BurnProgress"];
+        [window setFrameAutosaveName: @"BurnProgress"];
+        [window setFrameUsingName: @"BurnProgress"];
 	}
     return self;
 }
@@ -199,44 +149,55 @@ enum BurnStage {
 
 - (void) dealloc
 {
-	RELEASE(volumeId);
-	RELEASE(dataTracks);
-	RELEASE(audioTracks);
-	RELEASE(isoImageFile);
-	RELEASE(cdList);
-	RELEASE(burnParameters);
-    RELEASE(convertHelper);
-    RELEASE(burnHelper);
-    RELEASE(createIsoHelper);
+    [window setDelegate: nil];
+    RELEASE(window);
+    RELEASE(deviceRows);
 
 	[super dealloc];
 }
 
-//
-// access methods
-//
-- (NSDictionary *) burnParameters
+- (NSWindow *) window
 {
-    return burnParameters;
+    return window;
 }
 
-- (NSString *)isoImageFile
+- (void) setWindow: (NSWindow *) aWindow
 {
-    return isoImageFile;
+    ASSIGN(window, aWindow);
 }
 
-- (NSDictionary *) cdList
+- (void) close
 {
-    return cdList;
+    [window close];
 }
 
+//
+// progress
+//
+
 - (void) setTitle: (NSString *)title
 {
+    [super setTitle: title];
     if (title && [title length]) {
-        [[self window] setTitle: title];
+        if (backgroundStatus != nil) {
+            [window setTitle: [NSString stringWithFormat: @"%@ (%@)",
+                                                windowTitle, backgroundStatus]];
+        } else {
+            [window setTitle: title];
+        }
     }
 }
 
+/*
+ * The status is appended to the window title.
+ */
+- (void) setBackgroundStatus: (NSString *) status
+{
+    [super setBackgroundStatus: status];
+    if (windowTitle != nil) {
+        [self setTitle: windowTitle];
+    }
+}
 
 - (void) setTrackProgress: (double) value andLabel: (NSString *) label
 {
@@ -302,12 +263,20 @@ enum BurnStage {
 
 - (void) closeClicked: (id)sender
 {
+    /*
+     * Do not let the progress rows make it into the saved frame.
+     */
+    if (deviceRows != nil) {
+        [window setFrame: windowFrame display: NO];
+    }
 	[self close];
 
-	RELEASE(self);
 	logToConsole(MessageStatusInfo, @"Burning finished.");
 
-    [[AppController appController] unlockBurner];
+    if (devicesLocked) {
+        [[AppController appController] unlockDevices: burnDevices];
+    }
+	RELEASE(self);
 }
 
 
@@ -317,17 +286,7 @@ enum BurnStage {
 							_(@"Common.no"), _(@"Common.yes"), nil) == NSAlertDefaultReturn) {
 		return;
 	}
-
-    if (convertHelper != nil) {
-        [convertHelper stop: YES];
-    }
-    if (createIsoHelper != nil) {
-        [createIsoHelper stop: YES];
-    }
-    if (burnHelper != nil) {
-        [burnHelper stop: YES];
-    }
-    [self cleanUp: NO];
+    [self abortSession];
 }
 
 - (void) startProcess
@@ -337,88 +296,12 @@ enum BurnStage {
 		[self close];
 		return;
 	}
-
-	// create the temp path if it does not exist
-	if (![self createTempDirectory]) {
-		logToConsole(MessageStatusError, @"Could not create directory for temporary files.");
-		return;
-	}
-
-    stage = None;
-    [self nextStage: YES];
+    [super startProcess];
 }
 
-- (void) nextStage: (BOOL) success
+- (void) sessionFinished: (BOOL) success
 {
-    enum StartHelperStatus result;
-    if (!success) {
-        [self cleanUp: NO];
-    } else {
-        switch (stage) {
-        case None:
-            stage = ConvertAudio;
-            convertHelper = [[ConvertAudioHelper alloc] initWithController: self];
-            result = [convertHelper start: audioTracks];
-	    	if (Done == result) {
-                /*
-                 * Fall through to CD grabbing
-                 */
-            } else {
-    	    	if (Failed == result)
-                    [self cleanUp: NO];
-                break;
-            }
-        case ConvertAudio:
-            stage = CreateISO;
-            createIsoHelper = [[CreateISOHelper alloc] initWithController: self];
-            result = [createIsoHelper start: dataTracks volumeId: volumeId];
-    		if (Done == result) {
-                /*
-                 * Fall through to burning
-                 */
-            } else {
-                if (Failed == result)
-                    [self cleanUp: NO];
-                break;
-            }
-        case CreateISO:
-        {
-            stage = BurnCD;
-            if (isoImageOnly == YES) {
-                /*
-                 * Simply fall through, as we not have anything to burn.
-                 */
-            } else {
-                /*
-                * If we have not been passed the name of an ISO
-                * image file, we try to get the one created by the
-                * helper.
-                */
-                if (isoImageFile == nil) {
-                    isoImageFile = RETAIN([createIsoHelper isoImageFile]);
-                }
-                burnHelper = [[BurnCDHelper alloc] initWithController: self];
-                result = [burnHelper start: isoImageFile audioTracks: audioTracks];
-                if (Failed == result)
-                    [self cleanUp: NO];
-                break;
-            }
-        }
-        case BurnCD:
-            [self cleanUp: YES];
-            break;
-        }
-    }
-}
-
-
-- (void) cleanUp: (BOOL)success
-{
-	[convertHelper cleanUp: success];
-	[burnHelper cleanUp: success];
-	[createIsoHelper cleanUp: success];
-
-	[[self window] setTitle: _(@"Common.finished")];
+	[window setTitle: _(@"Common.finished")];
 	[closeButton setEnabled: YES];
 	[abortButton setEnabled: NO];
     [self hideTrackProgress: YES];
@@ -426,59 +309,49 @@ enum BurnStage {
 	[entireProgress setDoubleValue: 0.];
 	if (success == NO) {
 		[entireLabel setStringValue: _(@"BurnProgressController.noSuccess")];
-		logToConsole(MessageStatusError, _(@"BurnProgressController.noSuccess"));
 	} else {
 		[entireLabel setStringValue: _(@"BurnProgressController.success")];
-		logToConsole(MessageStatusInfo, _(@"BurnProgressController.success"));
 	}
+	[super sessionFinished: success];
 }
 
-- (BOOL) createTempDirectory
+- (void) showError: (NSString *) message
 {
-	int i, count;
-	BOOL isDir = YES;
-	NSFileManager *fileMan = [NSFileManager defaultManager];
-	NSDictionary *params = [burnParameters objectForKey: @"SessionParameters"];
-    NSString *tempDir = [params objectForKey: @"TempDirectory"];
-
-	if (!tempDir || ![tempDir length]) {
-		NSRunInformationalAlertPanel(APP_NAME,
-					[NSString stringWithFormat: @"%@\n%@",
-						_(@"BurnProgressController.provideTempDir"),
-						_(@"Common.stopProcess")],
-					_(@"Common.OK"), nil, nil);
-		return NO;
-	}
-	if (![fileMan fileExistsAtPath: tempDir isDirectory: &isDir]) {
-		NSMutableString *createDir = [[NSMutableString alloc] init];
-		NSArray *pathComponents = [tempDir pathComponents];
-		count = [pathComponents count];
-		// try to create the directories along out temp path
-		for (i = 0; i < count; i++) {
-			createDir = [[createDir stringByAppendingPathComponent: [pathComponents objectAtIndex: i]] copy];
-			if (![fileMan fileExistsAtPath: createDir]) {
-				if (![fileMan createDirectoryAtPath: createDir attributes: nil]) {
-					NSRunAlertPanel(APP_NAME,
-								[NSString stringWithFormat: @"%@ %@.\n%@",
-									_(@"BurnProgressController.createDirFail"), createDir,
-									_(@"Common.stopProcess")],
-								_(@"Common.OK"), nil, nil);
-					return NO;
-				}
-			}
+	NSRunAlertPanel(APP_NAME, message, _(@"Common.OK"), nil, nil);
+}
+
+- (BOOL) askForMedium: (NSString *) message
+{
+    /*
+     * The user may cancel the request, but must confirm it.
+     */
+	if (NSRunInformationalAlertPanel(APP_NAME, message,
+			_(@"Common.OK"), _(@"Common.cancel"), nil) == NSAlertAlternateReturn) {
+		if (NSRunAlertPanel(APP_NAME, _(@"GrabAudioCDHelper.reallyStop"),
+				_(@"Common.no"), _(@"Common.yes"), nil) == NSAlertAlternateReturn) {
+			return NO;
 		}
-	} else if (!isDir) {
-		NSRunAlertPanel(APP_NAME,
-				[NSString stringWithFormat: @"%@ %@\n%@",
-						tempDir,
-						_(@"BurnProgressController.existsNoDir"),
-						_(@"Common.stopProcess")],
-					_(@"Common.OK"), nil, nil);
-		return NO;
 	}
 	return YES;
 }
 
+- (enum ExistingImageAction) actionForExistingImage: (NSString *) path
+{
+	int result = NSRunAlertPanel(APP_NAME,
+				[NSString stringWithFormat: _(@"CreateISOHelper.imageExists"), path],
+				_(@"CreateISOHelper.useImage"), _(@"CreateISOHelper.overwrite"),
+				_(@"CreateISOHelper.createNew"));
+
+	switch (result) {
+	case NSAlertDefaultReturn:
+		return ReuseImage;
+	case NSAlertAlternateReturn:
+		return OverwriteImage;
+	default:
+		return CreateNewImage;
+	}
+}
+
 - (void) setMiniwindowToTrack: (double) track Entire: (double) entire
 {
     if (track >= 0)
@@ -489,4 +362,116 @@ enum BurnStage {
     [self setMiniwindowImage];
 }
 
+- (void) showProgressForDevices: (NSArray *) devices
+{
+    int i, count = [devices count];
+    NSView *contentView = [window contentView];
+    NSRect frame;
+    float width, y;
+
+    if ((count < 2) || (deviceRows != nil)) {
+        return;
+    }
+
+    deviceRows = [[NSMutableDictionary alloc] initWithCapacity: count];
+    windowFrame = [window frame];
+
+    /*
+     * Grow the window and put the rows on top of the existing
+     * controls, which keep their distance to the bottom.
+     */
+    [contentView setAutoresizesSubviews: NO];
+    frame = windowFrame;
+    frame.size.height += count * DEVICE_ROW_HEIGHT;
+    frame.origin.y -= count * DEVICE_ROW_HEIGHT;
+    [window setFrame: frame display: NO];
+    [contentView setAutoresizesSubviews: YES];
+
+    width = NSWidth([contentView frame]) - 2 * DEVICE_ROW_MARGIN;
+    y = NSHeight([contentView frame]) - DEVICE_ROW_MARGIN;
+
+    for (i = 0; i < count; i++) {
+        NSString *device = [devices objectAtIndex: i];
+        NSTextField *label;
+        NSProgressIndicator *progress;
+
+        y -= 18;
+        label = [[NSTextField alloc] initWithFrame:
+                        NSMakeRect(DEVICE_ROW_MARGIN, y, width, 18)];
+        [label setEditable: NO];
+        [label setSelectable: NO];
+        [label setBezeled: NO];
+        [label setDrawsBackground: NO];
+        [label setStringValue: device];
+        [label setAutoresizingMask: NSViewWidthSizable | NSViewMinYMargin];
+        [contentView addSubview: label];
+
+        y -= 16;
+        progress = [[NSProgressIndicator alloc] initWithFrame:
+                        NSMakeRect(DEVICE_ROW_MARGIN, y, width, 16)];
+        [progress setIndeterminate: NO];
+        [progress setMinValue: 0.];
+        [progress setMaxValue: 100.];
+        [progress setDoubleValue: 0.];
+        [progress setAutoresizingMask: NSViewWidthSizable | NSViewMinYMargin];
+        [contentView addSubview: progress];
+
+        y -= DEVICE_ROW_HEIGHT - 34;
+
+        [deviceRows setObject: [NSArray arrayWithObjects: label, progress, nil]
+                       forKey: device];
+        RELEASE(label);
+        RELEASE(progress);
+    }
+    [window display];
+}
+
+- (void) hideDeviceProgress
+{
+    NSView *contentView = [window contentView];
+    NSEnumerator *e = [deviceRows objectEnumerator];
+    NSArray *row;
+    NSRect frame;
+
+    if (nil == deviceRows) {
+        return;
+    }
+
+    while ((row = [e nextObject]) != nil) {
+        [[row objectAtIndex: 0] removeFromSuperview];
+        [[row objectAtIndex: 1] removeFromSuperview];
+    }
+
+    /*
+     * Shrink the window again, the other controls keep their
+     * distance to the bottom.
+     */
+    [contentView setAutoresizesSubviews: NO];
+    frame = [window frame];
+    frame.size.height -= [deviceRows count] * DEVICE_ROW_HEIGHT;
+    frame.origin.y += [deviceRows count] * DEVICE_ROW_HEIGHT;
+    [window setFrame: frame display: YES];
+    [contentView setAutoresizesSubviews: YES];
+
+    DESTROY(deviceRows);
+}
+
+- (void) setProgress: (double) value
+            andLabel: (NSString *) label
+           forDevice: (NSString *) device
+{
+    NSArray *row = [deviceRows objectForKey: device];
+
+    if (nil == row) {
+        return;
+    }
+    if (value >= 0) {
+        [[row objectAtIndex: 1] setDoubleValue: value];
+    }
+    if (label != nil) {
+        [[row objectAtIndex: 0] setStringValue:
+                [NSString stringWithFormat: @"%@: %@", device, label]];
+    }
+}
+
 @end
@@ -0,0 +1,217 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  BurnSession.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef BURNSESSION_H_INC
+#define BURNSESSION_H_INC
+
+#include <Foundation/Foundation.h>
+
+@class ConvertAudioHelper;
+@class CreateISOHelper;
+@class MediumHelper;
+@class BurnCDHelper;
+
+enum StartHelperStatus {
+    Failed,
+    Started,
+    Done
+};
+
+/**
+ * <p>What to do if the ISO image file of a session already exists.</p>
+ */
+enum ExistingImageAction {
+    ReuseImage,
+    OverwriteImage,
+    CreateNewImage,
+    CancelSession
+};
+
+/**
+ * <p>The stages of a burning session. Each stage is a node in
+ * the session's task graph. A stage is started as soon as all
+ * stages it depends on have finished, so independent stages
+ * (e.g. audio conversion and ISO creation) run concurrently.</p>
+ */
+enum BurnStage {
+    None,
+    ConvertAudio,
+    CreateISO,
+    CheckMedium,
+    BlankMedium,
+    BurnCD,
+    LastStage
+};
+
+/**
+ * <p>BurnSession runs the stages of a burning session. It does not
+ * depend on the user interface, so it is shared by Burn.app and
+ * burn-cli. The helpers report their progress and ask their questions
+ * by means of the methods in the sections <em>user interaction</em> and
+ * <em>progress</em>. The implementations of BurnSession only log the
+ * messages, subclasses override them to show them to the user.</p>
+ */
+@interface BurnSession : NSObject
+{
+	// data
+	NSString *volumeId;
+	NSArray *dataTracks;
+	NSArray *audioTracks;
+	NSDictionary *cdList;
+    BOOL isoImageOnly;
+
+	NSMutableDictionary *burnParameters;
+
+    // the drives we write to
+    NSArray *burnDevices;
+    BOOL devicesLocked;
+
+	NSString *isoImageFile;
+
+    unsigned runningStages;
+    unsigned finishedStages;
+    BOOL failed;
+
+    NSString *windowTitle;
+    NSString *backgroundStatus;
+
+    ConvertAudioHelper *convertHelper;
+    BurnCDHelper *burnHelper;
+    CreateISOHelper *createIsoHelper;
+    MediumHelper *mediumHelper;
+}
+
+- (id) init;
+
+- (id) initWithVolumeId: (NSString *) volId
+             dataTracks: (NSArray *) dTracks
+            audioTracks: (NSArray *) aTracks
+                 cdList: (NSDictionary *) cds
+                isoOnly: (BOOL) isoOnly;
+
+- (id) initWithIsoImage: (NSString *) isoImage;
+
+- (void) startProcess;
+
+/**
+ * <p>Tells the session that a stage has finished. Stages depending
+ * on it are started if possible. If <var>success</var> is NO, all
+ * running stages are stopped and the session ends.</p>
+ */
+- (void) stage: (enum BurnStage) aStage finished: (BOOL) success;
+
+/**
+ * <p>Returns YES if the progress of <var>aStage</var> should
+ * be shown in the progress bars. Only the earliest running stage
+ * owns the progress bars. All other running stages report their
+ * progress by means of -setBackgroundStatus:.</p>
+ */
+- (BOOL) showsProgressOfStage: (enum BurnStage) aStage;
+
+/**
+ * <p>Stops all running stages and ends the session without
+ * success.</p>
+ */
+- (void) abortSession;
+
+/**
+ * <p>Called when the session has ended. The default implementation
+ * only logs the result. Subclasses show it to the user.</p>
+ */
+- (void) sessionFinished: (BOOL) success;
+
+//
+// user interaction
+//
+- (void) showError: (NSString *) message;
+
+/**
+ * <p>Asks the user to insert a medium. Returns NO if the session
+ * shall be stopped instead. The default implementation returns NO.</p>
+ */
+- (BOOL) askForMedium: (NSString *) message;
+- (enum ExistingImageAction) actionForExistingImage: (NSString *) path;
+
+//
+// access methods
+//
+- (NSDictionary *) burnParameters;
+- (NSString *)isoImageFile;
+- (NSDictionary *) cdList;
+- (BOOL) isoImageOnly;
+- (NSArray *) burnDevices;
+
+//
+// progress
+//
+- (void) setTitle: (NSString *)title;
+
+/**
+ * <p>Shows the status of a stage which runs in the background,
+ * i.e. which does not own the progress bars. Pass nil to remove
+ * it.</p>
+ */
+- (void) setBackgroundStatus: (NSString *) status;
+- (void) setTrackProgress: (double) value andLabel: (NSString *) label;
+- (void) hideTrackProgress: (BOOL) hide;
+- (void) setEntireProgress: (double) value andLabel: (NSString *) label;
+- (void) hideEntireProgress: (BOOL) hide;
+- (void) makeEntireProgressIndeterminate: (BOOL) ind;
+- (void) setAbortEnabled: (BOOL) enabled;
+- (void) setMiniwindowToTrack: (double) track Entire: (double) entire;
+
+/**
+ * <p>Shows a progress row for each of the burn devices. Nothing
+ * is shown if we write to a single device.</p>
+ */
+- (void) showDeviceProgress;
+
+/**
+ * <p>Shows a progress row for each of <var>devices</var>, e.g. for
+ * the drives CDs are ripped from. Nothing is shown if there is only
+ * one device or rows are shown already.</p>
+ */
+- (void) showProgressForDevices: (NSArray *) devices;
+
+/**
+ * <p>Removes the progress rows of the devices.</p>
+ */
+- (void) hideDeviceProgress;
+- (void) setProgress: (double) value
+            andLabel: (NSString *) label
+           forDevice: (NSString *) device;
+
+//
+// private methods
+//
+- (void) initSession;
+- (void) cleanUp: (BOOL) success;
+- (BOOL) createTempDirectory;
+- (void) startReadyStages;
+- (unsigned) dependenciesOfStage: (enum BurnStage) aStage;
+- (enum StartHelperStatus) startStage: (enum BurnStage) aStage;
+- (void) stopRunningStages;
+
+@end
+
+#endif
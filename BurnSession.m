@@ -0,0 +1,519 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *	BurnSession.m
+ *
+ *	Copyright (c) 2002-2005, 2011, 2026
+ *
+ *	Author: Andreas Schik <andreas@schik.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program; if not, write to the Free Software
+ *	Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "BurnSession.h"
+
+#include "Constants.h"
+#include "Functions.h"
+#include "AppController.h"
+#include "ConvertAudioHelper.h"
+#include "CreateISOHelper.h"
+#include "BurnCDHelper.h"
+#include "MediumHelper.h"
+
+
+#define STAGE(s) (1 << (s))
+#define ALL_STAGES (STAGE(LastStage) - 1)
+
+/*
+ * The task graph of a burning session. For each stage the
+ * entry holds the set of stages which must have finished before
+ * the stage may be started. Everything not listed here runs
+ * concurrently.
+ */
+static const unsigned stageDependencies[LastStage] = {
+    0,                                      /* None */
+    0,                                      /* ConvertAudio */
+    0,                                      /* CreateISO */
+    0,                                      /* CheckMedium */
+    STAGE(CheckMedium),                     /* BlankMedium */
+    STAGE(ConvertAudio) | STAGE(CreateISO)
+        | STAGE(CheckMedium) | STAGE(BlankMedium) /* BurnCD */
+};
+
+
+@implementation BurnSession
+
+- (id) init
+{
+    self = [super init];
+
+    if (self != nil) {
+        [self initSession];
+    }
+    return self;
+}
+
+- (id) initWithVolumeId: (NSString *)volId
+             dataTracks: (NSArray *)dTracks
+            audioTracks: (NSArray *)aTracks
+                 cdList: (NSDictionary *)cds
+                isoOnly: (BOOL) isoOnly
+{
+    self = [self init];
+
+    if (self != nil) {
+    	ASSIGN(volumeId, volId);
+	    ASSIGN(dataTracks, dTracks);
+    	ASSIGN(audioTracks, aTracks);
+	    ASSIGN(cdList, cds);
+        isoImageOnly=isoOnly;
+    }
+    return self;
+}
+
+
+- (id) initWithIsoImage: (NSString *)isoImage
+{
+    self = [self init];
+
+    if (self != nil) {
+        ASSIGN(isoImageFile, isoImage);
+    }
+    return self;
+}
+
+/**
+ * <p>Sets up the state of the session. Called by -init.</p>
+ */
+- (void) initSession
+{
+    runningStages = 0;
+    finishedStages = 0;
+    failed = NO;
+    windowTitle = nil;
+    backgroundStatus = nil;
+    convertHelper = nil;
+    createIsoHelper = nil;
+    burnHelper = nil;
+    mediumHelper = nil;
+    burnDevices = nil;
+    devicesLocked = NO;
+
+    /*
+     * We take a snap shot of the current parameter set. Thus,
+     * another session may already override the parameters while
+     * this process is taking place.
+     * autoreleased!!!
+     */
+    burnParameters = [NSMutableDictionary new];
+    [burnParameters setDictionary: [[NSUserDefaults standardUserDefaults] dictionaryRepresentation]];
+
+    burnDevices = RETAIN([[AppController appController]
+                            burnDevicesForParameters: burnParameters]);
+
+    isoImageFile = nil;
+}
+
+- (void) dealloc
+{
+	RELEASE(volumeId);
+	RELEASE(dataTracks);
+	RELEASE(audioTracks);
+	RELEASE(isoImageFile);
+	RELEASE(cdList);
+	RELEASE(burnParameters);
+    RELEASE(convertHelper);
+    RELEASE(burnHelper);
+    RELEASE(createIsoHelper);
+    RELEASE(mediumHelper);
+    RELEASE(windowTitle);
+    RELEASE(backgroundStatus);
+    RELEASE(burnDevices);
+
+	[super dealloc];
+}
+
+//
+// access methods
+//
+/*
+ * The stages read the parameters from their threads at the same time.
+ * A stage which needs other values passes a copy to its tools, the
+ * dictionary itself is never changed after -init.
+ */
+- (NSDictionary *) burnParameters
+{
+    return burnParameters;
+}
+
+- (NSString *)isoImageFile
+{
+    return isoImageFile;
+}
+
+- (NSDictionary *) cdList
+{
+    return cdList;
+}
+
+- (BOOL) isoImageOnly
+{
+    return isoImageOnly;
+}
+
+- (NSArray *) burnDevices
+{
+    return burnDevices;
+}
+
+- (BOOL) showsProgressOfStage: (enum BurnStage) aStage
+{
+    /*
+     * The earliest running stage owns the progress bars.
+     */
+    return (runningStages & (STAGE(aStage) - 1)) == 0;
+}
+
+//
+// progress
+//
+
+- (void) setTitle: (NSString *)title
+{
+    if (title && [title length]) {
+        ASSIGN(windowTitle, title);
+    }
+}
+
+- (void) setBackgroundStatus: (NSString *) status
+{
+    ASSIGN(backgroundStatus, status);
+}
+
+- (void) setTrackProgress: (double) value andLabel: (NSString *) label
+{
+}
+
+- (void) hideTrackProgress: (BOOL) hide
+{
+}
+
+- (void) setEntireProgress: (double) value andLabel: (NSString *) label
+{
+}
+
+- (void) hideEntireProgress: (BOOL) hide
+{
+}
+
+- (void) makeEntireProgressIndeterminate: (BOOL) ind
+{
+}
+
+- (void) setAbortEnabled: (BOOL) enabled
+{
+}
+
+- (void) setMiniwindowToTrack: (double) track Entire: (double) entire
+{
+}
+
+- (void) showDeviceProgress
+{
+    [self showProgressForDevices: burnDevices];
+}
+
+- (void) showProgressForDevices: (NSArray *) devices
+{
+}
+
+- (void) hideDeviceProgress
+{
+}
+
+- (void) setProgress: (double) value
+            andLabel: (NSString *) label
+           forDevice: (NSString *) device
+{
+}
+
+//
+// user interaction
+//
+
+- (void) showError: (NSString *) message
+{
+    logToConsole(MessageStatusError, message);
+}
+
+- (BOOL) askForMedium: (NSString *) message
+{
+    logToConsole(MessageStatusError, message);
+    return NO;
+}
+
+- (enum ExistingImageAction) actionForExistingImage: (NSString *) path
+{
+    logToConsole(MessageStatusError, [NSString stringWithFormat:
+                        _(@"CreateISOHelper.imageExists"), path]);
+    return CancelSession;
+}
+
+//
+// session
+//
+
+- (void) abortSession
+{
+    if (failed == YES) {
+        return;
+    }
+    failed = YES;
+    [self stopRunningStages];
+    [self cleanUp: NO];
+}
+
+- (void) startProcess
+{
+	// no tracks -> nothing to do
+	if ((audioTracks == nil) && (dataTracks == nil) && (isoImageFile == nil)) {
+		[self sessionFinished: YES];
+		return;
+	}
+
+	/*
+	 * Even a session which only creates an ISO image keeps the
+	 * burner busy, as the project must not be modified meanwhile.
+	 */
+	if (![[AppController appController] lockDevices: burnDevices]) {
+		[self showError: _(@"Common.burnerLocked")];
+		[self cleanUp: NO];
+		return;
+	}
+	devicesLocked = YES;
+
+	// create the temp path if it does not exist
+	if (![self createTempDirectory]) {
+		logToConsole(MessageStatusError, @"Could not create directory for temporary files.");
+		[self cleanUp: NO];
+		return;
+	}
+
+    runningStages = 0;
+    finishedStages = STAGE(None);
+    failed = NO;
+    [self startReadyStages];
+}
+
+- (void) startReadyStages
+{
+    int s;
+
+    for (s = None + 1; (s < LastStage) && (failed == NO); s++) {
+        enum StartHelperStatus result;
+
+        if (((runningStages | finishedStages) & STAGE(s)) != 0) {
+            continue;
+        }
+        if ((finishedStages & [self dependenciesOfStage: s])
+                != [self dependenciesOfStage: s]) {
+            continue;
+        }
+
+        runningStages |= STAGE(s);
+        result = [self startStage: s];
+        /*
+         * Stages which did not need to start a thread are finished
+         * right away. This may recursively start other stages.
+         */
+        if (Started != result) {
+            [self stage: s finished: (Done == result)];
+        }
+    }
+}
+
+/*
+ * A CD grabbed in one of the burners must be ripped and ejected
+ * before the medium to burn is checked. As long as we do not know
+ * the drive of a CD, we must assume the worst.
+ */
+- (unsigned) dependenciesOfStage: (enum BurnStage) aStage
+{
+    if ((CheckMedium == aStage)
+            && ((finishedStages & STAGE(ConvertAudio)) == 0)
+            && [convertHelper mayGrabFromDevices: burnDevices]) {
+        return stageDependencies[aStage] | STAGE(ConvertAudio);
+    }
+    return stageDependencies[aStage];
+}
+
+- (enum StartHelperStatus) startStage: (enum BurnStage) aStage
+{
+    switch (aStage) {
+    case ConvertAudio:
+        convertHelper = [[ConvertAudioHelper alloc] initWithController: self];
+        return [convertHelper start: audioTracks];
+
+    case CreateISO:
+        if ([dataTracks count] == 0) {
+            return Done;
+        }
+        createIsoHelper = [[CreateISOHelper alloc] initWithController: self];
+        return [createIsoHelper start: dataTracks volumeId: volumeId];
+
+    case CheckMedium:
+        if (isoImageOnly == YES) {
+            return Done;
+        }
+        mediumHelper = [[MediumHelper alloc] initWithController: self];
+        return [mediumHelper checkMedium];
+
+    case BlankMedium:
+        if (isoImageOnly == YES) {
+            return Done;
+        }
+        return [mediumHelper blankMedium];
+
+    case BurnCD:
+        if (isoImageOnly == YES) {
+            return Done;
+        }
+        /*
+         * If we have not been passed the name of an ISO
+         * image file, we try to get the one created by the
+         * helper.
+         */
+        burnHelper = [[BurnCDHelper alloc] initWithController: self];
+        if ([convertHelper isOnTheFly]) {
+            [burnHelper setAudioHelper: convertHelper];
+        }
+        if ((isoImageFile == nil) && [createIsoHelper isOnTheFly]) {
+            return [burnHelper startOnTheFly: createIsoHelper audioTracks: audioTracks];
+        }
+        if (isoImageFile == nil) {
+            isoImageFile = RETAIN([createIsoHelper isoImageFile]);
+        }
+        return [burnHelper start: isoImageFile audioTracks: audioTracks];
+
+    default:
+        return Done;
+    }
+}
+
+- (void) stage: (enum BurnStage) aStage finished: (BOOL) success
+{
+    runningStages &= ~STAGE(aStage);
+
+    /*
+     * Late notifications of stages which were stopped because
+     * of an error or a user abort are ignored.
+     */
+    if (failed == YES) {
+        return;
+    }
+
+    if (!success) {
+        failed = YES;
+        [self stopRunningStages];
+        [self cleanUp: NO];
+        return;
+    }
+
+    finishedStages |= STAGE(aStage);
+    [self setBackgroundStatus: nil];
+
+    if (finishedStages == ALL_STAGES) {
+        [self cleanUp: YES];
+    } else {
+        [self startReadyStages];
+    }
+}
+
+- (void) stopRunningStages
+{
+    if (runningStages & STAGE(ConvertAudio)) {
+        [convertHelper stop: YES];
+    }
+    if (runningStages & STAGE(CreateISO)) {
+        [createIsoHelper stop: YES];
+    }
+    if (runningStages & (STAGE(CheckMedium) | STAGE(BlankMedium))) {
+        [mediumHelper stop: YES];
+    }
+    if (runningStages & STAGE(BurnCD)) {
+        [burnHelper stop: YES];
+    }
+}
+
+
+- (void) cleanUp: (BOOL)success
+{
+	[convertHelper cleanUp: success];
+	[burnHelper cleanUp: success];
+	[createIsoHelper cleanUp: success];
+	[mediumHelper cleanUp: success];
+
+	[self sessionFinished: success];
+}
+
+- (void) sessionFinished: (BOOL) success
+{
+	if (success == NO) {
+		logToConsole(MessageStatusError, _(@"BurnProgressController.noSuccess"));
+	} else {
+		logToConsole(MessageStatusInfo, _(@"BurnProgressController.success"));
+	}
+}
+
+- (BOOL) createTempDirectory
+{
+	int i, count;
+	BOOL isDir = YES;
+	NSFileManager *fileMan = [NSFileManager defaultManager];
+	NSDictionary *params = [burnParameters objectForKey: @"SessionParameters"];
+    NSString *tempDir = [params objectForKey: @"TempDirectory"];
+
+	if (!tempDir || ![tempDir length]) {
+		[self showError: [NSString stringWithFormat: @"%@\n%@",
+						_(@"BurnProgressController.provideTempDir"),
+						_(@"Common.stopProcess")]];
+		return NO;
+	}
+	if (![fileMan fileExistsAtPath: tempDir isDirectory: &isDir]) {
+		NSMutableString *createDir = [[NSMutableString alloc] init];
+		NSArray *pathComponents = [tempDir pathComponents];
+		count = [pathComponents count];
+		// try to create the directories along out temp path
+		for (i = 0; i < count; i++) {
+			createDir = [[createDir stringByAppendingPathComponent: [pathComponents objectAtIndex: i]] copy];
+			if (![fileMan fileExistsAtPath: createDir]) {
+				if (![fileMan createDirectoryAtPath: createDir attributes: nil]) {
+					[self showError: [NSString stringWithFormat: @"%@ %@.\n%@",
+									_(@"BurnProgressController.createDirFail"), createDir,
+									_(@"Common.stopProcess")]];
+					return NO;
+				}
+			}
+		}
+	} else if (!isDir) {
+		[self showError: [NSString stringWithFormat: @"%@ %@\n%@",
+						tempDir,
+						_(@"BurnProgressController.existsNoDir"),
+						_(@"Common.stopProcess")]];
+		return NO;
+	}
+	return YES;
+}
+
+@end
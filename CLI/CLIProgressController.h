@@ -0,0 +1,105 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  CLIProgressController.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CLIPROGRESSCONTROLLER_H_INC
+#define CLIPROGRESSCONTROLLER_H_INC
+
+#include <signal.h>
+
+#include <Foundation/Foundation.h>
+
+#include "BurnSession.h"
+
+/*
+ * Exit codes of burn-cli.
+ */
+enum CLIExitCode {
+    ExitOK = 0,
+    ExitUsage = 1,
+    ExitNoProject = 2,
+    ExitFailed = 3,
+    ExitNoMedium = 4,
+    ExitImageExists = 5
+};
+
+/*
+ * Set by the signal handlers of burn-cli when the user wants to
+ * stop the session.
+ */
+extern volatile sig_atomic_t cliInterrupted;
+
+/**
+ * <p>CLIProgressController runs a burning session without a window.
+ * Instead of updating the progress bars it writes one line per change
+ * to stdout. Each line starts with a keyword followed by tab separated
+ * fields:</p>
+ * <list>
+ *  <item><code>STAGE</code> title</item>
+ *  <item><code>STATUS</code> status of a stage running in the background</item>
+ *  <item><code>PROGRESS</code> entire track entire-label track-label</item>
+ *  <item><code>DEVICE</code> device progress label</item>
+ *  <item><code>RESULT</code> <code>ok</code> or <code>failed</code></item>
+ * </list>
+ * <p>A progress value of -1 means that the value is unknown. Questions
+ * the GUI would ask are answered by the policies set up front.</p>
+ */
+@interface CLIProgressController : BurnSession
+{
+    NSString *trackText;
+    NSString *entireText;
+    double trackValue;
+    double entireValue;
+    NSString *lastProgress;
+
+    enum ExistingImageAction imageAction;
+    BOOL failIfImageExists;
+    NSTimeInterval mediaTimeout;
+    NSDate *mediaDeadline;
+
+    BOOL finished;
+    int exitCode;
+}
+
+- (void) setActionForExistingImage: (enum ExistingImageAction) action;
+- (void) setFailIfImageExists: (BOOL) fail;
+
+/**
+ * <p>Sets the number of seconds to wait for a usable medium. With
+ * a timeout of 0 the session fails immediately if there is none.</p>
+ */
+- (void) setMediaTimeout: (NSTimeInterval) seconds;
+
+- (id) init;
+
+- (BOOL) isFinished;
+- (int) exitCode;
+
+//
+// private methods
+//
+- (void) printLine: (NSString *) line;
+- (void) printProgress;
+
+@end
+
+#endif
@@ -0,0 +1,275 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  CLIProgressController.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+
+#include "CLIProgressController.h"
+
+#include "Constants.h"
+#include "Functions.h"
+#include "AppController.h"
+
+volatile sig_atomic_t cliInterrupted = 0;
+
+/*
+ * Fields must neither contain tabs nor line breaks.
+ */
+static NSString *field(NSString *text)
+{
+    NSMutableString *result;
+
+    if (nil == text) {
+        return @"";
+    }
+    result = [NSMutableString stringWithString: text];
+    [result replaceOccurrencesOfString: @"\t" withString: @" "
+                               options: 0 range: NSMakeRange(0, [result length])];
+    [result replaceOccurrencesOfString: @"\n" withString: @" "
+                               options: 0 range: NSMakeRange(0, [result length])];
+    return result;
+}
+
+
+@implementation CLIProgressController
+
+- (id) init
+{
+    self = [super init];
+    if (self != nil) {
+        trackText = nil;
+        entireText = nil;
+        trackValue = -1;
+        entireValue = -1;
+        lastProgress = nil;
+        imageAction = ReuseImage;
+        failIfImageExists = NO;
+        mediaTimeout = 0;
+        mediaDeadline = nil;
+        finished = NO;
+        exitCode = ExitOK;
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    RELEASE(trackText);
+    RELEASE(entireText);
+    RELEASE(lastProgress);
+    RELEASE(mediaDeadline);
+    [super dealloc];
+}
+
+- (void) setActionForExistingImage: (enum ExistingImageAction) action
+{
+    imageAction = action;
+}
+
+- (void) setFailIfImageExists: (BOOL) fail
+{
+    failIfImageExists = fail;
+}
+
+- (void) setMediaTimeout: (NSTimeInterval) seconds
+{
+    mediaTimeout = seconds;
+}
+
+- (BOOL) isFinished
+{
+    return finished;
+}
+
+- (int) exitCode
+{
+    return exitCode;
+}
+
+//
+// progress output
+//
+
+- (void) setTitle: (NSString *) title
+{
+    if (title && [title length]) {
+        ASSIGN(windowTitle, title);
+        [self printLine: [NSString stringWithFormat: @"STAGE\t%@", field(title)]];
+    }
+}
+
+- (void) setBackgroundStatus: (NSString *) status
+{
+    if ((status != nil) && ![status isEqualToString: backgroundStatus]) {
+        [self printLine: [NSString stringWithFormat: @"STATUS\t%@", field(status)]];
+    }
+    ASSIGN(backgroundStatus, status);
+}
+
+- (void) setTrackProgress: (double) value andLabel: (NSString *) label
+{
+    if (value >= 0) {
+        trackValue = value;
+    }
+    if (label != nil) {
+        ASSIGN(trackText, label);
+    }
+    [self printProgress];
+}
+
+- (void) setEntireProgress: (double) value andLabel: (NSString *) label
+{
+    if (value >= 0) {
+        entireValue = value;
+    }
+    if (label != nil) {
+        ASSIGN(entireText, label);
+    }
+    [self printProgress];
+}
+
+- (void) hideTrackProgress: (BOOL) hide
+{
+    if (hide) {
+        trackValue = -1;
+        DESTROY(trackText);
+    }
+}
+
+- (void) hideEntireProgress: (BOOL) hide
+{
+    if (hide) {
+        entireValue = -1;
+        DESTROY(entireText);
+    }
+}
+
+- (void) makeEntireProgressIndeterminate: (BOOL) ind
+{
+    if (ind) {
+        entireValue = -1;
+    }
+}
+
+- (void) setProgress: (double) value
+            andLabel: (NSString *) label
+           forDevice: (NSString *) device
+{
+    [self printLine: [NSString stringWithFormat: @"DEVICE\t%@\t%.1f\t%@",
+                                field(device), value, field(label)]];
+}
+
+- (void) sessionFinished: (BOOL) success
+{
+    [super sessionFinished: success];
+    if (!success && (exitCode == ExitOK)) {
+        exitCode = ExitFailed;
+    }
+    [self printLine: [NSString stringWithFormat: @"RESULT\t%@",
+                                success ? @"ok" : @"failed"]];
+
+    if (devicesLocked) {
+        [[AppController appController] unlockDevices: burnDevices];
+        devicesLocked = NO;
+    }
+    finished = YES;
+}
+
+//
+// user interaction
+//
+
+- (void) showError: (NSString *) message
+{
+    logToConsole(MessageStatusError, message);
+}
+
+- (BOOL) askForMedium: (NSString *) message
+{
+    NSDate *now = [NSDate date];
+    NSDate *limit;
+
+    if (nil == mediaDeadline) {
+        mediaDeadline = [[NSDate alloc] initWithTimeIntervalSinceNow: mediaTimeout];
+    }
+    if ([now compare: mediaDeadline] != NSOrderedAscending) {
+        logToConsole(MessageStatusError, message);
+        exitCode = ExitNoMedium;
+        return NO;
+    }
+
+    logToConsole(MessageStatusWarning, message);
+
+    /*
+     * Keep the run loop going while we wait, so that the stages
+     * running in the background still report their progress.
+     * The caller checks again afterwards.
+     */
+    limit = [[NSDate dateWithTimeIntervalSinceNow: 5] earlierDate: mediaDeadline];
+    while (([limit timeIntervalSinceNow] > 0) && !cliInterrupted && !failed) {
+        if (![[NSRunLoop currentRunLoop] runMode: NSDefaultRunLoopMode
+                                      beforeDate: limit]) {
+            [NSThread sleepUntilDate: [limit earlierDate:
+                                        [NSDate dateWithTimeIntervalSinceNow: 0.5]]];
+        }
+    }
+    return !cliInterrupted && !failed;
+}
+
+- (enum ExistingImageAction) actionForExistingImage: (NSString *) path
+{
+    logToConsole(MessageStatusWarning, [NSString stringWithFormat:
+                        _(@"CreateISOHelper.imageExists"), path]);
+    if (failIfImageExists) {
+        exitCode = ExitImageExists;
+        return CancelSession;
+    }
+    return imageAction;
+}
+
+//
+// private methods
+//
+
+- (void) printLine: (NSString *) line
+{
+    fprintf(stdout, "%s\n", [line UTF8String]);
+    fflush(stdout);
+}
+
+- (void) printProgress
+{
+    NSString *line = [NSString stringWithFormat: @"PROGRESS\t%.1f\t%.1f\t%@\t%@",
+                                entireValue, trackValue,
+                                field(entireText), field(trackText)];
+
+    /*
+     * The helpers update the progress several times a second,
+     * even if nothing has changed.
+     */
+    if (![line isEqualToString: lastProgress]) {
+        ASSIGN(lastProgress, line);
+        [self printLine: line];
+    }
+}
+
+@end
@@ -0,0 +1,199 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  main.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <signal.h>
+
+#include <Foundation/Foundation.h>
+
+#include "Constants.h"
+#include "Functions.h"
+#include "AppController.h"
+#include "ProjectFile.h"
+#include "CLIProgressController.h"
+
+
+static void handleSignal(int sig)
+{
+    cliInterrupted = 1;
+}
+
+/*
+ * Messages go to stderr, so that stdout only carries the progress.
+ */
+static void logToStderr(NSString *priority, NSString *theMessage)
+{
+    NSString *level = @"INFO";
+
+    if ([priority isEqualToString: MessageStatusError]) {
+        level = @"ERROR";
+    } else if ([priority isEqualToString: MessageStatusWarning]) {
+        level = @"WARNING";
+    } else if ([priority isEqualToString: MessageStatusToolOutput]) {
+        level = @"TOOL";
+    }
+    fprintf(stderr, "%s: %s\n", [level UTF8String], [theMessage UTF8String]);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s [options] project.burnprj\n"
+        "\n"
+        "Options:\n"
+        "  --iso-only                  only create the ISO image\n"
+        "  --image-exists=POLICY       what to do if the ISO image exists:\n"
+        "                              reuse (default), overwrite, new or fail\n"
+        "  --media-timeout=SECONDS     wait this long for a usable medium (default 0)\n"
+        "  --help                      show this help\n"
+        "\n"
+        "Exit codes:\n"
+        "  0 success, 1 usage, 2 project not loaded, 3 session failed,\n"
+        "  4 no medium, 5 ISO image exists\n",
+        name);
+}
+
+int main(int argc, const char *argv[])
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSUserDefaults *defaults;
+    NSDictionary *appDomain;
+    NSString *projectFile = nil;
+    NSData *data;
+    ProjectFile *project;
+    CLIProgressController *session;
+    enum ExistingImageAction imageAction = ReuseImage;
+    BOOL failIfImageExists = NO;
+    BOOL isoOnly = NO;
+    double mediaTimeout = 0;
+    int i, rc;
+
+    for (i = 1; i < argc; i++) {
+        NSString *arg = [NSString stringWithUTF8String: argv[i]];
+
+        if ([arg isEqualToString: @"--iso-only"]) {
+            isoOnly = YES;
+        } else if ([arg hasPrefix: @"--image-exists="]) {
+            NSString *policy = [arg substringFromIndex: 15];
+
+            if ([policy isEqualToString: @"reuse"]) {
+                imageAction = ReuseImage;
+            } else if ([policy isEqualToString: @"overwrite"]) {
+                imageAction = OverwriteImage;
+            } else if ([policy isEqualToString: @"new"]) {
+                imageAction = CreateNewImage;
+            } else if ([policy isEqualToString: @"fail"]) {
+                failIfImageExists = YES;
+            } else {
+                usage(argv[0]);
+                RELEASE(pool);
+                return ExitUsage;
+            }
+        } else if ([arg hasPrefix: @"--media-timeout="]) {
+            mediaTimeout = [[arg substringFromIndex: 16] doubleValue];
+        } else if ([arg isEqualToString: @"--help"]) {
+            usage(argv[0]);
+            RELEASE(pool);
+            return ExitOK;
+        } else if ([arg hasPrefix: @"-"] || (projectFile != nil)) {
+            usage(argv[0]);
+            RELEASE(pool);
+            return ExitUsage;
+        } else {
+            projectFile = arg;
+        }
+    }
+
+    if (nil == projectFile) {
+        usage(argv[0]);
+        RELEASE(pool);
+        return ExitUsage;
+    }
+
+    setLogHandler(logToStderr);
+
+    /*
+     * We use the settings of Burn.app. Options passed on the
+     * command line still take precedence.
+     */
+    defaults = [NSUserDefaults standardUserDefaults];
+    appDomain = [defaults persistentDomainForName: @"Burn"];
+    if (appDomain != nil) {
+        [defaults registerDefaults: appDomain];
+    }
+
+    [[AppController appController] loadTools];
+
+    data = [NSData dataWithContentsOfFile: projectFile];
+    project = AUTORELEASE([[ProjectFile alloc] initWithData: data]);
+    if (nil == project) {
+        logToConsole(MessageStatusError, [NSString stringWithFormat:
+                            _(@"CLI.loadFailed"), projectFile]);
+        RELEASE(pool);
+        return ExitNoProject;
+    }
+    if ([project numberOfTracks] == 0) {
+        logToConsole(MessageStatusError, [NSString stringWithFormat:
+                            _(@"CLI.noTracks"), projectFile]);
+        RELEASE(pool);
+        return ExitNoProject;
+    }
+
+    session = [[CLIProgressController alloc] initWithVolumeId: [project volumeId]
+                                                   dataTracks: [project dataTracks]
+                                                  audioTracks: [project audioTracks]
+                                                       cdList: [project cdList]
+                                                      isoOnly: isoOnly];
+    [session setActionForExistingImage: imageAction];
+    [session setFailIfImageExists: failIfImageExists];
+    [session setMediaTimeout: mediaTimeout];
+
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+
+    [session startProcess];
+
+    while (![session isFinished]) {
+        NSDate *limit = [NSDate dateWithTimeIntervalSinceNow: 0.5];
+
+        if (cliInterrupted) {
+            cliInterrupted = 0;
+            [session abortSession];
+            continue;
+        }
+        /*
+         * The helpers poll their threads by means of timers. If there
+         * is none, the run loop returns at once.
+         */
+        if (![[NSRunLoop currentRunLoop] runMode: NSDefaultRunLoopMode
+                                      beforeDate: limit]) {
+            [NSThread sleepUntilDate: limit];
+        }
+    }
+
+    rc = [session exitCode];
+    RELEASE(session);
+    RELEASE(pool);
+
+    return rc;
+}
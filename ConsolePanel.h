@@ -32,8 +32,8 @@
 
 	// ivars
 	BOOL lastLineWasEmpty;
-	NSMutableArray *logMessages;
-	NSLock *appendLock;
+	BOOL mirrorToolOutput;
+	NSMutableAttributedString *batch;
 }
 
 - (id) init;
@@ -43,7 +43,7 @@
 //
 // other methods
 //
-- (void) messageWasReceived: (id) not;
+- (void) appendMessage: (NSString *) message priority: (NSString *) priority;
 - (void) appendOutput: (id) timer;
 
 + (id) consolePanel;
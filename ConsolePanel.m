@@ -23,8 +23,8 @@
 
 #include "ConsolePanel.h"
 #include "Constants.h"
-
-NSString *_ConsoleMessage = @"ConsoleMessage";
+#include "Functions.h"
+#include "LogBus.h"
 
 static ConsolePanel *consolePanel = nil;
 
@@ -35,18 +35,44 @@ void releaseSharedConsole()
 	consolePanel = nil;
 }
 
-
-void logToConsole(NSString *priority, NSString *theMessage)
+void openSharedConsole()
 {
 	// create console if not already done
-	[ConsolePanel consolePanel];
-
-	[[NSNotificationCenter defaultCenter]
-		postNotificationName: _ConsoleMessage
-		object: nil
-		userInfo: [NSDictionary dictionaryWithObjectsAndKeys:
-									priority, @"Priority",
-									theMessage, @"Message", nil]];
+	if (consolePanel == nil) {
+		[ConsolePanel consolePanel];
+	}
+}
+
+static void appendFromBus(NSString *priority, NSString *message, void *context)
+{
+	[(ConsolePanel *)context appendMessage: message priority: priority];
+}
+
+static NSDictionary *attributesForPriority(NSString *priority)
+{
+	static NSDictionary *toolOutput = nil, *info, *warning, *error;
+
+	if (toolOutput == nil) {
+		toolOutput = [[NSDictionary alloc] initWithObjectsAndKeys:
+						    [NSColor darkGrayColor], NSForegroundColorAttributeName, nil];
+		info = [[NSDictionary alloc] initWithObjectsAndKeys:
+						    [NSColor blackColor], NSForegroundColorAttributeName, nil];
+		warning = [[NSDictionary alloc] initWithObjectsAndKeys:
+						    [NSColor blueColor], NSForegroundColorAttributeName, nil];
+		error = [[NSDictionary alloc] initWithObjectsAndKeys:
+						    [NSColor redColor], NSForegroundColorAttributeName, nil];
+	}
+
+	if ([priority isEqualToString: MessageStatusToolOutput]) {
+		return toolOutput;
+	} else if ([priority isEqualToString: MessageStatusInfo]) {
+		return info;
+	} else if ([priority isEqualToString: MessageStatusWarning]) {
+		return warning;
+	} else if ([priority isEqualToString: MessageStatusError]) {
+		return error;
+	}
+	return nil;
 }
 
 @implementation ConsolePanel
@@ -66,12 +92,12 @@ void logToConsole(NSString *priority, NSString *theMessage)
 	    self = [super initWithWindowNibName: windowNibName];
 		consolePanel = self;
 
-		// The array is used to temporarily store the messages and is emptied
-		// by a timer.
-		// We need this to decouple the GUI action from the actual posting
-		// of the output, as this might have happend in a separate thread.
+		// The messages are posted to the log bus from any thread and
+		// collected here by a timer. We need this to decouple the GUI
+		// action from the actual posting of the output, as this might
+		// have happend in a separate thread.
 		// And as we all know, is -gui not thread-safe...
-		logMessages = [NSMutableArray new];
+		batch = [NSMutableAttributedString new];
 
 		[[self window] setFrameAutosaveName: @"ConsoleWindow"];
 		[[self window] setFrameUsingName: @"ConsoleWindow"];
@@ -81,15 +107,7 @@ void logToConsole(NSString *priority, NSString *theMessage)
 
 - (void) dealloc
 {
-	[[NSNotificationCenter defaultCenter] removeObserver: self
-						   name: _ConsoleMessage
-						   object: nil];
-	[[NSDistributedNotificationCenter defaultCenter] removeObserver: self
-						   name: ExternalToolOutput
-						   object: nil];
-
-	[appendLock release];
-	[logMessages release];
+	[batch release];
 	[super dealloc];
 }
 
@@ -116,19 +134,7 @@ void logToConsole(NSString *priority, NSString *theMessage)
 //
 - (void) windowDidLoad
 {
-	appendLock = [NSLock new];
-
-	[[NSNotificationCenter defaultCenter] addObserver: self
-						   selector: @selector(messageWasReceived:)
-						   name: _ConsoleMessage
-						   object: nil];
-
-	[[NSDistributedNotificationCenter defaultCenter] addObserver: self
-						   selector: @selector(messageWasReceived:)
-						   name: ExternalToolOutput
-						   object: nil];
-
-	// This timer process the message array.
+	// This timer drains the log bus.
 	[NSTimer scheduledTimerWithTimeInterval: 0.5
 								target: self
 							  selector: @selector(appendOutput:)
@@ -140,27 +146,24 @@ void logToConsole(NSString *priority, NSString *theMessage)
 //
 // other methods
 //
-- (void) messageWasReceived: (id) not
+- (void) appendMessage: (NSString *) message priority: (NSString *) priority
 {
-	NSString *priority;
-	NSString *message;
-	NSMutableAttributedString *output;
-	NSDictionary *attributes = nil;
-
-	// extract the output string from the message
-	message = [[not userInfo] objectForKey: @"Message"];
-	if (message == nil)
-		message = [[not userInfo] objectForKey: @"Output"];
-
 	if (message == nil) {
 		return;
 	}
-
-	// get the priority
-	priority = [[not userInfo] objectForKey: @"Priority"];
 	if (priority == nil)
 		priority = MessageStatusToolOutput;
 
+	/*
+	 * Other processes may still listen to the output of the tools.
+	 */
+	if (mirrorToolOutput && [priority isEqualToString: MessageStatusToolOutput]) {
+		[[NSDistributedNotificationCenter defaultCenter]
+					postNotificationName: ExternalToolOutput
+					object: nil
+					userInfo: [NSDictionary dictionaryWithObject: message forKey: @"Output"]];
+	}
+
 	// check for empty lines
 	if (([message length] == 0) ||
 			[message isEqualToString: @"\n"] || [message isEqualToString: @"\r"] ||
@@ -178,60 +181,40 @@ void logToConsole(NSString *priority, NSString *theMessage)
 		message = [message stringByAppendingString: @"\n"];
 
 	// set color for the message due to priority
-	if ([priority isEqualToString: MessageStatusToolOutput]) {
-		attributes= [NSDictionary dictionaryWithObjectsAndKeys:
-						    [NSColor darkGrayColor], NSForegroundColorAttributeName,
-						    NULL];
-	} else if ([priority isEqualToString: MessageStatusInfo]) {
-		attributes= [NSDictionary dictionaryWithObjectsAndKeys:
-						    [NSColor blackColor], NSForegroundColorAttributeName,
-						    NULL];
-	} else if ([priority isEqualToString: MessageStatusWarning]) {
-		attributes= [NSDictionary dictionaryWithObjectsAndKeys:
-						    [NSColor blueColor], NSForegroundColorAttributeName,
-						    NULL];
-	} else if ([priority isEqualToString: MessageStatusError]) {
-		attributes= [NSDictionary dictionaryWithObjectsAndKeys:
-						    [NSColor redColor], NSForegroundColorAttributeName,
-						    NULL];
-	}
-
-	output = [NSMutableAttributedString new];
-
-	// append message to output
-	[output appendAttributedString: [[[NSAttributedString new] initWithString: message
-												 attributes: attributes] autorelease]];
-
-	// add to message array
-	[appendLock lock];
-	[logMessages addObject: output];
-	[appendLock unlock];
-
-	[output release];
+	[batch appendAttributedString: AUTORELEASE([[NSAttributedString alloc]
+									initWithString: message
+										attributes: attributesForPriority(priority)])];
 }
 
 
 - (void) appendOutput: (id)timer
 {
-	BOOL mustScroll = NO;
-	int i;
+	NSDictionary *params =
+		[[NSUserDefaults standardUserDefaults] objectForKey: @"GeneralParameters"];
+	unsigned long lost;
    	NSRange range;
 
-	// lock the output window for a moment
-	[appendLock lock];
+	mirrorToolOutput = [[params objectForKey: @"MirrorToolOutput"] boolValue];
+
+	/*
+	 * Collect everything in one attributed string. Appending to
+	 * the text view only once is much cheaper than once per line.
+	 */
+	logBusDrain(appendFromBus, self, LOG_BUS_SIZE);
+	lost = logBusDropped();
+	if (lost > 0) {
+		[self appendMessage: [NSString stringWithFormat:
+									_(@"ConsolePanel.dropped"), lost]
+				   priority: MessageStatusWarning];
+	}
 
-	for (i = 0; i < [logMessages count]; i++) {
-		mustScroll = YES;
-		// extract message from timer data and append it to output window
+	if ([batch length] > 0) {
+		// extract messages from the batch and append them to output window
    		range = NSMakeRange ([[outputWindow string] length], 0);
 	   	[outputWindow replaceCharactersInRange: range
-						  withAttributedString: (NSAttributedString*)[logMessages objectAtIndex: i]];
-	}
-	[logMessages removeAllObjects];
+						  withAttributedString: batch];
+		[batch deleteCharactersInRange: NSMakeRange(0, [batch length])];
 
-	[appendLock unlock];
-
-	if (mustScroll) {
 	   	range = NSMakeRange ([[outputWindow string] length], 0);
 		[outputWindow scrollRangeToVisible: range];
 	}
@@ -242,7 +225,6 @@ void logToConsole(NSString *priority, NSString *theMessage)
 				 			  userInfo: nil
 							   repeats: NO];
 }
-
 + (id) consolePanel
 {
     if (consolePanel == nil) {
@@ -0,0 +1,130 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ConversionCache.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CONVERSIONCACHE_H_INC
+#define CONVERSIONCACHE_H_INC
+
+#include <Foundation/Foundation.h>
+
+#include "Burn/ExternalTools.h"
+
+@class Track;
+
+/**
+ * <p>ConversionCache keeps the .wav files created by the audio
+ * converters across burning sessions. Burning the same compilation
+ * again thus does not decode the tracks again.</p>
+ * <p>The files live in the directory <code>ConversionCache</code> in
+ * UserLibraryPath(). Each file is named after a hash of its key, which
+ * is made up of the source file's path, size and modification date
+ * (or the CDDB id and track number for tracks from an audio CD) and
+ * the converter's name and settings.</p>
+ * <p>The cache is limited by the <em>ConversionCacheSize</em> entry
+ * of the SessionParameters in MB. If it is missing or 0, the cache
+ * is not used. When the limit is exceeded, the least recently used
+ * files are removed.</p>
+ * <p>Several sessions may use the cache at once. A file handed out by
+ * -fileForKey: or -storeFile:forKey: is in use until the session
+ * passes its key to -releaseKeys:. Files in use are never removed.</p>
+ */
+@interface ConversionCache : NSObject
+{
+    NSString *cachePath;
+    NSMutableDictionary *entries;
+    // the keys of the files in use, once per session using them
+    NSCountedSet *pinnedKeys;
+    NSLock *cacheLock;
+    BOOL dirty;
+}
+
++ (ConversionCache *) sharedCache;
+
+/**
+ * <p>Returns the size limit of the cache in bytes as defined by
+ * <var>parameters</var>. 0 means the cache is disabled.</p>
+ */
++ (unsigned long long) cacheSizeForParameters: (NSDictionary *) parameters;
+
+/**
+ * <p>Returns the key for <var>track</var> converted by <var>tool</var>
+ * or nil, if the source of the track cannot be found.</p>
+ */
++ (NSString *) keyForTrack: (Track *) track
+                      tool: (id<BurnTool>) tool
+                parameters: (NSDictionary *) parameters;
+
+/**
+ * <p>Returns the path of the cached file for <var>key</var> or nil, if
+ * there is none. The entry is marked as used and the file is in use
+ * until the key is released.</p>
+ */
+- (NSString *) fileForKey: (NSString *) key;
+
+/**
+ * <p>Moves <var>file</var> into the cache and returns its new path.
+ * The file is in use until the key is released. Returns nil if the
+ * file could not be moved. In this case, the file is left where it
+ * is.</p>
+ * <p>If another session has stored a file for <var>key</var> in the
+ * meantime and still uses it, that one is kept and <var>file</var> is
+ * removed.</p>
+ */
+- (NSString *) storeFile: (NSString *) file forKey: (NSString *) key;
+
+/**
+ * <p>Marks the files for <var>keys</var> as no longer used by the
+ * session which got them from -fileForKey: or -storeFile:forKey:.</p>
+ */
+- (void) releaseKeys: (NSArray *) keys;
+
+/**
+ * <p>Removes the least recently used files until the cache
+ * is not larger than <var>limit</var> bytes. Files in use are
+ * kept.</p>
+ */
+- (void) trimToSize: (unsigned long long) limit;
+
+/**
+ * <p>Removes all files which are not in use from the cache and
+ * returns the number of bytes freed.</p>
+ */
+- (unsigned long long) evictAll;
+
+- (unsigned long long) size;
+
+/**
+ * <p>Writes the index if entries have been marked as used since it
+ * was written last.</p>
+ */
+- (void) synchronize;
+
+//
+// private methods
+//
+- (void) readIndex;
+- (void) writeIndex;
+- (void) removeEntryForKey: (NSString *) key;
+
+@end
+
+#endif
@@ -0,0 +1,400 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ConversionCache.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "ConversionCache.h"
+
+#include "Constants.h"
+#include "Functions.h"
+#include "LoudnessMeter.h"
+#include "Track.h"
+
+
+static ConversionCache *sharedCache = nil;
+static NSLock *sharedCacheLock = nil;
+
+@interface NSDictionary (ConversionCache)
+- (NSComparisonResult) compareLastUsed: (NSDictionary *) other;
+@end
+
+/*
+ * The keys of an entry in the cache's index.
+ */
+static NSString *EntryFile = @"File";
+static NSString *EntrySize = @"Size";
+static NSString *EntryLastUsed = @"LastUsed";
+
+
+/*
+ * 64 bit FNV-1a hash of the key. Used as name of the cached file.
+ */
+static NSString *fileNameForKey(NSString *key)
+{
+    const unsigned char *p = (const unsigned char *)[key UTF8String];
+    unsigned long long hash = 14695981039346656037ULL;
+
+    while (*p) {
+        hash ^= *p++;
+        hash *= 1099511628211ULL;
+    }
+    return [NSString stringWithFormat: @"%016llx.wav", hash];
+}
+
+
+@implementation ConversionCache
+
++ (void) initialize
+{
+    if (self == [ConversionCache class]) {
+        sharedCacheLock = [NSLock new];
+    }
+}
+
+/*
+ * The converters' threads may be the first to use the cache.
+ */
++ (ConversionCache *) sharedCache
+{
+    [sharedCacheLock lock];
+    if (nil == sharedCache) {
+        sharedCache = [ConversionCache new];
+    }
+    [sharedCacheLock unlock];
+    return sharedCache;
+}
+
++ (unsigned long long) cacheSizeForParameters: (NSDictionary *) parameters
+{
+    int size = [[[parameters objectForKey: @"SessionParameters"]
+                            objectForKey: @"ConversionCacheSize"] intValue];
+
+    if (size <= 0) {
+        return 0;
+    }
+    return (unsigned long long)size * 1024 * 1024;
+}
+
++ (NSString *) keyForTrack: (Track *) track
+                      tool: (id<BurnTool>) tool
+                parameters: (NSDictionary *) parameters
+{
+    NSString *settings;
+    NSString *toolParams = NSStringFromClass([(id)tool class]);
+
+    /*
+     * The bundles keep their settings in <Name>Parameters, where
+     * the bundle's principal class is <Name>Controller.
+     */
+    if ([toolParams hasSuffix: @"Controller"]) {
+        toolParams = [toolParams substringToIndex:
+                            [toolParams length] - [@"Controller" length]];
+    }
+    toolParams = [toolParams stringByAppendingString: @"Parameters"];
+    settings = [[parameters objectForKey: toolParams] description];
+
+    /*
+     * Normalized files differ from those converted without.
+     */
+    if ([LoudnessMeter shouldNormalize: parameters]) {
+        settings = [NSString stringWithFormat: @"%@|%.1f LUFS", settings,
+                        [LoudnessMeter targetLoudnessForParameters: parameters]];
+    }
+
+    if ([[track type] isEqualToString: @"audio:cd"]) {
+        return [NSString stringWithFormat: @"cd|%@|%@|%@",
+                            [track source], [tool name], settings];
+    } else {
+        NSDictionary *attributes = [[NSFileManager defaultManager]
+                                        fileAttributesAtPath: [track source]
+                                                traverseLink: YES];
+        if (nil == attributes) {
+            return nil;
+        }
+        return [NSString stringWithFormat: @"file|%@|%llu|%.0f|%@|%@",
+                            [track source], [attributes fileSize],
+                            [[attributes fileModificationDate] timeIntervalSinceReferenceDate],
+                            [tool name], settings];
+    }
+}
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        cachePath = RETAIN([UserLibraryPath() stringByAppendingPathComponent: @"ConversionCache"]);
+        entries = [NSMutableDictionary new];
+        pinnedKeys = [NSCountedSet new];
+        cacheLock = [NSLock new];
+        dirty = NO;
+        [self readIndex];
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    RELEASE(cachePath);
+    RELEASE(entries);
+    RELEASE(pinnedKeys);
+    RELEASE(cacheLock);
+    [super dealloc];
+}
+
+- (NSString *) fileForKey: (NSString *) key
+{
+    NSString *file = nil;
+    NSMutableDictionary *entry;
+
+    if (nil == key) {
+        return nil;
+    }
+
+    [cacheLock lock];
+    entry = [entries objectForKey: key];
+    if (nil != entry) {
+        file = [cachePath stringByAppendingPathComponent: [entry objectForKey: EntryFile]];
+        if ([[NSFileManager defaultManager] fileExistsAtPath: file]) {
+            [entry setObject: [NSNumber numberWithDouble: [NSDate timeIntervalSinceReferenceDate]]
+                      forKey: EntryLastUsed];
+            [pinnedKeys addObject: key];
+        } else {
+            // Somebody removed the file behind our back.
+            [entries removeObjectForKey: key];
+            file = nil;
+        }
+        // Written by -synchronize at the end of the session.
+        dirty = YES;
+    }
+    [cacheLock unlock];
+
+    return file;
+}
+
+- (NSString *) storeFile: (NSString *) file forKey: (NSString *) key
+{
+    NSFileManager *fileMan = [NSFileManager defaultManager];
+    NSString *name = fileNameForKey(key);
+    NSString *cacheFile = [cachePath stringByAppendingPathComponent: name];
+    NSDictionary *attributes;
+    BOOL isDir;
+
+    if (![fileMan fileExistsAtPath: cachePath isDirectory: &isDir]) {
+        if (![fileMan createDirectoryAtPath: cachePath attributes: nil]) {
+            return nil;
+        }
+    } else if (!isDir) {
+        return nil;
+    }
+
+    [cacheLock lock];
+
+    /*
+     * Another session has converted the same track at the same time
+     * and may be burning its file.
+     */
+    if ([pinnedKeys containsObject: key] && (nil != [entries objectForKey: key])) {
+        [fileMan removeFileAtPath: file handler: nil];
+        [pinnedKeys addObject: key];
+        [cacheLock unlock];
+        return cacheFile;
+    }
+    [self removeEntryForKey: key];
+
+    /*
+     * The temporary directory may be on another file system. In
+     * this case we must copy the file.
+     */
+    if (![fileMan movePath: file toPath: cacheFile handler: nil]) {
+        if (![fileMan copyPath: file toPath: cacheFile handler: nil]) {
+            [fileMan removeFileAtPath: cacheFile handler: nil];
+            [cacheLock unlock];
+            return nil;
+        }
+        [fileMan removeFileAtPath: file handler: nil];
+    }
+
+    attributes = [fileMan fileAttributesAtPath: cacheFile traverseLink: NO];
+    [entries setObject: [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                            name, EntryFile,
+                            [NSNumber numberWithUnsignedLongLong: [attributes fileSize]], EntrySize,
+                            [NSNumber numberWithDouble: [NSDate timeIntervalSinceReferenceDate]], EntryLastUsed,
+                            nil]
+                forKey: key];
+    [pinnedKeys addObject: key];
+    [self writeIndex];
+    [cacheLock unlock];
+
+    return cacheFile;
+}
+
+- (void) releaseKeys: (NSArray *) keys
+{
+    int i;
+
+    [cacheLock lock];
+    for (i = 0; i < [keys count]; i++) {
+        [pinnedKeys removeObject: [keys objectAtIndex: i]];
+    }
+    [cacheLock unlock];
+}
+
+- (void) trimToSize: (unsigned long long) limit
+{
+    unsigned long long size;
+    NSMutableArray *keys;
+    int i;
+
+    [cacheLock lock];
+    size = 0;
+    keys = [NSMutableArray arrayWithArray: [entries allKeys]];
+    for (i = 0; i < [keys count]; i++) {
+        size += [[[entries objectForKey: [keys objectAtIndex: i]]
+                            objectForKey: EntrySize] unsignedLongLongValue];
+    }
+
+    if (size > limit) {
+        /*
+         * Oldest entries first.
+         */
+        NSArray *sorted = [entries keysSortedByValueUsingSelector: @selector(compareLastUsed:)];
+
+        for (i = 0; (i < [sorted count]) && (size > limit); i++) {
+            NSString *key = [sorted objectAtIndex: i];
+
+            if ([pinnedKeys containsObject: key]) {
+                continue;
+            }
+            size -= [[[entries objectForKey: key] objectForKey: EntrySize] unsignedLongLongValue];
+            logToConsole(MessageStatusInfo, [NSString stringWithFormat:
+                                _(@"ConversionCache.evict"),
+                                [[entries objectForKey: key] objectForKey: EntryFile]]);
+            [self removeEntryForKey: key];
+        }
+        [self writeIndex];
+    }
+    [cacheLock unlock];
+}
+
+- (unsigned long long) evictAll
+{
+    unsigned long long size = 0;
+    NSArray *keys;
+    int i;
+
+    [cacheLock lock];
+    keys = [entries allKeys];
+    for (i = 0; i < [keys count]; i++) {
+        NSString *key = [keys objectAtIndex: i];
+
+        if ([pinnedKeys containsObject: key]) {
+            continue;
+        }
+        size += [[[entries objectForKey: key] objectForKey: EntrySize] unsignedLongLongValue];
+        [self removeEntryForKey: key];
+    }
+    [self writeIndex];
+    [cacheLock unlock];
+
+    return size;
+}
+
+- (unsigned long long) size
+{
+    unsigned long long size = 0;
+    NSEnumerator *e;
+    NSDictionary *entry;
+
+    [cacheLock lock];
+    e = [entries objectEnumerator];
+    while (nil != (entry = [e nextObject])) {
+        size += [[entry objectForKey: EntrySize] unsignedLongLongValue];
+    }
+    [cacheLock unlock];
+
+    return size;
+}
+
+- (void) synchronize
+{
+    [cacheLock lock];
+    if (dirty) {
+        [self writeIndex];
+    }
+    [cacheLock unlock];
+}
+
+//
+// private methods
+//
+
+- (void) readIndex
+{
+    NSDictionary *index = [NSDictionary dictionaryWithContentsOfFile:
+                        [cachePath stringByAppendingPathComponent: @"index.plist"]];
+    NSEnumerator *e = [index keyEnumerator];
+    NSString *key;
+
+    while (nil != (key = [e nextObject])) {
+        NSDictionary *entry = [index objectForKey: key];
+
+        // Depending on the format, numbers may be read as strings.
+        [entries setObject: [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                                [entry objectForKey: EntryFile], EntryFile,
+                                [NSNumber numberWithUnsignedLongLong:
+                                    [[entry objectForKey: EntrySize] longLongValue]], EntrySize,
+                                [NSNumber numberWithDouble:
+                                    [[entry objectForKey: EntryLastUsed] doubleValue]], EntryLastUsed,
+                                nil]
+                    forKey: key];
+    }
+}
+
+- (void) writeIndex
+{
+    [entries writeToFile: [cachePath stringByAppendingPathComponent: @"index.plist"]
+              atomically: YES];
+    dirty = NO;
+}
+
+- (void) removeEntryForKey: (NSString *) key
+{
+    NSDictionary *entry = [entries objectForKey: key];
+
+    if (nil != entry) {
+        [[NSFileManager defaultManager] removeFileAtPath:
+                    [cachePath stringByAppendingPathComponent: [entry objectForKey: EntryFile]]
+                                                 handler: nil];
+        [entries removeObjectForKey: key];
+    }
+}
+
+@end
+
+
+@implementation NSDictionary (ConversionCache)
+
+- (NSComparisonResult) compareLastUsed: (NSDictionary *) other
+{
+    return [[self objectForKey: EntryLastUsed] compare: [other objectForKey: EntryLastUsed]];
+}
+
+@end
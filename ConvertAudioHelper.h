@@ -24,36 +24,112 @@
 #ifndef CONVERTAUDIOHELPER_H_INC
 #define CONVERTAUDIOHELPER_H_INC
 
-#include <AppKit/AppKit.h>
+#include <Foundation/Foundation.h>
 
-#include "BurnProgressController.h"
+#include "BurnSession.h"
 #include "Burn/ExternalTools.h"
 
 @interface ConvertAudioHelper : NSObject
 {
-    BurnProgressController *controller;
+    BurnSession *controller;
 
 	NSMutableArray *processes;
 	NSMutableArray *tempFiles;
+    // the keys of the files this session uses from the ConversionCache
+    NSMutableArray *cacheKeys;
 
     int nextProcess;
 
 	id<BurnTool> currentTool;
+    NSLock *convertLock;
+
+    /*
+     * copying an audio CD on-the-fly
+     */
+    BOOL onTheFly;
+    id streamProcess;
+    NSMutableArray *fifos;
+    NSConditionLock *streamLock;
+    BOOL streamResult;
+
+    /*
+     * ripping several CDs at once, one per drive
+     */
+    NSMutableArray *pendingCDs;
+    NSMutableArray *ripWorkers;
+    NSMutableArray *ripDevices;
+    NSLock *ripLock;
+    id audioCD;
+    int cdCount;
+    int ripChecks;
+    BOOL ripStopped;
+    BOOL ripFailed;
+    BOOL ripPolling;
+
+    // the session has ended while grabbers were still running
+    BOOL cleanUpPending;
+    BOOL keepTempFiles;
 }
 
-- (id) initWithController: (BurnProgressController *)aController;
+- (id) initWithController: (BurnSession *)aController;
 
 - (enum StartHelperStatus) start: (NSArray *)audioTracks;
 - (void) stop: (BOOL) immediately;
 
+/**
+ * <p>Returns YES if the CD tracks are not ripped to files but copied
+ * on-the-fly while burning. This is requested by the <em>OnTheFly</em>
+ * entry of the SessionParameters and only possible if all tracks to
+ * be ripped come from one CD, the grabber implements the
+ * AudioCDStreamer protocol and the writer supports burning
+ * on-the-fly. The storage of each such track then is a FIFO and its
+ * size the exact size of the track.</p>
+ */
+- (BOOL) isOnTheFly;
+
+/**
+ * <p>Starts writing the CD tracks into their FIFOs on a separate
+ * thread. Used by BurnCDHelper when copying on-the-fly.</p>
+ */
+- (void) streamTracks;
+
+/**
+ * <p>Waits for the grabber when the burner has finished. If burning
+ * failed, the grabber is stopped first. Returns YES if all tracks
+ * were streamed completely.</p>
+ */
+- (BOOL) finishStreaming: (BOOL) burnSucceeded;
+
+/**
+ * <p>Returns YES if CD tracks are still to be ripped from one of
+ * <var>devices</var> or from a drive which is not known yet. The
+ * medium in such a drive must not be checked before the CD is
+ * done.</p>
+ */
+- (BOOL) mayGrabFromDevices: (NSArray *) devices;
+
 //
 // private methods
 //
 - (void) cleanUp: (BOOL) success;
+- (void) removeTempFiles;
+- (void) releaseCacheFiles;
 
 - (NSString *) checkCD: (NSString *) cddbId;
+- (BOOL) canCopyOnTheFly;
+- (BOOL) prepareOnTheFly: (BOOL *) ripFirst;
 - (void) startNextProcess;
 - (void) convertThread: (id) anObject;
+- (void) normalizeTracksOfProcess: (id) anObject
+                       parameters: (NSDictionary *) parameters;
+- (void) storeTracksOfProcess: (id) anObject;
+- (void) streamThread: (id) anObject;
+- (BOOL) canRipInParallel;
+- (void) startRipping;
+- (void) assignDrives;
+- (void) ripThread: (id) anObject;
+- (void) collectFilesOfWorker: (id) anObject;
+- (void) updateRipStatus: (id) timer;
 - (void) updateStatus: (id) timer;
 
 @end
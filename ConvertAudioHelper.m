@@ -22,15 +22,18 @@
  */
 
 #include "ConvertAudioHelper.h"
+#include "ConversionCache.h"
+#include "LoudnessMeter.h"
+#include "MetadataCache.h"
 
 #include "Constants.h"
 #include "Functions.h"
 #include "AppController.h"
 #include "Track.h"
-#include "Project.h"
 
 #include <AudioCD/AudioCDProtocol.h>
 #include "Burn/ExternalTools.h"
+#include <sys/stat.h>
 #include <unistd.h>
 
 /**
@@ -43,6 +46,17 @@
     id tool;
     id data;
     NSMutableArray *tracks;
+    // The cache keys of the tracks, NSNull if a track is not cached.
+    NSMutableArray *keys;
+    // The drive of a CD, once it has been found.
+    NSString *device;
+    // The parameters passed to the tool, set before its thread starts.
+    NSDictionary *parameters;
+    // YES if the tracks have been converted.
+    BOOL done;
+    // set by the converting thread, guarded by convertLock
+    BOOL finished;
+    BOOL result;
 }
 - (id) init;
 - (void) setTool: (id) t;
@@ -56,13 +70,22 @@
     tool = nil;
     data = nil;
     tracks = [NSMutableArray new];
+    keys = [NSMutableArray new];
+    device = nil;
+    parameters = nil;
+    done = NO;
+    finished = NO;
+    result = NO;
     return self;
 }
 - (void) dealloc
 {
     RELEASE(tracks);
+    RELEASE(keys);
     RELEASE(tool);
     RELEASE(data);
+    RELEASE(device);
+    RELEASE(parameters);
     [super dealloc];
 }
 - (void) setTool: (id) t
@@ -75,21 +98,114 @@
 }
 @end
 
+/**
+ * A private helper class to hold the data for one
+ * CD ripped in parallel with others.
+ */
+@interface RipWorker : NSObject
+{
+@public
+    ConvertProcess *process;
+    id tool;
+    NSString *device;
+    NSDictionary *parameters;
+    // set by the ripping thread, guarded by ripLock
+    BOOL finished;
+    BOOL result;
+}
+- (id) initWithProcess: (ConvertProcess *) p
+                  tool: (id) t
+                device: (NSString *) d
+            parameters: (NSDictionary *) params;
+@end
+
+@implementation RipWorker
+- (id) initWithProcess: (ConvertProcess *) p
+                  tool: (id) t
+                device: (NSString *) d
+            parameters: (NSDictionary *) params
+{
+    self = [super init];
+    process = RETAIN(p);
+    tool = RETAIN(t);
+    device = [d copy];
+    parameters = RETAIN(params);
+    finished = NO;
+    result = NO;
+    return self;
+}
+- (void) dealloc
+{
+    RELEASE(process);
+    RELEASE(tool);
+    RELEASE(device);
+    RELEASE(parameters);
+    [super dealloc];
+}
+@end
+
+/* The drives are checked for new CDs every RIP_CHECK_TICKS status updates. */
+#define RIP_CHECK_TICKS 5
+
+/*
+ * Polling is stopped while drives are ripping. After it is
+ * restarted, the AudioCD bundle gets RIP_POLL_TICKS status
+ * updates to find the CDs again.
+ */
+#define RIP_POLL_TICKS 3
+
+/*
+ * Returns a copy of the session's parameters for a grabber reading
+ * the CD cddbId from device. The stages run concurrently and share
+ * the session's parameters, so these must not be changed.
+ */
+static NSDictionary *grabberParameters(NSDictionary *burnParameters,
+                                       NSString *device, NSString *cddbId)
+{
+    NSMutableDictionary *parameters =
+        [NSMutableDictionary dictionaryWithDictionary: burnParameters];
+
+    [parameters setObject: device forKey: @"SourceDevice"];
+    [parameters setObject: cddbId forKey: @"CddbId"];
+    return [NSDictionary dictionaryWithDictionary: parameters];
+}
+
+static NSString *cdTitle(NSDictionary *cdList, NSString *cddbId)
+{
+    NSDictionary *cd = [cdList objectForKey: cddbId];
+
+    return [NSString stringWithFormat: @"%@ - %@",
+                        [cd objectForKey: @"artist"], [cd objectForKey: @"title"]];
+}
+
 @implementation ConvertAudioHelper
 
-- (id) initWithController: (BurnProgressController *)aController
+- (id) initWithController: (BurnSession *)aController
 {
     self = [super init];
     if (self) {
         controller = aController;
         tempFiles = nil;
+        cacheKeys = [NSMutableArray new];
         processes = [NSMutableArray new];
+        onTheFly = NO;
+        fifos = nil;
+        convertLock = [NSLock new];
     }
     return self;
 }
 
 - (void) dealloc
 {
+    RELEASE(streamProcess);
+    RELEASE(streamLock);
+    RELEASE(fifos);
+    RELEASE(pendingCDs);
+    RELEASE(ripWorkers);
+    RELEASE(ripDevices);
+    RELEASE(ripLock);
+    RELEASE(convertLock);
+    RELEASE(cacheKeys);
     [super dealloc];
     RELEASE(tempFiles);
     RELEASE(processes);
@@ -102,6 +218,9 @@
 	NSEnumerator *eTracks = [audioTracks objectEnumerator];
 	Track *track = nil;
     id data = nil;
+    unsigned long long cacheSize =
+        [ConversionCache cacheSizeForParameters: [controller burnParameters]];
+    BOOL normalize = [LoudnessMeter shouldNormalize: [controller burnParameters]];
 
     if ((audioTracks == nil)
             || ([audioTracks count] == 0)) {
@@ -119,19 +238,31 @@
 		NSString *type = nil;
 		id tool = nil;
 		ConvertProcess *process;
-
-		/*
-		 * Ignore the built-in types.
-		 */
-		if ([trackType isEqualToString: @"audio:wav"]
-				|| [trackType isEqualToString: @"audio:au"])
-			continue;
+		NSString *key = nil;
+		NSString *cachedFile;
 
 		if (![trackType hasPrefix: @"audio:"])
 			continue;
 
 		type = [trackType substringFromIndex: [@"audio:" length]];
 
+		/*
+		 * The built-in types are burned as they are. To be normalized,
+		 * they are read in process like other uncompressed files.
+		 */
+		if ([trackType isEqualToString: @"audio:wav"]
+				|| [trackType isEqualToString: @"audio:au"]) {
+			if (!normalize) {
+				continue;
+			}
+			type = @"pcm";
+			if (nil == [[AppController appController] audioConverterBundleForType: type]) {
+				logToConsole(MessageStatusWarning, [NSString stringWithFormat:
+									_(@"ConvertAudioHelper.notNormalized"), [track description]]);
+				continue;
+			}
+		}
+
 		/*
 		 * Try to get a handle to the converter bundle for this file type.
 		 */
@@ -145,19 +276,35 @@
                 objectAtIndex: 0]; 
             type = data;
         } else {
-		    tool = [[AppController appController] currentAudioConverterBundle];
+		    tool = [[AppController appController] audioConverterBundleForType: type];
             data = nil;
         }
 		if (nil == tool) {
-    	    NSRunAlertPanel(APP_NAME,
-							[NSString stringWithFormat: @"%@\n%@",
+    	    [controller showError: [NSString stringWithFormat: @"%@\n%@",
 										_(@"ConvertAudioHelper.noProgram"),
-										_(@"Common.stopProcess")],
-							_(@"Common.OK"), nil, nil);
+										_(@"Common.stopProcess")]];
 			ret = Failed;
 	        goto clean_up;
 		}
 
+		/*
+		 * Tracks converted in an earlier session are taken
+		 * from the cache.
+		 */
+		if (cacheSize > 0) {
+			key = [ConversionCache keyForTrack: track
+										  tool: tool
+									parameters: [controller burnParameters]];
+			cachedFile = [[ConversionCache sharedCache] fileForKey: key];
+			if (nil != cachedFile) {
+				logToConsole(MessageStatusInfo, [NSString stringWithFormat:
+									_(@"ConvertAudioHelper.cacheHit"), [track description]]);
+				[track setStorage: cachedFile];
+				[cacheKeys addObject: key];
+				continue;
+			}
+		}
+
 		process = [processHelper objectForKey: type];
 		if (!process) {
 			process = [ConvertProcess new];
@@ -167,8 +314,37 @@
             [processes addObject: process];
         }
         [process->tracks addObject: track];
+        [process->keys addObject: (nil != key) ? (id)key : (id)[NSNull null]];
 	}
 
+    /*
+     * Copying an audio CD on-the-fly: Nothing is ripped now. The
+     * grabber writes the tracks into FIFOs while BurnCDHelper burns.
+     */
+    if ([self canCopyOnTheFly]) {
+        BOOL ripFirst = NO;
+
+        if (![self prepareOnTheFly: &ripFirst]) {
+            ret = Failed;
+            goto clean_up;
+        }
+        if (!ripFirst) {
+            ret = Done;
+            goto clean_up;
+        }
+    }
+
+    /*
+     * Several CDs are ripped at once if there are drives enough.
+     * The other tracks are converted afterwards.
+     */
+    if ([self canRipInParallel]) {
+        ret = Started;
+        nextProcess = 0;
+        [self startRipping];
+        goto clean_up;
+    }
+
     /*
      * Release the helper dict and start the second stage.
      */
@@ -182,10 +358,76 @@ clean_up:
     return ret;
 }
 
+- (BOOL) isOnTheFly
+{
+    return onTheFly;
+}
+
+- (void) streamTracks
+{
+    DESTROY(streamLock);
+    streamLock = [[NSConditionLock alloc] initWithCondition: 0];
+
+	[NSThread detachNewThreadSelector: @selector(streamThread:)
+							 toTarget: self
+						   withObject: streamProcess];
+}
+
+- (BOOL) finishStreaming: (BOOL) burnSucceeded
+{
+    id<BurnTool> grabber = ((ConvertProcess *)streamProcess)->tool;
+
+    /*
+     * If the burner stopped early, the grabber waits in vain for it
+     * to read on. Thus, we stop it until its thread is gone, as it
+     * may not even have started reading when we get here.
+     */
+    while (![streamLock lockWhenCondition: 1
+                              beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.5]]) {
+        if (!burnSucceeded) {
+            [grabber stop: YES];
+        }
+    }
+    [streamLock unlock];
+
+    return streamResult;
+}
+
+- (BOOL) mayGrabFromDevices: (NSArray *) devices
+{
+    int i, j;
+
+    for (i = 0; i < [processes count]; i++) {
+        ConvertProcess *process = [processes objectAtIndex: i];
+
+        if (process->done || ![process->tool isCDGrabber]) {
+            continue;
+        }
+        if (nil == process->device) {
+            return YES;
+        }
+        for (j = 0; j < [devices count]; j++) {
+            if (isSameDrive(process->device, [devices objectAtIndex: j])) {
+                return YES;
+            }
+        }
+    }
+    return NO;
+}
+
 - (void) stop: (BOOL) immediately
 {
+    NSEnumerator *e = [ripWorkers objectEnumerator];
+    RipWorker *worker;
+
+    ripStopped = YES;
+    while ((worker = [e nextObject]) != nil) {
+        [(id<BurnTool>)worker->tool stop: immediately];
+    }
     if (currentTool != nil) {
         [(id<BurnTool>)currentTool stop: immediately];
+    }
+    if ((currentTool != nil) || ([ripWorkers count] != 0)) {
 		logToConsole(MessageStatusError, _(@"Common.cancelled"));
     }
 }
@@ -193,19 +435,69 @@ clean_up:
 
 - (void) cleanUp: (BOOL) success
 {
-	BOOL keepTempFiles = [[[[controller burnParameters]
-                                objectForKey: @"SessionParameters"]
-                                    objectForKey: @"KeepTempWavs"] boolValue];
-	NSFileManager *fileMan = [NSFileManager defaultManager];
     NSEnumerator *e = [processes objectEnumerator];
     ConvertProcess *p;
+    NSString *file;
+    unsigned long long cacheSize =
+        [ConversionCache cacheSizeForParameters: [controller burnParameters]];
+
+	keepTempFiles = [[[[controller burnParameters]
+                            objectForKey: @"SessionParameters"]
+                                objectForKey: @"KeepTempWavs"] boolValue];
 
     while ((p = [e nextObject]) != nil) {
         [p->tool cleanUp];
     }
 
+    if (nil != audioCD) {
+        if (ripPolling) {
+            [audioCD stopPolling];
+            ripPolling = NO;
+        }
+        DESTROY(audioCD);
+    }
+
+    /*
+     * The FIFOs of a copy on-the-fly are of no use afterwards.
+     */
+    e = [fifos objectEnumerator];
+    while ((file = [e nextObject]) != nil) {
+        unlink([file fileSystemRepresentation]);
+    }
+    DESTROY(fifos);
+
+    /*
+     * Grabbers which were stopped may still be writing. Their files
+     * are removed by -updateRipStatus: as soon as all of them are done.
+     */
+    if ([ripWorkers count] != 0) {
+        cleanUpPending = YES;
+    } else {
+        [self removeTempFiles];
+    }
+
+    /*
+     * Keep the loudness measured during the conversion.
+     */
+    [[MetadataCache sharedCache] synchronize];
+
+    /*
+     * The session is over, so its files of the cache may be removed
+     * now. Those other sessions are still using are kept.
+     */
+    [self releaseCacheFiles];
+    if (cacheSize > 0) {
+        [[ConversionCache sharedCache] synchronize];
+        [[ConversionCache sharedCache] trimToSize: cacheSize];
+    }
+}
+
+- (void) removeTempFiles
+{
+	NSFileManager *fileMan = [NSFileManager defaultManager];
+	NSString *file;
+
 	if ((keepTempFiles == NO) && tempFiles) {
-		NSString *file;
 		int i, count = [tempFiles count];
 		for (i = 0; i < count; i++) {
 			file = [tempFiles objectAtIndex: i];
@@ -220,6 +512,14 @@ clean_up:
 	}
 }
 
+- (void) releaseCacheFiles
+{
+    if ([cacheKeys count] != 0) {
+        [[ConversionCache sharedCache] releaseKeys: cacheKeys];
+        [cacheKeys removeAllObjects];
+    }
+}
+
 - (NSString *) checkCD: (NSString *) cddbId
 {
 	BOOL isRightCD = NO;
@@ -227,6 +527,7 @@ clean_up:
 	id<AudioCDProtocol> audioCD = loadAudioCD();
 
 	if (!audioCD) {
+		[controller showError: _(@"Functions.errorAudioCD")];
 		return nil;
 	}
 
@@ -238,16 +539,11 @@ clean_up:
 	// We check first, whether we have the right CD and then rip the stuff.
 	while (isRightCD == NO) {
 		if (![audioCD checkForCDWithId: cddbId]) {
-			int result = NSRunInformationalAlertPanel(APP_NAME,
-				[NSString stringWithFormat: _(@"GrabAudioCDHelper.insertCD"),
+			if (![controller askForMedium:
+					[NSString stringWithFormat: _(@"GrabAudioCDHelper.insertCD"),
 											[[[controller cdList] objectForKey: cddbId] objectForKey: @"artist"],
-											[[[controller cdList] objectForKey: cddbId] objectForKey: @"title"]],
-				_(@"Common.OK"), _(@"Common.cancel"), nil);
-			if (result == NSAlertAlternateReturn) {
-				if (NSRunAlertPanel(APP_NAME, _(@"GrabAudioCDHelper.reallyStop"),
-							_(@"Common.no"), _(@"Common.yes"), nil) == NSAlertAlternateReturn) {
-					break;
-				}
+											[[[controller cdList] objectForKey: cddbId] objectForKey: @"title"]]]) {
+				break;
 			}
 		} else {
 			sourceDevice = [[audioCD device] copy];
@@ -262,17 +558,152 @@ clean_up:
 }
 
 
+- (BOOL) canCopyOnTheFly
+{
+    NSDictionary *params = [[controller burnParameters] objectForKey: @"SessionParameters"];
+    ConvertProcess *process;
+    BOOL hasCD = NO;
+    int i;
+
+    if (![[params objectForKey: @"OnTheFly"] boolValue]
+            || ([controller isoImageOnly] == YES)) {
+        return NO;
+    }
+    for (i = 0; i < [processes count]; i++) {
+        process = [processes objectAtIndex: i];
+        hasCD = hasCD || [process->tool isCDGrabber];
+    }
+    if (hasCD == NO) {
+        return NO;
+    }
+
+    process = [processes objectAtIndex: 0];
+    if ([processes count] > 1) {
+        /*
+         * The burner must not wait while we change the CD or
+         * convert other tracks.
+         */
+        logToConsole(MessageStatusWarning, _(@"ConvertAudioHelper.noOnTheFlySources"));
+    } else if (![process->tool conformsToProtocol: @protocol(AudioCDStreamer)]) {
+        logToConsole(MessageStatusWarning, _(@"ConvertAudioHelper.noOnTheFlyGrabber"));
+    } else if (![[[AppController appController] currentWriterBundle] canBurnOnTheFly]) {
+        logToConsole(MessageStatusWarning, _(@"ConvertAudioHelper.noOnTheFly"));
+    } else if ([[controller burnDevices] count] > 1) {
+        /*
+         * A single drive cannot feed several burners.
+         */
+        logToConsole(MessageStatusWarning, _(@"ConvertAudioHelper.noOnTheFlyCopies"));
+    } else if ([LoudnessMeter shouldNormalize: [controller burnParameters]]) {
+        /*
+         * The gain is only known when the whole track has been read.
+         */
+        logToConsole(MessageStatusWarning, _(@"ConvertAudioHelper.noOnTheFlyNormalize"));
+    } else {
+        return YES;
+    }
+    return NO;
+}
+
+/*
+ * Checks the CD and creates a FIFO for each track. The tracks get
+ * their exact sizes, because the burner cannot determine them from
+ * a FIFO. If the CD is in one of the burners, nothing is prepared
+ * and ripFirst is set. The tracks must be ripped before the blank
+ * medium can be inserted then.
+ */
+- (BOOL) prepareOnTheFly: (BOOL *) ripFirst
+{
+    ConvertProcess *process = [processes objectAtIndex: 0];
+	NSDictionary *burnParameters = [controller burnParameters];
+    NSString *tempDir = [[burnParameters objectForKey: @"SessionParameters"]
+                            objectForKey: @"TempDirectory"];
+    NSDictionary *cd = [[controller cdList] objectForKey: process->data];
+    NSString *sourceDevice;
+    NSArray *sectors;
+    NSArray *burnDevices = [controller burnDevices];
+    int i;
+
+    *ripFirst = NO;
+    [controller setTitle: _(@"ConvertAudioHelper.preparing")];
+    [controller setTrackProgress: 0. andLabel: @""];
+    [controller setEntireProgress: 0. andLabel: [NSString stringWithFormat:
+											_(@"GrabAudioCDHelper.CDTitle"),
+											[cd objectForKey: @"artist"],
+											[cd objectForKey: @"title"]]];
+
+    sourceDevice = [self checkCD: process->data];
+    if (!sourceDevice) {
+        return NO;
+    }
+    ASSIGN(process->device, sourceDevice);
+    RELEASE(sourceDevice);
+    ASSIGN(process->parameters,
+           grabberParameters(burnParameters, process->device, process->data));
+
+    for (i = 0; i < [burnDevices count]; i++) {
+        if (isSameDrive(process->device, [burnDevices objectAtIndex: i])) {
+            logToConsole(MessageStatusWarning, [NSString stringWithFormat:
+                                _(@"ConvertAudioHelper.noOnTheFlySameDrive"),
+                                process->device]);
+            *ripFirst = YES;
+            return YES;
+        }
+    }
+
+    sectors = [(id<AudioCDStreamer>)process->tool sectorsOfTracks: process->tracks
+                                                   withParameters: process->parameters];
+    if (nil == sectors) {
+        [controller showError: [NSString stringWithFormat: @"%@\n%@",
+										_(@"ConvertAudioHelper.cannotReadCD"),
+										_(@"Common.stopProcess")]];
+        return NO;
+    }
+
+    fifos = [NSMutableArray new];
+    for (i = 0; i < [process->tracks count]; i++) {
+        Track *track = [process->tracks objectAtIndex: i];
+        /*
+         * cdrecord takes a file without .wav or .au suffix for raw
+         * samples in big endian byte order.
+         */
+        NSString *fifo = [tempDir stringByAppendingPathComponent:
+                            [NSString stringWithFormat: @"%@_track%d.cdr",
+                                process->data,
+                                [[[track source] substringFromIndex: 14] intValue]]];
+
+        unlink([fifo fileSystemRepresentation]);
+        if (mkfifo([fifo fileSystemRepresentation], 0600) != 0) {
+            [controller showError: [NSString stringWithFormat: @"%@\n%@",
+										[NSString stringWithFormat:
+											_(@"ConvertAudioHelper.noFifo"), fifo],
+										_(@"Common.stopProcess")]];
+            return NO;
+        }
+        [fifos addObject: fifo];
+        [track setStorage: fifo];
+        [track setSize: framesToAudioSize([[sectors objectAtIndex: i] longValue])];
+    }
+
+    ASSIGN(streamProcess, process);
+    onTheFly = YES;
+    logToConsole(MessageStatusInfo, _(@"ConvertAudioHelper.onTheFly"));
+
+    return YES;
+}
+
 - (void) startNextProcess
 {
 	NSString *sourceDevice;
     ConvertProcess *process;
-    // We know, that the dictionary returned here is mutable!
-    // Silence the compiler!
-	NSMutableDictionary *burnParameters = (NSMutableDictionary *)[controller burnParameters];
+	NSDictionary *burnParameters = [controller burnParameters];
 
+    while ((nextProcess < [processes count])
+            && ((ConvertProcess *)[processes objectAtIndex: nextProcess])->done) {
+        nextProcess++;
+    }
     if (nextProcess >= [processes count]) {
 		logToConsole(MessageStatusInfo, _(@"ConvertAudioHelper.success"));
-        [controller nextStage: YES];
+        [controller stage: ConvertAudio finished: YES];
         return;
     }
 
@@ -292,15 +723,17 @@ clean_up:
         [controller setEntireProgress: 0. andLabel: entireProgresstext];
         sourceDevice = [self checkCD: process->data];
         if (!sourceDevice) {
-            [controller nextStage: NO];
+            [controller stage: ConvertAudio finished: NO];
             return;
         }
 
-	    [burnParameters setObject: sourceDevice forKey: @"SourceDevice"];
+        ASSIGN(process->device, sourceDevice);
     	RELEASE(sourceDevice);
-    	[burnParameters setObject: process->data forKey: @"CddbId"];
+        ASSIGN(process->parameters,
+               grabberParameters(burnParameters, process->device, process->data));
     } else {
        [controller setEntireProgress: 0. andLabel: _(@"ConvertAudioHelper.allTracks")];
+       ASSIGN(process->parameters, burnParameters);
     }
 
 	// now get it
@@ -313,15 +746,22 @@ clean_up:
 								   selector: @selector(updateStatus:)
 								   userInfo: nil
 									repeats: NO];
+
+    /*
+     * Now that we know the drive, the medium may be checked
+     * while we are converting.
+     */
+    if ([process->tool isCDGrabber] == YES) {
+        [controller startReadyStages];
+    }
 }
 
 
 - (void) convertThread: (id)anObject
 {
-	int i;
 	BOOL result = YES;
 	id pool = [NSAutoreleasePool new];
-	NSDictionary *burnParameters = [controller burnParameters];
+	NSDictionary *burnParameters = ((ConvertProcess *)anObject)->parameters;
 	id<AudioConverter> converter = ((ConvertProcess *)anObject)->tool;
 	NSArray *tracks = ((ConvertProcess *)anObject)->tracks;
 
@@ -329,15 +769,419 @@ clean_up:
 	result = [converter convertTracks: tracks withParameters: burnParameters];
 
 	if (result) {
-		if (!tempFiles) {
-			tempFiles = [NSMutableArray new];
+		[self normalizeTracksOfProcess: anObject parameters: burnParameters];
+	}
+
+	/*
+	 * The converter's status says it is done before the tracks are
+	 * normalized. -updateStatus: waits for this instead and moves
+	 * the files to the cache on the main thread.
+	 */
+	[convertLock lock];
+	((ConvertProcess *)anObject)->result = result;
+	((ConvertProcess *)anObject)->finished = YES;
+	[convertLock unlock];
+
+	RELEASE(pool);
+	[NSThread exit];
+}
+
+/*
+ * The decoders and LibParanoia measure the tracks while they write
+ * them. The files written by external programs, i.e. by the generic
+ * converter and by cdparanoia, are normalized afterwards. This reads
+ * and writes each of them once more.
+ */
+- (void) normalizeTracksOfProcess: (id) anObject
+                       parameters: (NSDictionary *) parameters
+{
+	ConvertProcess *process = anObject;
+	int i;
+
+	if (![LoudnessMeter shouldNormalize: parameters]
+			|| [process->tool conformsToProtocol: @protocol(LoudnessMeasurer)]) {
+		return;
+	}
+	for (i = 0; i < [process->tracks count]; i++) {
+		Track *track = [process->tracks objectAtIndex: i];
+
+		logToConsole(MessageStatusInfo, [NSString stringWithFormat:
+							_(@"ConvertAudioHelper.normalizing"), [track description]]);
+		if (![LoudnessMeter normalizeFile: [track storage]
+								 forTrack: track
+							   parameters: parameters]) {
+			logToConsole(MessageStatusWarning, [NSString stringWithFormat:
+								_(@"ConvertAudioHelper.notNormalized"), [track description]]);
+		}
+	}
+}
+
+- (void) storeTracksOfProcess: (id) anObject
+{
+	int i;
+	NSArray *tracks = ((ConvertProcess *)anObject)->tracks;
+	NSArray *keys = ((ConvertProcess *)anObject)->keys;
+
+	if (!tempFiles) {
+		tempFiles = [NSMutableArray new];
+	}
+	// move file to the cache or add it to the list of temporary files
+	for (i = 0; i < [tracks count]; i++) {
+		Track *track = [tracks objectAtIndex: i];
+		id key = [keys objectAtIndex: i];
+		NSString *cacheFile = nil;
+
+		if (key != [NSNull null]) {
+			cacheFile = [[ConversionCache sharedCache] storeFile: [track storage]
+														  forKey: key];
 		}
-		// add file to list of temporary files
-		for (i = 0; i < [tracks count]; i++) {
-			Track *track = [tracks objectAtIndex: i];
+		if (nil != cacheFile) {
+			[track setStorage: cacheFile];
+			[cacheKeys addObject: key];
+		} else {
 			[tempFiles addObject: [track storage]];
 		}
 	}
+}
+
+- (BOOL) canRipInParallel
+{
+    NSDictionary *params = [[controller burnParameters] objectForKey: @"SessionParameters"];
+    id tool = nil;
+    int i, cds = 0;
+
+    if ((nil != [params objectForKey: @"ParallelRipping"])
+            && ![[params objectForKey: @"ParallelRipping"] boolValue]) {
+        return NO;
+    }
+    for (i = 0; i < [processes count]; i++) {
+        ConvertProcess *process = [processes objectAtIndex: i];
+
+        if ([process->tool isCDGrabber]) {
+            tool = process->tool;
+            cds++;
+        }
+    }
+    return (cds > 1) && [tool conformsToProtocol: @protocol(ParallelGrabber)];
+}
+
+- (void) startRipping
+{
+    int i;
+
+    pendingCDs = [NSMutableArray new];
+    ripWorkers = [NSMutableArray new];
+    ripDevices = [NSMutableArray new];
+    ripLock = [NSLock new];
+    ripStopped = NO;
+    ripFailed = NO;
+
+    for (i = 0; i < [processes count]; i++) {
+        ConvertProcess *process = [processes objectAtIndex: i];
+
+        if ([process->tool isCDGrabber]) {
+            [pendingCDs addObject: process];
+        }
+    }
+    cdCount = [pendingCDs count];
+
+    audioCD = loadAudioCD();
+    if (nil == audioCD) {
+        [controller showError: _(@"Functions.errorAudioCD")];
+        [controller stage: ConvertAudio finished: NO];
+        return;
+    }
+    [audioCD startPollingWithPreferredDevice: nil];
+    ripPolling = YES;
+
+    [controller setTitle: _(@"ConvertAudioHelper.ripping")];
+    [controller setTrackProgress: 0. andLabel: @""];
+    [controller setEntireProgress: 0. andLabel: @""];
+
+	// Give the AudioCD.bundle some time to load the CDs.
+    ripChecks = RIP_POLL_TICKS;
+    [self updateRipStatus: nil];
+}
+
+/*
+ * Starts a grabber for each CD we still need which is in a drive
+ * now. Each drive holds one CD, so no drive gets two grabbers.
+ */
+- (void) assignDrives
+{
+    int i = 0;
+
+    while (i < [pendingCDs count]) {
+        ConvertProcess *process = [pendingCDs objectAtIndex: i];
+        NSString *device;
+        RipWorker *worker;
+
+        if (![audioCD checkForCDWithId: process->data]) {
+            i++;
+            continue;
+        }
+        device = [audioCD device];
+        ASSIGN(process->device, device);
+
+        worker = [[RipWorker alloc] initWithProcess: process
+                                               tool: [process->tool parallelGrabber]
+                                             device: device
+                                         parameters: grabberParameters([controller burnParameters],
+                                                                       device, process->data)];
+        [ripWorkers addObject: worker];
+        [pendingCDs removeObjectAtIndex: i];
+
+        if (![ripDevices containsObject: worker->device]) {
+            [ripDevices addObject: worker->device];
+            [controller hideDeviceProgress];
+            [controller showProgressForDevices: ripDevices];
+            [controller hideTrackProgress: ([ripDevices count] > 1)];
+        }
+        logToConsole(MessageStatusInfo, [NSString stringWithFormat:
+                            _(@"ConvertAudioHelper.ripStarted"),
+                            cdTitle([controller cdList], process->data), worker->device]);
+
+    	[NSThread detachNewThreadSelector: @selector(ripThread:)
+	    						 toTarget: self
+		    				   withObject: worker];
+        RELEASE(worker);
+    }
+}
+
+- (void) ripThread: (id)anObject
+{
+	id pool = [NSAutoreleasePool new];
+	RipWorker *worker = anObject;
+	BOOL result;
+
+	result = [worker->tool convertTracks: worker->process->tracks
+                          withParameters: worker->parameters];
+	if (result) {
+		[self normalizeTracksOfProcess: worker->process
+							parameters: worker->parameters];
+	}
+
+	[ripLock lock];
+	worker->result = result;
+	worker->finished = YES;
+	[ripLock unlock];
+
+	RELEASE(pool);
+	[NSThread exit];
+}
+
+/*
+ * A grabber which failed or was stopped leaves the tracks it has
+ * written so far in the temporary directory. They are added to the
+ * temporary files, so they are removed with the others.
+ */
+- (void) collectFilesOfWorker: (id) anObject
+{
+	RipWorker *worker = anObject;
+	NSFileManager *fileMan = [NSFileManager defaultManager];
+	NSString *tempDir = [[[worker->parameters objectForKey: @"SessionParameters"]
+								objectForKey: @"TempDirectory"] stringByStandardizingPath];
+	NSEnumerator *e = [worker->process->tracks objectEnumerator];
+	Track *track;
+
+	if (nil == tempDir) {
+		return;
+	}
+	if (!tempFiles) {
+		tempFiles = [NSMutableArray new];
+	}
+	while ((track = [e nextObject]) != nil) {
+		NSString *file = [track storage];
+
+		if ((nil != file)
+				&& [[file stringByStandardizingPath] hasPrefix: tempDir]
+				&& [fileMan fileExistsAtPath: file]
+				&& ![tempFiles containsObject: file]) {
+			[tempFiles addObject: file];
+		}
+	}
+}
+
+- (void) updateRipStatus: (id)timer
+{
+    NSMutableArray *finished = [NSMutableArray array];
+    BOOL startStages = NO;
+    double progress = 0.;
+    int i;
+
+    /*
+     * After the session has ended, the controller must not be used
+     * any more. We only wait for the grabbers to remove their files.
+     */
+    for (i = 0; i < [ripWorkers count]; i++) {
+        RipWorker *worker = [ripWorkers objectAtIndex: i];
+        ToolStatus status = [(id<BurnTool>)worker->tool getStatus];
+        BOOL done, result;
+
+        [ripLock lock];
+        done = worker->finished;
+        result = worker->result;
+        [ripLock unlock];
+
+        if (!done) {
+            if (cleanUpPending) {
+                continue;
+            }
+            progress += status.entireProgress;
+            [controller setProgress: status.entireProgress
+                           andLabel: [NSString stringWithFormat: _(@"Common.trackTitle"),
+                                                    status.trackName]
+                          forDevice: worker->device];
+            /*
+             * With a single drive there are no rows per drive.
+             */
+            if ([ripDevices count] < 2) {
+                [controller setTrackProgress: status.trackProgress
+                                    andLabel: [NSString stringWithFormat:
+                                                    _(@"Common.trackTitle"), status.trackName]];
+            }
+            continue;
+        }
+
+        [finished addObject: worker];
+        if (!result) {
+            ripFailed = YES;
+            [self collectFilesOfWorker: worker];
+            continue;
+        }
+        [self storeTracksOfProcess: worker->process];
+        worker->process->done = YES;
+        if (cleanUpPending) {
+            continue;
+        }
+        startStages = YES;
+        [controller setProgress: 100.
+                       andLabel: _(@"ConvertAudioHelper.driveDone")
+                      forDevice: worker->device];
+        logToConsole(MessageStatusInfo, [NSString stringWithFormat:
+                            _(@"ConvertAudioHelper.ripDone"),
+                            cdTitle([controller cdList], worker->process->data), worker->device]);
+    }
+    [ripWorkers removeObjectsInArray: finished];
+
+    /*
+     * If one CD cannot be read, the other drives need not go on.
+     * But the stage only fails after all of them have stopped, as
+     * their files must be removed with the others.
+     */
+    if (ripFailed || ripStopped) {
+        if (!ripStopped) {
+            ripStopped = YES;
+            for (i = 0; i < [ripWorkers count]; i++) {
+                [(id<BurnTool>)((RipWorker *)[ripWorkers objectAtIndex: i])->tool stop: YES];
+            }
+        }
+        [pendingCDs removeAllObjects];
+
+        if ([ripWorkers count] != 0) {
+            [NSTimer scheduledTimerWithTimeInterval: 0.4
+                                             target: self
+                                           selector: @selector(updateRipStatus:)
+                                           userInfo: nil
+                                            repeats: NO];
+            return;
+        }
+
+        if (cleanUpPending) {
+            cleanUpPending = NO;
+            [self removeTempFiles];
+            [self releaseCacheFiles];
+        } else if (ripFailed) {
+            [controller stage: ConvertAudio finished: NO];
+        }
+        return;
+    }
+
+    progress += 100. * (cdCount - [pendingCDs count] - [ripWorkers count]);
+    progress /= cdCount;
+    [controller setEntireProgress: progress
+                         andLabel: [NSString stringWithFormat: _(@"ConvertAudioHelper.ripProgress"),
+                                        [ripWorkers count], [pendingCDs count]]];
+    [controller setMiniwindowToTrack: -1 Entire: progress];
+
+    if ([pendingCDs count] != 0) {
+        /*
+         * The AudioCD bundle must not access the drives while they
+         * are ripping. So it only polls when we look for new CDs.
+         */
+        if (!ripPolling) {
+            if (([finished count] != 0) || (--ripChecks <= 0)) {
+                [audioCD startPollingWithPreferredDevice: nil];
+                ripPolling = YES;
+                ripChecks = RIP_POLL_TICKS;
+            }
+        } else if (--ripChecks <= 0) {
+            [self assignDrives];
+            ripChecks = RIP_CHECK_TICKS;
+            startStages = YES;
+
+            if ([ripWorkers count] != 0) {
+                [audioCD stopPolling];
+                ripPolling = NO;
+            } else {
+                /*
+                 * Only if all drives are idle we must wait for the user.
+                 */
+                NSMutableArray *titles = [NSMutableArray arrayWithCapacity: [pendingCDs count]];
+
+                for (i = 0; i < [pendingCDs count]; i++) {
+                    [titles addObject: cdTitle([controller cdList],
+                                            ((ConvertProcess *)[pendingCDs objectAtIndex: i])->data)];
+                }
+                if (![controller askForMedium: [NSString stringWithFormat:
+                                                    _(@"ConvertAudioHelper.insertCDs"),
+                                                    [titles componentsJoinedByString: @"\n"]]]) {
+                    [controller stage: ConvertAudio finished: NO];
+                    return;
+                }
+                ripChecks = 0;
+            }
+        }
+    } else if ([ripWorkers count] == 0) {
+        if (ripPolling) {
+            [audioCD stopPolling];
+            ripPolling = NO;
+        }
+        DESTROY(audioCD);
+        [controller hideDeviceProgress];
+        [controller hideTrackProgress: NO];
+        [self startNextProcess];
+        return;
+    }
+
+	[NSTimer scheduledTimerWithTimeInterval: 0.4
+									 target: self
+								   selector: @selector(updateRipStatus:)
+								   userInfo: nil
+								    repeats: NO];
+
+    /*
+     * The medium may be checked as soon as no CD is left
+     * which may be in one of the burners.
+     */
+    if (startStages) {
+        [controller startReadyStages];
+    }
+}
+
+- (void) streamThread: (id)anObject
+{
+	id pool = [NSAutoreleasePool new];
+	ConvertProcess *process = anObject;
+	BOOL result;
+
+	currentTool = (id<BurnTool>)process->tool;
+	result = [(id<AudioCDStreamer>)process->tool streamTracks: process->tracks
+                                               withParameters: process->parameters];
+
+	[streamLock lock];
+	streamResult = result;
+	[streamLock unlockWithCondition: 1];
 
 	RELEASE(pool);
 	[NSThread exit];
@@ -347,14 +1191,42 @@ clean_up:
 {
 	ToolStatus status;
 	id<BurnTool> converter = currentTool;
+	ConvertProcess *process = [processes objectAtIndex: nextProcess - 1];
+	BOOL finished, result;
 
 	status = [converter getStatus];
 
+	[convertLock lock];
+	finished = process->finished;
+	result = process->result;
+	[convertLock unlock];
+
 	[controller setMiniwindowToTrack: status.trackProgress Entire: status.entireProgress];
 
-	if (status.processStatus == isConverting) {
+	if (!finished) {
+        NSString *label;
+
+        /*
+         * The tracks may still be normalized after the converter
+         * has stopped. Then the last progress is kept.
+         */
+        if (status.processStatus != isConverting) {
+            [NSTimer scheduledTimerWithTimeInterval: 0.4
+                                             target: self
+                                           selector: @selector(updateStatus:)
+                                           userInfo: nil
+                                            repeats: NO];
+            return;
+        }
+
+        if (status.speed > 0.) {
+            label = [NSString stringWithFormat: _(@"ConvertAudioHelper.trackTitleSpeed"),
+                                    status.trackName, status.speed];
+        } else {
+            label = [NSString stringWithFormat: _(@"Common.trackTitle"), status.trackName];
+        }
         [controller setTrackProgress: status.trackProgress
-                            andLabel: [NSString stringWithFormat: _(@"Common.trackTitle"), status.trackName]];
+                            andLabel: label];
         [controller setEntireProgress: status.entireProgress
                              andLabel: nil];
         
@@ -368,9 +1240,11 @@ clean_up:
 	}
 
 	// did we stop by 'Cancel' or by terminated thread?
-	if (status.processStatus == isCancelled) {
-		[controller nextStage: NO];
+	if (!result || (status.processStatus == isCancelled)) {
+		[controller stage: ConvertAudio finished: NO];
 	} else {
+        [self storeTracksOfProcess: process];
+        process->done = YES;
         [controller setTrackProgress: status.trackProgress
                             andLabel: nil];
         [controller setEntireProgress: status.entireProgress
@@ -379,7 +1253,7 @@ clean_up:
         /*
          * -startNextProcess will determine whether we are
          * finished or not. Hence, we do not need to call
-         * the controller's -nextStage: method here.
+         * the controller's -stage:finished: method here.
          */
 		[self startNextProcess];
 	}
@@ -24,22 +24,36 @@
 #ifndef CREATEISOHELPER_H_INC
 #define CREATEISOHELPER_H_INC
 
-#include <AppKit/AppKit.h>
+#include <Foundation/Foundation.h>
 
-#include "BurnProgressController.h"
+#include "BurnSession.h"
 #include "Burn/ExternalTools.h"
 
+@class Track;
+
 @interface CreateISOHelper : NSObject
 {
-    BurnProgressController *controller;
+    BurnSession *controller;
 
 	id<IsoImageCreator> currentTool;
 
     NSString *isoImageFile;
     BOOL creationStarted;
+    // condition 1 when the image or size thread has finished
+    NSConditionLock *threadLock;
+
+    /*
+     * on-the-fly burning
+     */
+    BOOL onTheFly;
+    Track *imageTrack;
+    NSArray *imageFiles;
+    NSString *imageVolumeId;
+    NSConditionLock *streamLock;
+    BOOL streamResult;
 }
 
-- (id) initWithController: (BurnProgressController *)aController;
+- (id) initWithController: (BurnSession *)aController;
 
 - (enum StartHelperStatus) start: (NSArray *) dataTracks volumeId: (NSString *)volumeId;
 - (void) stop: (BOOL) immediately;
@@ -49,6 +63,34 @@
  */ 
 - (NSString *)isoImageFile;
 
+/**
+ * <p>Returns YES if the image is not written to a file but
+ * created on-the-fly while burning. This is requested by the
+ * <em>OnTheFly</em> entry of the SessionParameters and only
+ * possible if the writer supports it.</p>
+ */
+- (BOOL) isOnTheFly;
+
+/**
+ * <p>Returns the image track to be burned on-the-fly. Its
+ * storage is <code>-</code> and its size the exact size of
+ * the image.</p>
+ */
+- (Track *) onTheFlyImage;
+
+/**
+ * <p>Starts writing the image into <var>pipe</var> on a separate
+ * thread. Used by BurnCDHelper when burning on-the-fly.</p>
+ */
+- (void) streamImageToPipe: (NSPipe *) pipe;
+
+/**
+ * <p>Waits for the image creator when the burner has finished. If
+ * burning failed, the image creation is stopped first. Returns YES
+ * if the image was written completely.</p>
+ */
+- (BOOL) finishStreaming: (BOOL) burnSucceeded;
+
 /**
  * private methods
  */
@@ -56,6 +98,9 @@
 
 
 - (void) createImageThread: (id) anObject;
+- (void) sizeImageThread: (id) anObject;
+- (void) streamImageThread: (id) anObject;
+- (BOOL) threadFinished;
 - (void) updateCreateISOProgress: (id) timer;
 
 @end
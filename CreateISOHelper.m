@@ -26,7 +26,6 @@
 #include "Constants.h"
 #include "Functions.h"
 #include "Track.h"
-#include "Project.h"
 #include "AppController.h"
 
 #include "Burn/ExternalTools.h"
@@ -35,12 +34,18 @@
 @implementation CreateISOHelper
 
 
-- (id) initWithController: (BurnProgressController *)aController
+- (id) initWithController: (BurnSession *)aController
 {
     self = [super init];
     if (self) {
         controller = aController;
         isoImageFile = nil;
+        onTheFly = NO;
+        imageTrack = nil;
+        imageFiles = nil;
+        imageVolumeId = nil;
+        threadLock = nil;
+        streamLock = nil;
     }
     return self;
 }
@@ -49,6 +54,11 @@
 - (void) dealloc
 {
     RELEASE(isoImageFile);
+    RELEASE(imageTrack);
+    RELEASE(imageFiles);
+    RELEASE(imageVolumeId);
+    RELEASE(threadLock);
+    RELEASE(streamLock);
     [super dealloc];
 }
 
@@ -60,6 +70,16 @@
     return isoImageFile;
 }
 
+- (BOOL) isOnTheFly
+{
+    return onTheFly;
+}
+
+- (Track *) onTheFlyImage
+{
+    return imageTrack;
+}
+
 - (enum StartHelperStatus) start: (NSArray *) dataTracks volumeId: (NSString *)volumeId
 {
 	BOOL isDir, mustCreate = YES;
@@ -78,11 +98,9 @@
 
 	currentTool = [[AppController appController] currentMkisofsBundle];
 	if (nil == currentTool) {
-        NSRunAlertPanel(APP_NAME,
-						[NSString stringWithFormat: @"%@\n%@",
+        [controller showError: [NSString stringWithFormat: @"%@\n%@",
 									_(@"CreateISOHelper.noProgram"),
-									_(@"Common.stopProcess")],
-						_(@"Common.OK"), nil, nil);
+									_(@"Common.stopProcess")]];
         return Failed;
 	}
 
@@ -111,16 +129,59 @@
 	}
 
 	if ([missingTracks count] != 0) {
-		NSRunAlertPanel(APP_NAME,
-						[NSString stringWithFormat: @"%@\n%@\n%@",
+		[controller showError: [NSString stringWithFormat: @"%@\n%@\n%@",
 								_(@"CreateISOHelper.noFiles"),
 								[missingTracks componentsJoinedByString: @"\n"],
-								_(@"Common.stopProcess")],
-						 _(@"Common.OK"), nil, nil);
+								_(@"Common.stopProcess")]];
 		
 		return Failed;
 	}
 
+	/*
+	 * Burning on-the-fly needs a writer that can read the image from
+	 * a pipe. In this case we only determine the image's size here. The
+	 * image itself is created by BurnCDHelper via -streamImageToPipe:.
+	 */
+	if ([[params objectForKey: @"OnTheFly"] boolValue]
+			&& ([controller isoImageOnly] == NO)) {
+		if (![[[AppController appController] currentWriterBundle] canBurnOnTheFly]) {
+			logToConsole(MessageStatusWarning, _(@"CreateISOHelper.noOnTheFly"));
+		} else if ([[controller burnDevices] count] > 1) {
+			/*
+			 * A single image stream cannot feed several burners.
+			 */
+			logToConsole(MessageStatusWarning, _(@"CreateISOHelper.noOnTheFlyCopies"));
+		} else {
+			onTheFly = YES;
+		}
+	}
+
+	if (onTheFly) {
+		ASSIGN(imageFiles, fileNames);
+		ASSIGN(imageVolumeId, volumeId);
+
+		if ([controller showsProgressOfStage: CreateISO]) {
+			[controller setTitle: _(@"CreateISOHelper.title")];
+			[controller setTrackProgress: 0. andLabel: @""];
+			[controller setEntireProgress: 0. andLabel: _(@"CreateISOHelper.calculatingSize")];
+		}
+
+		creationStarted = NO;
+		DESTROY(threadLock);
+		threadLock = [[NSConditionLock alloc] initWithCondition: 0];
+
+		[NSThread detachNewThreadSelector: @selector(sizeImageThread:)
+								 toTarget: self
+							   withObject: nil];
+
+		[NSTimer scheduledTimerWithTimeInterval: 0.4
+										 target: self
+									   selector: @selector(updateCreateISOProgress:)
+									   userInfo: nil
+									    repeats: NO];
+		return Started;
+	}
+
 	isoImageFile = [currentTool isoImageFile];
     if ((nil == isoImageFile) || [isoImageFile isEqualToString: @""]) {
 	    isoImageFile = [tempDir stringByAppendingPathComponent:
@@ -131,17 +192,16 @@
 		// if file does not exist, yet, we are fine
 	} else if (!isDir) {
 		// otherwise ask whether the file shall be reused, if it is a file
-		int result = NSRunAlertPanel(APP_NAME,
-							[NSString stringWithFormat: _(@"CreateISOHelper.imageExists"), isoImageFile],
-							_(@"CreateISOHelper.useImage"), _(@"CreateISOHelper.overwrite"), _(@"CreateISOHelper.createNew"));
-
-		switch (result) {
-		case NSAlertDefaultReturn:
+		switch ([controller actionForExistingImage: isoImageFile]) {
+		case ReuseImage:
 			mustCreate = NO;	// don't create an image
 			break;
-		case NSAlertAlternateReturn:
+		case OverwriteImage:
 			break;
-		case NSAlertOtherReturn:
+		case CancelSession:
+			isoImageFile = nil;	// not retained, yet
+			return Failed;
+		case CreateNewImage:
 			i = 0;
 			do {
 				// try new names
@@ -178,11 +238,10 @@
 	RETAIN(isoImageFile);
 
 	/*
-	 * If we reuse an already existing ISO image, we directly
-	 * start the burning process and skip the rest
+	 * If we reuse an already existing ISO image, we are done
+	 * and the controller may go on with the burning process.
 	 */
 	if (!mustCreate) {
-		[controller nextStage: YES];
 		return Done;
 	}
 
@@ -192,11 +251,19 @@
 	[threadObject setObject: isoImageFile forKey: @"image"];
 	[threadObject setObject: volumeId forKey: @"volid"];
 
-    [controller setTitle: _(@"CreateISOHelper.title")];
-    [controller setTrackProgress: 0. andLabel: @""];
-    [controller setEntireProgress: 0. andLabel: _(@"CreateISOHelper.settingUp")];
+	/*
+	 * Audio conversion may still be running. In this case it
+	 * keeps the progress bars and we only report in the background.
+	 */
+	if ([controller showsProgressOfStage: CreateISO]) {
+		[controller setTitle: _(@"CreateISOHelper.title")];
+		[controller setTrackProgress: 0. andLabel: @""];
+		[controller setEntireProgress: 0. andLabel: _(@"CreateISOHelper.settingUp")];
+	}
 
 	creationStarted = NO;
+	DESTROY(threadLock);
+	threadLock = [[NSConditionLock alloc] initWithCondition: 0];
 
 	[NSThread detachNewThreadSelector: @selector(createImageThread:)
 							 toTarget: self
@@ -251,17 +318,112 @@
                          toFile: [anObject objectForKey: @"image"]
                  withParameters: [controller burnParameters]];
 
+	[threadLock lock];
+	[threadLock unlockWithCondition: 1];
+	RELEASE(pool);
+	[NSThread exit];
+}
+
+- (void) sizeImageThread: (id)anObject
+{
+	id pool = [NSAutoreleasePool new];
+	long size;
+
+	size = [currentTool sizeOfISOImage: imageVolumeId
+	                        withTracks: imageFiles
+	                    withParameters: [controller burnParameters]];
+
+	if (size > 0) {
+		imageTrack = [[Track alloc] initWithProperties:
+						[NSArray arrayWithObjects: @"data", imageVolumeId, @"-", imageVolumeId,
+								[NSNumber numberWithUnsignedLong: size * 2048], nil]
+					forKeys: [NSArray arrayWithObjects: @"type", @"source", @"storage",
+								@"description", @"size", nil]];
+	}
+
+	[threadLock lock];
+	[threadLock unlockWithCondition: 1];
 	RELEASE(pool);
 	[NSThread exit];
 }
 
+- (BOOL) threadFinished
+{
+	if ([threadLock tryLockWhenCondition: 1]) {
+		[threadLock unlock];
+		return YES;
+	}
+	return NO;
+}
+
+- (void) streamImageToPipe: (NSPipe *) pipe
+{
+	DESTROY(streamLock);
+	streamLock = [[NSConditionLock alloc] initWithCondition: 0];
+
+	[NSThread detachNewThreadSelector: @selector(streamImageThread:)
+							 toTarget: self
+						   withObject: pipe];
+}
+
+- (void) streamImageThread: (id)anObject
+{
+	id pool = [NSAutoreleasePool new];
+	BOOL result;
+
+    result = [currentTool createISOImage: imageVolumeId
+                              withTracks: imageFiles
+                                  toPipe: anObject
+                          withParameters: [controller burnParameters]];
+
+	/*
+	 * Make sure the burner sees EOF even if mkisofs could not
+	 * be started at all.
+	 */
+	NS_DURING
+		[[anObject fileHandleForWriting] closeFile];
+	NS_HANDLER
+		// already closed by ToolProcess
+	NS_ENDHANDLER
+
+	[streamLock lock];
+	streamResult = result;
+	[streamLock unlockWithCondition: 1];
+
+	RELEASE(pool);
+	[NSThread exit];
+}
+
+- (BOOL) finishStreaming: (BOOL) burnSucceeded
+{
+	/*
+	 * If the burner stopped early, nobody reads the rest of the
+	 * image. Thus, we stop the image creator until its thread is
+	 * gone.
+	 */
+	while (![streamLock lockWhenCondition: 1
+	                           beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.5]]) {
+		if (!burnSucceeded) {
+			[(id<BurnTool>)currentTool stop: YES];
+		}
+	}
+	[streamLock unlock];
+
+	return streamResult;
+}
+
 - (void) updateCreateISOProgress: (id) timer
 {
     // silence compiler
 	id isoCreator = currentTool;
 	ToolStatus status = [isoCreator getStatus];
 
-	if (status.processStatus == isPreparing) {
+	/*
+	 * The tool's status may not have been set yet when the thread
+	 * has just been started. Wait for the thread in any case.
+	 */
+	if ((status.processStatus == isPreparing)
+			|| (![self threadFinished] && (status.processStatus != isCreatingImage))) {
 		[NSTimer scheduledTimerWithTimeInterval: 0.4
 										target: self
 										selector: @selector(updateCreateISOProgress:)
@@ -271,14 +433,26 @@
 		return;
 	}
 
-	[controller setMiniwindowToTrack: status.entireProgress Entire: status.entireProgress];
 	if (status.processStatus == isCreatingImage) {
-		if (!creationStarted) {
-			creationStarted = YES;
-			[controller setAbortEnabled: YES];
-    		[controller setEntireProgress: -1 andLabel: _(@"CreateISOHelper.creatingImage")];
+		if (![controller showsProgressOfStage: CreateISO]) {
+			[controller setBackgroundStatus:
+					[NSString stringWithFormat: _(@"CreateISOHelper.backgroundStatus"),
+							status.entireProgress]];
+			/*
+			 * Set up the progress bars as soon as we own them.
+			 */
+			creationStarted = NO;
+		} else {
+			if (!creationStarted) {
+				creationStarted = YES;
+				[controller setAbortEnabled: YES];
+				[controller setTitle: _(@"CreateISOHelper.title")];
+				[controller setTrackProgress: 0. andLabel: @""];
+				[controller setEntireProgress: -1 andLabel: _(@"CreateISOHelper.creatingImage")];
+			}
+			[controller setEntireProgress: status.entireProgress andLabel: nil];
+			[controller setMiniwindowToTrack: status.entireProgress Entire: status.entireProgress];
 		}
-    	[controller setEntireProgress: status.entireProgress andLabel: nil];
 
 		[NSTimer scheduledTimerWithTimeInterval: 0.4
 										target: self
@@ -289,14 +463,17 @@
 		return;
 	}
 
-    [controller setEntireProgress: status.entireProgress
-                         andLabel: nil];
+	if ([controller showsProgressOfStage: CreateISO]) {
+		[controller setEntireProgress: status.entireProgress
+		                     andLabel: nil];
+	}
 
 	// did we stop by 'Cancel' or by terminated thread?
-	if (status.processStatus == isCancelled) {
-		[controller nextStage: NO];
+	if ((status.processStatus == isCancelled)
+			|| (onTheFly && (imageTrack == nil))) {
+		[controller stage: CreateISO finished: NO];
 	} else {
-		[controller nextStage: YES];
+		[controller stage: CreateISO finished: YES];
 	}
 }
 
@@ -25,7 +25,6 @@
 #define FUNCTIONS_H
 
 #include <Foundation/Foundation.h>
-#include <AppKit/AppKit.h>
 
 @class NSString;
 @class NSMenuItem;
@@ -115,8 +114,11 @@ NSString *UserLibraryPath(void);
 NSString *LocalLibraryPath(void);
 id loadAudioCD(void);
 NSArray *getAvailableDrives(void);
+BOOL isSameDrive(NSString *sourceDevice, NSString *burnDevice);
 BOOL isAudioFile(NSString *fileName);
 NSArray *getAudioFileTypes(void);
+int numberOfJobs(NSDictionary *parameters);
+NSArray *probeDurations(id converter, NSArray *fileNames);
 
 NSString* framesToString(long frames);
 double framesToSeconds(long frames);
@@ -131,8 +133,22 @@ long audioSizeToFrames(unsigned size);
  * Doing it this way makes it easier to exchange them.
  */
 void releaseSharedConsole();
+void openSharedConsole();
 void logToConsole(NSString *priority, NSString *theMessage);
 
+/*
+ * Passes one line of output of an external tool to the console.
+ * May be called from any thread.
+ */
+void logToolOutput(NSString *theLine);
+
+/*
+ * Programs without a console window may divert the messages
+ * passed to logToConsole(). Pass NULL to use the console again.
+ */
+typedef void (*LogHandler)(NSString *priority, NSString *theMessage);
+void setLogHandler(LogHandler handler);
+
 id sharedInspectorsWin();
 void releaseSharedInspectorsWin();
 
@@ -21,6 +21,7 @@
  *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
  */
 
+#include <stdlib.h>
 #include <unistd.h>
 
 #include <AudioCD/AudioCDProtocol.h>
@@ -201,8 +202,7 @@ id loadAudioCD(void)
 			audioCDBundle = nil;
 		}
 	}
-	NSRunAlertPanel(APP_NAME, _(@"Functions.errorAudioCD"),
-						_(@"Common.abort"), nil, nil);
+	logToConsole(MessageStatusError, _(@"Functions.errorAudioCD"));
 
 	return nil;
 }
@@ -222,15 +222,226 @@ NSArray *getAvailableDrives(void)
 	return drives;
 }
 
+/**
+ * Returns YES if the CD drive <var>sourceDevice</var>, as it is used by
+ * the AudioCD bundle (e.g. /dev/sr0), is the same drive as the burner
+ * <var>burnDevice</var>, as it is listed by the writer bundle (e.g.
+ * "1,0,0: VENDOR MODEL REV" or "/dev/cd0c: VENDOR MODEL REV").
+ * If this cannot be told for sure, the function returns YES.<br />
+ * <br />
+ * <strong>Inputs</strong><br />
+ * <deflist>
+ * <term>sourceDevice</term>
+ * <desc>The device path of the CD drive.</desc>
+ * <term>burnDevice</term>
+ * <desc>The burner as listed by the writer bundle.</desc>
+ * </deflist>
+ */
+BOOL isSameDrive(NSString *sourceDevice, NSString *burnDevice)
+{
+	NSRange range;
+	NSString *burnId;
+	NSString *link;
+	NSArray *scsiId;
+	NSArray *busId;
+
+	if ((nil == sourceDevice) || (nil == burnDevice)) {
+		return YES;
+	}
+
+	range = [burnDevice rangeOfString: @": "];
+	if (range.location != NSNotFound) {
+		burnId = [burnDevice substringToIndex: range.location];
+	} else {
+		burnId = burnDevice;
+	}
+
+	/*
+	 * The burner is given as a device path, as on the BSDs.
+	 */
+	if ([burnId hasPrefix: @"/"]) {
+		return [[sourceDevice stringByResolvingSymlinksInPath]
+					isEqualToString: [burnId stringByResolvingSymlinksInPath]];
+	}
+
+	/*
+	 * The burner is given as a SCSI id "bus,target,lun". On Linux
+	 * the sysfs entry of the block device links to its SCSI address
+	 * "host:channel:target:lun".
+	 */
+	link = [NSString stringWithFormat: @"/sys/class/block/%@/device",
+				[[sourceDevice stringByResolvingSymlinksInPath] lastPathComponent]];
+	link = [[NSFileManager defaultManager] pathContentOfSymbolicLinkAtPath: link];
+	if (nil == link) {
+		return YES;
+	}
+
+	scsiId = [[link lastPathComponent] componentsSeparatedByString: @":"];
+	/*
+	 * Strip a transport prefix like "ATA:" from the SCSI id.
+	 */
+	range = [burnId rangeOfString: @":" options: NSBackwardsSearch];
+	if (range.location != NSNotFound) {
+		burnId = [burnId substringFromIndex: NSMaxRange(range)];
+	}
+	busId = [burnId componentsSeparatedByString: @","];
+	if (([scsiId count] != 4) || ([busId count] != 3)) {
+		return YES;
+	}
+
+	return ([[scsiId objectAtIndex: 0] intValue] == [[busId objectAtIndex: 0] intValue])
+		&& ([[scsiId objectAtIndex: 2] intValue] == [[busId objectAtIndex: 1] intValue])
+		&& ([[scsiId objectAtIndex: 3] intValue] == [[busId objectAtIndex: 2] intValue]);
+}
+
 NSArray *getAudioFileTypes(void)
 {
     if (nil == audioTypes) {
-        audioTypes = [[NSArray alloc] initWithObjects: @"wav", @"au", @"mp3", @"ogg",
-                   @"flac", @"wma", @"aiff", @"avi", @"flv", @"m4v", @"mov", nil];
+        audioTypes = [[NSArray alloc] initWithObjects: @"wav", @"au", @"snd", @"mp3", @"ogg",
+                   @"flac", @"wma", @"aif", @"aiff", @"aifc", @"avi", @"flv", @"m4v", @"mov", nil];
     }
     return audioTypes;
 }
 
+/**
+ * Returns the number of jobs a backend may run concurrently, e.g. the
+ * number of audio tracks converted at the same time. The value is taken
+ * from the <em>ConversionJobs</em> entry of the SessionParameters. If it
+ * is missing or not positive, the number of online processors is used.<br />
+ * <br />
+ * <strong>Inputs</strong><br />
+ * <deflist>
+ * <term>parameters</term>
+ * <desc>The parameters passed to the backend.</desc>
+ * </deflist>
+ */
+int numberOfJobs(NSDictionary *parameters)
+{
+	int jobs = [[[parameters objectForKey: @"SessionParameters"]
+								objectForKey: @"ConversionJobs"] intValue];
+
+	if (jobs <= 0) {
+		jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (jobs <= 0) {
+		jobs = 1;
+	}
+
+	return jobs;
+}
+
+/*
+ * The state shared by the threads of probeDurations().
+ */
+@interface DurationProbe : NSObject
+{
+@public
+	id converter;
+	NSArray *fileNames;
+	long *durations;
+	unsigned nextFile;
+	NSLock *lock;
+	NSConditionLock *workersLock;
+}
+- (void) probeFiles;
+- (void) probeThread: (id) anObject;
+@end
+
+@implementation DurationProbe
+
+- (void) probeFiles
+{
+	unsigned count = [fileNames count];
+
+	for (;;) {
+		id pool;
+		unsigned i;
+
+		[lock lock];
+		i = nextFile++;
+		[lock unlock];
+		if (i >= count) {
+			break;
+		}
+
+		pool = [NSAutoreleasePool new];
+		durations[i] = [converter duration: [fileNames objectAtIndex: i]];
+		RELEASE(pool);
+	}
+}
+
+- (void) probeThread: (id) anObject
+{
+	id pool = [NSAutoreleasePool new];
+
+	[self probeFiles];
+
+	[workersLock lock];
+	[workersLock unlockWithCondition: [workersLock condition] - 1];
+
+	RELEASE(pool);
+	[NSThread exit];
+}
+
+@end
+
+/**
+ * <p>Calls -duration: of <var>converter</var> for each of the files in
+ * <var>fileNames</var> and returns the results as NSNumbers in the same
+ * order. The files are examined by as many threads as there are
+ * processors, the calling thread being one of them. Thus, a converter
+ * which runs an external program for each file keeps all processors
+ * busy when many files are imported.</p>
+ * <p>-duration: must be safe to be called from several threads at
+ * once.</p>
+ */
+NSArray *probeDurations(id converter, NSArray *fileNames)
+{
+	DurationProbe *probe;
+	NSMutableArray *result;
+	unsigned count = [fileNames count];
+	unsigned i;
+	int workers;
+
+	if (count == 0) {
+		return [NSArray array];
+	}
+
+	probe = [DurationProbe new];
+	probe->converter = converter;
+	probe->fileNames = fileNames;
+	probe->durations = calloc(count, sizeof(long));
+	probe->nextFile = 0;
+	probe->lock = [NSLock new];
+
+	workers = MIN(numberOfJobs(nil), (int)count);
+	probe->workersLock = [[NSConditionLock alloc] initWithCondition: workers];
+	for (i = 1; i < workers; i++) {
+		[NSThread detachNewThreadSelector: @selector(probeThread:)
+								 toTarget: probe
+							   withObject: nil];
+	}
+
+	[probe probeFiles];
+	[probe->workersLock lock];
+	[probe->workersLock unlockWithCondition: [probe->workersLock condition] - 1];
+
+	[probe->workersLock lockWhenCondition: 0];
+	[probe->workersLock unlock];
+
+	result = [NSMutableArray arrayWithCapacity: count];
+	for (i = 0; i < count; i++) {
+		[result addObject: [NSNumber numberWithLong: probe->durations[i]]];
+	}
+
+	free(probe->durations);
+	RELEASE(probe->lock);
+	RELEASE(probe->workersLock);
+	RELEASE(probe);
+
+	return result;
+}
+
 NSString* framesToString(long frames)
 {
 	NSString *ret;
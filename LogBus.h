@@ -0,0 +1,66 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  LogBus.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef LOGBUS_H_INC
+#define LOGBUS_H_INC
+
+#include <Foundation/Foundation.h>
+
+/*
+ * The log bus carries the messages passed to logToConsole() and the
+ * output lines of the external tools to the console. It is a bounded
+ * ring buffer without locks. Any thread may post to it, but only one
+ * thread at a time, the main thread, may drain it.
+ * If the console does not keep up, new messages are dropped and
+ * counted.
+ */
+
+#define LOG_BUS_SIZE 8192		/* must be a power of 2 */
+
+typedef void (*LogBusConsumer)(NSString *priority, NSString *message, void *context);
+
+/*
+ * Adds a message to the bus. Returns NO if the bus is full.
+ */
+BOOL logBusPost(NSString *priority, NSString *message);
+
+/*
+ * Passes at most maxCount messages to consumer in the order they
+ * were posted. Returns the number of messages passed.
+ */
+unsigned logBusDrain(LogBusConsumer consumer, void *context, unsigned maxCount);
+
+/*
+ * Returns the number of messages dropped since the last call.
+ */
+unsigned long logBusDropped(void);
+
+/*
+ * The listener is called on the main thread after logToConsole()
+ * has posted a message to the bus, e.g. to open the console which
+ * drains it. Pass NULL to remove it.
+ */
+typedef void (*LogBusListener)(void);
+void setLogBusListener(LogBusListener listener);
+
+#endif
@@ -0,0 +1,162 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  LogBus.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "LogBus.h"
+
+#include "Constants.h"
+#include "Functions.h"
+
+#define LOG_BUS_MASK (LOG_BUS_SIZE - 1)
+
+/*
+ * Each slot carries a sequence number which tells whether the slot
+ * may be written (sequence == position) or read (sequence ==
+ * position + 1). To get along without an initialisation we store
+ * the sequence relative to the slot's index. Thus, the zeroed array
+ * has all slots free for the first round.
+ */
+typedef struct {
+    volatile unsigned long sequence;
+    NSString *priority;
+    NSString *message;
+} LogSlot;
+
+static LogSlot slots[LOG_BUS_SIZE];
+static volatile unsigned long writePosition = 0;
+static unsigned long readPosition = 0;
+static volatile unsigned long dropped = 0;
+
+static LogHandler logHandler = NULL;
+static LogBusListener busListener = NULL;
+
+static inline unsigned long slotSequence(unsigned long index)
+{
+    return slots[index].sequence + index;
+}
+
+static inline void setSlotSequence(unsigned long index, unsigned long sequence)
+{
+    slots[index].sequence = sequence - index;
+}
+
+
+BOOL logBusPost(NSString *priority, NSString *message)
+{
+    unsigned long pos = writePosition;
+    unsigned long index;
+
+    for (;;) {
+        long diff;
+
+        index = pos & LOG_BUS_MASK;
+        diff = (long)(slotSequence(index) - pos);
+        if (diff == 0) {
+            // The slot is free. Try to claim it.
+            if (__sync_bool_compare_and_swap(&writePosition, pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The consumer has not read this slot, yet. We are full.
+            __sync_fetch_and_add(&dropped, 1);
+            return NO;
+        }
+        pos = writePosition;
+    }
+
+    slots[index].priority = RETAIN(priority);
+    slots[index].message = [message copy];
+    // Publish the message only after it has been written.
+    __sync_synchronize();
+    setSlotSequence(index, pos + 1);
+    return YES;
+}
+
+unsigned logBusDrain(LogBusConsumer consumer, void *context, unsigned maxCount)
+{
+    unsigned count = 0;
+
+    while (count < maxCount) {
+        unsigned long index = readPosition & LOG_BUS_MASK;
+        NSString *message;
+        NSString *priority;
+
+        if (slotSequence(index) != readPosition + 1) {
+            // Empty or the producer is still writing the message.
+            break;
+        }
+        __sync_synchronize();
+        priority = slots[index].priority;
+        message = slots[index].message;
+        slots[index].priority = nil;
+        slots[index].message = nil;
+        __sync_synchronize();
+        // Hand the slot back to the producers for the next round.
+        setSlotSequence(index, readPosition + LOG_BUS_SIZE);
+        readPosition++;
+
+        consumer(priority, message, context);
+        RELEASE(priority);
+        RELEASE(message);
+        count++;
+    }
+    return count;
+}
+
+unsigned long logBusDropped(void)
+{
+    return __sync_fetch_and_and(&dropped, 0);
+}
+
+void setLogBusListener(LogBusListener listener)
+{
+    busListener = listener;
+}
+
+void setLogHandler(LogHandler handler)
+{
+    logHandler = handler;
+}
+
+void logToConsole(NSString *priority, NSString *theMessage)
+{
+    if (logHandler != NULL) {
+        logHandler(priority, theMessage);
+        return;
+    }
+
+    logBusPost(priority, theMessage);
+
+    if ((busListener != NULL) && [NSThread isMainThread]) {
+        busListener();
+    }
+}
+
+void logToolOutput(NSString *theLine)
+{
+    if (logHandler != NULL) {
+        logHandler(MessageStatusToolOutput, theLine);
+        return;
+    }
+
+    logBusPost(MessageStatusToolOutput, theLine);
+}
@@ -0,0 +1,156 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  LoudnessMeter.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef LOUDNESSMETER_H_INC
+#define LOUDNESSMETER_H_INC
+
+#include <stdint.h>
+
+#include <Foundation/Foundation.h>
+
+@class Track;
+@class WavWriter;
+
+/* The loudness ReplayGain 2.0 refers to, in LUFS */
+#define REPLAYGAIN_REFERENCE (-18.)
+
+/**
+ * <p>LoudnessMeter measures the integrated loudness of 16 bit stereo
+ * samples as defined by ITU-R BS.1770 and EBU R128: the samples are
+ * K-weighted, the mean square is taken over blocks of 400 ms which
+ * overlap by 75 %, and the blocks below -70 LUFS and those more than
+ * 10 LU below the mean of the rest are left out. The sample peak is
+ * recorded, too.</p>
+ * <p>The meter is fed while the samples are written, see WavWriter,
+ * so that the files need not be read again. The results are kept as
+ * properties of the tracks. If the <em>NormalizeLoudness</em> entry of
+ * the SessionParameters is set, the converters use them to bring the
+ * tracks to the loudness given by <em>TargetLoudness</em>, which is
+ * -18 LUFS like ReplayGain by default. <em>AnalyzeLoudness</em> makes
+ * them measure the tracks without changing them.</p>
+ */
+@interface LoudnessMeter : NSObject
+{
+    double shelf[5];
+    double highPass[5];
+    double state[2][4];
+
+    unsigned subBlockSize;
+    unsigned subBlockFill;
+    double subBlockEnergy;
+    double lastSubBlocks[3];
+    unsigned subBlocks;
+
+    double *blocks;
+    unsigned long blockCount;
+    unsigned long blockCapacity;
+
+    int peak;
+}
+
+/**
+ * <p>Returns YES if the converters shall measure the loudness of the
+ * tracks, i.e. <em>AnalyzeLoudness</em> or <em>NormalizeLoudness</em>
+ * is set in the SessionParameters of <var>parameters</var>.</p>
+ */
++ (BOOL) shouldAnalyze: (NSDictionary *) parameters;
+
+/**
+ * <p>Returns YES if the converters shall bring the tracks to the
+ * target loudness.</p>
+ */
++ (BOOL) shouldNormalize: (NSDictionary *) parameters;
+
+/**
+ * <p>Returns the loudness the tracks shall be brought to in LUFS.</p>
+ */
++ (double) targetLoudnessForParameters: (NSDictionary *) parameters;
+
+/**
+ * <p>Returns the factor the samples of a track with the given
+ * <var>loudness</var> and <var>peak</var> are multiplied with. The
+ * gain is reduced as far as necessary to keep the peak from clipping.
+ * Returns 1 if the loudness is not known or normalization is not
+ * requested.</p>
+ */
++ (float) gainForLoudness: (double) loudness
+                     peak: (double) peak
+               parameters: (NSDictionary *) parameters;
+
+/**
+ * <p>Sets <var>writer</var> up for the conversion of <var>track</var>:
+ * attaches a new meter if the loudness shall be measured and sets the
+ * gain if the track shall be normalized and its loudness is known
+ * already.</p>
+ */
++ (void) prepareWriter: (WavWriter *) writer
+              forTrack: (Track *) track
+            parameters: (NSDictionary *) parameters;
+
+/**
+ * <p>Must be called when all samples of <var>track</var> have been
+ * appended to <var>writer</var>, before it is closed. Stores the
+ * measured loudness in the track. If the track shall be normalized,
+ * but its loudness was not known before, the gain is applied to the
+ * samples written. Returns NO if this fails.</p>
+ */
++ (BOOL) finishWriter: (WavWriter *) writer
+             forTrack: (Track *) track
+           parameters: (NSDictionary *) parameters;
+
+/**
+ * <p>Brings the WAV file <var>file</var>, which has been written by an
+ * external program, to the target loudness. The samples are copied
+ * through a WavWriter, which measures them, and the copy replaces the
+ * file. Returns NO if the file cannot be read or written. It is left
+ * unchanged then.</p>
+ */
++ (BOOL) normalizeFile: (NSString *) file
+              forTrack: (Track *) track
+            parameters: (NSDictionary *) parameters;
+
+- (id) initWithSampleRate: (unsigned) rate;
+
+/**
+ * <p>Adds <var>count</var> interleaved stereo frames in native byte
+ * order to the measurement.</p>
+ */
+- (void) addSamples: (const int16_t *) samples
+             frames: (unsigned) count;
+
+/**
+ * <p>Returns the integrated loudness of the samples added so far in
+ * LUFS, or NAN if they are too short or silent.</p>
+ */
+- (double) integratedLoudness;
+
+/**
+ * <p>Returns the largest absolute sample value, 1 being full
+ * scale.</p>
+ */
+- (double) peak;
+
+@end
+
+#endif
@@ -0,0 +1,374 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  LoudnessMeter.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "LoudnessMeter.h"
+#include "PCMFile.h"
+#include "Track.h"
+#include "WavWriter.h"
+
+/* The gates of BS.1770-4 */
+#define ABSOLUTE_GATE (-70.)
+#define RELATIVE_GATE (-10.)
+
+/* The initial number of blocks there is room for, about 7 minutes */
+#define INITIAL_BLOCKS 4096
+
+
+static inline double energyToLoudness(double energy)
+{
+    return -0.691 + 10. * log10(energy);
+}
+
+static inline double loudnessToEnergy(double loudness)
+{
+    return pow(10., (loudness + 0.691) / 10.);
+}
+
+/*
+ * One biquad in transposed direct form II. coef holds b0, b1, b2, a1
+ * and a2, z the two state variables.
+ */
+static inline double biquad(const double *coef, double *z, double x)
+{
+    double y = coef[0] * x + z[0];
+
+    z[0] = coef[1] * x - coef[3] * y + z[1];
+    z[1] = coef[2] * x - coef[4] * y;
+    return y;
+}
+
+
+@interface LoudnessMeter (Private)
+- (void) endSubBlock;
+@end
+
+@implementation LoudnessMeter (Private)
+
+/*
+ * A block is made of the last four sub-blocks of 100 ms, thus the
+ * blocks overlap by 75 %.
+ */
+- (void) endSubBlock
+{
+    double energy = subBlockEnergy;
+
+    if (subBlocks >= 3) {
+        energy += lastSubBlocks[0] + lastSubBlocks[1] + lastSubBlocks[2];
+        if (blockCount == blockCapacity) {
+            double *newBlocks = realloc(blocks, 2 * blockCapacity * sizeof(double));
+
+            if (NULL != newBlocks) {
+                blocks = newBlocks;
+                blockCapacity *= 2;
+            }
+        }
+        if (blockCount < blockCapacity) {
+            blocks[blockCount++] = energy / (4. * subBlockSize);
+        }
+    }
+
+    lastSubBlocks[0] = lastSubBlocks[1];
+    lastSubBlocks[1] = lastSubBlocks[2];
+    lastSubBlocks[2] = subBlockEnergy;
+    subBlocks++;
+    subBlockEnergy = 0.;
+    subBlockFill = 0;
+}
+
+@end
+
+
+@implementation LoudnessMeter
+
++ (BOOL) shouldAnalyze: (NSDictionary *) parameters
+{
+    NSDictionary *sesParams = [parameters objectForKey: @"SessionParameters"];
+
+    return [[sesParams objectForKey: @"AnalyzeLoudness"] boolValue]
+        || [[sesParams objectForKey: @"NormalizeLoudness"] boolValue];
+}
+
++ (BOOL) shouldNormalize: (NSDictionary *) parameters
+{
+    return [[[parameters objectForKey: @"SessionParameters"]
+                objectForKey: @"NormalizeLoudness"] boolValue];
+}
+
++ (double) targetLoudnessForParameters: (NSDictionary *) parameters
+{
+    id target = [[parameters objectForKey: @"SessionParameters"]
+                    objectForKey: @"TargetLoudness"];
+
+    if ((nil == target) || ([target doubleValue] >= 0.)) {
+        return REPLAYGAIN_REFERENCE;
+    }
+    return [target doubleValue];
+}
+
++ (float) gainForLoudness: (double) loudness
+                     peak: (double) peak
+               parameters: (NSDictionary *) parameters
+{
+    double gain;
+
+    if (isnan(loudness) || ![LoudnessMeter shouldNormalize: parameters]) {
+        return 1.f;
+    }
+
+    gain = [LoudnessMeter targetLoudnessForParameters: parameters] - loudness;
+    if ((peak > 0.) && (gain > -20. * log10(peak))) {
+        gain = -20. * log10(peak);
+    }
+    return (float)pow(10., gain / 20.);
+}
+
++ (void) prepareWriter: (WavWriter *) writer
+              forTrack: (Track *) track
+            parameters: (NSDictionary *) parameters
+{
+    if ([LoudnessMeter shouldAnalyze: parameters]) {
+        [writer setLoudnessMeter:
+                    AUTORELEASE([[LoudnessMeter alloc] initWithSampleRate: 44100])];
+    }
+    if ([LoudnessMeter shouldNormalize: parameters] && [track hasLoudness]) {
+        [writer setGain: [LoudnessMeter gainForLoudness: [track loudness]
+                                                   peak: [track peak]
+                                             parameters: parameters]];
+    }
+}
+
++ (BOOL) finishWriter: (WavWriter *) writer
+             forTrack: (Track *) track
+           parameters: (NSDictionary *) parameters
+{
+    LoudnessMeter *meter = [writer loudnessMeter];
+    BOOL gainApplied = [track hasLoudness];
+    double loudness;
+
+    if (nil == meter) {
+        return YES;
+    }
+
+    /*
+     * Silence is left alone.
+     */
+    loudness = [meter integratedLoudness];
+    if (isnan(loudness)) {
+        return YES;
+    }
+    [track setLoudness: loudness peak: [meter peak]];
+
+    if (!gainApplied && [LoudnessMeter shouldNormalize: parameters]) {
+        return [writer applyGainToWrittenSamples:
+                            [LoudnessMeter gainForLoudness: loudness
+                                                      peak: [meter peak]
+                                                parameters: parameters]];
+    }
+    return YES;
+}
+
++ (BOOL) normalizeFile: (NSString *) file
+              forTrack: (Track *) track
+            parameters: (NSDictionary *) parameters
+{
+    NSString *copy = [file stringByAppendingString: @".norm"];
+    PCMFile *pcm;
+    WavWriter *writer;
+    BOOL ok = YES;
+
+    pcm = AUTORELEASE([[PCMFile alloc] initWithPath: file]);
+    if ((nil == pcm) || ![pcm canRead] || ([pcm sampleRate] != 44100)) {
+        return NO;
+    }
+    writer = AUTORELEASE([[WavWriter alloc] initWithPath: copy
+                                              sampleRate: 44100
+                                                channels: 2
+                                          expectedFrames: [pcm frames]]);
+    if (nil == writer) {
+        return NO;
+    }
+    [LoudnessMeter prepareWriter: writer forTrack: track parameters: parameters];
+
+    while (ok) {
+        unsigned char *bytes = [writer bytesForAppending: PCM_READ_FRAMES * 4];
+        long frames;
+
+        if (NULL == bytes) {
+            ok = NO;
+            break;
+        }
+        frames = [pcm readFrames: PCM_READ_FRAMES into: (int16_t *)bytes];
+        if (frames < 0) {
+            ok = NO;
+        } else if (frames == 0) {
+            break;
+        } else {
+            [writer appendedBytes: frames * 4];
+        }
+    }
+
+    ok = ok && [LoudnessMeter finishWriter: writer forTrack: track parameters: parameters];
+    ok = [writer close] && ok;
+    if (ok) {
+        ok = (rename([copy fileSystemRepresentation], [file fileSystemRepresentation]) == 0);
+    }
+    if (!ok) {
+        unlink([copy fileSystemRepresentation]);
+    }
+    return ok;
+}
+
+/*
+ * The K-weighting filter is a high shelf followed by a high pass.
+ * BS.1770 gives the coefficients for 48 kHz only. We compute them
+ * for the actual rate from the analog prototypes, as libebur128 does.
+ */
+- (id) initWithSampleRate: (unsigned) rate
+{
+    double f0, gain, q, k, vh, vb, a0;
+
+    self = [super init];
+    if (nil == self) {
+        return nil;
+    }
+
+    f0 = 1681.974450955533;
+    gain = 3.999843853973347;
+    q = 0.7071752369554196;
+    k = tan(M_PI * f0 / rate);
+    vh = pow(10., gain / 20.);
+    vb = pow(vh, 0.4996667741545416);
+    a0 = 1. + k / q + k * k;
+    shelf[0] = (vh + vb * k / q + k * k) / a0;
+    shelf[1] = 2. * (k * k - vh) / a0;
+    shelf[2] = (vh - vb * k / q + k * k) / a0;
+    shelf[3] = 2. * (k * k - 1.) / a0;
+    shelf[4] = (1. - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1. + k / q + k * k;
+    highPass[0] = 1.;
+    highPass[1] = -2.;
+    highPass[2] = 1.;
+    highPass[3] = 2. * (k * k - 1.) / a0;
+    highPass[4] = (1. - k / q + k * k) / a0;
+
+    memset(state, 0, sizeof(state));
+    subBlockSize = rate / 10;
+    subBlockFill = 0;
+    subBlockEnergy = 0.;
+    subBlocks = 0;
+    blockCount = 0;
+    blockCapacity = INITIAL_BLOCKS;
+    blocks = malloc(blockCapacity * sizeof(double));
+    peak = 0;
+
+    if ((NULL == blocks) || (0 == subBlockSize)) {
+        DESTROY(self);
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    free(blocks);
+    [super dealloc];
+}
+
+- (void) addSamples: (const int16_t *) samples
+             frames: (unsigned) count
+{
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        int left = samples[2 * i];
+        int right = samples[2 * i + 1];
+        double l, r;
+
+        if (abs(left) > peak) {
+            peak = abs(left);
+        }
+        if (abs(right) > peak) {
+            peak = abs(right);
+        }
+
+        l = biquad(highPass, state[0] + 2, biquad(shelf, state[0], left / 32768.));
+        r = biquad(highPass, state[1] + 2, biquad(shelf, state[1], right / 32768.));
+        subBlockEnergy += l * l + r * r;
+
+        if (++subBlockFill == subBlockSize) {
+            [self endSubBlock];
+        }
+    }
+}
+
+- (double) integratedLoudness
+{
+    double absoluteGate = loudnessToEnergy(ABSOLUTE_GATE);
+    double relativeGate, sum = 0.;
+    unsigned long i, n = 0;
+
+    for (i = 0; i < blockCount; i++) {
+        if (blocks[i] > absoluteGate) {
+            sum += blocks[i];
+            n++;
+        }
+    }
+    if (0 == n) {
+        return NAN;
+    }
+
+    relativeGate = loudnessToEnergy(energyToLoudness(sum / n) + RELATIVE_GATE);
+    if (relativeGate < absoluteGate) {
+        relativeGate = absoluteGate;
+    }
+
+    sum = 0.;
+    n = 0;
+    for (i = 0; i < blockCount; i++) {
+        if (blocks[i] > relativeGate) {
+            sum += blocks[i];
+            n++;
+        }
+    }
+    if (0 == n) {
+        return NAN;
+    }
+    return energyToLoudness(sum / n);
+}
+
+- (double) peak
+{
+    return peak / 32768.;
+}
+
+@end
@@ -0,0 +1,76 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  MediumHelper.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef MEDIUMHELPER_H_INC
+#define MEDIUMHELPER_H_INC
+
+#include <Foundation/Foundation.h>
+
+#include "BurnSession.h"
+#include "Burn/ExternalTools.h"
+
+/**
+ * <p>MediumHelper prepares the media in the writing devices while
+ * the other stages of a burning session are still running. It checks
+ * whether a usable medium is inserted in each device and optionally
+ * blanks the CD-RWs one after the other.</p>
+ * <p>Blanking is requested by the <em>BlankMode</em> entry of the
+ * SessionParameters, which may be <code>fast</code> or <code>full</code>.
+ * If the entry is missing, the medium is not blanked.</p>
+ */
+@interface MediumHelper : NSObject
+{
+    BurnSession *controller;
+
+	id<Burner> currentTool;
+    NSArray *devices;
+    // a copy of the burn parameters with the blanker's settings
+    NSDictionary *blankParameters;
+
+    NSLock *threadLock;
+    BOOL threadRunning;
+    BOOL threadResult;
+    NSMutableArray *missingDevices;
+}
+
+- (id) initWithController: (BurnSession *)aController;
+
+- (enum StartHelperStatus) checkMedium;
+- (enum StartHelperStatus) blankMedium;
+- (void) stop: (BOOL) immediately;
+
+//
+// private methods
+//
+- (void) cleanUp: (BOOL) success;
+
+- (NSString *) blankMode;
+- (void) startThread: (SEL) selector forStage: (enum BurnStage) aStage;
+- (void) checkMediumThread: (id) anObject;
+- (void) blankMediumThread: (id) anObject;
+- (void) updateStatus: (id) timer;
+
+@end
+
+
+#endif
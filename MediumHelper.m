@@ -0,0 +1,274 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *	MediumHelper.m
+ *
+ *	Copyright (c) 2026
+ *
+ *	Author: Andreas Schik <andreas@schik.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation; either version 2 of the License, or
+ *	(at your option) any later version.
+ *
+ *	This program is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ *	GNU General Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License
+ *	along with this program; if not, write to the Free Software
+ *	Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "MediumHelper.h"
+
+#include "Constants.h"
+#include "Functions.h"
+#include "AppController.h"
+
+#include "Burn/ExternalTools.h"
+
+
+@implementation MediumHelper
+
+- (id) initWithController: (BurnSession *)aController
+{
+    self = [super init];
+    if (self) {
+        controller = aController;
+        currentTool = nil;
+        devices = nil;
+        blankParameters = nil;
+        missingDevices = [NSMutableArray new];
+        threadLock = [NSLock new];
+        threadRunning = NO;
+        threadResult = NO;
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    RELEASE(devices);
+    RELEASE(blankParameters);
+    RELEASE(threadLock);
+    RELEASE(missingDevices);
+    [super dealloc];
+}
+
+- (NSString *) blankMode
+{
+    NSString *mode = [[[controller burnParameters]
+                            objectForKey: @"SessionParameters"]
+                                objectForKey: @"BlankMode"];
+
+    if ([mode isEqualToString: @"fast"] || [mode isEqualToString: @"full"]) {
+        return mode;
+    }
+    return nil;
+}
+
+- (enum StartHelperStatus) checkMedium
+{
+	currentTool = [[AppController appController] currentWriterBundle];
+	if (nil == currentTool) {
+        [controller showError: [NSString stringWithFormat: @"%@\n%@",
+									_(@"BurnCDHelper.noProgram"),
+									_(@"Common.stopProcess")]];
+        return Failed;
+	}
+
+    ASSIGN(devices, [controller burnDevices]);
+	if ([devices count] == 0) {
+		return Failed;
+	}
+
+    [self startThread: @selector(checkMediumThread:) forStage: CheckMedium];
+    return Started;
+}
+
+- (enum StartHelperStatus) blankMedium
+{
+    NSString *mode = [self blankMode];
+	NSMutableDictionary *parameters;
+
+    if (nil == mode) {
+        return Done;
+    }
+
+    /*
+     * The writer usually ejects the medium after blanking. We want
+     * to burn it right away, though. The other stages run at the
+     * same time and read the session's parameters, so the blanker
+     * gets a copy.
+     */
+    parameters = [NSMutableDictionary dictionaryWithDictionary: [controller burnParameters]];
+    [parameters setObject: @"YES" forKey: @"KeepMediumLoaded"];
+    ASSIGN(blankParameters, [NSDictionary dictionaryWithDictionary: parameters]);
+
+    if ([controller showsProgressOfStage: BlankMedium]) {
+        [controller setTitle: _(@"MediumHelper.title")];
+        [controller hideTrackProgress: YES];
+        [controller setEntireProgress: -1 andLabel: _(@"MediumHelper.blanking")];
+        [controller makeEntireProgressIndeterminate: YES];
+    } else {
+        [controller setBackgroundStatus: _(@"MediumHelper.blanking")];
+    }
+    logToConsole(MessageStatusInfo, _(@"MediumHelper.blanking"));
+
+    [self startThread: @selector(blankMediumThread:) forStage: BlankMedium];
+    return Started;
+}
+
+- (void) stop: (BOOL) immediately
+{
+    if (currentTool != nil) {
+        [(id<BurnTool>)currentTool stop: immediately];
+		logToConsole(MessageStatusError, _(@"Common.cancelled"));
+    }
+}
+
+- (void) cleanUp: (BOOL) success
+{
+    /*
+     * Nothing to do here. The writer is cleaned up by BurnCDHelper.
+     */
+}
+
+- (void) startThread: (SEL) selector forStage: (enum BurnStage) aStage
+{
+    [threadLock lock];
+    threadRunning = YES;
+    threadResult = NO;
+    [threadLock unlock];
+
+	[NSThread detachNewThreadSelector: selector
+							 toTarget: self
+						   withObject: nil];
+
+	[NSTimer scheduledTimerWithTimeInterval: 0.4
+									 target: self
+								   selector: @selector(updateStatus:)
+								   userInfo: [NSNumber numberWithInt: aStage]
+									repeats: NO];
+}
+
+- (void) checkMediumThread: (id)anObject
+{
+	id pool = [NSAutoreleasePool new];
+    NSDictionary *burnParameters = [controller burnParameters];
+    NSMutableArray *missing = [NSMutableArray array];
+    int i;
+
+    for (i = 0; i < [devices count]; i++) {
+        NSString *device = [devices objectAtIndex: i];
+        BOOL result;
+
+        /*
+         * A CD-RW we are going to blank need not be empty.
+         */
+        if (nil != [self blankMode]) {
+            NSDictionary *info = [currentTool mediaInformationForDevice: device
+                                                             parameters: burnParameters];
+            result = [[info objectForKey: @"type"] isEqualToString: @"CD-RW"];
+        } else {
+            result = [currentTool isWritableMediumInDevice: device
+                                                parameters: burnParameters];
+        }
+        if (!result) {
+            [missing addObject: device];
+        }
+    }
+
+    [threadLock lock];
+    [missingDevices setArray: missing];
+    threadResult = ([missing count] == 0);
+    threadRunning = NO;
+    [threadLock unlock];
+
+	RELEASE(pool);
+	[NSThread exit];
+}
+
+- (void) blankMediumThread: (id)anObject
+{
+	id pool = [NSAutoreleasePool new];
+    EBlankingMode mode = fastBlank;
+    BOOL result = YES;
+    int i;
+
+    if ([[self blankMode] isEqualToString: @"full"]) {
+        mode = fullBlank;
+    }
+
+    for (i = 0; (i < [devices count]) && result; i++) {
+        result = [currentTool blankCDRW: mode
+                               inDevice: [devices objectAtIndex: i]
+                         withParameters: blankParameters];
+    }
+
+    [threadLock lock];
+    threadResult = result;
+    threadRunning = NO;
+    [threadLock unlock];
+
+	RELEASE(pool);
+	[NSThread exit];
+}
+
+- (void) updateStatus: (id)timer
+{
+    enum BurnStage stage = [[timer userInfo] intValue];
+    BOOL running, result;
+    NSString *message;
+
+    [threadLock lock];
+    running = threadRunning;
+    result = threadResult;
+    [threadLock unlock];
+
+    if (running) {
+		[NSTimer scheduledTimerWithTimeInterval: 0.4
+										 target: self
+									   selector: @selector(updateStatus:)
+									   userInfo: [timer userInfo]
+									    repeats: NO];
+        return;
+    }
+
+    if (stage == BlankMedium) {
+        if ([controller showsProgressOfStage: BlankMedium]) {
+            [controller makeEntireProgressIndeterminate: NO];
+        }
+        if (result) {
+            logToConsole(MessageStatusInfo, _(@"BlankPanel.success"));
+        } else {
+            logToConsole(MessageStatusError, _(@"BlankPanel.error"));
+        }
+        [controller stage: BlankMedium finished: result];
+        return;
+    }
+
+    if (result) {
+        [controller stage: CheckMedium finished: YES];
+        return;
+    }
+
+    /*
+     * No usable medium. Ask the user to insert one and check again.
+     * With several drives we tell which ones need a new medium.
+     */
+    message = (nil != [self blankMode]) ? _(@"MediumHelper.insertCDRW") : _(@"BurnCDHelper.insertCD");
+    if ([devices count] > 1) {
+        message = [NSString stringWithFormat: @"%@\n%@", message,
+                            [missingDevices componentsJoinedByString: @"\n"]];
+    }
+    if (![controller askForMedium: message]) {
+        [controller stage: CheckMedium finished: NO];
+        return;
+    }
+    [self startThread: @selector(checkMediumThread:) forStage: CheckMedium];
+}
+
+@end
@@ -0,0 +1,101 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  MetadataCache.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef METADATACACHE_H_INC
+#define METADATACACHE_H_INC
+
+#include <Foundation/Foundation.h>
+
+/**
+ * <p>MetadataCache remembers the type, duration and size of the audio
+ * files added to projects. Adding a file again thus neither scans an
+ * MP3 file for its frames nor runs ffmpeg to get its duration. The
+ * loudness measured while a file is converted is kept, too.</p>
+ * <p>The entries are kept in <code>MetadataCache.plist</code> in
+ * UserLibraryPath(). Each entry is found by the file's path and holds
+ * the file's inode, size and modification date. An entry is only
+ * used as long as they have not changed. When the cache is loaded, a
+ * background thread removes the entries of files which have been
+ * changed or removed since.</p>
+ */
+@interface MetadataCache : NSObject
+{
+    NSString *indexPath;
+    NSMutableDictionary *entries;
+    NSLock *cacheLock;
+    BOOL dirty;
+}
+
++ (MetadataCache *) sharedCache;
+
+/**
+ * <p>Looks up <var>file</var>. Returns YES and the cached values if
+ * there is an entry and the file has not changed since it was
+ * stored.</p>
+ */
+- (BOOL) getType: (NSString **) type
+        duration: (long *) duration
+            size: (unsigned *) size
+         forFile: (NSString *) file;
+
+/**
+ * <p>Stores the values for <var>file</var>. Only the entries in
+ * memory are changed. They are written by -synchronize.</p>
+ */
+- (void) setType: (NSString *) type
+        duration: (long) duration
+            size: (unsigned) size
+         forFile: (NSString *) file;
+
+/**
+ * <p>Looks up the loudness in LUFS and the sample peak of
+ * <var>file</var>. Returns NO if they have not been measured or the
+ * file has changed since.</p>
+ */
+- (BOOL) getLoudness: (double *) loudness
+                peak: (double *) peak
+             forFile: (NSString *) file;
+
+/**
+ * <p>Stores the loudness and the peak of <var>file</var>. The other
+ * values of its entry are kept if the file has not changed.</p>
+ */
+- (void) setLoudness: (double) loudness
+                peak: (double) peak
+             forFile: (NSString *) file;
+
+/**
+ * <p>Writes the entries to disk if they have been changed.</p>
+ */
+- (void) synchronize;
+
+//
+// private methods
+//
+- (void) readIndex;
+- (void) validateEntries: (id) anObject;
+
+@end
+
+#endif
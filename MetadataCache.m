@@ -0,0 +1,325 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  MetadataCache.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include <sys/stat.h>
+
+#include "MetadataCache.h"
+
+#include "Functions.h"
+
+
+static MetadataCache *sharedCache = nil;
+static NSLock *sharedCacheLock = nil;
+
+/*
+ * The keys of an entry in the cache's index.
+ */
+static NSString *EntryInode = @"Inode";
+static NSString *EntryFileSize = @"FileSize";
+static NSString *EntryModified = @"Modified";
+static NSString *EntryType = @"Type";
+static NSString *EntryDuration = @"Duration";
+static NSString *EntrySize = @"Size";
+static NSString *EntryLoudness = @"Loudness";
+static NSString *EntryPeak = @"Peak";
+
+
+/*
+ * Returns whether entry was made for the file described by st.
+ * Numbers read from the index may be strings, so we compare
+ * them as long long.
+ */
+static BOOL entryMatchesStat(NSDictionary *entry, const struct stat *st)
+{
+    return (nil != entry)
+        && ([[entry objectForKey: EntryInode] longLongValue] == (long long)st->st_ino)
+        && ([[entry objectForKey: EntryFileSize] longLongValue] == (long long)st->st_size)
+        && ([[entry objectForKey: EntryModified] longLongValue] == (long long)st->st_mtime);
+}
+
+/*
+ * Returns whether entry was made for the file as it is now.
+ */
+static BOOL entryMatchesFile(NSDictionary *entry, NSString *file)
+{
+    struct stat st;
+
+    if ((nil == entry)
+            || (0 != stat([file fileSystemRepresentation], &st))
+            || !S_ISREG(st.st_mode)) {
+        return NO;
+    }
+    return entryMatchesStat(entry, &st);
+}
+
+
+@implementation MetadataCache
+
++ (void) initialize
+{
+    if (self == [MetadataCache class]) {
+        sharedCacheLock = [NSLock new];
+    }
+}
+
+/*
+ * The threads probing durations may be the first to use the cache.
+ */
++ (MetadataCache *) sharedCache
+{
+    [sharedCacheLock lock];
+    if (nil == sharedCache) {
+        sharedCache = [MetadataCache new];
+    }
+    [sharedCacheLock unlock];
+    return sharedCache;
+}
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        indexPath = RETAIN([UserLibraryPath() stringByAppendingPathComponent: @"MetadataCache.plist"]);
+        entries = [NSMutableDictionary new];
+        cacheLock = [NSLock new];
+        dirty = NO;
+        [self readIndex];
+
+        if ([entries count] > 0) {
+            [NSThread detachNewThreadSelector: @selector(validateEntries:)
+                                     toTarget: self
+                                   withObject: nil];
+        }
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    RELEASE(indexPath);
+    RELEASE(entries);
+    RELEASE(cacheLock);
+    [super dealloc];
+}
+
+- (BOOL) getType: (NSString **) type
+        duration: (long *) duration
+            size: (unsigned *) size
+         forFile: (NSString *) file
+{
+    NSDictionary *entry;
+
+    if (nil == file) {
+        return NO;
+    }
+
+    [cacheLock lock];
+    entry = RETAIN([entries objectForKey: file]);
+    [cacheLock unlock];
+    AUTORELEASE(entry);
+
+    if (!entryMatchesFile(entry, file) || (nil == [entry objectForKey: EntryType])) {
+        return NO;
+    }
+
+    if (NULL != type) {
+        *type = [entry objectForKey: EntryType];
+    }
+    if (NULL != duration) {
+        *duration = [[entry objectForKey: EntryDuration] longValue];
+    }
+    if (NULL != size) {
+        *size = (unsigned)[[entry objectForKey: EntrySize] longLongValue];
+    }
+    return YES;
+}
+
+- (void) setType: (NSString *) type
+        duration: (long) duration
+            size: (unsigned) size
+         forFile: (NSString *) file
+{
+    struct stat st;
+    NSMutableDictionary *entry;
+    NSDictionary *old;
+
+    if ((nil == file) || (nil == type)
+            || (0 != stat([file fileSystemRepresentation], &st))
+            || !S_ISREG(st.st_mode)) {
+        return;
+    }
+
+    entry = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                    [NSNumber numberWithLongLong: (long long)st.st_ino], EntryInode,
+                    [NSNumber numberWithLongLong: (long long)st.st_size], EntryFileSize,
+                    [NSNumber numberWithLongLong: (long long)st.st_mtime], EntryModified,
+                    type, EntryType,
+                    [NSNumber numberWithLong: duration], EntryDuration,
+                    [NSNumber numberWithUnsignedInt: size], EntrySize,
+                    nil];
+
+    [cacheLock lock];
+    old = [entries objectForKey: file];
+    if (entryMatchesStat(old, &st) && (nil != [old objectForKey: EntryLoudness])) {
+        [entry setObject: [old objectForKey: EntryLoudness] forKey: EntryLoudness];
+        [entry setObject: [old objectForKey: EntryPeak] forKey: EntryPeak];
+    }
+    [entries setObject: entry forKey: file];
+    dirty = YES;
+    [cacheLock unlock];
+}
+
+- (BOOL) getLoudness: (double *) loudness
+                peak: (double *) peak
+             forFile: (NSString *) file
+{
+    NSDictionary *entry;
+
+    if (nil == file) {
+        return NO;
+    }
+
+    [cacheLock lock];
+    entry = RETAIN([entries objectForKey: file]);
+    [cacheLock unlock];
+    AUTORELEASE(entry);
+
+    if (!entryMatchesFile(entry, file) || (nil == [entry objectForKey: EntryLoudness])) {
+        return NO;
+    }
+
+    if (NULL != loudness) {
+        *loudness = [[entry objectForKey: EntryLoudness] doubleValue];
+    }
+    if (NULL != peak) {
+        *peak = [[entry objectForKey: EntryPeak] doubleValue];
+    }
+    return YES;
+}
+
+- (void) setLoudness: (double) loudness
+                peak: (double) peak
+             forFile: (NSString *) file
+{
+    struct stat st;
+    NSMutableDictionary *entry;
+    NSDictionary *old;
+
+    if ((nil == file)
+            || (0 != stat([file fileSystemRepresentation], &st))
+            || !S_ISREG(st.st_mode)) {
+        return;
+    }
+
+    [cacheLock lock];
+    old = [entries objectForKey: file];
+    if (entryMatchesStat(old, &st)) {
+        entry = [NSMutableDictionary dictionaryWithDictionary: old];
+    } else {
+        entry = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                        [NSNumber numberWithLongLong: (long long)st.st_ino], EntryInode,
+                        [NSNumber numberWithLongLong: (long long)st.st_size], EntryFileSize,
+                        [NSNumber numberWithLongLong: (long long)st.st_mtime], EntryModified,
+                        nil];
+    }
+    [entry setObject: [NSNumber numberWithDouble: loudness] forKey: EntryLoudness];
+    [entry setObject: [NSNumber numberWithDouble: peak] forKey: EntryPeak];
+    [entries setObject: entry forKey: file];
+    dirty = YES;
+    [cacheLock unlock];
+}
+
+- (void) synchronize
+{
+    NSDictionary *copy = nil;
+
+    [cacheLock lock];
+    if (dirty) {
+        copy = [NSDictionary dictionaryWithDictionary: entries];
+        dirty = NO;
+    }
+    [cacheLock unlock];
+
+    if (nil != copy) {
+        [copy writeToFile: indexPath atomically: YES];
+    }
+}
+
+//
+// private methods
+//
+
+- (void) readIndex
+{
+    NSDictionary *index = [NSDictionary dictionaryWithContentsOfFile: indexPath];
+
+    if (nil != index) {
+        [entries addEntriesFromDictionary: index];
+    }
+}
+
+/*
+ * Runs in a thread of its own. Checking each entry means a stat()
+ * per file, which takes a while for a large cache or files on slow
+ * media. Thus, the lookups do not wait for it. They check their
+ * entries themselves.
+ */
+- (void) validateEntries: (id) anObject
+{
+    id pool = [NSAutoreleasePool new];
+    NSArray *files;
+    int i, count;
+
+    [cacheLock lock];
+    files = [entries allKeys];
+    [cacheLock unlock];
+
+    count = [files count];
+    for (i = 0; i < count; i++) {
+        NSString *file = [files objectAtIndex: i];
+        NSDictionary *entry;
+
+        [cacheLock lock];
+        entry = RETAIN([entries objectForKey: file]);
+        [cacheLock unlock];
+
+        if ((nil != entry) && !entryMatchesFile(entry, file)) {
+            [cacheLock lock];
+            // Do not remove an entry which has been renewed meanwhile.
+            if ([entries objectForKey: file] == entry) {
+                [entries removeObjectForKey: file];
+                dirty = YES;
+            }
+            [cacheLock unlock];
+        }
+        RELEASE(entry);
+    }
+
+    [self synchronize];
+
+    RELEASE(pool);
+    [NSThread exit];
+}
+
+@end
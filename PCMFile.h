@@ -0,0 +1,123 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  PCMFile.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef PCMFILE_H_INC
+#define PCMFILE_H_INC
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <Foundation/Foundation.h>
+
+/* The number of sample frames -readFrames:into: returns at most */
+#define PCM_READ_FRAMES 8192
+
+typedef enum {
+    PCMContainerWAV,
+    PCMContainerAIFF,
+    PCMContainerAU
+} PCMContainer;
+
+/**
+ * <p>PCMFile reads uncompressed audio from WAV, AIFF/AIFC and AU files.
+ * It walks the files' chunks, so that chunks like LIST or bext and
+ * WAVE_FORMAT_EXTENSIBLE headers are understood. Integer samples of
+ * 8 to 32 bits in either byte order and 32 bit floating point samples
+ * are supported.</p>
+ * <p>-readFrames:into: returns the samples as 16 bit stereo in native
+ * byte order, which is what WavWriter takes. Mono is written to both
+ * channels. Files with more than two channels cannot be read.</p>
+ */
+@interface PCMFile : NSObject
+{
+    NSString *path;
+    int fd;
+    PCMContainer container;
+    unsigned sampleRate;
+    unsigned channels;
+    unsigned sampleBytes;
+    BOOL bigEndian;
+    BOOL isFloat;
+    BOOL isUnsigned;
+    BOOL plainHeader;
+    unsigned long long dataOffset;
+    unsigned long long frames;
+    unsigned long long position;
+
+    unsigned char *raw;
+    int32_t *wide;
+}
+
+/**
+ * <p>Returns whether files with the extension <var>ext</var> may be
+ * read by PCMFile.</p>
+ */
++ (BOOL) handlesFileType: (NSString *) ext;
+
+/**
+ * <p>Reads the header of the file at <var>aPath</var>. Returns nil if
+ * the file is not a WAV, AIFF or AU file with uncompressed samples.</p>
+ */
+- (id) initWithPath: (NSString *) aPath;
+
+- (PCMContainer) container;
+- (unsigned) sampleRate;
+- (unsigned) channels;
+- (unsigned) bitsPerSample;
+- (unsigned long long) frames;
+
+/**
+ * <p>Returns the position of the first sample in the file.</p>
+ */
+- (unsigned long long) dataOffset;
+
+/**
+ * <p>Returns the duration in CD frames.</p>
+ */
+- (long) duration;
+
+/**
+ * <p>Returns YES if the file may be passed to the burning programs
+ * unchanged: a WAV file with the plain 44 byte header or an AU file,
+ * holding 16 bit stereo samples at 44100 Hz.</p>
+ */
+- (BOOL) isBurnable;
+
+/**
+ * <p>Returns YES if -readFrames:into: can deliver the samples, i.e.
+ * the file has one or two channels.</p>
+ */
+- (BOOL) canRead;
+
+/**
+ * <p>Reads up to <var>count</var> sample frames, at most
+ * PCM_READ_FRAMES, into <var>out</var>, which must have room for
+ * <var>count</var> 16 bit stereo frames. Returns the number of frames
+ * read, 0 at the end of the data and -1 on errors.</p>
+ */
+- (long) readFrames: (unsigned) count into: (int16_t *) out;
+
+@end
+
+#endif
@@ -0,0 +1,634 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  PCMFile.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "PCMFile.h"
+#include "Constants.h"
+#include "Functions.h"
+
+/* WAVE format tags */
+#define WAVE_FORMAT_PCM         0x0001
+#define WAVE_FORMAT_IEEE_FLOAT  0x0003
+#define WAVE_FORMAT_EXTENSIBLE  0xfffe
+
+#ifdef WORDS_BIGENDIAN
+#define NATIVE_BIG_ENDIAN YES
+#else
+#define NATIVE_BIG_ENDIAN NO
+#endif
+
+typedef uint16_t v8hu __attribute__ ((vector_size (16)));
+
+/* AU encodings */
+#define AU_LINEAR_8     2
+#define AU_LINEAR_16    3
+#define AU_LINEAR_24    4
+#define AU_LINEAR_32    5
+#define AU_FLOAT        6
+
+
+static inline unsigned le16(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline unsigned long le32(const unsigned char *p)
+{
+    return (unsigned long)p[0] | ((unsigned long)p[1] << 8)
+        | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static inline unsigned be16(const unsigned char *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static inline unsigned long be32(const unsigned char *p)
+{
+    return ((unsigned long)p[0] << 24) | ((unsigned long)p[1] << 16)
+        | ((unsigned long)p[2] << 8) | (unsigned long)p[3];
+}
+
+/*
+ * AIFF stores the sample rate as 80 bit IEEE extended.
+ */
+static double extendedToDouble(const unsigned char *p)
+{
+    int exponent = ((p[0] & 0x7f) << 8) | p[1];
+    unsigned long long mantissa = ((unsigned long long)be32(p + 2) << 32) | be32(p + 6);
+    double value;
+
+    if ((exponent == 0) && (mantissa == 0)) {
+        return 0.;
+    }
+    value = ldexp((double)mantissa, exponent - 16383 - 63);
+    return (p[0] & 0x80) ? -value : value;
+}
+
+static BOOL readAt(int fd, unsigned long long offset, void *buffer, size_t length)
+{
+    size_t done = 0;
+
+    while (done < length) {
+        ssize_t n = pread(fd, (char *)buffer + done, length - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return NO;
+        }
+        if (n == 0) {
+            return NO;
+        }
+        done += n;
+    }
+    return YES;
+}
+
+
+/*
+ * The conversion kernels. Integer samples are first moved to the top
+ * of 32 bits, whatever their width and byte order. Then they are all
+ * rounded to 16 bits the same way. The loops have no dependencies
+ * between their iterations, so that the compiler can vectorize them.
+ */
+static void loadIntegerSamples(const unsigned char *in, int32_t *out, size_t n,
+                               unsigned width, BOOL bigEndian, BOOL isUnsigned)
+{
+    BOOL swap = (bigEndian != NATIVE_BIG_ENDIAN);
+    size_t i;
+
+    switch (width) {
+    case 1:
+        if (isUnsigned) {
+            for (i = 0; i < n; i++)
+                out[i] = (int32_t)((uint32_t)(in[i] ^ 0x80) << 24);
+        } else {
+            for (i = 0; i < n; i++)
+                out[i] = (int32_t)((uint32_t)in[i] << 24);
+        }
+        break;
+    case 2:
+        if (swap) {
+            for (i = 0; i < n; i++) {
+                uint16_t v;
+                memcpy(&v, in + 2*i, 2);
+                out[i] = (int32_t)((uint32_t)__builtin_bswap16(v) << 16);
+            }
+        } else {
+            for (i = 0; i < n; i++) {
+                uint16_t v;
+                memcpy(&v, in + 2*i, 2);
+                out[i] = (int32_t)((uint32_t)v << 16);
+            }
+        }
+        break;
+    case 3:
+        if (bigEndian) {
+            for (i = 0; i < n; i++)
+                out[i] = (int32_t)(((uint32_t)in[3*i] << 24) | ((uint32_t)in[3*i+1] << 16)
+                                   | ((uint32_t)in[3*i+2] << 8));
+        } else {
+            for (i = 0; i < n; i++)
+                out[i] = (int32_t)(((uint32_t)in[3*i+2] << 24) | ((uint32_t)in[3*i+1] << 16)
+                                   | ((uint32_t)in[3*i] << 8));
+        }
+        break;
+    case 4:
+        if (swap) {
+            for (i = 0; i < n; i++) {
+                uint32_t v;
+                memcpy(&v, in + 4*i, 4);
+                out[i] = (int32_t)__builtin_bswap32(v);
+            }
+        } else {
+            memcpy(out, in, n * 4);
+        }
+        break;
+    }
+}
+
+static void loadFloatSamples(const unsigned char *in, int32_t *out, size_t n,
+                             BOOL bigEndian)
+{
+    BOOL swap = (bigEndian != NATIVE_BIG_ENDIAN);
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        uint32_t bits;
+        float f;
+
+        memcpy(&bits, in + 4*i, 4);
+        if (swap)
+            bits = __builtin_bswap32(bits);
+        memcpy(&f, &bits, sizeof(f));
+        // Full scale of 16 bits, rounded below, kept in the top bits.
+        f = f * 32768.f;
+        f = (f > 32767.f) ? 32767.f : ((f < -32768.f) ? -32768.f : f);
+        out[i] = (int32_t)lrintf(f) * 65536;
+    }
+}
+
+/*
+ * Rounds to the nearest 16 bit value. Only the largest positive
+ * values can overflow.
+ */
+static void requantize(const int32_t *in, int16_t *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        int32_t v = (in[i] >> 16) + ((in[i] >> 15) & 1);
+        out[i] = (int16_t)((v > 32767) ? 32767 : v);
+    }
+}
+
+/*
+ * Swaps the bytes of 16 bit samples in place. The block loop uses
+ * 16 byte vectors, so that it does not depend on the compiler
+ * vectorizing the plain loop.
+ */
+static void swapSamples16(int16_t *samples, size_t n)
+{
+    unsigned char *p = (unsigned char *)samples;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        v8hu v;
+
+        memcpy(&v, p + 2*i, sizeof(v));
+        v = (v << 8) | (v >> 8);
+        memcpy(p + 2*i, &v, sizeof(v));
+    }
+    for (; i < n; i++) {
+        uint16_t v;
+
+        memcpy(&v, p + 2*i, 2);
+        v = __builtin_bswap16(v);
+        memcpy(p + 2*i, &v, 2);
+    }
+}
+
+static void monoToStereo(const int16_t *in, int16_t *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        out[2*i] = in[i];
+        out[2*i+1] = in[i];
+    }
+}
+
+
+@interface PCMFile (Private)
+- (BOOL) parseWAV: (unsigned long long) fileSize;
+- (BOOL) parseAIFF: (unsigned long long) fileSize;
+- (BOOL) parseAU: (unsigned long long) fileSize;
+@end
+
+@implementation PCMFile (Private)
+
+- (BOOL) parseWAV: (unsigned long long) fileSize
+{
+    unsigned long long offset = 12;
+    unsigned formatTag = 0;
+    unsigned headerTag = 0;
+    BOOL haveFormat = NO;
+
+    container = PCMContainerWAV;
+
+    while (offset + 8 <= fileSize) {
+        unsigned char chunk[8];
+        unsigned long long size;
+
+        if (!readAt(fd, offset, chunk, 8)) {
+            return NO;
+        }
+        size = le32(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char fmt[40];
+            unsigned blockAlign, bits;
+
+            if ((size < 16) || !readAt(fd, offset + 8, fmt, MIN(size, sizeof(fmt)))) {
+                return NO;
+            }
+            formatTag = headerTag = le16(fmt);
+            channels = le16(fmt + 2);
+            sampleRate = le32(fmt + 4);
+            blockAlign = le16(fmt + 12);
+            bits = le16(fmt + 14);
+            if ((formatTag == WAVE_FORMAT_EXTENSIBLE) && (size >= 40)) {
+                // The real format is in the first two bytes of the sub format GUID.
+                formatTag = le16(fmt + 24);
+            }
+            if ((channels == 0) || (blockAlign % channels != 0)) {
+                return NO;
+            }
+            sampleBytes = blockAlign / channels;
+            if (formatTag == WAVE_FORMAT_PCM) {
+                if ((sampleBytes < 1) || (sampleBytes > 4) || (bits > sampleBytes * 8)) {
+                    return NO;
+                }
+            } else if (formatTag == WAVE_FORMAT_IEEE_FLOAT) {
+                if (sampleBytes != 4) {
+                    return NO;
+                }
+                isFloat = YES;
+            } else {
+                return NO;
+            }
+            isUnsigned = (sampleBytes == 1);
+            haveFormat = YES;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                return NO;
+            }
+            dataOffset = offset + 8;
+            // Streamed files may not know their size.
+            if ((size == 0) || (size == 0xffffffffULL) || (dataOffset + size > fileSize)) {
+                size = fileSize - dataOffset;
+            }
+            frames = size / (sampleBytes * channels);
+            plainHeader = (dataOffset == 44) && (headerTag == WAVE_FORMAT_PCM);
+            return YES;
+        }
+        // Chunks are padded to an even size.
+        offset += 8 + size + (size & 1);
+    }
+    return NO;
+}
+
+- (BOOL) parseAIFF: (unsigned long long) fileSize
+{
+    unsigned char form[12];
+    unsigned long long offset = 12;
+    BOOL isAIFC;
+    BOOL haveFormat = NO;
+
+    container = PCMContainerAIFF;
+    bigEndian = YES;
+
+    if (!readAt(fd, 0, form, 12)) {
+        return NO;
+    }
+    isAIFC = (memcmp(form + 8, "AIFC", 4) == 0);
+
+    while (offset + 8 <= fileSize) {
+        unsigned char chunk[8];
+        unsigned long long size;
+
+        if (!readAt(fd, offset, chunk, 8)) {
+            return NO;
+        }
+        size = be32(chunk + 4);
+
+        if (memcmp(chunk, "COMM", 4) == 0) {
+            unsigned char comm[22];
+            unsigned bits;
+
+            if ((size < (isAIFC ? 22 : 18))
+                    || !readAt(fd, offset + 8, comm, isAIFC ? 22 : 18)) {
+                return NO;
+            }
+            channels = be16(comm);
+            bits = be16(comm + 6);
+            sampleRate = (unsigned)(extendedToDouble(comm + 8) + 0.5);
+            sampleBytes = (bits + 7) / 8;
+            if (isAIFC) {
+                if (memcmp(comm + 18, "sowt", 4) == 0) {
+                    bigEndian = NO;
+                } else if ((memcmp(comm + 18, "fl32", 4) == 0)
+                        || (memcmp(comm + 18, "FL32", 4) == 0)) {
+                    isFloat = YES;
+                    sampleBytes = 4;
+                } else if ((memcmp(comm + 18, "NONE", 4) != 0)
+                        && (memcmp(comm + 18, "twos", 4) != 0)) {
+                    return NO;
+                }
+            }
+            if ((channels == 0) || (sampleBytes < 1) || (sampleBytes > 4)) {
+                return NO;
+            }
+            haveFormat = YES;
+        } else if (memcmp(chunk, "SSND", 4) == 0) {
+            unsigned char ssnd[8];
+
+            if (!haveFormat || (size < 8) || !readAt(fd, offset + 8, ssnd, 8)) {
+                return NO;
+            }
+            /*
+             * The samples must start within the chunk. Otherwise the
+             * length below would wrap around.
+             */
+            if (be32(ssnd) > size - 8) {
+                return NO;
+            }
+            dataOffset = offset + 16 + be32(ssnd);
+            if (dataOffset > fileSize) {
+                return NO;
+            }
+            size = MIN(offset + 8 + size, fileSize) - dataOffset;
+            frames = size / (sampleBytes * channels);
+            return YES;
+        }
+        offset += 8 + size + (size & 1);
+    }
+    return NO;
+}
+
+- (BOOL) parseAU: (unsigned long long) fileSize
+{
+    unsigned char header[24];
+    unsigned long long size;
+
+    container = PCMContainerAU;
+    bigEndian = YES;
+
+    if (!readAt(fd, 0, header, 24)) {
+        return NO;
+    }
+    dataOffset = be32(header + 4);
+    size = be32(header + 8);
+    sampleRate = be32(header + 16);
+    channels = be32(header + 20);
+
+    switch (be32(header + 12)) {
+    case AU_LINEAR_8:
+        sampleBytes = 1;
+        break;
+    case AU_LINEAR_16:
+        sampleBytes = 2;
+        break;
+    case AU_LINEAR_24:
+        sampleBytes = 3;
+        break;
+    case AU_LINEAR_32:
+        sampleBytes = 4;
+        break;
+    case AU_FLOAT:
+        sampleBytes = 4;
+        isFloat = YES;
+        break;
+    default:
+        return NO;
+    }
+    if ((channels == 0) || (dataOffset < 24) || (dataOffset > fileSize)) {
+        return NO;
+    }
+    // The size may be -1 if it was not known when the file was written.
+    if ((size == 0xffffffffULL) || (dataOffset + size > fileSize)) {
+        size = fileSize - dataOffset;
+    }
+    frames = size / (sampleBytes * channels);
+    return YES;
+}
+
+@end
+
+
+@implementation PCMFile
+
++ (BOOL) handlesFileType: (NSString *) ext
+{
+    static NSArray *types = nil;
+
+    if (nil == types) {
+        types = [[NSArray alloc] initWithObjects: @"wav", @"au", @"snd",
+                                    @"aif", @"aiff", @"aifc", nil];
+    }
+    return [types containsObject: [ext lowercaseString]];
+}
+
+- (id) initWithPath: (NSString *) aPath
+{
+    struct stat st;
+    unsigned char magic[12];
+    BOOL ok = NO;
+
+    self = [super init];
+    if (nil == self) {
+        return nil;
+    }
+
+    path = [aPath copy];
+    raw = NULL;
+    wide = NULL;
+    position = 0;
+
+    fd = open([aPath fileSystemRepresentation], O_RDONLY);
+    if ((fd >= 0) && (fstat(fd, &st) == 0) && S_ISREG(st.st_mode)
+            && readAt(fd, 0, magic, 12)) {
+        if ((memcmp(magic, "RIFF", 4) == 0) && (memcmp(magic + 8, "WAVE", 4) == 0)) {
+            ok = [self parseWAV: st.st_size];
+        } else if ((memcmp(magic, "FORM", 4) == 0)
+                && ((memcmp(magic + 8, "AIFF", 4) == 0) || (memcmp(magic + 8, "AIFC", 4) == 0))) {
+            ok = [self parseAIFF: st.st_size];
+        } else if (memcmp(magic, ".snd", 4) == 0) {
+            ok = [self parseAU: st.st_size];
+        }
+    }
+
+    if (!ok) {
+        DESTROY(self);
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    if (fd >= 0) {
+        close(fd);
+    }
+    free(raw);
+    free(wide);
+    RELEASE(path);
+    [super dealloc];
+}
+
+- (PCMContainer) container
+{
+    return container;
+}
+
+- (unsigned) sampleRate
+{
+    return sampleRate;
+}
+
+- (unsigned) channels
+{
+    return channels;
+}
+
+- (unsigned) bitsPerSample
+{
+    return sampleBytes * 8;
+}
+
+- (unsigned long long) frames
+{
+    return frames;
+}
+
+- (unsigned long long) dataOffset
+{
+    return dataOffset;
+}
+
+- (long) duration
+{
+    if (0 == sampleRate) {
+        return 0;
+    }
+    return (long)(frames * FramesPerSecond / sampleRate);
+}
+
+- (BOOL) isBurnable
+{
+    if ((sampleRate != 44100) || (channels != 2) || (sampleBytes != 2) || isFloat) {
+        return NO;
+    }
+    if (container == PCMContainerWAV) {
+        return plainHeader;
+    }
+    return (container == PCMContainerAU);
+}
+
+- (BOOL) canRead
+{
+    return (channels == 1) || (channels == 2);
+}
+
+- (long) readFrames: (unsigned) count into: (int16_t *) out
+{
+    size_t samples, bytes;
+
+    if (![self canRead]) {
+        return -1;
+    }
+
+    count = MIN(count, PCM_READ_FRAMES);
+    if (position + count > frames) {
+        count = frames - position;
+    }
+    if (0 == count) {
+        return 0;
+    }
+
+    samples = count * channels;
+    bytes = samples * sampleBytes;
+
+    /*
+     * 16 bit stereo integer samples, as on CDs, are read right into
+     * the output and swapped there if need be.
+     */
+    if ((channels == 2) && (sampleBytes == 2) && !isFloat) {
+        if (!readAt(fd, dataOffset + position * 4, out, bytes)) {
+            return -1;
+        }
+        position += count;
+        if (bigEndian != NATIVE_BIG_ENDIAN) {
+            swapSamples16(out, samples);
+        }
+        return count;
+    }
+
+    if (NULL == raw) {
+        raw = malloc(PCM_READ_FRAMES * channels * sampleBytes);
+        wide = malloc(PCM_READ_FRAMES * channels * sizeof(int32_t));
+        if ((NULL == raw) || (NULL == wide)) {
+            return -1;
+        }
+    }
+
+    if (!readAt(fd, dataOffset + position * channels * sampleBytes, raw, bytes)) {
+        return -1;
+    }
+    position += count;
+
+    if (isFloat) {
+        loadFloatSamples(raw, wide, samples, bigEndian);
+    } else {
+        loadIntegerSamples(raw, wide, samples, sampleBytes, bigEndian, isUnsigned);
+    }
+
+    if (channels == 2) {
+        requantize(wide, out, samples);
+    } else {
+        // The mono samples go to the second half first, then are spread.
+        requantize(wide, out + count, samples);
+        monoToStereo(out + count, out, count);
+    }
+
+    return count;
+}
+
+@end
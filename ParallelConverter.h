@@ -0,0 +1,142 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ParallelConverter.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef PARALLELCONVERTER_H_INC
+#define PARALLELCONVERTER_H_INC
+
+#include <Foundation/Foundation.h>
+
+#include "Burn/ExternalTools.h"
+
+@class Track;
+
+/**
+ * <p>ConversionJob holds the state of one track while it is
+ * converted by one of the worker threads of a ParallelConverter.
+ * Converters which need more state use a subclass.</p>
+ */
+@interface ConversionJob : NSObject
+{
+@public
+    Track *track;
+    NSString *outFile;
+    long duration;
+    volatile BOOL cancelled;
+    BOOL running;
+}
+
+- (id) initWithTrack: (Track *) aTrack outFile: (NSString *) aFile;
+
+- (Track *) track;
+- (NSString *) outFile;
+
+/**
+ * <p>Returns YES if the converter should stop.</p>
+ */
+- (BOOL) isCancelled;
+
+/**
+ * <p>Sorts the longest track first.</p>
+ */
+- (NSComparisonResult) compareDuration: (ConversionJob *) other;
+
+@end
+
+/**
+ * <p>ParallelConverter is the base class for audio converter bundles
+ * which convert several tracks at once. It creates a job for each
+ * track and runs the jobs in a pool of worker threads, the longest
+ * tracks first. The number of workers is taken from the session
+ * parameters. If a job fails, the others are cancelled. The state of
+ * the running jobs is combined by -getStatus.</p>
+ * <p>A subclass implements -name, -fileTypes, -duration: and
+ * -runJob:. It overrides -cancelJob: and -progressOfJob: if it can
+ * stop a job or tell its progress. The methods called with the status
+ * lock held must not block.</p>
+ */
+@interface ParallelConverter : NSObject <BurnTool, AudioConverter>
+{
+    ToolStatus convStatus;
+    NSLock *statusLock;
+    NSString *trackName;
+
+    NSMutableArray *allJobs;
+    int nextJob;
+    long totalFrames;
+    long finishedFrames;
+    NSConditionLock *workersLock;
+    NSDictionary *convParameters;
+}
+
+/**
+ * <p>Returns the class of the jobs, ConversionJob by default.</p>
+ */
++ (Class) jobClass;
+
+/**
+ * <p>Converts the track of <var>job</var> into the file
+ * <var>job->outFile</var>. It is called in a worker thread. Returns
+ * NO if the track could not be converted. The output file is removed
+ * then. Must be implemented by subclasses.</p>
+ */
+- (BOOL) runJob: (ConversionJob *) job;
+
+/**
+ * <p>Called with the status lock held when the jobs are stopped.
+ * The default implementation marks <var>job</var> as cancelled.</p>
+ */
+- (void) cancelJob: (ConversionJob *) job;
+
+/**
+ * <p>Called with the status lock held. Returns the progress of the
+ * running <var>job</var> in percent. The default is 0.</p>
+ */
+- (double) progressOfJob: (ConversionJob *) job;
+
+/**
+ * <p>Called with the status lock held. Returns the seconds of audio
+ * the running <var>job</var> converts per second. The default is
+ * 0.</p>
+ */
+- (double) speedOfJob: (ConversionJob *) job;
+
+/**
+ * <p>Called with the status lock held when <var>job</var> is over,
+ * before it is counted as finished.</p>
+ */
+- (void) finishJob: (ConversionJob *) job;
+
+/**
+ * <p>Called with the status lock held after the jobs have been
+ * created and sorted, before the workers are started.</p>
+ */
+- (void) prepareJobs;
+
+/**
+ * <p>Writes a message to the console.</p>
+ */
+- (void) sendOutputString: (NSString *) outString;
+
+@end
+
+#endif
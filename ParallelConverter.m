@@ -0,0 +1,498 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ParallelConverter.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "ParallelConverter.h"
+
+#include "Constants.h"
+#include "Functions.h"
+#include "Track.h"
+
+
+@implementation ConversionJob
+
+- (id) initWithTrack: (Track *) aTrack outFile: (NSString *) aFile
+{
+    self = [super init];
+    if (self) {
+        ASSIGN(track, aTrack);
+        ASSIGN(outFile, aFile);
+        duration = [aTrack duration];
+        cancelled = NO;
+        running = NO;
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    RELEASE(track);
+    RELEASE(outFile);
+    [super dealloc];
+}
+
+- (Track *) track
+{
+    return track;
+}
+
+- (NSString *) outFile
+{
+    return outFile;
+}
+
+- (BOOL) isCancelled
+{
+    return cancelled;
+}
+
+- (NSComparisonResult) compareDuration: (ConversionJob *) other
+{
+    if (duration > other->duration)
+        return NSOrderedAscending;
+    if (duration < other->duration)
+        return NSOrderedDescending;
+    return NSOrderedSame;
+}
+
+@end
+
+
+@interface ParallelConverter (Private)
+- (void) workerThread: (id) parameters;
+- (void) runJobs;
+- (ConversionJob *) nextJob;
+- (BOOL) convertJob: (ConversionJob *) job;
+- (void) cancelJobs;
+- (NSString *) makeOutfileNameForTrack: (NSString *) trackName
+                               tempDir: (NSString *) tempDir;
+@end
+
+@implementation ParallelConverter (Private)
+
+- (NSString *) makeOutfileNameForTrack: (NSString *) aTrackName
+                               tempDir: (NSString *) tempDir
+{
+    NSString *baseName = [[aTrackName lastPathComponent] stringByDeletingPathExtension];
+
+    return [tempDir stringByAppendingPathComponent:
+                        [NSString stringWithFormat: @"%@.wav", baseName]];
+}
+
+- (void) workerThread: (id) parameters
+{
+    id pool = [NSAutoreleasePool new];
+
+    [self runJobs];
+
+    [workersLock lock];
+    [workersLock unlockWithCondition: [workersLock condition] - 1];
+
+    RELEASE(pool);
+    [NSThread exit];
+}
+
+/*
+ * Converts jobs until there are none left or the conversion
+ * was cancelled. Runs in each worker thread.
+ */
+- (void) runJobs
+{
+    ConversionJob *job;
+
+    while (nil != (job = [self nextJob])) {
+        id pool = [NSAutoreleasePool new];
+
+        if (![self convertJob: job]) {
+            /*
+             * One failed track spoils the whole session. Stop
+             * the other workers, too.
+             */
+            [statusLock lock];
+            convStatus.processStatus = isCancelled;
+            [statusLock unlock];
+            [self cancelJobs];
+        }
+        RELEASE(pool);
+    }
+}
+
+- (ConversionJob *) nextJob
+{
+    ConversionJob *job = nil;
+
+    [statusLock lock];
+    if ((convStatus.processStatus == isConverting)
+            && (nextJob < [allJobs count])) {
+        job = [allJobs objectAtIndex: nextJob++];
+        job->running = YES;
+    }
+    [statusLock unlock];
+
+    return job;
+}
+
+- (BOOL) convertJob: (ConversionJob *) job
+{
+    BOOL ret;
+
+    [job->track setStorage: job->outFile];
+
+    ret = [self runJob: job] && ![job isCancelled];
+
+    /*
+     * We delete in any case the unfinished file.
+     */
+    if (!ret && [[NSFileManager defaultManager] fileExistsAtPath: job->outFile]) {
+        [self sendOutputString: [NSString stringWithFormat: _(@"Common.removeTempFile"),
+                                    job->outFile]];
+        if (![[NSFileManager defaultManager] removeFileAtPath: job->outFile handler: nil]) {
+            [self sendOutputString: _(@"Common.removeFail")];
+        }
+    }
+
+    [statusLock lock];
+    [self finishJob: job];
+    job->running = NO;
+    if (ret) {
+        finishedFrames += job->duration;
+    }
+    [statusLock unlock];
+
+    return ret;
+}
+
+- (void) cancelJobs
+{
+    int i;
+
+    [statusLock lock];
+    for (i = 0; i < [allJobs count]; i++) {
+        [self cancelJob: [allJobs objectAtIndex: i]];
+    }
+    [statusLock unlock];
+}
+
+@end
+
+
+@implementation ParallelConverter
+
++ (Class) jobClass
+{
+    return [ConversionJob class];
+}
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        statusLock = [NSLock new];
+        trackName = nil;
+        allJobs = nil;
+        workersLock = nil;
+        convParameters = nil;
+        convStatus.processStatus = isStopped;
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    RELEASE(statusLock);
+    RELEASE(trackName);
+    RELEASE(allJobs);
+    RELEASE(convParameters);
+    [super dealloc];
+}
+
+- (BOOL) runJob: (ConversionJob *) job
+{
+    [self subclassResponsibility: _cmd];
+    return NO;
+}
+
+- (void) cancelJob: (ConversionJob *) job
+{
+    job->cancelled = YES;
+}
+
+- (double) progressOfJob: (ConversionJob *) job
+{
+    return 0.;
+}
+
+- (double) speedOfJob: (ConversionJob *) job
+{
+    return 0.;
+}
+
+- (void) finishJob: (ConversionJob *) job
+{
+}
+
+- (void) prepareJobs
+{
+}
+
+- (void) sendOutputString: (NSString *) outString
+{
+    logToolOutput(outString);
+}
+
+//
+// BurnTool methods
+//
+
+- (NSString *) name
+{
+    [self subclassResponsibility: _cmd];
+    return nil;
+}
+
+- (id<PreferencesModule>) preferences
+{
+    return nil;
+}
+
+- (id<PreferencesModule>) parameters
+{
+    return nil;
+}
+
+- (void) cleanUp
+{
+    /*
+     * The converted files belong to the session.
+     */
+}
+
+/*
+ * Each subclass keeps its own instance.
+ */
++ (id) singleInstance
+{
+    return nil;
+}
+
+/**
+ * Combines the state of all running jobs. The overall progress
+ * is weighted by the tracks' lengths, the track progress is the
+ * mean of the tracks being converted right now. The jobs run in
+ * parallel, so their speeds add up.
+ */
+- (ToolStatus) getStatus
+{
+    ToolStatus status;
+    int i, count, active = 0;
+    double frames = 0., trackSum = 0., speed = 0.;
+    ConversionJob *first = nil;
+
+    [statusLock lock];
+    count = [allJobs count];
+    for (i = 0; i < count; i++) {
+        ConversionJob *job = [allJobs objectAtIndex: i];
+        double progress;
+
+        if (!job->running) {
+            continue;
+        }
+        if (nil == first) {
+            first = job;
+            convStatus.trackNumber = i + 1;
+        }
+        active++;
+        progress = MIN(100., [self progressOfJob: job]);
+        trackSum += progress;
+        frames += job->duration * progress / 100.;
+        speed += [self speedOfJob: job];
+    }
+
+    if (active > 1) {
+        ASSIGN(trackName, ([NSString stringWithFormat: _(@"ParallelConverter.moreTracks"),
+                                [first->track description], active - 1]));
+    } else if (nil != first) {
+        ASSIGN(trackName, [first->track description]);
+    }
+    convStatus.trackName = trackName;
+    convStatus.trackProgress = (active > 0) ? trackSum / active : 0.;
+    convStatus.speed = speed;
+    if (totalFrames > 0) {
+        convStatus.entireProgress = (finishedFrames + frames) * 100. / totalFrames;
+    } else {
+        convStatus.entireProgress = 0.;
+    }
+    status = convStatus;
+    [statusLock unlock];
+
+    return status;
+}
+
+- (BOOL) stop: (BOOL) immediately
+{
+    BOOL converting;
+
+    /*
+     * Test and set the status at once, so that a job started
+     * meanwhile sees the cancelled state.
+     */
+    [statusLock lock];
+    converting = (convStatus.processStatus == isConverting);
+    if (converting) {
+        convStatus.processStatus = isCancelled;
+    }
+    [statusLock unlock];
+
+    if (converting) {
+        [self sendOutputString: _(@"ParallelConverter.terminating")];
+        [self cancelJobs];
+    }
+    return YES;
+}
+
+//
+// AudioConverter methods
+//
+
+- (BOOL) isCDGrabber
+{
+    return NO;
+}
+
+- (NSArray *) fileTypes
+{
+    [self subclassResponsibility: _cmd];
+    return nil;
+}
+
+- (long) duration: (NSString *) fileName
+{
+    [self subclassResponsibility: _cmd];
+    return 0;
+}
+
+/*
+ * Each file is examined on its own, so several of them can be
+ * probed at once.
+ */
+- (NSArray *) durations: (NSArray *) fileNames
+{
+    return probeDurations(self, fileNames);
+}
+
+- (unsigned) size: (NSString *) fileName
+{
+    return framesToAudioSize([self duration: fileName]);
+}
+
+- (BOOL) convertTracks: (NSArray *) tracks
+        withParameters: (NSDictionary *) parameters
+{
+    BOOL ret;
+    int i, workers;
+    NSMutableSet *outFiles;
+    NSDictionary *sesDefaults = [parameters objectForKey: @"SessionParameters"];
+    Class jobClass = [[self class] jobClass];
+
+    /*
+     * Create one job per track. Tracks from different directories
+     * may share the same name, but the jobs must not share an output
+     * file, as they run concurrently.
+     */
+    ASSIGN(convParameters, parameters);
+
+    outFiles = [NSMutableSet set];
+    [statusLock lock];
+    ASSIGN(allJobs, [NSMutableArray arrayWithCapacity: [tracks count]]);
+    totalFrames = 0;
+    finishedFrames = 0;
+    nextJob = 0;
+    for (i = 0; i < [tracks count]; i++) {
+        Track *track = [tracks objectAtIndex: i];
+        ConversionJob *job;
+        NSString *fileName = [self makeOutfileNameForTrack: [track source]
+                                                   tempDir: [sesDefaults objectForKey: @"TempDirectory"]];
+        int n = 1;
+
+        while ([outFiles containsObject: fileName]) {
+            fileName = [NSString stringWithFormat: @"%@-%d.wav",
+                            [fileName stringByDeletingPathExtension], n++];
+        }
+        [outFiles addObject: fileName];
+
+        job = [[jobClass alloc] initWithTrack: track outFile: fileName];
+        totalFrames += job->duration;
+        [allJobs addObject: job];
+        RELEASE(job);
+    }
+
+    /*
+     * Start the longest tracks first. Otherwise a long track picked up
+     * last keeps a single worker busy while the others are idle.
+     */
+    [allJobs sortUsingSelector: @selector(compareDuration:)];
+    [self prepareJobs];
+
+    convStatus.entireProgress = 0;
+    convStatus.trackProgress = 0;
+    convStatus.speed = 0;
+    convStatus.processStatus = isConverting;
+    [statusLock unlock];
+
+    workers = MIN(numberOfJobs(parameters), (int)[allJobs count]);
+    if (workers < 1) {
+        workers = 1;
+    }
+    [self sendOutputString: [NSString stringWithFormat: _(@"ParallelConverter.parallelJobs"),
+                                [allJobs count], workers]];
+
+    /*
+     * The calling thread is one of the workers. The lock's condition
+     * counts the workers still running.
+     */
+    workersLock = [[NSConditionLock alloc] initWithCondition: workers];
+    for (i = 1; i < workers; i++) {
+        [NSThread detachNewThreadSelector: @selector(workerThread:)
+                                 toTarget: self
+                               withObject: parameters];
+    }
+
+    [self runJobs];
+    [workersLock lock];
+    [workersLock unlockWithCondition: [workersLock condition] - 1];
+
+    [workersLock lockWhenCondition: 0];
+    [workersLock unlock];
+    DESTROY(workersLock);
+
+    [statusLock lock];
+    ret = (convStatus.processStatus != isCancelled);
+    if (convStatus.processStatus == isConverting) {
+        convStatus.processStatus = isStopped;
+    }
+    DESTROY(allJobs);
+    [statusLock unlock];
+
+    return ret;
+}
+
+@end
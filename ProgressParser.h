@@ -0,0 +1,76 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ProgressParser.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef PROGRESSPARSER_H_INC
+#define PROGRESSPARSER_H_INC
+
+#include <Foundation/Foundation.h>
+
+/*
+ * The progress parsers read one line of a tool's output as it comes
+ * from ToolProcess, i.e. as bytes without the line end, and tell what
+ * kind of progress information the line carries. They neither copy the
+ * line nor create any objects, so that the frequent progress lines
+ * cost next to nothing.
+ */
+
+typedef enum {
+    ProgressNone,               /* no progress information */
+    ProgressNoMedium,           /* cdrecord, cdrdao: there is no usable medium */
+    ProgressTotalSize,          /* cdrecord: total = size of the session in MB */
+    ProgressOperationStarts,    /* cdrecord: writing is about to begin */
+    ProgressStartingWrite,      /* cdrdao: writing is about to begin */
+    ProgressLeadIn,             /* cdrdao: writing the lead-in */
+    ProgressNewTrack,           /* cdrecord, cdrdao: current = the track, if known */
+    ProgressWritten,            /* cdrecord, cdrdao: current of total MB written,
+                                   value = buffer level in percent */
+    ProgressFixating,           /* cdrecord, cdrdao: writing the lead-out */
+    ProgressFailed,             /* cdrdao: something failed */
+    ProgressPercent,            /* mkisofs: value = percentage done */
+    ProgressFirstSector,        /* cdparanoia: current = first sector of the track */
+    ProgressLastSector,         /* cdparanoia: current = last sector of the track */
+    ProgressTocEntry,           /* cdparanoia -Q: current = track, total = first sector,
+                                   value = length in sectors */
+    ProgressDuration,           /* ffmpeg: value = length of the input in seconds */
+    ProgressTime,               /* ffmpeg: value = seconds converted so far */
+    ProgressReport              /* ffmpeg: any other line of the -progress output */
+} ProgressEventType;
+
+typedef struct {
+    ProgressEventType type;
+    long current;
+    long total;
+    double value;
+} ProgressEvent;
+
+/*
+ * Each function fills event and returns its type. If the line does
+ * not contain any progress information, the type is ProgressNone.
+ */
+ProgressEventType parseCDrecordLine(const char *line, unsigned length, ProgressEvent *event);
+ProgressEventType parseCdrdaoLine(const char *line, unsigned length, ProgressEvent *event);
+ProgressEventType parseMkIsoFsLine(const char *line, unsigned length, ProgressEvent *event);
+ProgressEventType parseCDparanoiaLine(const char *line, unsigned length, ProgressEvent *event);
+ProgressEventType parseFFmpegLine(const char *line, unsigned length, ProgressEvent *event);
+
+#endif
@@ -0,0 +1,406 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ProgressParser.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <string.h>
+
+#include "ProgressParser.h"
+
+/*
+ * The lines are not terminated by a 0 byte. Hence, all helpers
+ * take the end of the line and never read beyond it.
+ */
+
+#define TOKEN(s) s, (sizeof(s) - 1)
+
+static const char *findToken(const char *p, const char *end,
+                             const char *token, size_t tokenLength)
+{
+    while ((size_t)(end - p) >= tokenLength) {
+        p = memchr(p, token[0], (end - p) - tokenLength + 1);
+        if (NULL == p) {
+            return NULL;
+        }
+        if (memcmp(p, token, tokenLength) == 0) {
+            return p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+static BOOL hasPrefix(const char *p, const char *end,
+                      const char *token, size_t tokenLength)
+{
+    return ((size_t)(end - p) >= tokenLength)
+                && (memcmp(p, token, tokenLength) == 0);
+}
+
+static const char *skipSpaces(const char *p, const char *end)
+{
+    while ((p < end) && ((*p == ' ') || (*p == '\t'))) {
+        p++;
+    }
+    return p;
+}
+
+static inline BOOL isDigit(char c)
+{
+    return (c >= '0') && (c <= '9');
+}
+
+/*
+ * Reads a decimal number after optional blanks. Returns the position
+ * behind the number or NULL if there is none.
+ */
+static const char *scanLong(const char *p, const char *end, long *value)
+{
+    const char *start;
+    long v = 0;
+
+    p = skipSpaces(p, end);
+    start = p;
+    while ((p < end) && isDigit(*p)) {
+        v = v * 10 + (*p - '0');
+        p++;
+    }
+    if (p == start) {
+        return NULL;
+    }
+    *value = v;
+    return p;
+}
+
+static const char *scanDouble(const char *p, const char *end, double *value)
+{
+    long integer;
+    double fraction = 0.;
+    double scale = 0.1;
+
+    p = scanLong(p, end, &integer);
+    if (NULL == p) {
+        return NULL;
+    }
+    if ((p < end) && (*p == '.')) {
+        for (p++; (p < end) && isDigit(*p); p++) {
+            fraction += (*p - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    *value = integer + fraction;
+    return p;
+}
+
+/*
+ * Reads a time in the form hh:mm:ss.xx and returns it in seconds.
+ */
+static const char *scanTime(const char *p, const char *end, double *seconds)
+{
+    long hours, minutes;
+    double secs;
+
+    p = scanLong(p, end, &hours);
+    if ((NULL == p) || (p >= end) || (*p != ':')) {
+        return NULL;
+    }
+    p = scanLong(p + 1, end, &minutes);
+    if ((NULL == p) || (p >= end) || (*p != ':')) {
+        return NULL;
+    }
+    p = scanDouble(p + 1, end, &secs);
+    if (NULL == p) {
+        return NULL;
+    }
+    *seconds = hours * 3600. + minutes * 60. + secs;
+    return p;
+}
+
+static ProgressEventType setEvent(ProgressEvent *event, ProgressEventType type)
+{
+    event->type = type;
+    return type;
+}
+
+
+/*
+ * cdrecord writes e.g.
+ *   Total size:      635 MB (62:59.61) = 283471 sectors
+ *   Track 01:   12 of  635 MB written (fifo 100%) [buf  99%]  16.0x.
+ */
+ProgressEventType parseCDrecordLine(const char *line, unsigned length, ProgressEvent *event)
+{
+    const char *end = line + length;
+    const char *p;
+
+    event->current = 0;
+    event->total = 0;
+    event->value = 0.;
+
+    p = findToken(line, end, TOKEN("MB written (fifo"));
+    if (NULL != p) {
+        const char *of = findToken(line, p, TOKEN(" of "));
+        const char *digits;
+        const char *q;
+
+        if (NULL == of) {
+            return setEvent(event, ProgressNone);
+        }
+        // The MB written so far stand right in front of " of ".
+        q = of;
+        while ((q > line) && (q[-1] == ' ')) {
+            q--;
+        }
+        digits = q;
+        while ((digits > line) && isDigit(digits[-1])) {
+            digits--;
+        }
+        if ((digits == q)
+                || (NULL == scanLong(digits, q, &event->current))
+                || (NULL == scanLong(of + 4, p, &event->total))) {
+            return setEvent(event, ProgressNone);
+        }
+
+        // If cdrecord does not report the buffer level, we simply assume 100%.
+        q = findToken(p, end, TOKEN("[buf"));
+        if ((NULL == q) || (NULL == scanDouble(q + 4, end, &event->value))) {
+            event->value = 100.;
+        }
+        return setEvent(event, ProgressWritten);
+    }
+    if (NULL != findToken(line, end, TOKEN("Starting new track"))) {
+        return setEvent(event, ProgressNewTrack);
+    }
+    if (NULL != findToken(line, end, TOKEN("Fixating"))) {
+        return setEvent(event, ProgressFixating);
+    }
+    p = findToken(line, end, TOKEN("Total size:"));
+    if (NULL != p) {
+        if (NULL == scanLong(p + 11, end, &event->total)) {
+            return setEvent(event, ProgressNone);
+        }
+        return setEvent(event, ProgressTotalSize);
+    }
+    if (NULL != findToken(line, end, TOKEN("Operation starts."))) {
+        return setEvent(event, ProgressOperationStarts);
+    }
+    if (NULL != findToken(line, end, TOKEN("No disk / Wrong disk!"))) {
+        return setEvent(event, ProgressNoMedium);
+    }
+    return setEvent(event, ProgressNone);
+}
+
+/*
+ * cdrdao writes e.g.
+ *   Writing track 01 (mode AUDIO/AUDIO )...
+ *   Wrote 12 of 635 MB (Buffers 100%  99%).
+ */
+ProgressEventType parseCdrdaoLine(const char *line, unsigned length, ProgressEvent *event)
+{
+    const char *end = line + length;
+
+    event->current = 0;
+    event->total = 0;
+    event->value = 0.;
+
+    if (hasPrefix(line, end, TOKEN("Wrote"))) {
+        const char *p = scanLong(line + 5, end, &event->current);
+
+        p = skipSpaces(p ? p : end, end);
+        if (!hasPrefix(p, end, TOKEN("of"))
+                || (NULL == scanLong(p + 2, end, &event->total))) {
+            return setEvent(event, ProgressNone);
+        }
+        p = findToken(p, end, TOKEN("(Buffers"));
+        if (NULL != p) {
+            scanDouble(p + 8, end, &event->value);
+        }
+        return setEvent(event, ProgressWritten);
+    }
+    if (hasPrefix(line, end, TOKEN("Writing track"))) {
+        if (NULL == scanLong(line + 13, end, &event->current)) {
+            return setEvent(event, ProgressNone);
+        }
+        return setEvent(event, ProgressNewTrack);
+    }
+    if (NULL != findToken(line, end, TOKEN("Writing lead-in"))) {
+        return setEvent(event, ProgressLeadIn);
+    }
+    if (hasPrefix(line, end, TOKEN("Writing lead-out"))
+            || hasPrefix(line, end, TOKEN("Flushing cache"))) {
+        return setEvent(event, ProgressFixating);
+    }
+    if (NULL != findToken(line, end, TOKEN("Starting write"))) {
+        return setEvent(event, ProgressStartingWrite);
+    }
+    if (NULL != findToken(line, end, TOKEN("Unit not ready, giving up"))) {
+        return setEvent(event, ProgressNoMedium);
+    }
+    if (NULL != findToken(line, end, TOKEN("failed"))) {
+        return setEvent(event, ProgressFailed);
+    }
+    return setEvent(event, ProgressNone);
+}
+
+/*
+ * mkisofs writes e.g.
+ *    12.34% done, estimate finish Sat Oct 17 12:00:00 2026
+ */
+ProgressEventType parseMkIsoFsLine(const char *line, unsigned length, ProgressEvent *event)
+{
+    const char *end = line + length;
+    const char *p;
+
+    event->current = 0;
+    event->total = 0;
+    event->value = 0.;
+
+    p = findToken(line, end, TOKEN("done, estimate finish"));
+    if ((NULL == p) || (NULL == scanDouble(line, p, &event->value))) {
+        return setEvent(event, ProgressNone);
+    }
+    return setEvent(event, ProgressPercent);
+}
+
+/*
+ * cdparanoia -Q lists the tracks like this:
+ *     1.    16094 [03:34.44]        0 [00:00.00]    no   no  2
+ */
+static BOOL scanCDparanoiaToc(const char *p, const char *end, ProgressEvent *event)
+{
+    long track, sectors, begin;
+
+    p = scanLong(p, end, &track);
+    if ((NULL == p) || (p >= end) || (*p != '.')) {
+        return NO;
+    }
+    p = scanLong(p + 1, end, &sectors);
+    if (NULL == p) {
+        return NO;
+    }
+    p = skipSpaces(p, end);
+    if ((p >= end) || (*p != '[')) {
+        return NO;
+    }
+    p = memchr(p, ']', end - p);
+    if ((NULL == p) || (NULL == scanLong(p + 1, end, &begin))) {
+        return NO;
+    }
+    event->current = track;
+    event->total = begin;
+    event->value = sectors;
+    return YES;
+}
+
+/*
+ * cdparanoia writes e.g.
+ *   Ripping from sector       0 (track  1 [0:00.00])
+ *             to sector   16093 (track  1 [3:34.43])
+ */
+ProgressEventType parseCDparanoiaLine(const char *line, unsigned length, ProgressEvent *event)
+{
+    const char *end = line + length;
+    const char *p;
+
+    event->current = 0;
+    event->total = 0;
+    event->value = 0.;
+
+    if (scanCDparanoiaToc(line, end, event)) {
+        return setEvent(event, ProgressTocEntry);
+    }
+    p = findToken(line, end, TOKEN("from sector "));
+    if (NULL != p) {
+        if (NULL == scanLong(p + 12, end, &event->current)) {
+            return setEvent(event, ProgressNone);
+        }
+        return setEvent(event, ProgressFirstSector);
+    }
+    p = findToken(line, end, TOKEN("to sector "));
+    if (NULL != p) {
+        if (NULL == scanLong(p + 10, end, &event->current)) {
+            return setEvent(event, ProgressNone);
+        }
+        return setEvent(event, ProgressLastSector);
+    }
+    return setEvent(event, ProgressNone);
+}
+
+/*
+ * Tells whether the line is a key=value pair as written by
+ * ffmpeg -progress.
+ */
+static BOOL isReportLine(const char *p, const char *end)
+{
+    const char *key = p;
+
+    while ((p < end) && (((*p >= 'a') && (*p <= 'z'))
+                            || isDigit(*p) || (*p == '_'))) {
+        p++;
+    }
+    if ((p == key) || (p >= end) || (*p != '=')) {
+        return NO;
+    }
+    return (NULL == memchr(p, ' ', end - p));
+}
+
+/*
+ * ffmpeg/avconv write e.g.
+ *     Duration: 00:03:45.12, start: 0.000000, bitrate: 192 kb/s
+ *   size=    1024kB time=00:01:02.34 bitrate= 134.5kbits/s speed=41.2x
+ * With -progress, ffmpeg writes key=value pairs instead of the latter,
+ * among them
+ *   out_time_us=62340000
+ */
+ProgressEventType parseFFmpegLine(const char *line, unsigned length, ProgressEvent *event)
+{
+    const char *end = line + length;
+    const char *p;
+
+    event->current = 0;
+    event->total = 0;
+    event->value = 0.;
+
+    if (isReportLine(line, end)) {
+        if (hasPrefix(line, end, TOKEN("out_time_us="))
+                && (NULL != scanLong(line + 12, end, &event->current))) {
+            event->value = event->current / 1000000.;
+            return setEvent(event, ProgressTime);
+        }
+        return setEvent(event, ProgressReport);
+    }
+
+    p = findToken(line, end, TOKEN("time="));
+    if (NULL != p) {
+        if (NULL == scanTime(p + 5, end, &event->value)) {
+            return setEvent(event, ProgressNone);
+        }
+        return setEvent(event, ProgressTime);
+    }
+    p = findToken(line, end, TOKEN("Duration:"));
+    if (NULL != p) {
+        if (NULL == scanTime(p + 9, end, &event->value)) {
+            return setEvent(event, ProgressNone);
+        }
+        return setEvent(event, ProgressDuration);
+    }
+    return setEvent(event, ProgressNone);
+}
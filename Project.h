@@ -40,6 +40,7 @@
 	NSMutableArray *audioTracks;
 	NSMutableArray *dataTracks;
 	NSMutableDictionary *allCDs;
+	NSMutableDictionary *durationHints;
 
 	unsigned long	audioLength;
 	unsigned long	dataLength;
@@ -58,6 +59,10 @@
 - (NSString *) volumeId;
 - (void) setVolumeId: (NSString *)newVolId;
 
+- (NSArray *) audioTracks;
+- (NSArray *) dataTracks;
+- (NSDictionary *) cdList;
+
 - (unsigned long) totalLength;		// in frames !!
 - (int) numberOfTracks;
 
@@ -74,6 +79,7 @@
 					asType: (int)type
 				atPosition: (int)pos
 				recursive: (BOOL)rec;
+- (void) probeDurationsOfFiles: (NSArray *)files;
 - (void) deleteTrack: (Track *)track;
 - (void) deleteTrackOfType: (int)type atIndex: (int)index;
 
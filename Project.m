@@ -26,7 +26,10 @@
 #include "AppController.h"
 #include "Constants.h"
 #include "Functions.h"
+#include "MetadataCache.h"
+#include "PCMFile.h"
 #include "Project.h"
+#include "ProjectFile.h"
 #include "ProjectWindowController.h"
 #include "PreferencesWindowController.h"
 #include "BurnProgressController.h"
@@ -35,8 +38,6 @@
 
 
 
-static NSString *version = @"2.0";
-
 @interface Project (Private)
 
 - (BOOL) loadDataRepresentationForBurnprj: (NSData *)data;
@@ -62,6 +63,7 @@ static NSString *version = @"2.0";
 		audioTracks = [[NSMutableArray alloc] init];
 		dataTracks = [[NSMutableArray alloc] init];
 		allCDs = [[NSMutableDictionary alloc] init];
+		durationHints = [[NSMutableDictionary alloc] init];
 	}
 	return self;
 }
@@ -108,6 +110,7 @@ isoimgExit:
 	RELEASE(audioTracks);
 	RELEASE(dataTracks);
 	RELEASE(allCDs);
+	RELEASE(durationHints);
 
 	[super dealloc];
 }
@@ -129,6 +132,21 @@ isoimgExit:
 	[self updateChangeCount:NSChangeDone];
 }
 
+- (NSArray *) audioTracks
+{
+	return audioTracks;
+}
+
+- (NSArray *) dataTracks
+{
+	return dataTracks;
+}
+
+- (NSDictionary *) cdList
+{
+	return allCDs;
+}
+
 - (unsigned long) totalLength
 {
 	return (audioLength + dataLength);
@@ -228,18 +246,34 @@ isoimgExit:
 	BOOL ret = NO;
 	Track  *newTrack = nil;
 
+	NSNumber *duration = [durationHints objectForKey: file];
+
 	switch (type) {
 	case TrackTypeNone:
-		newTrack = [[Track alloc] initWithFile: file];
+		if ((nil != duration) && isAudioFile(file)) {
+			newTrack = [[Track alloc] initWithAudioFile: file
+											   duration: [duration longValue]];
+		} else {
+			newTrack = [[Track alloc] initWithFile: file];
+		}
 		break;
 	case TrackTypeAudio:
-		newTrack = [[Track alloc] initWithAudioFile: file];
+		if (nil != duration) {
+			newTrack = [[Track alloc] initWithAudioFile: file
+											   duration: [duration longValue]];
+		} else {
+			newTrack = [[Track alloc] initWithAudioFile: file];
+		}
 		break;
 	case TrackTypeData:
 		newTrack = [[Track alloc] initWithDataFile: file];
 		break;
 	}
 
+	if (nil != duration) {
+		[durationHints removeObjectForKey: file];
+	}
+
 	if (newTrack) {
 		ret = [self insertTrack: newTrack asType: type atPosition: pos];
 		AUTORELEASE(newTrack);
@@ -267,6 +301,7 @@ isoimgExit:
 		NSEnumerator *enumerator;
 		NSString *filePath;
 		NSArray *files;
+		NSMutableArray *paths;
 
 		if (rec == YES)
 			enumerator = [fileMan enumeratorAtPath: directory];
@@ -274,12 +309,7 @@ isoimgExit:
 			files = [fileMan directoryContentsAtPath: directory];
 			enumerator = [files objectEnumerator];
 		}
-		/*
-		 * Now walk the files/directories in the given directory. All files
-		 * will be inserted as a track in the order we find them.
-		 * We insert as many as possible and don't stop on errors.
-		 */
-		ret = NO;
+		paths = [NSMutableArray array];
 		while((filePath = [enumerator nextObject])) {
 			filePath = [directory stringByAppendingPathComponent: filePath];
 			[fileMan fileExistsAtPath: filePath isDirectory: &isDir];
@@ -288,9 +318,24 @@ isoimgExit:
 			 * but not the recursive directories themselves!
 			 */
 			if (!rec || !isDir)
-				if ([self insertTrackFromFile: filePath asType: type atPosition: pos])
-					// If at least on file can be inserted we report success
-					ret = YES;
+				[paths addObject: filePath];
+		}
+
+		if (type != TrackTypeData) {
+			[self probeDurationsOfFiles: paths];
+		}
+
+		/*
+		 * Now walk the files/directories in the given directory. All files
+		 * will be inserted as a track in the order we find them.
+		 * We insert as many as possible and don't stop on errors.
+		 */
+		ret = NO;
+		enumerator = [paths objectEnumerator];
+		while((filePath = [enumerator nextObject])) {
+			if ([self insertTrackFromFile: filePath asType: type atPosition: pos])
+				// If at least on file can be inserted we report success
+				ret = YES;
 		}
 	} else {
 		return NO;
@@ -299,6 +344,64 @@ isoimgExit:
 	return ret;
 }
 
+/**
+ * <p>Determines the durations of the audio files among
+ * <var>files</var> in advance. The files are handed to their audio
+ * converters in one go, which may examine them in parallel. The
+ * durations are used by the next -insertTrackFromFile:asType:atPosition:
+ * for each of the files. WAV, AIFF and AU files are skipped, as
+ * Track reads their headers itself, and so are the files found in
+ * the MetadataCache.</p>
+ */
+- (void) probeDurationsOfFiles: (NSArray *)files
+{
+	AppController *appController = [AppController appController];
+	MetadataCache *cache = [MetadataCache sharedCache];
+	NSMutableArray *converters = [NSMutableArray array];
+	NSMutableArray *groups = [NSMutableArray array];
+	NSEnumerator *enumerator = [files objectEnumerator];
+	NSString *file;
+	int i, count;
+
+	/*
+	 * Sort the files by the converter which handles them.
+	 */
+	while ((file = [enumerator nextObject])) {
+		NSString *ext = [[file pathExtension] lowercaseString];
+		id converter;
+		unsigned index;
+		long duration;
+
+		if (!isAudioFile(file) || [PCMFile handlesFileType: ext]) {
+			continue;
+		}
+		if ([cache getType: NULL duration: &duration size: NULL forFile: file]) {
+			[durationHints setObject: [NSNumber numberWithLong: duration] forKey: file];
+			continue;
+		}
+		converter = [appController audioConverterBundleForType: ext];
+		if (nil == converter) {
+			continue;
+		}
+		index = [converters indexOfObjectIdenticalTo: converter];
+		if (index == NSNotFound) {
+			[converters addObject: converter];
+			[groups addObject: [NSMutableArray arrayWithObject: file]];
+		} else {
+			[[groups objectAtIndex: index] addObject: file];
+		}
+	}
+
+	count = [converters count];
+	for (i = 0; i < count; i++) {
+		NSArray *group = [groups objectAtIndex: i];
+		NSArray *durations = [[converters objectAtIndex: i] durations: group];
+
+		[durationHints addEntriesFromDictionary:
+			[NSDictionary dictionaryWithObjects: durations forKeys: group]];
+	}
+}
+
 - (BOOL) addTrackFromFile: (NSString *)file
 {
 	return [self insertTrackFromFile: file asType: TrackTypeNone atPosition: [audioTracks count]];
@@ -425,15 +528,10 @@ isoimgExit:
 
 - (NSData *) dataRepresentationOfType: (NSString *)aType
 {
-	NSData *data;
-	NSArray *dataArray;
-
-	/* Remember: version must be the first data item!!! */
-	dataArray = [NSArray arrayWithObjects: version, volumeId, allCDs, audioTracks, dataTracks, nil];
-
-	data = [NSArchiver archivedDataWithRootObject: dataArray];
-
-	return data;
+	return [ProjectFile dataWithVolumeId: volumeId
+	                              cdList: allCDs
+	                         audioTracks: audioTracks
+	                          dataTracks: dataTracks];
 }
 
 - (BOOL) loadDataRepresentation: (NSData *)data ofType: (NSString *)aType 
@@ -441,7 +539,7 @@ isoimgExit:
 	if ([aType isEqualToString: @"burnprj"])
 		return [self loadDataRepresentationForBurnprj: data];
 
-	NSRunAlertPanel(APP_NAME, _(@"Project.unknownType"), nil, nil, nil);
+	logToConsole(MessageStatusError, _(@"Project.unknownType"));
 	return NO;
 }
 
@@ -517,30 +615,14 @@ isoimgExit:
 - (BOOL) loadDataRepresentationForBurnprj: (NSData *)data
 {
 	int i;
-	NSArray *dataArray;
-	NSString *fileVersion;
-
-	dataArray = [NSUnarchiver unarchiveObjectWithData: data];
-
-	/* Check version first, the decide what to do */
-	fileVersion =  [dataArray objectAtIndex: 0];
-
-	if ([fileVersion isEqual: version]) {
-		RELEASE(volumeId);
-		volumeId = [dataArray objectAtIndex: 1];
-		RETAIN(volumeId);
-
-		RELEASE(allCDs);
-		allCDs = [dataArray objectAtIndex: 2];
-		RETAIN(allCDs);
-
-		RELEASE(audioTracks);
-		audioTracks = [dataArray objectAtIndex: 3];
-		RETAIN(audioTracks);
+	ProjectFile *file = [[ProjectFile alloc] initWithData: data];
 
-		RELEASE(dataTracks);
-		dataTracks = [dataArray objectAtIndex: 4];
-		RETAIN(dataTracks);
+	if (file != nil) {
+		ASSIGN(volumeId, [file volumeId]);
+		ASSIGN(allCDs, [file cdList]);
+		ASSIGN(audioTracks, [file audioTracks]);
+		ASSIGN(dataTracks, [file dataTracks]);
+		RELEASE(file);
 
 		audioLength = dataLength = dataSize = 0;
 		for (i = [dataTracks count]-1; i >= 0; i--) {
@@ -557,7 +639,6 @@ isoimgExit:
 			[track setOwner: self];
 		}
 	} else {
-		NSRunAlertPanel(APP_NAME, _(@"Project.unknownVers"), nil, nil, nil);
 		return NO;
 	}
 
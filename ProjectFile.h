@@ -0,0 +1,65 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ProjectFile.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef PROJECTFILE_H_INC
+#define PROJECTFILE_H_INC
+
+#include <Foundation/Foundation.h>
+
+/**
+ * <p>ProjectFile reads and writes the contents of a .burnprj file.
+ * Project uses it to load and save its documents, burn-cli to load
+ * a project without a document.</p>
+ */
+@interface ProjectFile : NSObject
+{
+	NSString *volumeId;
+	NSMutableDictionary *cdList;
+	NSMutableArray *audioTracks;
+	NSMutableArray *dataTracks;
+}
+
+/**
+ * <p>Returns the contents of a .burnprj file for the given
+ * project data.</p>
+ */
++ (NSData *) dataWithVolumeId: (NSString *) volId
+                       cdList: (NSDictionary *) cds
+                  audioTracks: (NSArray *) aTracks
+                   dataTracks: (NSArray *) dTracks;
+
+/**
+ * <p>Reads the contents of a .burnprj file. Returns nil if
+ * <var>data</var> cannot be read or has an unknown version.</p>
+ */
+- (id) initWithData: (NSData *) data;
+
+- (NSString *) volumeId;
+- (NSMutableDictionary *) cdList;
+- (NSMutableArray *) audioTracks;
+- (NSMutableArray *) dataTracks;
+- (int) numberOfTracks;
+
+@end
+
+#endif
@@ -0,0 +1,116 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ProjectFile.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "ProjectFile.h"
+
+#include "Constants.h"
+#include "Functions.h"
+#include "Track.h"
+
+
+static NSString *version = @"2.0";
+
+@implementation ProjectFile
+
++ (NSData *) dataWithVolumeId: (NSString *) volId
+                       cdList: (NSDictionary *) cds
+                  audioTracks: (NSArray *) aTracks
+                   dataTracks: (NSArray *) dTracks
+{
+	NSArray *dataArray;
+
+	/* Remember: version must be the first data item!!! */
+	dataArray = [NSArray arrayWithObjects: version, volId, cds, aTracks, dTracks, nil];
+
+	return [NSArchiver archivedDataWithRootObject: dataArray];
+}
+
+- (id) initWithData: (NSData *) data
+{
+	NSArray *dataArray = nil;
+
+	self = [super init];
+	if (self == nil) {
+		return nil;
+	}
+
+	if (data != nil) {
+		NS_DURING
+			dataArray = [NSUnarchiver unarchiveObjectWithData: data];
+		NS_HANDLER
+			dataArray = nil;
+		NS_ENDHANDLER
+	}
+
+	/* Check version first, the decide what to do */
+	if (([dataArray count] < 5)
+			|| ![[dataArray objectAtIndex: 0] isEqual: version]) {
+		logToConsole(MessageStatusError, _(@"Project.unknownVers"));
+		DESTROY(self);
+		return nil;
+	}
+
+	volumeId = RETAIN([dataArray objectAtIndex: 1]);
+	cdList = RETAIN([dataArray objectAtIndex: 2]);
+	audioTracks = RETAIN([dataArray objectAtIndex: 3]);
+	dataTracks = RETAIN([dataArray objectAtIndex: 4]);
+
+	return self;
+}
+
+- (void) dealloc
+{
+	RELEASE(volumeId);
+	RELEASE(cdList);
+	RELEASE(audioTracks);
+	RELEASE(dataTracks);
+
+	[super dealloc];
+}
+
+- (NSString *) volumeId
+{
+	return volumeId;
+}
+
+- (NSMutableDictionary *) cdList
+{
+	return cdList;
+}
+
+- (NSMutableArray *) audioTracks
+{
+	return audioTracks;
+}
+
+- (NSMutableArray *) dataTracks
+{
+	return dataTracks;
+}
+
+- (int) numberOfTracks
+{
+	return ([audioTracks count] + [dataTracks count]);
+}
+
+@end
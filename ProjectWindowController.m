@@ -27,6 +27,7 @@
 #include "AppController.h"
 #include "Constants.h"
 #include "Functions.h"
+#include "MetadataCache.h"
 #include "Project.h"
 #include "Inspectors/InspectorsWin.h"
 #include "PreferencesWindowController.h"
@@ -381,6 +382,23 @@ static NSString *BlankCDButton = @"blankCdButton";
 
     id pool = [NSAutoreleasePool new];
 
+    /*
+     * Have the durations of all audio files determined at once.
+     * The contents of directories are taken care of by the project.
+     */
+    if (trackType != TrackTypeData) {
+        NSMutableArray *plainFiles = [NSMutableArray array];
+
+        for (i = 0; i < count; i++) {
+            BOOL isDir;
+            NSString *sourceFile = [fileNames objectAtIndex: i];
+            if ([fileMan fileExistsAtPath: sourceFile isDirectory: &isDir] && !isDir) {
+                [plainFiles addObject: sourceFile];
+            }
+        }
+        [[self document] probeDurationsOfFiles: plainFiles];
+    }
+
     for (i = count - 1; (i >= 0) && (YES == success); i--) {
         BOOL isDir;
         NSString *sourceFile = [fileNames objectAtIndex: i];
@@ -411,6 +429,7 @@ static NSString *BlankCDButton = @"blankCdButton";
             }
         }
     }
+    [[MetadataCache sharedCache] synchronize];
     [dict setObject: [NSNumber numberWithBool: success] forKey: @"returnValue"];
 
     [self performSelectorOnMainThread: @selector(wakeUpMainThreadRunloop:)
@@ -646,11 +665,6 @@ static NSString *BlankCDButton = @"blankCdButton";
     [paramsPanel release];
 
     if (burn) {
-        if (![[AppController appController] lockBurner]) {
-            NSBeep();
-            return;
-        }
-
         [[self document] createCD: isoOnly];
     }
 }
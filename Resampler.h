@@ -0,0 +1,142 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  Resampler.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef RESAMPLER_H_INC
+#define RESAMPLER_H_INC
+
+#include <stdint.h>
+
+#include <Foundation/Foundation.h>
+
+/* The sample rate of audio CDs, which Resampler converts to */
+#define RESAMPLE_OUTPUT_RATE 44100
+
+typedef enum {
+    ResampleQualityFast,
+    ResampleQualityGood,
+    ResampleQualityBest
+} ResampleQuality;
+
+/**
+ * <p>Resampler converts 16 bit stereo samples from another sample rate
+ * to 44100 Hz. It is a polyphase FIR filter: the ratio of the rates is
+ * reduced to <var>up</var>/<var>down</var>, e.g. 147/160 for 48000 Hz,
+ * and each output sample is computed with one of <var>up</var> sets of
+ * coefficients from the input samples around it. The coefficients are
+ * taken from a Kaiser windowed sinc, whose stop band starts at the lower
+ * one of the two Nyquist frequencies, so that nothing is aliased into
+ * the output.</p>
+ * <p>The quality selects the length of the filter and the attenuation
+ * of its stop band:</p>
+ * <deflist>
+ * <term>ResampleQualityFast</term>
+ * <desc>60 dB, pass band up to about 17 kHz</desc>
+ * <term>ResampleQualityGood</term>
+ * <desc>80 dB, pass band up to about 18.5 kHz</desc>
+ * <term>ResampleQualityBest</term>
+ * <desc>100 dB, pass band up to about 20 kHz</desc>
+ * </deflist>
+ * <p>The filter delay is compensated, thus the output is aligned with
+ * the input and the number of output frames follows exactly from the
+ * number of input frames. A Resampler keeps the state of one stream
+ * and must not be used by several threads at the same time.</p>
+ */
+@interface Resampler : NSObject
+{
+    unsigned inputRate;
+    unsigned up;
+    unsigned down;
+    unsigned taps;
+    float *filters;
+
+    /* The input samples not needed any longer are dropped from the
+       start of the history from time to time. */
+    float *history[2];
+    unsigned capacity;
+    unsigned filled;
+    unsigned offset;
+    unsigned phase;
+
+    unsigned long long inputFrames;
+    unsigned long long outputFrames;
+    BOOL flushed;
+}
+
+/**
+ * <p>Returns YES if samples at <var>rate</var> Hz can be converted.
+ * Supported are the rates between 8000 and 384000 Hz whose ratio to
+ * 44100 Hz can be reduced to a fraction with a numerator of at most
+ * 1024, which includes all common rates.</p>
+ */
++ (BOOL) canResampleFrom: (unsigned) rate;
+
+/**
+ * <p>Returns the quality set by the <em>ResampleQuality</em> entry of
+ * the SessionParameters in <var>parameters</var>, which may be
+ * <code>Fast</code>, <code>Good</code> or <code>Best</code>. The
+ * default is <code>Best</code>.</p>
+ */
++ (ResampleQuality) qualityForParameters: (NSDictionary *) parameters;
+
+/**
+ * <p>Returns nil if samples at <var>rate</var> Hz cannot be
+ * converted.</p>
+ */
+- (id) initWithInputRate: (unsigned) rate
+                 quality: (ResampleQuality) quality;
+
+- (unsigned) inputRate;
+
+/**
+ * <p>Returns the number of frames -resample:frames:into: writes at most
+ * for <var>count</var> input frames.</p>
+ */
+- (unsigned) maxOutputFrames: (unsigned) count;
+
+/**
+ * <p>Converts <var>count</var> interleaved stereo frames in native byte
+ * order from <var>in</var> and writes the frames that are complete to
+ * <var>out</var>, which must have room for -maxOutputFrames: frames.
+ * Some input is kept back until the samples following it are known.
+ * Returns the number of frames written.</p>
+ */
+- (unsigned) resample: (const int16_t *) in
+               frames: (unsigned) count
+                 into: (int16_t *) out;
+
+/**
+ * <p>Returns the number of frames -flush: writes at most.</p>
+ */
+- (unsigned) maxFlushFrames;
+
+/**
+ * <p>Writes the frames still kept back at the end of the stream to
+ * <var>out</var>. Returns the number of frames written. No more input
+ * may be passed afterwards.</p>
+ */
+- (unsigned) flush: (int16_t *) out;
+
+@end
+
+#endif
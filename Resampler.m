@@ -0,0 +1,398 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  Resampler.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Resampler.h"
+
+/* The number of input frames taken into the history at once */
+#define RESAMPLE_BLOCK 4096
+
+/* More sets of coefficients would take too much memory. */
+#define MAX_PHASES 1024
+
+#define MIN_INPUT_RATE 8000
+#define MAX_INPUT_RATE 384000
+
+/*
+ * The length of the filter and the attenuation of the stop band for
+ * each quality. The length is given in taps at 44100 Hz. For higher
+ * input rates, the filter is made longer by the ratio of the rates,
+ * so that the transition band keeps its width in Hz.
+ */
+static const struct {
+    unsigned taps;
+    double attenuation;
+} qualities[] = {
+    { 32, 60. },
+    { 64, 80. },
+    { 128, 100. }
+};
+
+
+static unsigned gcd(unsigned a, unsigned b)
+{
+    while (b != 0) {
+        unsigned t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/*
+ * The modified Bessel function of the first kind and order 0, which
+ * the Kaiser window is made of.
+ */
+static double besselI0(double x)
+{
+    double sum = 1., term = 1., y = x * x / 4.;
+    unsigned k;
+
+    for (k = 1; k < 100; k++) {
+        term *= y / ((double)k * k);
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+/*
+ * Computes the coefficients for the outputs which lie phase/up input
+ * samples after an input sample. coef[m] is applied to the input
+ * sample taps/2 - 1 - m samples before it. cutoff is relative to the
+ * input rate. Each set is scaled to a gain of 1 at 0 Hz, so that the
+ * phases do not modulate a DC offset.
+ */
+static void designPhase(float *coef, unsigned taps, unsigned phase,
+                        unsigned up, double cutoff, double beta)
+{
+    unsigned half = taps / 2, m;
+    double i0Beta = besselI0(beta);
+    double sum = 0.;
+
+    for (m = 0; m < taps; m++) {
+        double d = (double)m - (double)(half - 1) - (double)phase / up;
+        double x = d / half;
+        double window = besselI0(beta * sqrt(fmax(0., 1. - x * x))) / i0Beta;
+        double sinc = (d == 0.) ? 2. * cutoff : sin(2. * M_PI * cutoff * d) / (M_PI * d);
+
+        coef[m] = sinc * window;
+        sum += coef[m];
+    }
+    for (m = 0; m < taps; m++) {
+        coef[m] /= sum;
+    }
+}
+
+/*
+ * Four floats processed by one instruction. GCC and clang map this to
+ * SSE, NEON or AltiVec registers, or to plain code on other machines.
+ */
+typedef float v4sf __attribute__ ((vector_size (16)));
+
+static inline v4sf load4(const float *p)
+{
+    v4sf v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*
+ * Applies one set of coefficients to both channels. taps is a
+ * multiple of 8. Each channel has two accumulators, so that the
+ * additions do not have to wait for each other.
+ */
+static inline void convolve(const float *coef, const float *left, const float *right,
+                            unsigned taps, float *outLeft, float *outRight)
+{
+    v4sf l0 = { 0.f, 0.f, 0.f, 0.f }, l1 = l0, r0 = l0, r1 = l0;
+    unsigned i;
+
+    for (i = 0; i < taps; i += 8) {
+        v4sf c0 = load4(coef + i);
+        v4sf c1 = load4(coef + i + 4);
+
+        l0 += c0 * load4(left + i);
+        l1 += c1 * load4(left + i + 4);
+        r0 += c0 * load4(right + i);
+        r1 += c1 * load4(right + i + 4);
+    }
+    l0 += l1;
+    r0 += r1;
+    *outLeft = (l0[0] + l0[2]) + (l0[1] + l0[3]);
+    *outRight = (r0[0] + r0[2]) + (r0[1] + r0[3]);
+}
+
+static inline int16_t toSample(float value)
+{
+    if (value >= 32767.f) {
+        return 32767;
+    }
+    if (value <= -32768.f) {
+        return -32768;
+    }
+    return (int16_t)lrintf(value);
+}
+
+
+@interface Resampler (Private)
+- (unsigned) convertInto: (int16_t *) out
+                   limit: (unsigned long long) limit;
+- (void) compact;
+@end
+
+@implementation Resampler (Private)
+
+/*
+ * Computes all output frames whose input samples are in the history,
+ * but no more than limit frames in total.
+ */
+- (unsigned) convertInto: (int16_t *) out
+                   limit: (unsigned long long) limit
+{
+    unsigned n = 0;
+
+    while ((offset + taps <= filled) && (outputFrames < limit)) {
+        float left, right;
+
+        convolve(filters + phase * taps, history[0] + offset, history[1] + offset,
+                 taps, &left, &right);
+        out[2 * n] = toSample(left);
+        out[2 * n + 1] = toSample(right);
+        n++;
+        outputFrames++;
+
+        phase += down;
+        offset += phase / up;
+        phase %= up;
+    }
+    return n;
+}
+
+/*
+ * Drops the input samples before the next output's window. When
+ * going down, the window may start after the end of the history,
+ * then the next input samples are skipped, too.
+ */
+- (void) compact
+{
+    unsigned drop = MIN(offset, filled);
+
+    if (drop > 0) {
+        memmove(history[0], history[0] + drop, (filled - drop) * sizeof(float));
+        memmove(history[1], history[1] + drop, (filled - drop) * sizeof(float));
+        filled -= drop;
+        offset -= drop;
+    }
+}
+
+@end
+
+
+@implementation Resampler
+
++ (BOOL) canResampleFrom: (unsigned) rate
+{
+    if ((rate < MIN_INPUT_RATE) || (rate > MAX_INPUT_RATE)) {
+        return NO;
+    }
+    return (RESAMPLE_OUTPUT_RATE / gcd(rate, RESAMPLE_OUTPUT_RATE)) <= MAX_PHASES;
+}
+
++ (ResampleQuality) qualityForParameters: (NSDictionary *) parameters
+{
+    id quality = [[parameters objectForKey: @"SessionParameters"]
+                                objectForKey: @"ResampleQuality"];
+
+    if ([quality isKindOfClass: [NSString class]]) {
+        if ([quality caseInsensitiveCompare: @"Fast"] == NSOrderedSame) {
+            return ResampleQualityFast;
+        }
+        if ([quality caseInsensitiveCompare: @"Good"] == NSOrderedSame) {
+            return ResampleQualityGood;
+        }
+    }
+    return ResampleQualityBest;
+}
+
+- (id) initWithInputRate: (unsigned) rate
+                 quality: (ResampleQuality) quality
+{
+    unsigned divisor, p;
+    double attenuation, transition, cutoff, beta;
+
+    self = [super init];
+    if (nil == self) {
+        return nil;
+    }
+
+    filters = NULL;
+    history[0] = NULL;
+    history[1] = NULL;
+
+    if (![Resampler canResampleFrom: rate]) {
+        DESTROY(self);
+        return nil;
+    }
+
+    if ((quality < ResampleQualityFast) || (quality > ResampleQualityBest)) {
+        quality = ResampleQualityBest;
+    }
+
+    inputRate = rate;
+    divisor = gcd(rate, RESAMPLE_OUTPUT_RATE);
+    up = RESAMPLE_OUTPUT_RATE / divisor;
+    down = rate / divisor;
+
+    taps = qualities[quality].taps;
+    if (rate > RESAMPLE_OUTPUT_RATE) {
+        taps = (taps * rate + RESAMPLE_OUTPUT_RATE - 1) / RESAMPLE_OUTPUT_RATE;
+    }
+    taps = (taps + 7) & ~7;
+
+    /*
+     * Kaiser's formulas give the width of the transition band and the
+     * window's shape for the attenuation. The stop band starts at the
+     * lower Nyquist frequency. All frequencies are relative to the
+     * input rate.
+     */
+    attenuation = qualities[quality].attenuation;
+    transition = (attenuation - 7.95) / (14.36 * taps);
+    cutoff = (double)MIN(rate, RESAMPLE_OUTPUT_RATE) / (2. * rate) - transition / 2.;
+    beta = 0.1102 * (attenuation - 8.7);
+
+    capacity = taps + RESAMPLE_BLOCK;
+    filters = malloc((size_t)up * taps * sizeof(float));
+    history[0] = malloc(capacity * sizeof(float));
+    history[1] = malloc(capacity * sizeof(float));
+    if ((NULL == filters) || (NULL == history[0]) || (NULL == history[1])) {
+        DESTROY(self);
+        return nil;
+    }
+
+    for (p = 0; p < up; p++) {
+        designPhase(filters + p * taps, taps, p, up, cutoff, beta);
+    }
+
+    /*
+     * The first output is computed from the input samples around the
+     * first one. There is silence before it.
+     */
+    filled = taps / 2 - 1;
+    memset(history[0], 0, filled * sizeof(float));
+    memset(history[1], 0, filled * sizeof(float));
+    offset = 0;
+    phase = 0;
+    inputFrames = 0;
+    outputFrames = 0;
+    flushed = NO;
+
+    return self;
+}
+
+- (void) dealloc
+{
+    free(filters);
+    free(history[0]);
+    free(history[1]);
+    [super dealloc];
+}
+
+- (unsigned) inputRate
+{
+    return inputRate;
+}
+
+- (unsigned) maxOutputFrames: (unsigned) count
+{
+    return (unsigned)(((unsigned long long)count * up + down - 1) / down + 1);
+}
+
+- (unsigned) resample: (const int16_t *) in
+               frames: (unsigned) count
+                 into: (int16_t *) out
+{
+    unsigned done = 0, written = 0;
+
+    if (flushed) {
+        return 0;
+    }
+
+    while (done < count) {
+        unsigned n = MIN(count - done, capacity - filled);
+        float *left = history[0] + filled;
+        float *right = history[1] + filled;
+        const int16_t *src = in + 2 * done;
+        unsigned i;
+
+        for (i = 0; i < n; i++) {
+            left[i] = src[2 * i];
+            right[i] = src[2 * i + 1];
+        }
+        filled += n;
+        done += n;
+        inputFrames += n;
+
+        written += [self convertInto: out + 2 * written limit: ULLONG_MAX];
+        [self compact];
+    }
+
+    return written;
+}
+
+- (unsigned) maxFlushFrames
+{
+    return [self maxOutputFrames: taps / 2];
+}
+
+- (unsigned) flush: (int16_t *) out
+{
+    unsigned long long total;
+    unsigned half = taps / 2;
+
+    if (flushed) {
+        return 0;
+    }
+    flushed = YES;
+
+    /*
+     * The last outputs need the silence after the last input sample.
+     * Not more outputs are made than the input's duration gives.
+     */
+    total = (inputFrames * up + down - 1) / down;
+    memset(history[0] + filled, 0, half * sizeof(float));
+    memset(history[1] + filled, 0, half * sizeof(float));
+    filled += half;
+
+    return [self convertInto: out limit: total];
+}
+
+@end
@@ -0,0 +1,758 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  BurnCDTest.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <Foundation/Foundation.h>
+
+#include "BurnCDHelper.h"
+#include "CreateISOHelper.h"
+#include "Constants.h"
+#include "Functions.h"
+#include "CDrecordController.h"
+#include "MkIsoFsController.h"
+
+/*
+ * Runs BurnCDHelper with the CDrecord bundle's burner against the
+ * cdrecord stand-in in bin/, which "burns" into a file per drive.
+ *
+ * Usage: burn-cd-test [bin-directory]
+ *
+ * The image is burned to all three drives of the stand-in at once.
+ * Each drive must get a complete copy of its own, the progress of the
+ * entire CD must be the average of the drives' progress, and the
+ * session must succeed. Then one drive fails halfway: the session must
+ * fail, that drive must be shown as cancelled, and the others must
+ * still finish their copies.
+ *
+ * Then CreateISOHelper and BurnCDHelper burn on-the-fly, with the
+ * MkIsoFs bundle's image creator running the mkisofs stand-in. The
+ * image must arrive through the pipe as mkisofs wrote it. At last
+ * mkisofs fails halfway. The burner does not notice, as it is only
+ * told the image's size, so the session must fail because the image
+ * is incomplete.
+ *
+ * The program runs without Burn.app's user interface and bundles:
+ * TestSession takes the place of BurnSession and records what the
+ * helpers show, AppController only hands out the tools, and Track
+ * only knows its properties. The messages passed to logToConsole()
+ * are recorded, too.
+ */
+
+#define IMAGE_SIZE (1000 * 1000)
+
+/* A run takes about 2 s, the helpers poll every 0.2 and 0.4 s */
+#define RUN_TIMEOUT 30.
+
+static NSString *binDirectory = @"bin";
+static NSMutableArray *logMessages = nil;
+static NSLock *logLock = nil;
+
+
+/*
+ * The few parts of Burn.app the helper and the burner use.
+ */
+@interface AppController : NSObject
++ (AppController *) appController;
+- (id) currentWriterBundle;
+- (id) currentMkisofsBundle;
+@end
+
+@interface Track : NSObject
+{
+    NSDictionary *properties;
+}
+- (id) initWithProperties: (NSArray *) props forKeys: (NSArray *) keys;
+- (id) initWithDataFile: (NSString *) file;
+- (NSString *) source;
+- (NSString *) storage;
+- (unsigned) size;
+@end
+
+@interface CDrecordSettingsView : NSObject
++ (id) singleInstance;
+@end
+
+@interface CDrecordParametersView : NSObject
++ (id) singleInstance;
+@end
+
+@interface MkIsoFsSettingsView : NSObject
++ (id) singleInstance;
+@end
+
+@interface MkIsoFsParametersView : NSObject
++ (id) singleInstance;
+@end
+
+static CDrecordController *writer = nil;
+static MkIsoFsController *isoCreator = nil;
+
+@implementation AppController
+
++ (AppController *) appController
+{
+    static AppController *appController = nil;
+
+    if (nil == appController) {
+        appController = [AppController new];
+    }
+    return appController;
+}
+
+- (id) currentWriterBundle
+{
+    return writer;
+}
+
+- (id) currentMkisofsBundle
+{
+    return isoCreator;
+}
+
+@end
+
+@implementation Track
+
+- (id) initWithProperties: (NSArray *) props forKeys: (NSArray *) keys
+{
+    self = [super init];
+    if (self) {
+        properties = [[NSDictionary alloc] initWithObjects: props forKeys: keys];
+    }
+    return self;
+}
+
+- (id) initWithDataFile: (NSString *) file
+{
+    NSDictionary *attributes =
+        [[NSFileManager defaultManager] fileAttributesAtPath: file
+                                                traverseLink: YES];
+
+    return [self initWithProperties:
+                    [NSArray arrayWithObjects: @"data", file, file, [file lastPathComponent],
+                        [NSNumber numberWithUnsignedLongLong: [attributes fileSize]], nil]
+                            forKeys:
+                    [NSArray arrayWithObjects: @"type", @"source", @"storage",
+                        @"description", @"size", nil]];
+}
+
+- (void) dealloc
+{
+    RELEASE(properties);
+    [super dealloc];
+}
+
+- (NSString *) source
+{
+    return [properties objectForKey: @"source"];
+}
+
+- (NSString *) storage
+{
+    return [properties objectForKey: @"storage"];
+}
+
+- (unsigned) size
+{
+    return [[properties objectForKey: @"size"] unsignedIntValue];
+}
+
+- (NSString *) description
+{
+    return [properties objectForKey: @"description"];
+}
+
+@end
+
+@implementation CDrecordSettingsView
++ (id) singleInstance
+{
+    return nil;
+}
+@end
+
+@implementation CDrecordParametersView
++ (id) singleInstance
+{
+    return nil;
+}
+@end
+
+@implementation MkIsoFsSettingsView
++ (id) singleInstance
+{
+    return nil;
+}
+@end
+
+@implementation MkIsoFsParametersView
++ (id) singleInstance
+{
+    return nil;
+}
+@end
+
+NSString *which(NSString *name)
+{
+    if ([[NSFileManager defaultManager] isExecutableFileAtPath: name]) {
+        return name;
+    }
+    return NOT_FOUND;
+}
+
+BOOL checkProgram(NSString *name)
+{
+    return (nil != name) && ![which(name) isEqual: NOT_FOUND];
+}
+
+static void recordMessage(NSString *priority, NSString *theMessage)
+{
+    if ([priority isEqualToString: MessageStatusToolOutput]) {
+        return;
+    }
+    [logLock lock];
+    [logMessages addObject: [NSArray arrayWithObjects: priority, theMessage, nil]];
+    [logLock unlock];
+}
+
+
+/*
+ * Takes the place of BurnSession. It records the progress of each
+ * device and checks each time the entire progress is set while
+ * several burners run that it is the average of the devices' progress.
+ */
+@interface TestSession : NSObject
+{
+    NSArray *devices;
+    NSDictionary *parameters;
+    NSMutableDictionary *progress;
+    NSMutableDictionary *labels;
+    int averages;
+    int spreadAverages;
+    int wrongAverages;
+    BOOL finished[LastStage];
+    BOOL success[LastStage];
+}
+
+- (id) initWithDevices: (NSArray *) someDevices parameters: (NSDictionary *) someParameters;
+- (BOOL) isFinished: (enum BurnStage) aStage;
+- (BOOL) succeeded: (enum BurnStage) aStage;
+- (NSString *) labelForDevice: (NSString *) device;
+- (double) progressForDevice: (NSString *) device;
+- (int) averages;
+- (int) spreadAverages;
+- (int) wrongAverages;
+
+@end
+
+@implementation TestSession
+
+- (id) initWithDevices: (NSArray *) someDevices parameters: (NSDictionary *) someParameters
+{
+    self = [super init];
+    if (self) {
+        ASSIGN(devices, someDevices);
+        ASSIGN(parameters, someParameters);
+        progress = [NSMutableDictionary new];
+        labels = [NSMutableDictionary new];
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    RELEASE(devices);
+    RELEASE(parameters);
+    RELEASE(progress);
+    RELEASE(labels);
+    [super dealloc];
+}
+
+- (BOOL) isFinished: (enum BurnStage) aStage
+{
+    return finished[aStage];
+}
+
+- (BOOL) succeeded: (enum BurnStage) aStage
+{
+    return success[aStage];
+}
+
+- (NSString *) labelForDevice: (NSString *) device
+{
+    return [labels objectForKey: device];
+}
+
+- (double) progressForDevice: (NSString *) device
+{
+    return [[progress objectForKey: device] doubleValue];
+}
+
+- (int) averages
+{
+    return averages;
+}
+
+- (int) spreadAverages
+{
+    return spreadAverages;
+}
+
+- (int) wrongAverages
+{
+    return wrongAverages;
+}
+
+- (NSArray *) burnDevices
+{
+    return devices;
+}
+
+- (NSDictionary *) burnParameters
+{
+    return parameters;
+}
+
+- (void) setProgress: (double) value
+            andLabel: (NSString *) label
+           forDevice: (NSString *) device
+{
+    [progress setObject: [NSNumber numberWithDouble: value] forKey: device];
+    if (nil != label) {
+        [labels setObject: label forKey: device];
+    }
+}
+
+- (void) setEntireProgress: (double) value andLabel: (NSString *) label
+{
+    double sum = 0., min = 100., max = 0.;
+    int i;
+
+    if (([devices count] < 2)
+            || ![label isEqualToString: @"BurnCDHelper.CDTotal"]) {
+        return;
+    }
+    for (i = 0; i < [devices count]; i++) {
+        double p = [self progressForDevice: [devices objectAtIndex: i]];
+
+        sum += p;
+        min = MIN(min, p);
+        max = MAX(max, p);
+    }
+    averages++;
+    if (fabs(value - sum / [devices count]) > 1e-9) {
+        fprintf(stderr, "entire progress %g, but the devices average %g\n",
+                value, sum / [devices count]);
+        wrongAverages++;
+    }
+    if ((max > min) && (value > 0.) && (value < 100.)) {
+        spreadAverages++;
+    }
+}
+
+- (void) stage: (enum BurnStage) aStage finished: (BOOL) result
+{
+    finished[aStage] = YES;
+    success[aStage] = result;
+}
+
+- (BOOL) showsProgressOfStage: (enum BurnStage) aStage
+{
+    return YES;
+}
+
+- (BOOL) isoImageOnly
+{
+    return NO;
+}
+
+- (enum ExistingImageAction) actionForExistingImage: (NSString *) path
+{
+    return OverwriteImage;
+}
+
+- (void) showError: (NSString *) message
+{
+    fprintf(stderr, "%s\n", [message UTF8String]);
+}
+
+- (void) setTitle: (NSString *) title {}
+- (void) setBackgroundStatus: (NSString *) status {}
+- (void) setTrackProgress: (double) value andLabel: (NSString *) label {}
+- (void) hideTrackProgress: (BOOL) hide {}
+- (void) makeEntireProgressIndeterminate: (BOOL) ind {}
+- (void) setAbortEnabled: (BOOL) enabled {}
+- (void) setMiniwindowToTrack: (double) track Entire: (double) entire {}
+- (void) showDeviceProgress {}
+
+@end
+
+
+static BOOL writeImage(NSString *path)
+{
+    NSMutableData *data = [NSMutableData dataWithLength: IMAGE_SIZE];
+    unsigned char *bytes = [data mutableBytes];
+    unsigned i;
+
+    for (i = 0; i < IMAGE_SIZE; i++) {
+        bytes[i] = (unsigned char)((i * 7) ^ (i >> 11));
+    }
+    return [data writeToFile: path atomically: NO];
+}
+
+static int failure(const char *what, NSString *device)
+{
+    if (nil != device) {
+        fprintf(stderr, "%s: %s\n", [device UTF8String], what);
+    } else {
+        fprintf(stderr, "%s\n", what);
+    }
+    return 1;
+}
+
+static NSDictionary *sessionParameters(NSString *dir, NSString *device, BOOL onTheFly)
+{
+    NSString *cdrecord = [binDirectory stringByAppendingPathComponent: @"cdrecord"];
+    NSString *mkisofs = [binDirectory stringByAppendingPathComponent: @"mkisofs"];
+
+    return [NSDictionary dictionaryWithObjectsAndKeys:
+                [NSDictionary dictionaryWithObject: device forKey: BurnDevice],
+                    @"SelectedTools",
+                [NSDictionary dictionaryWithObject: cdrecord forKey: @"Program"],
+                    @"CDrecordParameters",
+                [NSDictionary dictionaryWithObject: mkisofs forKey: @"Program"],
+                    @"MkIsofsParameters",
+                [NSDictionary dictionaryWithObjectsAndKeys:
+                    [NSNumber numberWithBool: onTheFly], @"OnTheFly",
+                    dir, @"TempDirectory", nil],
+                    @"SessionParameters",
+                nil];
+}
+
+/*
+ * Runs the run loop, which drives the helpers' timers, until aStage
+ * has finished.
+ */
+static BOOL runUntilFinished(TestSession *session, enum BurnStage aStage)
+{
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow: RUN_TIMEOUT];
+
+    while (![session isFinished: aStage] && ([timeout timeIntervalSinceNow] > 0.)) {
+        [[NSRunLoop currentRunLoop] runMode: NSDefaultRunLoopMode
+                                 beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+    }
+    return [session isFinished: aStage];
+}
+
+static void clearLog(void)
+{
+    [logLock lock];
+    [logMessages removeAllObjects];
+    [logLock unlock];
+}
+
+/*
+ * Returns YES if an error starting with key, or any error if key is
+ * nil, has been logged.
+ */
+static BOOL errorLogged(NSString *key)
+{
+    BOOL logged = NO;
+    int i;
+
+    [logLock lock];
+    for (i = 0; i < [logMessages count]; i++) {
+        NSArray *message = [logMessages objectAtIndex: i];
+
+        if ([[message objectAtIndex: 0] isEqual: MessageStatusError]
+                && ((nil == key) || [[message objectAtIndex: 1] hasPrefix: key])) {
+            logged = YES;
+        }
+    }
+    [logLock unlock];
+
+    return logged;
+}
+
+/*
+ * Burns the image to all devices, with failedDevice failing halfway,
+ * and checks the result.
+ */
+static int burnToAllDevices(NSString *image, NSString *dir, NSArray *devices,
+                            NSString *failedDevice)
+{
+    NSFileManager *fileMan = [NSFileManager defaultManager];
+    NSData *imageData = [NSData dataWithContentsOfFile: image];
+    TestSession *session;
+    BurnCDHelper *helper;
+    BOOL failed;
+    int failures = 0;
+    int i;
+
+    if (nil != failedDevice) {
+        setenv("BURN_TEST_FAIL", [[writer idForDevice: failedDevice] UTF8String], 1);
+    } else {
+        unsetenv("BURN_TEST_FAIL");
+    }
+    clearLog();
+
+    session = AUTORELEASE([[TestSession alloc]
+                    initWithDevices: devices
+                         parameters: sessionParameters(dir, [devices objectAtIndex: 0], NO)]);
+    helper = AUTORELEASE([[BurnCDHelper alloc] initWithController: (BurnSession *)session]);
+
+    if ([helper start: image audioTracks: [NSArray array]] != Started) {
+        return failure("the helper did not start", nil);
+    }
+    if (!runUntilFinished(session, BurnCD)) {
+        return failure("the helper did not finish", nil);
+    }
+    [helper cleanUp: [session succeeded: BurnCD]];
+
+    if ([session succeeded: BurnCD] != (nil == failedDevice)) {
+        failures += failure([session succeeded: BurnCD] ? "the session succeeded"
+                                                        : "the session failed", nil);
+    }
+
+    for (i = 0; i < [devices count]; i++) {
+        NSString *device = [devices objectAtIndex: i];
+        NSString *copy = [dir stringByAppendingPathComponent:
+                            [NSString stringWithFormat: @"%@.out", [writer idForDevice: device]]];
+        NSString *label = [session labelForDevice: device];
+        BOOL same = [imageData isEqualToData: [NSData dataWithContentsOfFile: copy]];
+
+        if ([device isEqual: failedDevice]) {
+            if (![label isEqual: @"Common.cancelled"]) {
+                failures += failure("the failed device is not shown as cancelled", device);
+            }
+            if (same) {
+                failures += failure("the failed device has a complete copy", device);
+            }
+        } else {
+            if (![label isEqual: @"Common.finished"]
+                    || ([session progressForDevice: device] != 100.)) {
+                failures += failure("the device is not shown as finished", device);
+            }
+            if (!same) {
+                failures += failure("the copy differs from the image", device);
+            }
+        }
+        [fileMan removeFileAtPath: copy handler: nil];
+    }
+
+    if ([session averages] == 0) {
+        failures += failure("the entire progress was never shown", nil);
+    } else if ([session spreadAverages] == 0) {
+        failures += failure("the devices never showed different progress", nil);
+    }
+    if ([session wrongAverages] != 0) {
+        failures += failure("the entire progress is not the average", nil);
+    }
+
+    failed = errorLogged(@"BurnCDHelper.devicesFailed");
+    if (failed != (nil != failedDevice)) {
+        failures += failure(failed ? "a failure was reported"
+                                   : "the failure was not reported", nil);
+    }
+
+    printf("%s, %d devices%s%s: %s, %d progress updates\n",
+           [[image lastPathComponent] UTF8String], (int)[devices count],
+           failedDevice ? ", failing " : "",
+           failedDevice ? [failedDevice UTF8String] : "",
+           failures ? "FAILED" : "ok", [session averages]);
+    return failures;
+}
+
+/*
+ * Burns the files on-the-fly, with mkisofs failing halfway if
+ * failImage is set, and checks the result. The stand-in's image is
+ * the files' contents padded to full sectors.
+ */
+static int burnOnTheFly(NSArray *files, NSString *dir, NSString *device, BOOL failImage)
+{
+    NSFileManager *fileMan = [NSFileManager defaultManager];
+    NSMutableData *imageData = [NSMutableData data];
+    NSMutableArray *tracks = [NSMutableArray array];
+    NSString *copy = [dir stringByAppendingPathComponent:
+                        [NSString stringWithFormat: @"%@.out", [writer idForDevice: device]]];
+    TestSession *session;
+    CreateISOHelper *isoHelper;
+    BurnCDHelper *helper;
+    int failures = 0;
+    int i;
+
+    if (failImage) {
+        setenv("BURN_TEST_FAIL_IMAGE", "1", 1);
+    } else {
+        unsetenv("BURN_TEST_FAIL_IMAGE");
+    }
+    unsetenv("BURN_TEST_FAIL");
+    clearLog();
+
+    for (i = 0; i < [files count]; i++) {
+        NSString *file = [files objectAtIndex: i];
+
+        [tracks addObject: AUTORELEASE([[Track alloc] initWithDataFile: file])];
+        [imageData appendData: [NSData dataWithContentsOfFile: file]];
+    }
+    [imageData increaseLengthBy: (2048 - [imageData length] % 2048) % 2048];
+
+    session = AUTORELEASE([[TestSession alloc]
+                    initWithDevices: [NSArray arrayWithObject: device]
+                         parameters: sessionParameters(dir, device, YES)]);
+    isoHelper = AUTORELEASE([[CreateISOHelper alloc] initWithController: (BurnSession *)session]);
+    helper = AUTORELEASE([[BurnCDHelper alloc] initWithController: (BurnSession *)session]);
+
+    /*
+     * The image's size is determined first, then the image creator
+     * and the burner are hooked up by a pipe.
+     */
+    if ([isoHelper start: tracks volumeId: @"BURNTEST"] != Started) {
+        return failure("the image creator did not start", nil);
+    }
+    if (!runUntilFinished(session, CreateISO)) {
+        return failure("the image creator did not finish", nil);
+    }
+    if (![session succeeded: CreateISO] || ![isoHelper isOnTheFly]
+            || ([[isoHelper onTheFlyImage] size] != [imageData length])) {
+        return failure("the image's size was not determined", nil);
+    }
+
+    if ([helper startOnTheFly: isoHelper audioTracks: [NSArray array]] != Started) {
+        return failure("the helper did not start", nil);
+    }
+    if (!runUntilFinished(session, BurnCD)) {
+        return failure("the helper did not finish", nil);
+    }
+    [helper cleanUp: [session succeeded: BurnCD]];
+    [isoHelper cleanUp: [session succeeded: BurnCD]];
+
+    if (failImage) {
+        /*
+         * The burner read less than it was told, but succeeded.
+         * Only the image creator knows that the image is incomplete.
+         */
+        if ([writer getStatus].processStatus == isCancelled) {
+            failures += failure("the burner failed, not the image creator", nil);
+        }
+        if ([session succeeded: BurnCD]) {
+            failures += failure("the session succeeded with an incomplete image", nil);
+        }
+    } else {
+        if (![session succeeded: BurnCD]) {
+            failures += failure("the session failed", nil);
+        }
+        if (![imageData isEqualToData: [NSData dataWithContentsOfFile: copy]]) {
+            failures += failure("the burned image differs from mkisofs' image", device);
+        }
+        if (errorLogged(nil)) {
+            failures += failure("an error was reported", nil);
+        }
+    }
+    [fileMan removeFileAtPath: copy handler: nil];
+
+    printf("on-the-fly, %d files%s: %s\n", (int)[files count],
+           failImage ? ", mkisofs failing" : "", failures ? "FAILED" : "ok");
+    return failures;
+}
+
+int main(int argc, const char *argv[])
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    NSString *dir, *image, *cdrecord, *mkisofs;
+    NSArray *devices, *files;
+    int failures = 0;
+
+    if (argc > 1) {
+        binDirectory = [NSString stringWithUTF8String: argv[1]];
+    }
+    binDirectory = [binDirectory stringByStandardizingPath];
+    if (![binDirectory isAbsolutePath]) {
+        binDirectory = [[[NSFileManager defaultManager] currentDirectoryPath]
+                            stringByAppendingPathComponent: binDirectory];
+    }
+    cdrecord = [binDirectory stringByAppendingPathComponent: @"cdrecord"];
+    mkisofs = [binDirectory stringByAppendingPathComponent: @"mkisofs"];
+    if (!checkProgram(cdrecord) || !checkProgram(mkisofs)) {
+        fprintf(stderr, "Usage: %s [bin-directory]\n", argv[0]);
+        RELEASE(pool);
+        return 2;
+    }
+
+    logMessages = [NSMutableArray new];
+    logLock = [NSLock new];
+    setLogHandler(recordMessage);
+
+    dir = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                [NSString stringWithFormat: @"burn-cd-test-%d", getpid()]];
+    [[NSFileManager defaultManager] createDirectoryAtPath: dir attributes: nil];
+    setenv("BURN_TEST_DIR", [dir fileSystemRepresentation], 1);
+    image = [dir stringByAppendingPathComponent: @"image.iso"];
+    if (!writeImage(image)) {
+        fprintf(stderr, "cannot write %s\n", [image fileSystemRepresentation]);
+        RELEASE(pool);
+        return 1;
+    }
+    /*
+     * The on-the-fly image holds two files and does not fill its
+     * last sector.
+     */
+    files = [NSArray arrayWithObjects: image, cdrecord, nil];
+
+    /*
+     * The tools take their programs from the defaults when they
+     * are created.
+     */
+    [defaults setObject: [NSDictionary dictionaryWithObject: cdrecord forKey: @"Program"]
+                 forKey: @"CDrecordParameters"];
+    [defaults setObject: [NSDictionary dictionaryWithObject: mkisofs forKey: @"Program"]
+                 forKey: @"MkIsofsParameters"];
+    writer = [CDrecordController new];
+    isoCreator = [MkIsoFsController new];
+    devices = [[writer availableDrives] sortedArrayUsingSelector: @selector(compare:)];
+    if ([devices count] != 3) {
+        fprintf(stderr, "the stand-in's drives were not found\n");
+        failures++;
+    } else {
+        failures += burnToAllDevices(image, dir, devices, nil);
+        failures += burnToAllDevices(image, dir, devices, [devices objectAtIndex: 1]);
+        failures += burnOnTheFly(files, dir, [devices objectAtIndex: 0], NO);
+        failures += burnOnTheFly(files, dir, [devices objectAtIndex: 0], YES);
+    }
+
+    RELEASE(isoCreator);
+    RELEASE(writer);
+    [[NSFileManager defaultManager] removeFileAtPath: dir handler: nil];
+
+    RELEASE(pool);
+    if (failures > 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}
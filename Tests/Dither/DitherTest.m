@@ -0,0 +1,244 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  DitherTest.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "Dither.h"
+
+/*
+ * Checks that dither_pcm16() gives exactly the samples and the dither
+ * state audio_linear_dither(), the reference, gives for each sample.
+ * Stereo and mono blocks of several lengths are passed, with noise,
+ * full scale sines, clipped samples and silence, the state being
+ * carried from one block to the next.
+ *
+ * Then it measures the samples per second of dither_pcm16() and of the
+ * loop PlayBuffer used before, which called audio_linear_dither() for
+ * each sample and packed the results byte by byte.
+ */
+
+#define BENCHMARK_TIME 1.0
+
+typedef enum {
+    SignalNoise,
+    SignalSine,
+    SignalClipped,
+    SignalSilence,
+    SignalCount
+} Signal;
+
+static const char *signalNames[] = { "noise", "sine", "clipped", "silence" };
+static const unsigned lengths[] = { 1152, 576, 1, 17, 1151 };
+
+static uint32_t seed = 1;
+
+static uint32_t nextRandom(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed;
+}
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.;
+}
+
+static void fillBlock(struct mad_pcm *pcm, Signal signal, unsigned channels,
+                      unsigned length, unsigned block)
+{
+    unsigned ch, i;
+
+    pcm->samplerate = 44100;
+    pcm->channels = channels;
+    pcm->length = length;
+    for (ch = 0; ch < channels; ch++) {
+        for (i = 0; i < length; i++) {
+            mad_fixed_t sample = 0;
+
+            switch (signal) {
+            case SignalNoise:
+                sample = (mad_fixed_t)(nextRandom() % (2 * MAD_F_ONE)) - MAD_F_ONE;
+                break;
+            case SignalSine:
+                sample = (mad_fixed_t)(sin((block * length + i) * (ch + 1) * 0.0625)
+                                        * (MAD_F_ONE - 1));
+                break;
+            case SignalClipped:
+                // Up to twice full scale, as libmad may return.
+                sample = (mad_fixed_t)(nextRandom() % (4 * MAD_F_ONE)) - 2 * MAD_F_ONE;
+                break;
+            default:
+                break;
+            }
+            pcm->samples[ch][i] = sample;
+        }
+    }
+}
+
+/*
+ * The reference: each sample passes audio_linear_dither() with the
+ * state of its channel.
+ */
+static void referenceBlock(struct mad_pcm const *pcm, struct audio_dither dither[2],
+                           int16_t *out)
+{
+    unsigned i;
+
+    for (i = 0; i < pcm->length; i++) {
+        int16_t left = (int16_t)audio_linear_dither(16, pcm->samples[0][i], &dither[0]);
+
+        out[2*i] = left;
+        out[2*i+1] = (pcm->channels == 2)
+                        ? (int16_t)audio_linear_dither(16, pcm->samples[1][i], &dither[1])
+                        : left;
+    }
+}
+
+/*
+ * PlayBuffer -writeOutput:pcmData: before dither_pcm16(), for the
+ * benchmark.
+ */
+static void perSampleBlock(struct mad_pcm const *pcm, struct audio_dither *dither,
+                           unsigned char *ptr)
+{
+    int nsamples = pcm->length;
+    mad_fixed_t const *left_ch = pcm->samples[0], *right_ch = pcm->samples[1];
+    signed int sample;
+
+    while (nsamples--) {
+        sample = (signed int) audio_linear_dither(16, *left_ch++, dither);
+        *ptr++ = (unsigned char) (sample >> 0);
+        *ptr++ = (unsigned char) (sample >> 8);
+        if (pcm->channels == 2) {
+            sample = (signed int) audio_linear_dither(16, *right_ch++, dither);
+        }
+        *ptr++ = (unsigned char) (sample >> 0);
+        *ptr++ = (unsigned char) (sample >> 8);
+    }
+}
+
+static int checkSignal(Signal signal, unsigned channels)
+{
+    static struct mad_pcm pcm;
+    static int16_t expected[2 * 1152], actual[2 * 1152];
+    struct audio_dither refState[2], fastState[2];
+    unsigned block;
+
+    memset(refState, 0, sizeof(refState));
+    memset(fastState, 0, sizeof(fastState));
+
+    for (block = 0; block < 200; block++) {
+        unsigned length = lengths[block % (sizeof(lengths) / sizeof(lengths[0]))];
+        unsigned bytes;
+
+        fillBlock(&pcm, signal, channels, length, block);
+        referenceBlock(&pcm, refState, expected);
+        bytes = dither_pcm16(&pcm, fastState, (unsigned char *)actual);
+
+        if ((bytes != length * 4)
+                || (memcmp(expected, actual, length * 4) != 0)) {
+            fprintf(stderr, "%s, %u channels: samples of block %u differ\n",
+                    signalNames[signal], channels, block);
+            return 1;
+        }
+        if ((memcmp(&refState[0], &fastState[0], sizeof(refState[0])) != 0)
+                || ((channels == 2)
+                    && (memcmp(&refState[1], &fastState[1], sizeof(refState[1])) != 0))) {
+            fprintf(stderr, "%s, %u channels: dither state after block %u differs\n",
+                    signalNames[signal], channels, block);
+            return 1;
+        }
+    }
+    printf("%-8s %u channel%s  bit-exact\n", signalNames[signal], channels,
+           (channels == 2) ? "s" : " ");
+    return 0;
+}
+
+static void benchmark(unsigned channels)
+{
+    static struct mad_pcm pcm;
+    static unsigned char out[4 * 1152];
+    struct audio_dither dither[2];
+    double start, elapsed, fast, perSample;
+    unsigned long blocks;
+
+    fillBlock(&pcm, SignalNoise, channels, 1152, 0);
+
+    memset(dither, 0, sizeof(dither));
+    blocks = 0;
+    start = now();
+    do {
+        int i;
+
+        for (i = 0; i < 1000; i++) {
+            dither_pcm16(&pcm, dither, out);
+        }
+        blocks += 1000;
+        elapsed = now() - start;
+    } while (elapsed < BENCHMARK_TIME);
+    fast = blocks * 1152. * channels / elapsed;
+
+    memset(dither, 0, sizeof(dither));
+    blocks = 0;
+    start = now();
+    do {
+        int i;
+
+        for (i = 0; i < 1000; i++) {
+            perSampleBlock(&pcm, dither, out);
+        }
+        blocks += 1000;
+        elapsed = now() - start;
+    } while (elapsed < BENCHMARK_TIME);
+    perSample = blocks * 1152. * channels / elapsed;
+
+    printf("%u channel%s  dither_pcm16: %6.1f M samples/s  per sample: %6.1f M samples/s  %.2fx\n",
+           channels, (channels == 2) ? "s" : " ",
+           fast / 1e6, perSample / 1e6, fast / perSample);
+}
+
+int main(int argc, const char *argv[])
+{
+    int failures = 0;
+    Signal signal;
+
+    for (signal = 0; signal < SignalCount; signal++) {
+        failures += checkSignal(signal, 2);
+        failures += checkSignal(signal, 1);
+    }
+    if (failures > 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+    benchmark(2);
+    benchmark(1);
+    return 0;
+}
@@ -0,0 +1,684 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  LibParanoiaTest.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <Foundation/Foundation.h>
+
+#include "LibParanoiaController.h"
+#include "ParanoiaReader.h"
+#include "Functions.h"
+#include "PCMFile.h"
+
+/*
+ * Runs the grabber of the LibParanoia bundle against generated BIN/CUE
+ * images, which libcdio opens like a drive.
+ *
+ * - An audio CD is copied on-the-fly: -streamTracks:withParameters:
+ *   writes the tracks, in an order other than on the disc, into FIFOs.
+ *   The test reads them like cdrecord does with tsize=, one track
+ *   after the other. Each FIFO must hold exactly the sectors
+ *   -sectorsOfTracks:withParameters: returned, as big endian samples.
+ * - The burner stops reading halfway through the first track. Once the
+ *   grabber is stopped, streaming must fail instead of waiting for the
+ *   burner forever.
+ * - Two CDs are ripped at once by instances from -parallelGrabber, each
+ *   in a thread of its own, while a third one finds no CD. Each must
+ *   rip its own tracks into .wav files and report only those in its
+ *   status. Releasing such an instance must not clear the single
+ *   instance.
+ *
+ * Only the bundle's sources are built into the tool. Track is a stub
+ * which only knows its source and storage, and the log messages are
+ * dropped.
+ *
+ * Usage: lib-paranoia-test [directory]
+ *
+ * The images, FIFOs and .wav files are created in the temporary
+ * directory by default and removed afterwards.
+ */
+
+#define MAX_TRACKS 3
+
+/* The ring of the on-the-fly copy, in MB */
+#define COPY_BUFFER 1
+
+/* Seconds to wait for the grabber before giving up */
+#define JOB_TIMEOUT 30.
+#define READ_TIMEOUT 10000
+
+typedef struct {
+    int tracks;
+    long sectors[MAX_TRACKS];
+    long offsets[MAX_TRACKS];
+    double frequency;
+    NSString *cddbId;
+    NSString *bin;
+    NSString *cue;
+    NSData *data;
+} Image;
+
+
+/*
+ * The parts of Track the grabber uses.
+ */
+@interface Track : NSObject
+{
+    NSString *source;
+    NSString *storage;
+}
+- (id) initWithSource: (NSString *) aSource storage: (NSString *) aStorage;
+- (NSString *) source;
+- (NSString *) storage;
+- (void) setStorage: (NSString *) aStorage;
+- (BOOL) hasLoudness;
+- (double) loudness;
+- (double) peak;
+- (void) setLoudness: (double) loudness peak: (double) peak;
+@end
+
+@implementation Track
+
+- (id) initWithSource: (NSString *) aSource storage: (NSString *) aStorage
+{
+    self = [super init];
+    if (self) {
+        ASSIGN(source, aSource);
+        ASSIGN(storage, aStorage);
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    RELEASE(source);
+    RELEASE(storage);
+    [super dealloc];
+}
+
+- (NSString *) source
+{
+    return source;
+}
+
+- (NSString *) storage
+{
+    return storage;
+}
+
+- (void) setStorage: (NSString *) aStorage
+{
+    ASSIGN(storage, aStorage);
+}
+
+- (NSString *) description
+{
+    return source;
+}
+
+- (BOOL) hasLoudness
+{
+    return NO;
+}
+
+- (double) loudness
+{
+    return 0.;
+}
+
+- (double) peak
+{
+    return 0.;
+}
+
+- (void) setLoudness: (double) loudness peak: (double) peak
+{
+}
+
+@end
+
+
+/*
+ * Runs a grabber in a thread of its own, like BurnCDHelper does it.
+ */
+@interface GrabberJob : NSObject
+{
+@public
+    LibParanoiaController *grabber;
+    NSArray *tracks;
+    NSDictionary *parameters;
+    volatile BOOL done;
+    BOOL result;
+}
+- (void) stream: (id) anObject;
+- (void) convert: (id) anObject;
+@end
+
+@implementation GrabberJob
+
+- (void) dealloc
+{
+    RELEASE(grabber);
+    RELEASE(tracks);
+    RELEASE(parameters);
+    [super dealloc];
+}
+
+- (void) stream: (id) anObject
+{
+    id pool = [NSAutoreleasePool new];
+
+    result = [grabber streamTracks: tracks withParameters: parameters];
+    done = YES;
+
+    RELEASE(pool);
+    [NSThread exit];
+}
+
+- (void) convert: (id) anObject
+{
+    id pool = [NSAutoreleasePool new];
+
+    result = [grabber convertTracks: tracks withParameters: parameters];
+    done = YES;
+
+    RELEASE(pool);
+    [NSThread exit];
+}
+
+@end
+
+
+NSArray *probeDurations(id converter, NSArray *fileNames)
+{
+    return nil;
+}
+
+static void dropMessage(NSString *priority, NSString *theMessage)
+{
+}
+
+/*
+ * Writes the BIN file, with tones in little endian byte order, and the
+ * CUE sheet of image.
+ */
+static BOOL writeImage(Image *image)
+{
+    NSMutableString *sheet = [NSMutableString stringWithFormat:
+                                @"FILE \"%@\" BINARY\n", [image->bin lastPathComponent]];
+    NSMutableData *data = [NSMutableData data];
+    long sector = 0;
+    int t;
+
+    for (t = 0; t < image->tracks; t++) {
+        long frames = image->sectors[t] * CDIO_CD_FRAMESIZE_RAW / 4;
+        unsigned char *bytes;
+        long i;
+
+        image->offsets[t] = sector;
+        [sheet appendFormat: @"  TRACK %02d AUDIO\n"
+                             @"    INDEX 01 %02ld:%02ld:%02ld\n",
+                             t + 1, sector / (75 * 60), (sector / 75) % 60, sector % 75];
+
+        [data increaseLengthBy: frames * 4];
+        bytes = (unsigned char *)[data mutableBytes] + sector * CDIO_CD_FRAMESIZE_RAW;
+        for (i = 0; i < frames; i++) {
+            double phase = 2. * M_PI * image->frequency * (t + 1) * i / 44100.;
+            int16_t left = (int16_t)(8000. * sin(phase));
+            int16_t right = (int16_t)(6000. * sin(phase * 1.5));
+
+            bytes[4 * i] = (unsigned char)left;
+            bytes[4 * i + 1] = (unsigned char)(left >> 8);
+            bytes[4 * i + 2] = (unsigned char)right;
+            bytes[4 * i + 3] = (unsigned char)(right >> 8);
+        }
+        sector += image->sectors[t];
+    }
+
+    ASSIGN(image->data, data);
+    return [data writeToFile: image->bin atomically: NO]
+        && [sheet writeToFile: image->cue atomically: NO];
+}
+
+static NSDictionary *grabberParameters(Image *image, NSString *dir)
+{
+    return [NSDictionary dictionaryWithObjectsAndKeys:
+                image->cue, @"SourceDevice",
+                image->cddbId, @"CddbId",
+                [NSDictionary dictionary], @"CDparanoiaParameters",
+                [NSDictionary dictionaryWithObjectsAndKeys:
+                    [NSNumber numberWithInt: COPY_BUFFER], @"CopyBufferSize",
+                    dir, @"TempDirectory", nil],
+                    @"SessionParameters",
+                nil];
+}
+
+static Track *trackOfImage(Image *image, int index, NSString *storage)
+{
+    return AUTORELEASE([[Track alloc] initWithSource:
+                            [NSString stringWithFormat: @"%@/Track%02d", image->cddbId, index + 1]
+                                             storage: storage]);
+}
+
+/*
+ * Waits until the grabber has started, or failed to start.
+ */
+static void waitUntilConverting(GrabberJob *job)
+{
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow: JOB_TIMEOUT];
+
+    while (!job->done && ([job->grabber getStatus].processStatus != isConverting)
+            && ([timeout timeIntervalSinceNow] > 0.)) {
+        usleep(10000);
+    }
+}
+
+/*
+ * Waits until the job is done. A grabber which hangs is stopped, so
+ * that the test ends.
+ */
+static BOOL waitForJob(GrabberJob *job)
+{
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow: JOB_TIMEOUT];
+
+    while (!job->done && ([timeout timeIntervalSinceNow] > 0.)) {
+        usleep(10000);
+    }
+    if (!job->done) {
+        fprintf(stderr, "the grabber hangs\n");
+        [job->grabber stop: YES];
+        while (!job->done) {
+            usleep(10000);
+        }
+        return NO;
+    }
+    return YES;
+}
+
+/*
+ * Reads length bytes from the non-blocking FIFO fd, like cdrecord
+ * reads a track of a known size.
+ */
+static BOOL readFifo(int fd, NSMutableData *data, unsigned long length)
+{
+    unsigned char buffer[65536];
+
+    while ([data length] < length) {
+        struct pollfd pfd;
+        ssize_t n;
+
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, READ_TIMEOUT) == 0) {
+            fprintf(stderr, "no data after %lu bytes\n", (unsigned long)[data length]);
+            return NO;
+        }
+        n = read(fd, buffer, MIN(sizeof(buffer), length - [data length]));
+        if (n > 0) {
+            [data appendBytes: buffer length: n];
+        } else if (n == 0) {
+            fprintf(stderr, "end of the FIFO after %lu bytes\n", (unsigned long)[data length]);
+            return NO;
+        } else if ((errno != EAGAIN) && (errno != EINTR)) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+/*
+ * The samples in the FIFO are big endian, those of the image little
+ * endian.
+ */
+static BOOL sameSwappedSamples(NSData *read, const unsigned char *raw)
+{
+    const unsigned char *bytes = [read bytes];
+    unsigned long i;
+
+    for (i = 0; i + 1 < [read length]; i += 2) {
+        if ((bytes[i] != raw[i + 1]) || (bytes[i + 1] != raw[i])) {
+            fprintf(stderr, "sample %lu differs\n", i / 2);
+            return NO;
+        }
+    }
+    return YES;
+}
+
+/*
+ * Copies the tracks of image in the given order on-the-fly and reads
+ * them from the FIFOs. If stopHalfway is set, the reading stops
+ * halfway through the first track, like a burner which died.
+ */
+static int streamImage(Image *image, NSString *dir, const int *order, int count,
+                       BOOL stopHalfway, const char *name)
+{
+    LibParanoiaController *grabber = [LibParanoiaController singleInstance];
+    NSDictionary *parameters = grabberParameters(image, dir);
+    NSMutableArray *tracks = [NSMutableArray array];
+    NSArray *sectors;
+    GrabberJob *job;
+    int fds[MAX_TRACKS];
+    int i, failures = 0;
+
+    for (i = 0; i < count; i++) {
+        NSString *fifo = [dir stringByAppendingPathComponent:
+                            [NSString stringWithFormat: @"lib-paranoia-test-%d-%d.fifo", getpid(), i]];
+
+        unlink([fifo fileSystemRepresentation]);
+        if (mkfifo([fifo fileSystemRepresentation], 0600) != 0) {
+            fprintf(stderr, "%s: cannot create %s\n", name, [fifo fileSystemRepresentation]);
+            return 1;
+        }
+        [tracks addObject: trackOfImage(image, order[i], fifo)];
+        fds[i] = -1;
+    }
+
+    sectors = [grabber sectorsOfTracks: tracks withParameters: parameters];
+    for (i = 0; i < count; i++) {
+        if ((nil == sectors) || ([[sectors objectAtIndex: i] longValue] != image->sectors[order[i]])) {
+            fprintf(stderr, "%s: wrong length of track %d\n", name, order[i] + 1);
+            failures++;
+        }
+    }
+
+    job = AUTORELEASE([GrabberJob new]);
+    ASSIGN(job->grabber, grabber);
+    ASSIGN(job->tracks, tracks);
+    ASSIGN(job->parameters, parameters);
+    [NSThread detachNewThreadSelector: @selector(stream:)
+                             toTarget: job
+                           withObject: nil];
+    waitUntilConverting(job);
+
+    /*
+     * The grabber holds the FIFOs open until it is done, so a track
+     * ends after its size, not at the end of the FIFO.
+     */
+    for (i = 0; (i < count) && (failures == 0); i++) {
+        long t = order[i];
+        unsigned long length = image->sectors[t] * CDIO_CD_FRAMESIZE_RAW;
+        NSMutableData *data = [NSMutableData dataWithCapacity: length];
+
+        fds[i] = open([[[tracks objectAtIndex: i] storage] fileSystemRepresentation],
+                      O_RDONLY | O_NONBLOCK);
+        if (fds[i] < 0) {
+            fprintf(stderr, "%s: cannot open the FIFO of track %ld\n", name, t + 1);
+            failures++;
+            break;
+        }
+        if (stopHalfway) {
+            readFifo(fds[i], data, length / 2);
+            close(fds[i]);
+            fds[i] = -1;
+            [grabber stop: YES];
+            break;
+        }
+        if (!readFifo(fds[i], data, length)) {
+            fprintf(stderr, "%s: track %ld is too short\n", name, t + 1);
+            failures++;
+        } else if (!sameSwappedSamples(data, (const unsigned char *)[image->data bytes]
+                                                + image->offsets[t] * CDIO_CD_FRAMESIZE_RAW)) {
+            fprintf(stderr, "%s: track %ld differs\n", name, t + 1);
+            failures++;
+        }
+    }
+    if (failures > 0) {
+        [grabber stop: YES];
+    }
+
+    if (!waitForJob(job)) {
+        failures++;
+    } else if (stopHalfway) {
+        if (job->result || ([grabber getStatus].processStatus != isCancelled)) {
+            fprintf(stderr, "%s: streaming did not fail\n", name);
+            failures++;
+        }
+    } else if (!job->result || ([grabber getStatus].processStatus != isStopped)) {
+        fprintf(stderr, "%s: streaming failed\n", name);
+        failures++;
+    }
+
+    /*
+     * Now that the grabber has closed the FIFOs, they must be empty.
+     */
+    for (i = 0; i < count; i++) {
+        if (fds[i] >= 0) {
+            char c;
+
+            if ((failures == 0) && (read(fds[i], &c, 1) != 0)) {
+                fprintf(stderr, "%s: track %d is too long\n", name, order[i] + 1);
+                failures++;
+            }
+            close(fds[i]);
+        }
+        unlink([[[tracks objectAtIndex: i] storage] fileSystemRepresentation]);
+    }
+
+    printf("%-36s %s\n", name, failures ? "FAILED" : "ok");
+    return failures;
+}
+
+/*
+ * Compares a ripped .wav file, in native byte order, with the raw
+ * little endian bytes of its track.
+ */
+static BOOL sameWavSamples(NSString *wavPath, const unsigned char *raw, long sectors)
+{
+    PCMFile *wav = AUTORELEASE([[PCMFile alloc] initWithPath: wavPath]);
+    static int16_t samples[2 * PCM_READ_FRAMES];
+    unsigned long long frame = 0;
+
+    if ((nil == wav) || ([wav frames] != (unsigned long long)sectors * CDIO_CD_FRAMESIZE_RAW / 4)) {
+        fprintf(stderr, "%s has the wrong length\n", [wavPath fileSystemRepresentation]);
+        return NO;
+    }
+    for (;;) {
+        long n = [wav readFrames: PCM_READ_FRAMES into: samples];
+        long i;
+
+        if (n <= 0) {
+            return (n == 0);
+        }
+        for (i = 0; i < 2 * n; i++) {
+            const unsigned char *p = raw + 4 * frame + 2 * i;
+
+            if (samples[i] != (int16_t)(p[0] | (p[1] << 8))) {
+                fprintf(stderr, "%s differs at frame %llu\n",
+                        [wavPath fileSystemRepresentation], frame + i / 2);
+                return NO;
+            }
+        }
+        frame += n;
+    }
+}
+
+/*
+ * Rips all images at once, each with a grabber of its own, like
+ * ConvertAudioHelper does it for CDs in several drives. The image
+ * without a BIN file is a drive without the CD.
+ */
+static int ripInParallel(Image *images, int count, NSString *dir, const char *name)
+{
+    LibParanoiaController *single = [LibParanoiaController singleInstance];
+    NSMutableArray *jobs = [NSMutableArray array];
+    NSAutoreleasePool *arp;
+    int i, t, failures = 0;
+
+    for (i = 0; i < count; i++) {
+        GrabberJob *job = AUTORELEASE([GrabberJob new]);
+        NSMutableArray *tracks = [NSMutableArray array];
+
+        for (t = 0; t < images[i].tracks; t++) {
+            [tracks addObject: trackOfImage(&images[i], t, nil)];
+        }
+        ASSIGN(job->grabber, [single parallelGrabber]);
+        ASSIGN(job->tracks, tracks);
+        ASSIGN(job->parameters, grabberParameters(&images[i], dir));
+        [jobs addObject: job];
+    }
+    for (i = 0; i < count; i++) {
+        [NSThread detachNewThreadSelector: @selector(convert:)
+                                 toTarget: [jobs objectAtIndex: i]
+                               withObject: nil];
+    }
+
+    /*
+     * Each grabber may only report its own tracks.
+     */
+    for (;;) {
+        BOOL running = NO;
+
+        for (i = 0; i < count; i++) {
+            GrabberJob *job = [jobs objectAtIndex: i];
+            ToolStatus status;
+
+            if (job->done) {
+                continue;
+            }
+            running = YES;
+            status = [job->grabber getStatus];
+            if ((status.processStatus == isConverting) && (nil != status.trackName)
+                    && ![status.trackName hasPrefix: images[i].cddbId]) {
+                fprintf(stderr, "%s: the grabber of %s reports %s\n", name,
+                        [images[i].cddbId UTF8String], [status.trackName UTF8String]);
+                failures++;
+            }
+        }
+        if (!running || (failures > 0)) {
+            break;
+        }
+        usleep(1000);
+    }
+
+    for (i = 0; i < count; i++) {
+        GrabberJob *job = [jobs objectAtIndex: i];
+        BOOL hasCD = [[NSFileManager defaultManager] fileExistsAtPath: images[i].bin];
+
+        if (!waitForJob(job)) {
+            failures++;
+            continue;
+        }
+        if (job->result != hasCD) {
+            fprintf(stderr, "%s: ripping %s %s\n", name, [images[i].cddbId UTF8String],
+                    hasCD ? "failed" : "did not fail");
+            failures++;
+        }
+        if (!hasCD) {
+            continue;
+        }
+        if ([job->grabber getStatus].processStatus != isStopped) {
+            fprintf(stderr, "%s: the grabber of %s is not stopped\n", name,
+                    [images[i].cddbId UTF8String]);
+            failures++;
+        }
+        for (t = 0; t < images[i].tracks; t++) {
+            NSString *wav = [dir stringByAppendingPathComponent:
+                                [NSString stringWithFormat: @"%@_track%d.wav", images[i].cddbId, t + 1]];
+
+            if (![[[job->tracks objectAtIndex: t] storage] isEqual: wav]) {
+                fprintf(stderr, "%s: track %d of %s is stored in %s\n", name, t + 1,
+                        [images[i].cddbId UTF8String],
+                        [[[job->tracks objectAtIndex: t] storage] UTF8String]);
+                failures++;
+            } else if (!sameWavSamples(wav, (const unsigned char *)[images[i].data bytes]
+                                                + images[i].offsets[t] * CDIO_CD_FRAMESIZE_RAW,
+                                       images[i].sectors[t])) {
+                failures++;
+            }
+            unlink([wav fileSystemRepresentation]);
+        }
+    }
+
+    arp = [NSAutoreleasePool new];
+    [single parallelGrabber];
+    RELEASE(arp);
+    if ([LibParanoiaController singleInstance] != single) {
+        fprintf(stderr, "%s: a parallel grabber cleared the single instance\n", name);
+        failures++;
+    }
+
+    printf("%-36s %s\n", name, failures ? "FAILED" : "ok");
+    return failures;
+}
+
+int main(int argc, const char *argv[])
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSString *dir = NSTemporaryDirectory();
+    Image images[3] = {
+        { 3, { 200, 151, 76 }, { 0 }, 220., @"a0b1c2d3", nil, nil, nil },
+        { 2, { 120, 90 }, { 0 }, 330., @"e4f5a6b7", nil, nil, nil },
+        { 1, { 100 }, { 0 }, 440., @"c8d9e0f1", nil, nil, nil }
+    };
+    static const int discOrder[] = { 0, 1, 2 };
+    static const int otherOrder[] = { 1, 2, 0 };
+    int i, failures = 0;
+
+    if (argc > 1) {
+        dir = [NSString stringWithUTF8String: argv[1]];
+    }
+    setLogHandler(dropMessage);
+
+    for (i = 0; i < 3; i++) {
+        images[i].bin = [dir stringByAppendingPathComponent:
+                            [NSString stringWithFormat: @"lib-paranoia-test-%d-%d.bin", getpid(), i]];
+        images[i].cue = [[images[i].bin stringByDeletingPathExtension]
+                            stringByAppendingPathExtension: @"cue"];
+        if (!writeImage(&images[i])) {
+            fprintf(stderr, "cannot write %s\n", [images[i].bin fileSystemRepresentation]);
+            RELEASE(pool);
+            return 1;
+        }
+    }
+    /*
+     * Without its files, the last image is a drive without a CD.
+     */
+    unlink([images[2].bin fileSystemRepresentation]);
+    unlink([images[2].cue fileSystemRepresentation]);
+
+    failures += streamImage(&images[0], dir, otherOrder, 3, NO, "on-the-fly, tracks 2, 3, 1");
+    failures += streamImage(&images[0], dir, discOrder, 3, YES, "on-the-fly, burner stops");
+    failures += ripInParallel(images, 2, dir, "two CDs at once");
+    failures += ripInParallel(images, 3, dir, "two CDs at once, one missing");
+
+    for (i = 0; i < 3; i++) {
+        unlink([images[i].bin fileSystemRepresentation]);
+        unlink([images[i].cue fileSystemRepresentation]);
+        RELEASE(images[i].data);
+    }
+
+    RELEASE(pool);
+    if (failures > 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}
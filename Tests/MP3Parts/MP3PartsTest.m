@@ -0,0 +1,514 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  MP3PartsTest.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <Foundation/Foundation.h>
+
+#include "PlayBuffer.h"
+#include "MadFunctions.h"
+#include "PCMFile.h"
+
+/*
+ * Decodes an mp3 file once with the mad_decoder, as MP3ToWav does it
+ * for short tracks, and once in several parts at once with
+ * -decodeInParts:. The two WAV files must have the same number of
+ * frames and the same samples, apart from the dither noise: each part
+ * has its own dither state, so the least significant bits differ.
+ * A part decoded at the wrong position or with missing or extra
+ * frames makes the samples differ by far more than the dither.
+ *
+ * Usage: mp3-parts-test [file.mp3...] [parts...]
+ *
+ * Without a file, two generated files are decoded: one at 44100 Hz in
+ * stereo and one at 48000 Hz in mono, which tests the resampling of
+ * the parts as well. A part is at least 1000 mp3 frames (26 s at
+ * 44100 Hz) long, so a file of your own should be several minutes
+ * long. The default parts are 2, 3, 4 and 8.
+ */
+
+/* The largest difference the dither may cause, in LSB */
+#define MAX_DIFFERENCE 8
+
+/* The largest RMS of the difference, in LSB */
+#define MAX_RMS 2.
+
+/*
+ * The generated files are MPEG-1 Layer III at 64 kbit/s. Each granule
+ * has only a count1 region, coded with table B, so no Huffman tables
+ * are needed. The bursts need more bits than a frame holds and take
+ * them from the bit reservoir.
+ */
+#define FIXTURE_BITRATE 64000
+#define FIXTURE_BITRATE_INDEX 5
+#define GRANULE_LINES 576
+#define MAX_MAIN_DATA_BEGIN 511
+#define BURST_PERIOD 24
+#define BURST_FRAMES 3
+
+/* A generated file must decode to more than this peak, in LSB */
+#define MIN_PEAK (32 * MAX_DIFFERENCE)
+
+
+static void putBits(unsigned char *p, unsigned long *bit, unsigned value, int count)
+{
+    while (count-- > 0) {
+        if (value & (1u << count)) {
+            p[*bit >> 3] |= 0x80 >> (*bit & 7);
+        }
+        (*bit)++;
+    }
+}
+
+/*
+ * Fills the spectral lines of one granule of one channel with -1, 0
+ * or 1 and returns its global gain. Most frames are quiet, with few
+ * lines at low frequencies. Every BURST_PERIOD frames, BURST_FRAMES
+ * loud frames have lines over the whole spectrum.
+ */
+static unsigned makeGranule(signed char *lines, unsigned long frame, unsigned *random)
+{
+    int loud = (frame % BURST_PERIOD) < BURST_FRAMES;
+    unsigned width = loud ? GRANULE_LINES : 48 + 16 * (frame % 5);
+    unsigned density = loud ? 3 : 4;
+    unsigned i;
+
+    memset(lines, 0, GRANULE_LINES);
+    for (i = 0; i < width; i++) {
+        *random = *random * 1103515245 + 12345;
+        if ((*random >> 16) % density == 0) {
+            lines[i] = (*random & 0x80000000) ? -1 : 1;
+        }
+    }
+    return loud ? 180 : 190 + frame % 4;
+}
+
+static unsigned usedQuads(const signed char *lines, unsigned quads)
+{
+    while ((quads > 0) && !lines[4 * quads - 1] && !lines[4 * quads - 2]
+            && !lines[4 * quads - 3] && !lines[4 * quads - 4]) {
+        quads--;
+    }
+    return quads;
+}
+
+/*
+ * Writes frames mp3 frames to file, which must be zeroed and large
+ * enough, and returns the number of bytes written. The main data of
+ * the frames is packed as tightly as main_data_begin allows.
+ */
+static unsigned long writeMP3(unsigned char *file, unsigned sampleRate,
+                              unsigned channels, unsigned long frames)
+{
+    unsigned sideInfoSize = (channels == 1) ? 17 : 32;
+    unsigned rateIndex = (sampleRate == 48000) ? 1 : (sampleRate == 32000) ? 2 : 0;
+    unsigned long slotStart = 0, slotEnd, packed = 0, rest = 0, length = 0;
+    unsigned long *slotOffsets = malloc(frames * sizeof(unsigned long));
+    unsigned long *slotStarts = malloc(frames * sizeof(unsigned long));
+    static signed char lines[2][2][GRANULE_LINES];
+    static unsigned char mainData[2 * 2 * (GRANULE_LINES + GRANULE_LINES / 4 * 4) / 8];
+    unsigned gain[2][2], quads[2][2], part23[2][2];
+    unsigned random = 1;
+    unsigned long f;
+
+    if ((NULL == slotOffsets) || (NULL == slotStarts)) {
+        free(slotOffsets);
+        free(slotStarts);
+        return 0;
+    }
+
+    for (f = 0; f < frames; f++) {
+        unsigned char *frame = file + length;
+        unsigned long begin, bits, total, i, k;
+        unsigned frameSize = 144 * FIXTURE_BITRATE / sampleRate;
+        unsigned gr, ch, padding;
+
+        rest += 144 * FIXTURE_BITRATE % sampleRate;
+        padding = (rest >= sampleRate);
+        if (padding) {
+            rest -= sampleRate;
+            frameSize++;
+        }
+        frame[0] = 0xff;
+        frame[1] = 0xfb;        /* MPEG-1 Layer III, no CRC */
+        frame[2] = (FIXTURE_BITRATE_INDEX << 4) | (rateIndex << 2) | (padding << 1);
+        frame[3] = ((channels == 1) ? 0xc0 : 0x00) | 0x04;
+
+        slotOffsets[f] = length + 4 + sideInfoSize;
+        slotStarts[f] = slotStart;
+        slotEnd = slotStart + frameSize - 4 - sideInfoSize;
+
+        /*
+         * The main data starts right after the one of the frame
+         * before, but at most MAX_MAIN_DATA_BEGIN bytes before the
+         * frame's own slot, and must end with it.
+         */
+        begin = packed;
+        if (slotStart - begin > MAX_MAIN_DATA_BEGIN) {
+            begin = slotStart - MAX_MAIN_DATA_BEGIN;
+        }
+        for (gr = 0; gr < 2; gr++) {
+            for (ch = 0; ch < channels; ch++) {
+                gain[gr][ch] = makeGranule(lines[gr][ch], f, &random);
+                quads[gr][ch] = usedQuads(lines[gr][ch], GRANULE_LINES / 4);
+            }
+        }
+        for (;;) {
+            total = 0;
+            for (gr = 0; gr < 2; gr++) {
+                for (ch = 0; ch < channels; ch++) {
+                    part23[gr][ch] = 4 * quads[gr][ch];
+                    for (i = 0; i < 4 * quads[gr][ch]; i++) {
+                        part23[gr][ch] += (lines[gr][ch][i] != 0);
+                    }
+                    total += part23[gr][ch];
+                }
+            }
+            if (total <= (slotEnd - begin) * 8) {
+                break;
+            }
+            /* Too loud for the reservoir, drop the highest lines */
+            for (gr = 0; gr < 2; gr++) {
+                for (ch = 0; ch < channels; ch++) {
+                    quads[gr][ch] = quads[gr][ch] * 3 / 4;
+                    memset(lines[gr][ch] + 4 * quads[gr][ch], 0,
+                           GRANULE_LINES - 4 * quads[gr][ch]);
+                    quads[gr][ch] = usedQuads(lines[gr][ch], quads[gr][ch]);
+                }
+            }
+        }
+
+        /*
+         * Each quadruple is coded as the inverted bits of its values,
+         * followed by the signs of the values which are not 0.
+         */
+        memset(mainData, 0, sizeof(mainData));
+        bits = 0;
+        for (gr = 0; gr < 2; gr++) {
+            for (ch = 0; ch < channels; ch++) {
+                const signed char *l = lines[gr][ch];
+
+                for (i = 0; i < 4 * quads[gr][ch]; i += 4) {
+                    putBits(mainData, &bits, 15 - (((l[i] != 0) << 3) | ((l[i + 1] != 0) << 2)
+                                                   | ((l[i + 2] != 0) << 1) | (l[i + 3] != 0)), 4);
+                    for (k = i; k < i + 4; k++) {
+                        if (l[k] != 0) {
+                            putBits(mainData, &bits, l[k] < 0, 1);
+                        }
+                    }
+                }
+            }
+        }
+        for (k = f; slotStarts[k] > begin; k--)
+            ;
+        for (i = 0; i < (bits + 7) / 8; i++) {
+            if ((k < f) && (begin + i >= slotStarts[k + 1])) {
+                k++;
+            }
+            file[slotOffsets[k] + begin + i - slotStarts[k]] = mainData[i];
+        }
+        packed = begin + (bits + 7) / 8;
+
+        bits = 0;
+        frame += 4;
+        putBits(frame, &bits, slotStart - begin, 9);   /* main_data_begin */
+        putBits(frame, &bits, 0, (channels == 1) ? 5 : 3);
+        putBits(frame, &bits, 0, 4 * channels);         /* scfsi */
+        for (gr = 0; gr < 2; gr++) {
+            for (ch = 0; ch < channels; ch++) {
+                putBits(frame, &bits, part23[gr][ch], 12);
+                putBits(frame, &bits, 0, 9);            /* big_values */
+                putBits(frame, &bits, gain[gr][ch], 8);
+                putBits(frame, &bits, 0, 4);            /* scalefac_compress */
+                putBits(frame, &bits, 0, 1);            /* window_switching_flag */
+                putBits(frame, &bits, 0, 15);           /* table_select */
+                putBits(frame, &bits, 0, 7);            /* region0/1_count */
+                putBits(frame, &bits, 0, 2);            /* preflag, scalefac_scale */
+                putBits(frame, &bits, 1, 1);            /* count1table_select */
+            }
+        }
+
+        slotStart = slotEnd;
+        length += frameSize;
+    }
+
+    free(slotOffsets);
+    free(slotStarts);
+    return length;
+}
+
+static BOOL writeFixture(NSString *path, unsigned sampleRate, unsigned channels,
+                         unsigned long frames)
+{
+    NSMutableData *data = [NSMutableData dataWithLength:
+                            frames * (144 * FIXTURE_BITRATE / sampleRate + 1)];
+    unsigned long length = writeMP3([data mutableBytes], sampleRate, channels, frames);
+
+    if (length == 0) {
+        return NO;
+    }
+    [data setLength: length];
+    return [data writeToFile: path atomically: NO];
+}
+
+
+static BOOL decodeSerially(NSString *mp3, NSString *wav, double *seconds)
+{
+    PlayBuffer *buffer = AUTORELEASE([PlayBuffer new]);
+    struct mad_decoder decoder;
+    NSString *error;
+    NSDate *start = [NSDate date];
+    BOOL ret;
+
+    error = [buffer setInFile: mp3 outFile: wav];
+    if (nil != error) {
+        fprintf(stderr, "%s", [error UTF8String]);
+        return NO;
+    }
+    mad_decoder_init(&decoder, buffer, read_from_mmap, read_header, 0,
+                     output, 0, 0);
+    ret = (mad_decoder_run(&decoder, MAD_DECODER_MODE_SYNC) == 0);
+    mad_decoder_finish(&decoder);
+    ret = [buffer closeOutput: ret] && ret;
+
+    *seconds = -[start timeIntervalSinceNow];
+    return ret;
+}
+
+static BOOL decodeInParts(NSString *mp3, NSString *wav, unsigned parts, double *seconds)
+{
+    PlayBuffer *buffer = AUTORELEASE([PlayBuffer new]);
+    NSString *error;
+    NSDate *start = [NSDate date];
+    BOOL ret;
+
+    error = [buffer setInFile: mp3 outFile: wav];
+    if (nil != error) {
+        fprintf(stderr, "%s", [error UTF8String]);
+        return NO;
+    }
+    ret = [buffer decodeInParts: parts];
+    ret = [buffer closeOutput: ret] && ret;
+
+    *seconds = -[start timeIntervalSinceNow];
+    return ret;
+}
+
+static BOOL compareFiles(NSString *expectedPath, NSString *actualPath)
+{
+    PCMFile *expected = AUTORELEASE([[PCMFile alloc] initWithPath: expectedPath]);
+    PCMFile *actual = AUTORELEASE([[PCMFile alloc] initWithPath: actualPath]);
+    static int16_t a[2 * PCM_READ_FRAMES], b[2 * PCM_READ_FRAMES];
+    unsigned long long frames = 0;
+    unsigned maxDiff = 0;
+    double sum = 0.;
+
+    if ((nil == expected) || (nil == actual)) {
+        fprintf(stderr, "cannot read the output files\n");
+        return NO;
+    }
+    if ([expected frames] != [actual frames]) {
+        fprintf(stderr, "%llu frames instead of %llu\n",
+                [actual frames], [expected frames]);
+        return NO;
+    }
+
+    for (;;) {
+        long n = [expected readFrames: PCM_READ_FRAMES into: a];
+        long i;
+
+        if ((n < 0) || ([actual readFrames: n into: b] != n)) {
+            fprintf(stderr, "cannot read the output files\n");
+            return NO;
+        }
+        if (n == 0) {
+            break;
+        }
+        for (i = 0; i < 2 * n; i++) {
+            unsigned diff = abs(a[i] - b[i]);
+
+            if (diff > maxDiff) {
+                maxDiff = diff;
+            }
+            sum += (double)diff * diff;
+        }
+        frames += n;
+    }
+
+    if (frames > 0) {
+        double rms = sqrt(sum / (2. * frames));
+
+        printf("    %llu frames, difference max %u LSB, RMS %.2f LSB\n",
+               frames, maxDiff, rms);
+        if ((maxDiff > MAX_DIFFERENCE) || (rms > MAX_RMS)) {
+            fprintf(stderr, "the samples differ by more than the dither\n");
+            return NO;
+        }
+    }
+    return YES;
+}
+
+/*
+ * A generated file must decode without losing frames, which a serial
+ * decode would skip as well, and not to silence.
+ */
+static BOOL checkSerialFile(NSString *wavPath, unsigned long long minFrames)
+{
+    PCMFile *wav = AUTORELEASE([[PCMFile alloc] initWithPath: wavPath]);
+    static int16_t samples[2 * PCM_READ_FRAMES];
+    unsigned peak = 0;
+
+    if ((nil == wav) || ([wav frames] < minFrames)) {
+        fprintf(stderr, "%llu frames instead of at least %llu\n",
+                (nil == wav) ? 0ULL : [wav frames], minFrames);
+        return NO;
+    }
+    for (;;) {
+        long n = [wav readFrames: PCM_READ_FRAMES into: samples];
+        long i;
+
+        if (n < 0) {
+            fprintf(stderr, "cannot read the output file\n");
+            return NO;
+        }
+        if (n == 0) {
+            break;
+        }
+        for (i = 0; i < 2 * n; i++) {
+            if ((unsigned)abs(samples[i]) > peak) {
+                peak = abs(samples[i]);
+            }
+        }
+    }
+    if (peak <= MIN_PEAK) {
+        fprintf(stderr, "the peak is only %u LSB\n", peak);
+        return NO;
+    }
+    return YES;
+}
+
+/*
+ * Decodes mp3 serially and in each number of parts. minFrames is the
+ * least number of frames the serial decode must yield, or 0.
+ */
+static int testFile(NSString *mp3, NSArray *partCounts, unsigned long long minFrames)
+{
+    NSString *serialWav;
+    double serialTime, time;
+    int i, failures = 0;
+
+    printf("%s\n", [[mp3 lastPathComponent] UTF8String]);
+    serialWav = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                    [NSString stringWithFormat: @"mp3-parts-test-%d.wav", getpid()]];
+    if (!decodeSerially(mp3, serialWav, &serialTime)) {
+        fprintf(stderr, "%s: cannot decode\n", [mp3 UTF8String]);
+        return 1;
+    }
+    printf("serial decode      %7.2f s\n", serialTime);
+    if ((minFrames > 0) && !checkSerialFile(serialWav, minFrames)) {
+        unlink([serialWav fileSystemRepresentation]);
+        return 1;
+    }
+
+    for (i = 0; i < [partCounts count]; i++) {
+        unsigned parts = [[partCounts objectAtIndex: i] unsignedIntValue];
+        NSString *partsWav = [NSString stringWithFormat: @"%@.%u.wav",
+                                [serialWav stringByDeletingPathExtension], parts];
+
+        if (!decodeInParts(mp3, partsWav, parts, &time)) {
+            fprintf(stderr, "%u parts: cannot decode\n", parts);
+            failures++;
+            continue;
+        }
+        printf("%2u parts           %7.2f s  %.2fx\n", parts, time,
+               (time > 0.) ? serialTime / time : 0.);
+        if (!compareFiles(serialWav, partsWav)) {
+            failures++;
+        }
+        unlink([partsWav fileSystemRepresentation]);
+    }
+    unlink([serialWav fileSystemRepresentation]);
+    return failures;
+}
+
+/*
+ * Generates a file and tests it. The last frame may be lost, since
+ * libmad wants a few bytes after a frame before it decodes it, and
+ * the resampler may hold back a few samples.
+ */
+static int testFixture(unsigned sampleRate, unsigned channels, unsigned long frames,
+                       NSArray *partCounts)
+{
+    NSString *mp3 = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                        [NSString stringWithFormat: @"mp3-parts-test-%d-%u-%u.mp3",
+                                  getpid(), sampleRate, channels]];
+    int failures;
+
+    if (!writeFixture(mp3, sampleRate, channels, frames)) {
+        fprintf(stderr, "cannot write %s\n", [mp3 fileSystemRepresentation]);
+        return 1;
+    }
+    failures = testFile(mp3, partCounts,
+                        (unsigned long long)(frames - 2) * 1152 * 44100 / sampleRate);
+    unlink([mp3 fileSystemRepresentation]);
+    return failures;
+}
+
+int main(int argc, const char *argv[])
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSMutableArray *files = [NSMutableArray array];
+    NSMutableArray *partCounts = [NSMutableArray array];
+    int i, failures = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strspn(argv[i], "0123456789") == strlen(argv[i])) {
+            [partCounts addObject: [NSNumber numberWithInt: atoi(argv[i])]];
+        } else {
+            [files addObject: [NSString stringWithUTF8String: argv[i]]];
+        }
+    }
+    if ([partCounts count] == 0) {
+        [partCounts addObject: [NSNumber numberWithInt: 2]];
+        [partCounts addObject: [NSNumber numberWithInt: 3]];
+        [partCounts addObject: [NSNumber numberWithInt: 4]];
+        [partCounts addObject: [NSNumber numberWithInt: 8]];
+    }
+
+    if ([files count] == 0) {
+        /* 8 parts of 1000 frames, and 4 parts with resampling */
+        failures += testFixture(44100, 2, 8200, partCounts);
+        failures += testFixture(48000, 1, 4200, partCounts);
+    }
+    for (i = 0; i < [files count]; i++) {
+        failures += testFile([files objectAtIndex: i], partCounts, 0);
+    }
+
+    printf("%s\n", (failures == 0) ? "ok" : "FAILED");
+    RELEASE(pool);
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,276 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ParanoiaReaderTest.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <Foundation/Foundation.h>
+
+#include "ParanoiaReader.h"
+
+/*
+ * Reads a disc image through the ParanoiaReader of the LibParanoia
+ * bundle and compares the samples with the image's raw bytes.
+ *
+ * The image is generated: a BIN file with three audio tracks of
+ * tones and the CUE sheet which describes it. The tracks are 200, 151
+ * and 76 sectors long, so that the last chunk of each track is only
+ * partly filled. The ring holds just 3 chunks, so it wraps around
+ * several times.
+ *
+ * - Each track is read with -startTrack:, with and without paranoia's
+ *   verification.
+ * - All tracks are read with -startTracks: in one go, in an order
+ *   other than on the disc. No chunk may hold sectors of two tracks,
+ *   and -nextChunk:track: must tell the right track.
+ *
+ * Usage: paranoia-reader-test [directory]
+ *
+ * The image is written to the temporary directory by default and
+ * removed afterwards.
+ */
+
+#define TRACKS 3
+#define RING_CHUNKS 3
+#define RETRIES 20
+
+static const long trackSectors[TRACKS] = { 200, 151, 76 };
+static long trackOffsets[TRACKS];
+
+
+/*
+ * Writes the BIN file, in the little endian byte order of "BINARY"
+ * files, and the CUE sheet. Paranoia guesses the byte order of the
+ * samples from how much neighbouring samples differ, so the tracks
+ * are tones rather than noise.
+ */
+static BOOL writeImage(NSString *bin, NSString *cue)
+{
+    NSMutableString *sheet = [NSMutableString stringWithFormat:
+                                @"FILE \"%@\" BINARY\n", [bin lastPathComponent]];
+    NSMutableData *data = [NSMutableData data];
+    long sector = 0;
+    int t;
+
+    for (t = 0; t < TRACKS; t++) {
+        long frames = trackSectors[t] * CDIO_CD_FRAMESIZE_RAW / 4;
+        unsigned char *bytes;
+        long i;
+
+        trackOffsets[t] = sector;
+        [sheet appendFormat: @"  TRACK %02d AUDIO\n"
+                             @"    INDEX 01 %02ld:%02ld:%02ld\n",
+                             t + 1, sector / (75 * 60), (sector / 75) % 60, sector % 75];
+
+        [data increaseLengthBy: frames * 4];
+        bytes = (unsigned char *)[data mutableBytes] + sector * CDIO_CD_FRAMESIZE_RAW;
+        for (i = 0; i < frames; i++) {
+            double phase = 2. * M_PI * 220. * (t + 1) * i / 44100.;
+            int16_t left = (int16_t)(8000. * sin(phase));
+            int16_t right = (int16_t)(6000. * sin(phase * 1.5));
+
+            bytes[4 * i] = (unsigned char)left;
+            bytes[4 * i + 1] = (unsigned char)(left >> 8);
+            bytes[4 * i + 2] = (unsigned char)right;
+            bytes[4 * i + 3] = (unsigned char)(right >> 8);
+        }
+        sector += trackSectors[t];
+    }
+
+    return [data writeToFile: bin atomically: NO]
+        && [sheet writeToFile: cue atomically: NO];
+}
+
+/*
+ * Compares sectors read by the reader, in native byte order, with
+ * the raw little endian bytes of the image.
+ */
+static BOOL sameSamples(const unsigned char *read, const unsigned char *raw, long sectors)
+{
+    const int16_t *samples = (const int16_t *)read;
+    long i, count = sectors * CDIO_CD_FRAMESIZE_RAW / 2;
+
+    for (i = 0; i < count; i++) {
+        int16_t expected = (int16_t)(raw[2 * i] | (raw[2 * i + 1] << 8));
+
+        if (samples[i] != expected) {
+            fprintf(stderr, "sample %ld is %d instead of %d\n", i, samples[i], expected);
+            return NO;
+        }
+    }
+    return YES;
+}
+
+/*
+ * Reads the tracks with the given indexes, 0 based, and checks each
+ * chunk against the image.
+ */
+static int readTracks(ParanoiaReader *reader, NSData *image, const int *tracks,
+                      int count, int mode, const char *name)
+{
+    const unsigned char *raw = [image bytes];
+    NSMutableArray *numbers = [NSMutableArray array];
+    long position[TRACKS];
+    long total = 0;
+    int i, current = 0, failures = 0;
+    BOOL started;
+
+    for (i = 0; i < count; i++) {
+        [numbers addObject: [NSNumber numberWithInt: tracks[i] + 1]];
+        position[tracks[i]] = 0;
+    }
+    if (count == 1) {
+        started = [reader startTrack: tracks[0] + 1 mode: mode retries: RETRIES];
+    } else {
+        started = [reader startTracks: numbers mode: mode retries: RETRIES];
+    }
+    if (!started) {
+        fprintf(stderr, "%s: cannot start reading\n", name);
+        return 1;
+    }
+
+    for (;;) {
+        const unsigned char *data = NULL;
+        int index = -1;
+        long n, t;
+
+        n = (count == 1) ? [reader nextChunk: &data] : [reader nextChunk: &data track: &index];
+        if (n <= 0) {
+            if (n < 0) {
+                fprintf(stderr, "%s: reading failed\n", name);
+                failures++;
+            }
+            break;
+        }
+        if (count == 1) {
+            index = 0;
+        }
+        if ((index < current) || (index >= count)) {
+            fprintf(stderr, "%s: chunk of track index %d after index %d\n", name, index, current);
+            failures++;
+            [reader releaseChunk];
+            break;
+        }
+        current = index;
+        t = tracks[index];
+        if ((n > READER_CHUNK_SECTORS) || (position[t] + n > trackSectors[t])) {
+            fprintf(stderr, "%s: chunk of %ld sectors at sector %ld of track %ld\n",
+                    name, n, position[t], t + 1);
+            failures++;
+        } else if (!sameSamples(data, raw + (trackOffsets[t] + position[t]) * CDIO_CD_FRAMESIZE_RAW, n)) {
+            fprintf(stderr, "%s: track %ld differs at sector %ld\n", name, t + 1, position[t]);
+            failures++;
+        }
+        position[t] += n;
+        [reader releaseChunk];
+        if (failures > 0) {
+            [reader cancel];
+        }
+    }
+    [reader finishTrack];
+
+    for (i = 0; i < count; i++) {
+        if (position[tracks[i]] != trackSectors[tracks[i]]) {
+            fprintf(stderr, "%s: %ld sectors of track %d instead of %ld\n", name,
+                    position[tracks[i]], tracks[i] + 1, trackSectors[tracks[i]]);
+            failures++;
+        }
+        total += position[tracks[i]];
+    }
+    if ([reader sectorsRead] != total) {
+        fprintf(stderr, "%s: the reader counted %ld sectors instead of %ld\n",
+                name, [reader sectorsRead], total);
+        failures++;
+    }
+
+    printf("%-36s %s\n", name, failures ? "FAILED" : "ok");
+    return failures;
+}
+
+int main(int argc, const char *argv[])
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSString *dir = NSTemporaryDirectory();
+    NSString *bin, *cue;
+    NSData *image;
+    ParanoiaReader *reader;
+    static const int allTracks[] = { 2, 0, 1 };
+    int t, failures = 0;
+
+    if (argc > 1) {
+        dir = [NSString stringWithUTF8String: argv[1]];
+    }
+    bin = [dir stringByAppendingPathComponent:
+                [NSString stringWithFormat: @"paranoia-reader-test-%d.bin", getpid()]];
+    cue = [[bin stringByDeletingPathExtension] stringByAppendingPathExtension: @"cue"];
+
+    if (!writeImage(bin, cue)) {
+        fprintf(stderr, "cannot write %s\n", [bin fileSystemRepresentation]);
+        RELEASE(pool);
+        return 1;
+    }
+    image = [NSData dataWithContentsOfFile: bin];
+
+    reader = [[ParanoiaReader alloc] initWithDevice: cue chunks: RING_CHUNKS];
+    if (nil == reader) {
+        fprintf(stderr, "cannot open %s\n", [cue fileSystemRepresentation]);
+        failures++;
+    } else {
+        for (t = 0; t < TRACKS; t++) {
+            if ([reader sectorsOfTrack: t + 1] != trackSectors[t]) {
+                fprintf(stderr, "track %d has %ld sectors instead of %ld\n",
+                        t + 1, [reader sectorsOfTrack: t + 1], trackSectors[t]);
+                failures++;
+            }
+        }
+        if ([reader sectorsOfTrack: TRACKS + 1] != -1) {
+            fprintf(stderr, "track %d exists\n", TRACKS + 1);
+            failures++;
+        }
+
+        for (t = 0; t < TRACKS; t++) {
+            char name[64];
+
+            snprintf(name, sizeof(name), "track %d, verified", t + 1);
+            failures += readTracks(reader, image, &t, 1, PARANOIA_MODE_FULL, name);
+            snprintf(name, sizeof(name), "track %d, not verified", t + 1);
+            failures += readTracks(reader, image, &t, 1, PARANOIA_MODE_DISABLE, name);
+        }
+        failures += readTracks(reader, image, allTracks, TRACKS,
+                               PARANOIA_MODE_FULL, "tracks 3, 1, 2 in one go");
+        RELEASE(reader);
+    }
+
+    unlink([bin fileSystemRepresentation]);
+    unlink([cue fileSystemRepresentation]);
+
+    RELEASE(pool);
+    if (failures > 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,329 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ProgressReplay.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "ProgressParser.h"
+
+/*
+ * Replays the captured output of the tools in corpus/ through the
+ * progress parsers.
+ *
+ * Usage: progress-replay [-g] log...
+ *
+ * The parser is chosen by the start of the log's name, e.g.
+ * corpus/cdrecord-nodisk.log is passed to parseCDrecordLine(). Each
+ * log is split into lines like ToolProcess does it: at newlines and
+ * carriage returns, dropping empty lines. To make sure that lines
+ * broken across reads are still parsed correctly, the log is split
+ * several times, with the data arriving in chunks of various sizes.
+ *
+ * The events must match those in the .expected file next to the log,
+ * one line for each line of output which carries progress information:
+ *   <line number> <event type> <current> <total> <value>
+ * With -g the events are written to stdout instead, to create the
+ * .expected file of a new log. Check them by hand before adding them.
+ *
+ * Afterwards each log is parsed repeatedly for a while to measure the
+ * lines per second.
+ */
+
+typedef ProgressEventType (*ParseFunction)(const char *line, unsigned length,
+                                           ProgressEvent *event);
+
+static const struct {
+    const char *name;
+    ParseFunction parse;
+} parsers[] = {
+    { "cdrecord", parseCDrecordLine },
+    { "cdrdao", parseCdrdaoLine },
+    { "mkisofs", parseMkIsoFsLine },
+    { "cdparanoia", parseCDparanoiaLine },
+    { "ffmpeg", parseFFmpegLine },
+    { NULL, NULL }
+};
+
+static const char *typeNames[] = {
+    "None",
+    "NoMedium",
+    "TotalSize",
+    "OperationStarts",
+    "StartingWrite",
+    "LeadIn",
+    "NewTrack",
+    "Written",
+    "Fixating",
+    "Failed",
+    "Percent",
+    "FirstSector",
+    "LastSector",
+    "TocEntry",
+    "Duration",
+    "Time",
+    "Report"
+};
+
+/* The chunk sizes the logs are read in, 0 for all at once */
+static const unsigned chunkSizes[] = { 0, 1, 7, 64, 4096 };
+
+/* How long each log is replayed for the benchmark, in seconds */
+#define BENCHMARK_TIME 0.5
+
+typedef struct {
+    ParseFunction parse;
+    unsigned lines;
+    unsigned events;
+    char *text;                 /* the formatted events */
+    size_t textLength;
+    size_t textSize;
+} Replay;
+
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.;
+}
+
+static char *readFile(const char *path, size_t *length)
+{
+    FILE *f = fopen(path, "rb");
+    char *data;
+    long size;
+
+    if (NULL == f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = malloc(size + 1);
+    if ((NULL == data) || (fread(data, 1, size, f) != (size_t)size)) {
+        free(data);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+    data[size] = 0;
+    *length = size;
+    return data;
+}
+
+static ParseFunction parserForLog(const char *path)
+{
+    const char *name = strrchr(path, '/');
+    int i;
+
+    name = (NULL == name) ? path : name + 1;
+    for (i = 0; NULL != parsers[i].name; i++) {
+        size_t n = strlen(parsers[i].name);
+
+        if ((strncmp(name, parsers[i].name, n) == 0)
+                && ((name[n] == '.') || (name[n] == '-'))) {
+            return parsers[i].parse;
+        }
+    }
+    return NULL;
+}
+
+static void appendText(Replay *replay, const char *text)
+{
+    size_t n = strlen(text);
+
+    if (replay->textLength + n + 1 > replay->textSize) {
+        replay->textSize = 2 * (replay->textLength + n + 1);
+        replay->text = realloc(replay->text, replay->textSize);
+    }
+    memcpy(replay->text + replay->textLength, text, n + 1);
+    replay->textLength += n;
+}
+
+static void parseLine(Replay *replay, const char *line, unsigned length)
+{
+    ProgressEvent event;
+
+    replay->lines++;
+    if ((replay->parse(line, length, &event) != ProgressNone)
+            && (NULL != replay->text)) {
+        char buffer[128];
+
+        snprintf(buffer, sizeof(buffer), "%u %s %ld %ld %.2f\n",
+                 replay->lines, typeNames[event.type],
+                 event.current, event.total, event.value);
+        appendText(replay, buffer);
+        replay->events++;
+    }
+}
+
+/*
+ * Splits data into lines as ToolProcess does it, receiving chunkSize
+ * bytes at a time. Incomplete lines are kept in pending until the
+ * rest arrives.
+ */
+static void replayLog(Replay *replay, const char *data, size_t length,
+                      unsigned chunkSize, char *pending)
+{
+    size_t pendingLength = 0;
+    size_t pos = 0;
+
+    if (chunkSize == 0) {
+        chunkSize = length;
+    }
+    while (pos < length) {
+        size_t n = (length - pos < chunkSize) ? length - pos : chunkSize;
+        size_t start = 0, i;
+
+        memcpy(pending + pendingLength, data + pos, n);
+        pendingLength += n;
+        pos += n;
+
+        for (i = 0; i < pendingLength; i++) {
+            if ((pending[i] == '\n') || (pending[i] == '\r')) {
+                if (i > start) {
+                    parseLine(replay, pending + start, i - start);
+                }
+                start = i + 1;
+            }
+        }
+        memmove(pending, pending + start, pendingLength - start);
+        pendingLength -= start;
+    }
+    if (pendingLength > 0) {
+        parseLine(replay, pending, pendingLength);
+    }
+}
+
+static int checkLog(const char *path, BOOL generate, double *linesPerSecond)
+{
+    ParseFunction parse = parserForLog(path);
+    char *data, *pending, *expected = NULL;
+    size_t length, expectedLength = 0;
+    char expectedPath[1024];
+    Replay replay;
+    unsigned i, passes = 0, lines;
+    double start, elapsed;
+    int failures = 0;
+
+    if (NULL == parse) {
+        fprintf(stderr, "%s: no parser for this log\n", path);
+        return 1;
+    }
+    data = readFile(path, &length);
+    if (NULL == data) {
+        fprintf(stderr, "%s: cannot read\n", path);
+        return 1;
+    }
+    pending = malloc(length + 1);
+
+    snprintf(expectedPath, sizeof(expectedPath), "%.*s.expected",
+             (int)(strrchr(path, '.') - path), path);
+    if (!generate) {
+        expected = readFile(expectedPath, &expectedLength);
+        if (NULL == expected) {
+            fprintf(stderr, "%s: cannot read\n", expectedPath);
+            free(pending);
+            free(data);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < sizeof(chunkSizes) / sizeof(chunkSizes[0]); i++) {
+        memset(&replay, 0, sizeof(replay));
+        replay.parse = parse;
+        replay.textSize = 4096;
+        replay.text = malloc(replay.textSize);
+        replay.text[0] = 0;
+
+        replayLog(&replay, data, length, chunkSizes[i], pending);
+
+        if (generate) {
+            fputs(replay.text, stdout);
+            free(replay.text);
+            break;
+        }
+        if ((replay.textLength != expectedLength)
+                || (memcmp(replay.text, expected, expectedLength) != 0)) {
+            fprintf(stderr, "%s: events differ from %s when read in chunks of %u bytes:\n%s",
+                    path, expectedPath, chunkSizes[i], replay.text);
+            failures++;
+        }
+        free(replay.text);
+    }
+
+    /*
+     * The benchmark parses without formatting the events.
+     */
+    memset(&replay, 0, sizeof(replay));
+    replay.parse = parse;
+    start = now();
+    do {
+        replayLog(&replay, data, length, 4096, pending);
+        passes++;
+        elapsed = now() - start;
+    } while (elapsed < BENCHMARK_TIME);
+    lines = replay.lines / passes;
+    *linesPerSecond = replay.lines / elapsed;
+
+    if (!generate) {
+        printf("%-40s %5u lines %s %12.0f lines/s\n", path, lines,
+               (failures == 0) ? "ok    " : "FAILED", *linesPerSecond);
+    }
+
+    free(expected);
+    free(pending);
+    free(data);
+    return failures;
+}
+
+int main(int argc, const char *argv[])
+{
+    BOOL generate = NO;
+    int i, first = 1, failures = 0;
+    double sum = 0., linesPerSecond;
+
+    if ((argc > 1) && (strcmp(argv[1], "-g") == 0)) {
+        generate = YES;
+        first = 2;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "Usage: %s [-g] log...\n", argv[0]);
+        return 2;
+    }
+
+    for (i = first; i < argc; i++) {
+        failures += checkLog(argv[i], generate, &linesPerSecond);
+        sum += linesPerSecond;
+    }
+
+    if (!generate) {
+        printf("%d logs, %s, %.0f lines/s on average\n", argc - first,
+               (failures == 0) ? "all events as expected" : "FAILED",
+               sum / (argc - first));
+    }
+    return (failures == 0) ? 0 : 1;
+}
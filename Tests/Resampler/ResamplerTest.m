@@ -0,0 +1,316 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ResamplerTest.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <Foundation/Foundation.h>
+
+#include "Resampler.h"
+
+/*
+ * Passes sine sweeps at 48000, 88200 and 96000 Hz through the
+ * Resampler at each quality and checks the output at 44100 Hz:
+ *
+ * - The number of output frames follows from the input's duration.
+ * - Tones in the pass band keep their level and get no distortion or
+ *   noise beyond what the 16 bit samples carry (THD+N). The tone is
+ *   fitted to the output by least squares, whatever is left over is
+ *   distortion and noise.
+ * - Tones above 22050 Hz, which would be aliased into the output,
+ *   are attenuated as much as the quality promises. Below the noise
+ *   floor of 16 bit samples this cannot be measured, so at most
+ *   90 dB are checked.
+ *
+ * Then it measures how fast each rate is converted.
+ *
+ * Usage: resampler-test [-q]
+ * -q skips the benchmark.
+ */
+
+#define OUTPUT_RATE RESAMPLE_OUTPUT_RATE
+
+/* The level of the test tones, -3 dBFS */
+#define AMPLITUDE (0.7071 * 32767.)
+
+/* The duration of each tone in seconds */
+#define TONE_TIME 0.5
+
+/* The number of tones swept through each band */
+#define SWEEP_TONES 24
+
+/* The duration of audio converted for the benchmark, in seconds */
+#define BENCHMARK_AUDIO 60.
+
+static const unsigned inputRates[] = { 48000, 88200, 96000 };
+
+static const struct {
+    const char *name;
+    ResampleQuality quality;
+    double passBand;            /* Hz, as documented in Resampler.h */
+    double maxThdN;             /* dB relative to the tone */
+    double minAttenuation;      /* dB */
+} qualities[] = {
+    { "Fast", ResampleQualityFast, 17000., -65., 57. },
+    { "Good", ResampleQualityGood, 18500., -85., 75. },
+    { "Best", ResampleQualityBest, 19800., -88., 90. }
+};
+
+#define NUM_RATES (sizeof(inputRates) / sizeof(inputRates[0]))
+#define NUM_QUALITIES (sizeof(qualities) / sizeof(qualities[0]))
+
+/* Level changes in the pass band we accept, in dB */
+#define MAX_RIPPLE 0.1
+
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.;
+}
+
+static void makeTone(int16_t *samples, unsigned long frames, double frequency,
+                     unsigned rate)
+{
+    unsigned long i;
+
+    for (i = 0; i < frames; i++) {
+        int16_t s = (int16_t)lrint(AMPLITUDE * sin(2. * M_PI * frequency * i / rate));
+
+        samples[2 * i] = s;
+        samples[2 * i + 1] = s;
+    }
+}
+
+/*
+ * Converts all frames like the converters do it, in blocks of 8192
+ * frames followed by a flush. Returns the number of
+ * output frames or -1 if the resampler could not be created.
+ */
+static long resampleSignal(unsigned rate, ResampleQuality quality,
+                           const int16_t *in, unsigned long frames, int16_t *out)
+{
+    Resampler *resampler = [[Resampler alloc] initWithInputRate: rate
+                                                        quality: quality];
+    unsigned long done = 0;
+    long written = 0;
+
+    if (nil == resampler) {
+        return -1;
+    }
+    while (done < frames) {
+        unsigned n = (frames - done > 8192) ? 8192 : (unsigned)(frames - done);
+
+        written += [resampler resample: in + 2 * done frames: n into: out + 2 * written];
+        done += n;
+    }
+    written += [resampler flush: out + 2 * written];
+    RELEASE(resampler);
+    return written;
+}
+
+/*
+ * Fits a sine of the given frequency to the left channel of out,
+ * leaving out the edges, where the filter sees the silence around the
+ * signal. Returns the level of the sine relative to AMPLITUDE and the
+ * RMS of the rest relative to the sine's RMS, both in dB.
+ */
+static void analyze(const int16_t *out, unsigned long frames, double frequency,
+                    double *level, double *thdN)
+{
+    unsigned long skip = OUTPUT_RATE / 100, i;
+    double ss = 0., cc = 0., sc = 0., sy = 0., cy = 0.;
+    double a, b, det, amplitude, residual = 0.;
+
+    for (i = skip; i < frames - skip; i++) {
+        double w = 2. * M_PI * frequency * i / OUTPUT_RATE;
+        double s = sin(w), c = cos(w);
+
+        ss += s * s;
+        cc += c * c;
+        sc += s * c;
+        sy += s * out[2 * i];
+        cy += c * out[2 * i];
+    }
+    det = ss * cc - sc * sc;
+    a = (sy * cc - cy * sc) / det;
+    b = (cy * ss - sy * sc) / det;
+    amplitude = sqrt(a * a + b * b);
+
+    for (i = skip; i < frames - skip; i++) {
+        double w = 2. * M_PI * frequency * i / OUTPUT_RATE;
+        double e = out[2 * i] - (a * sin(w) + b * cos(w));
+
+        residual += e * e;
+    }
+    residual = sqrt(residual / (frames - 2 * skip));
+
+    *level = 20. * log10(amplitude / AMPLITUDE);
+    *thdN = 20. * log10(residual / (amplitude / sqrt(2.)));
+}
+
+/*
+ * Returns the RMS of the left channel of out relative to the RMS of
+ * the tone put in, in dB.
+ */
+static double relativeLevel(const int16_t *out, unsigned long frames)
+{
+    unsigned long skip = OUTPUT_RATE / 100, i;
+    double sum = 0.;
+
+    for (i = skip; i < frames - skip; i++) {
+        sum += (double)out[2 * i] * out[2 * i];
+    }
+    sum = sqrt(sum / (frames - 2 * skip));
+    return 20. * log10((sum + 1e-9) / (AMPLITUDE / sqrt(2.)));
+}
+
+static int checkRate(unsigned rate, unsigned q)
+{
+    unsigned long frames = (unsigned long)(TONE_TIME * rate);
+    unsigned long expected = (frames * OUTPUT_RATE + rate - 1) / rate;
+    int16_t *in = malloc(frames * 4);
+    int16_t *out = malloc((expected + 16) * 4);
+    double worstThdN = -1000., worstRipple = 0., worstAttenuation = 1000.;
+    double low = 1e9, high = 0.;
+    int failures = 0;
+    int i;
+
+    /*
+     * The pass band, from 100 Hz on.
+     */
+    for (i = 0; i < SWEEP_TONES; i++) {
+        double frequency = 100. + i * (qualities[q].passBand - 100.) / (SWEEP_TONES - 1);
+        double level, thdN;
+        long n;
+
+        makeTone(in, frames, frequency, rate);
+        n = resampleSignal(rate, qualities[q].quality, in, frames, out);
+        if (n != (long)expected) {
+            fprintf(stderr, "%u Hz %s: %ld frames instead of %lu\n",
+                    rate, qualities[q].name, n, expected);
+            failures++;
+            break;
+        }
+        analyze(out, n, frequency, &level, &thdN);
+        if (thdN > worstThdN) {
+            worstThdN = thdN;
+        }
+        if (fabs(level) > fabs(worstRipple)) {
+            worstRipple = level;
+        }
+        if ((thdN > qualities[q].maxThdN) || (fabs(level) > MAX_RIPPLE)) {
+            fprintf(stderr, "%u Hz %s: %.0f Hz tone: level %+.3f dB, THD+N %.1f dB\n",
+                    rate, qualities[q].name, frequency, level, thdN);
+            failures++;
+        }
+    }
+
+    /*
+     * The stop band, from 22050 Hz to just below the input's Nyquist
+     * frequency. Everything coming out is aliased.
+     */
+    for (i = 0; (failures == 0) && (i < SWEEP_TONES); i++) {
+        double frequency = OUTPUT_RATE / 2. + 50.
+            + i * (rate / 2. - OUTPUT_RATE / 2. - 150.) / (SWEEP_TONES - 1);
+        double attenuation;
+        long n;
+
+        makeTone(in, frames, frequency, rate);
+        n = resampleSignal(rate, qualities[q].quality, in, frames, out);
+        attenuation = -relativeLevel(out, n);
+        if (attenuation < worstAttenuation) {
+            worstAttenuation = attenuation;
+        }
+        if (frequency < low) {
+            low = frequency;
+        }
+        if (frequency > high) {
+            high = frequency;
+        }
+        if (attenuation < qualities[q].minAttenuation) {
+            fprintf(stderr, "%u Hz %s: %.0f Hz tone attenuated by %.1f dB only\n",
+                    rate, qualities[q].name, frequency, attenuation);
+            failures++;
+        }
+    }
+
+    printf("%6u Hz %s  THD+N %6.1f dB  ripple %+.3f dB  aliasing %5.1f dB (%.0f-%.0f Hz)  %s\n",
+           rate, qualities[q].name, worstThdN, worstRipple, -worstAttenuation,
+           low, high, (failures == 0) ? "ok" : "FAILED");
+
+    free(in);
+    free(out);
+    return failures;
+}
+
+static void benchmark(unsigned rate, unsigned q)
+{
+    unsigned long frames = (unsigned long)(BENCHMARK_AUDIO * rate);
+    int16_t *in = malloc(frames * 4);
+    int16_t *out = malloc(((frames * OUTPUT_RATE) / rate + 16) * 4);
+    double start, elapsed;
+
+    makeTone(in, frames, 997., rate);
+    start = now();
+    resampleSignal(rate, qualities[q].quality, in, frames, out);
+    elapsed = now() - start;
+
+    printf("%6u Hz %s  %7.1f M frames/s  %6.0fx real time\n", rate,
+           qualities[q].name, frames / elapsed / 1e6, BENCHMARK_AUDIO / elapsed);
+
+    free(in);
+    free(out);
+}
+
+int main(int argc, const char *argv[])
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    BOOL quick = (argc > 1) && (strcmp(argv[1], "-q") == 0);
+    int failures = 0;
+    unsigned r, q;
+
+    for (r = 0; r < NUM_RATES; r++) {
+        for (q = 0; q < NUM_QUALITIES; q++) {
+            failures += checkRate(inputRates[r], q);
+        }
+    }
+
+    if (!quick) {
+        printf("\nOne thread, %.0f s of audio:\n", BENCHMARK_AUDIO);
+        for (r = 0; r < NUM_RATES; r++) {
+            for (q = 0; q < NUM_QUALITIES; q++) {
+                benchmark(inputRates[r], q);
+            }
+        }
+    }
+
+    printf("%s\n", (failures == 0) ? "ok" : "FAILED");
+    RELEASE(pool);
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ToolProcess.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef TOOLPROCESS_H_INC
+#define TOOLPROCESS_H_INC
+
+#include <sys/types.h>
+
+#include <Foundation/Foundation.h>
+
+@class ToolProcess;
+
+/**
+ * <p>The delegate of a ToolProcess receives the output of the
+ * external program line by line.</p>
+ */
+@protocol ToolProcessDelegate
+
+/**
+ * <p>Called for each complete line the program writes to its standard
+ * output or standard error. Lines end with a newline or a carriage
+ * return, the latter being used by many tools for progress updates.
+ * Empty lines are not reported. The method is called in the thread
+ * which called -waitUntilExit.</p>
+ */
+- (void) toolProcess: (ToolProcess *) process
+         didReadLine: (NSString *) line;
+
+@end
+
+/**
+ * <p>A delegate may implement this method in addition. Then it gets
+ * the bytes of each line, without the line end, before they are turned
+ * into a string. If it returns YES, the line has been dealt with and
+ * toolProcess:didReadLine: is not called for it. Thus, e.g. progress
+ * output can be parsed without creating any objects.</p>
+ */
+@interface NSObject (ToolProcessDelegate)
+- (BOOL) toolProcess: (ToolProcess *) process
+    didReadLineBytes: (const char *) bytes
+              length: (unsigned) length;
+@end
+
+/**
+ * <p>ToolProcess runs an external program, e.g. cdrecord or mkisofs,
+ * and hands its output to a delegate line by line.</p>
+ * <p>The program is started with posix_spawn(). -waitUntilExit waits
+ * with poll() on the program's output, so no CPU time is burnt while
+ * the program is quiet. Incomplete lines are kept until the rest
+ * arrives. -cancel may be called from any thread to stop the
+ * program.</p>
+ */
+@interface ToolProcess : NSObject
+{
+    NSString *launchPath;
+    NSArray *arguments;
+    id standardInput;
+    id standardOutput;
+    id delegate;
+    BOOL delegateReadsBytes;
+    NSStringEncoding encoding;
+    NSMutableArray *outputLines;
+
+    NSLock *lock;
+    pid_t pid;
+    int outFd;
+    int errFd;
+    BOOL running;
+    BOOL reaped;
+    BOOL cancelled;
+    BOOL killed;
+    NSTimeInterval cancelTime;
+    BOOL exitedNormally;
+    int terminationStatus;
+}
+
++ (ToolProcess *) processWithPath: (NSString *) path
+                        arguments: (NSArray *) args;
+
+- (id) initWithPath: (NSString *) path
+          arguments: (NSArray *) args;
+
+/**
+ * <p>Sets the object which receives the output. The delegate is not
+ * retained. Without a delegate the lines are collected and may be
+ * fetched by -outputLines.</p>
+ */
+- (void) setDelegate: (id) aDelegate;
+
+/**
+ * <p>Sets the program's standard input. <var>input</var> may be an
+ * NSPipe or an NSFileHandle. By default, the program inherits our
+ * standard input. When a pipe is passed, our copy of its read end
+ * is closed after the launch.</p>
+ */
+- (void) setStandardInput: (id) input;
+
+/**
+ * <p>Sends the program's standard output to <var>output</var>, which
+ * may be an NSPipe or an NSFileHandle, instead of to the delegate.
+ * Only the standard error is passed to the delegate then. When a pipe
+ * is passed, our copy of its write end is closed after the launch,
+ * so that the reader sees the end of the data.</p>
+ */
+- (void) setStandardOutput: (id) output;
+
+/**
+ * <p>Sets the encoding of the program's output. The default is
+ * NSISOLatin1StringEncoding.</p>
+ */
+- (void) setEncoding: (NSStringEncoding) anEncoding;
+
+- (NSString *) launchPath;
+- (NSArray *) arguments;
+
+/**
+ * <p>Starts the program. Returns NO if it could not be started or
+ * if the process has been cancelled before.</p>
+ */
+- (BOOL) launch;
+
+/**
+ * <p>Reads the program's output and passes it to the delegate until
+ * the program has exited. Output still arriving more than two seconds
+ * after the program's exit, e.g. from a child it left behind, is
+ * dropped. Returns YES if the program exited normally with status 0
+ * and was not cancelled.</p>
+ */
+- (BOOL) waitUntilExit;
+
+/**
+ * <p>Launches the program and waits for it. Returns the result of
+ * -waitUntilExit or NO if the program could not be started.</p>
+ */
+- (BOOL) run;
+
+/**
+ * <p>Stops the program by sending it SIGTERM. If it is still running
+ * ten seconds later, -waitUntilExit kills it with SIGKILL. If the
+ * program has not been started, yet, it will not be started at
+ * all.</p>
+ */
+- (void) cancel;
+
+- (BOOL) isRunning;
+- (BOOL) isCancelled;
+
+/**
+ * <p>Returns NO if the program was terminated by a signal.</p>
+ */
+- (BOOL) exitedNormally;
+
+/**
+ * <p>Returns the program's exit status or the number of the signal
+ * which terminated it.</p>
+ */
+- (int) terminationStatus;
+
+- (pid_t) processIdentifier;
+
+/**
+ * <p>Returns the lines the program has written if there is no
+ * delegate.</p>
+ */
+- (NSArray *) outputLines;
+
+@end
+
+#endif
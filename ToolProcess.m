@@ -0,0 +1,612 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  ToolProcess.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "ToolProcess.h"
+
+#include "Constants.h"
+#include "Functions.h"
+
+#define READ_SIZE 4096
+
+/*
+ * Seconds a cancelled program may take to exit after SIGTERM before
+ * it is killed.
+ */
+#define KILL_TIMEOUT 10.0
+
+/*
+ * Seconds we keep reading the output after the program has exited.
+ * A child of the program may still hold the pipes open.
+ */
+#define DRAIN_TIMEOUT 2.0
+
+/*
+ * Milliseconds between the checks for the above while waiting.
+ */
+#define CHECK_INTERVAL 250
+
+extern char **environ;
+
+
+/*
+ * Returns the file descriptor to use for the child's side of
+ * a standard stream.
+ */
+static int childDescriptor(id handle, BOOL forReading)
+{
+    if ([handle isKindOfClass: [NSPipe class]]) {
+        handle = forReading ? [handle fileHandleForReading]
+                            : [handle fileHandleForWriting];
+    }
+    return [handle fileDescriptor];
+}
+
+static void closeParentSide(id handle, BOOL forReading)
+{
+    if ([handle isKindOfClass: [NSPipe class]]) {
+        NS_DURING
+            if (forReading) {
+                [[handle fileHandleForReading] closeFile];
+            } else {
+                [[handle fileHandleForWriting] closeFile];
+            }
+        NS_HANDLER
+            // already closed
+        NS_ENDHANDLER
+    }
+}
+
+static void closeOnExec(int fd)
+{
+    fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+}
+
+
+@interface ToolProcess (Private)
+- (void) addCloseActions: (posix_spawn_file_actions_t *) actions;
+- (BOOL) readFrom: (int) fd into: (NSMutableData *) buffer;
+- (void) deliverLinesFrom: (NSMutableData *) buffer final: (BOOL) final;
+- (void) deliverBytes: (const char *) bytes length: (unsigned) length;
+- (void) deliverLine: (NSString *) line;
+- (void) setStatus: (int) status;
+- (BOOL) reapIfExited;
+- (void) killIfStuck;
+- (void) reap;
+@end
+
+@implementation ToolProcess (Private)
+
+/*
+ * The child must not inherit any other descriptors. Otherwise, e.g.
+ * the write end of an image pipe used by another process stays open
+ * and the reader never sees the end of the data.
+ */
+- (void) addCloseActions: (posix_spawn_file_actions_t *) actions
+{
+#if defined(__GLIBC__) && defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 34)
+    posix_spawn_file_actions_addclosefrom_np(actions, 3);
+    return;
+#endif
+#endif
+    {
+        int fd, max = getdtablesize();
+
+        for (fd = 3; fd < max; fd++) {
+            if (fcntl(fd, F_GETFD) != -1) {
+                posix_spawn_file_actions_addclose(actions, fd);
+            }
+        }
+    }
+}
+
+/*
+ * Returns NO at the end of the data.
+ */
+- (BOOL) readFrom: (int) fd into: (NSMutableData *) buffer
+{
+    char bytes[READ_SIZE];
+    ssize_t count;
+
+    do {
+        count = read(fd, bytes, READ_SIZE);
+    } while ((count < 0) && (errno == EINTR));
+
+    if (count <= 0) {
+        return NO;
+    }
+    [buffer appendBytes: bytes length: count];
+    [self deliverLinesFrom: buffer final: NO];
+    return YES;
+}
+
+- (void) deliverLinesFrom: (NSMutableData *) buffer final: (BOOL) final
+{
+    const char *bytes = [buffer bytes];
+    unsigned length = [buffer length];
+    unsigned start = 0, i;
+
+    for (i = 0; i < length; i++) {
+        if ((bytes[i] == '\n') || (bytes[i] == '\r')) {
+            if (i > start) {
+                [self deliverBytes: bytes + start length: i - start];
+            }
+            start = i + 1;
+        }
+    }
+
+    if (final && (length > start)) {
+        [self deliverBytes: bytes + start length: length - start];
+        start = length;
+    }
+
+    // Keep the incomplete line for the next read.
+    [buffer replaceBytesInRange: NSMakeRange(0, start) withBytes: NULL length: 0];
+}
+
+- (void) deliverBytes: (const char *) bytes length: (unsigned) length
+{
+    NSString *line;
+
+    if (delegateReadsBytes
+            && [delegate toolProcess: self didReadLineBytes: bytes length: length]) {
+        return;
+    }
+
+    line = [[NSString alloc] initWithBytes: bytes
+                                    length: length
+                                  encoding: encoding];
+    if (nil != line) {
+        [self deliverLine: line];
+        RELEASE(line);
+    }
+}
+
+- (void) deliverLine: (NSString *) line
+{
+    if (nil != delegate) {
+        [delegate toolProcess: self didReadLine: line];
+    } else {
+        [outputLines addObject: line];
+    }
+}
+
+- (void) setStatus: (int) status
+{
+    if (WIFEXITED(status)) {
+        exitedNormally = YES;
+        terminationStatus = WEXITSTATUS(status);
+    } else {
+        exitedNormally = NO;
+        terminationStatus = WIFSIGNALED(status) ? WTERMSIG(status) : -1;
+    }
+}
+
+/*
+ * Reaps the program if it has exited, without waiting for it.
+ * Returns YES if it has been reaped.
+ */
+- (BOOL) reapIfExited
+{
+    int status = 0;
+
+    [lock lock];
+    if (running) {
+        pid_t result = waitpid(pid, &status, WNOHANG);
+
+        if (result == pid) {
+            running = NO;
+            reaped = YES;
+            [self setStatus: status];
+        } else if ((result < 0) && (errno != EINTR)) {
+            // Somebody else has reaped it, its status is lost.
+            running = NO;
+            reaped = YES;
+            exitedNormally = NO;
+            terminationStatus = -1;
+        }
+    } else {
+        reaped = YES;
+    }
+    [lock unlock];
+
+    return reaped;
+}
+
+/*
+ * Kills the program if it did not exit within KILL_TIMEOUT
+ * after -cancel.
+ */
+- (void) killIfStuck
+{
+    [lock lock];
+    if (running && cancelled && !killed
+            && ([NSDate timeIntervalSinceReferenceDate] - cancelTime >= KILL_TIMEOUT)) {
+        logToConsole(MessageStatusError, [NSString stringWithFormat:
+                            @"%@ did not terminate, killing it.",
+                            launchPath]);
+        kill(pid, SIGKILL);
+        killed = YES;
+    }
+    [lock unlock];
+}
+
+/*
+ * Waits until the program has exited. We poll instead of blocking in
+ * waitpid(), so that a program which ignores -cancel is still killed
+ * after KILL_TIMEOUT, even if it has closed its output already.
+ */
+- (void) reap
+{
+    while (![self reapIfExited]) {
+        [self killIfStuck];
+        usleep(CHECK_INTERVAL * 1000);
+    }
+}
+
+@end
+
+
+@implementation ToolProcess
+
++ (ToolProcess *) processWithPath: (NSString *) path
+                        arguments: (NSArray *) args
+{
+    return AUTORELEASE([[ToolProcess alloc] initWithPath: path arguments: args]);
+}
+
+- (id) initWithPath: (NSString *) path
+          arguments: (NSArray *) args
+{
+    self = [super init];
+    if (self) {
+        ASSIGN(launchPath, path);
+        ASSIGN(arguments, args);
+        standardInput = nil;
+        standardOutput = nil;
+        delegate = nil;
+        delegateReadsBytes = NO;
+        encoding = NSISOLatin1StringEncoding;
+        outputLines = [NSMutableArray new];
+        lock = [NSLock new];
+        pid = 0;
+        outFd = -1;
+        errFd = -1;
+        running = NO;
+        reaped = NO;
+        cancelled = NO;
+        killed = NO;
+        cancelTime = 0.;
+        exitedNormally = NO;
+        terminationStatus = -1;
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    if (outFd >= 0) {
+        close(outFd);
+    }
+    if (errFd >= 0) {
+        close(errFd);
+    }
+    RELEASE(launchPath);
+    RELEASE(arguments);
+    RELEASE(standardInput);
+    RELEASE(standardOutput);
+    RELEASE(outputLines);
+    RELEASE(lock);
+    [super dealloc];
+}
+
+- (void) setDelegate: (id) aDelegate
+{
+    delegate = aDelegate;
+    delegateReadsBytes = [delegate respondsToSelector:
+                            @selector(toolProcess:didReadLineBytes:length:)];
+}
+
+- (void) setStandardInput: (id) input
+{
+    ASSIGN(standardInput, input);
+}
+
+- (void) setStandardOutput: (id) output
+{
+    ASSIGN(standardOutput, output);
+}
+
+- (void) setEncoding: (NSStringEncoding) anEncoding
+{
+    encoding = anEncoding;
+}
+
+- (NSString *) launchPath
+{
+    return launchPath;
+}
+
+- (NSArray *) arguments
+{
+    return arguments;
+}
+
+- (BOOL) launch
+{
+    posix_spawn_file_actions_t actions;
+    int outPipe[2] = {-1, -1};
+    int errPipe[2] = {-1, -1};
+    char **argv;
+    int i, count = [arguments count];
+    int rc = 0;
+    BOOL wasCancelled;
+
+    if ((pipe(errPipe) != 0)
+            || ((nil == standardOutput) && (pipe(outPipe) != 0))) {
+        logToConsole(MessageStatusError, [NSString stringWithFormat:
+                            @"Could not create pipe for %@: %s",
+                            launchPath, strerror(errno)]);
+        if (errPipe[0] >= 0) {
+            close(errPipe[0]);
+            close(errPipe[1]);
+        }
+        return NO;
+    }
+    closeOnExec(errPipe[0]);
+    closeOnExec(errPipe[1]);
+    if (outPipe[0] >= 0) {
+        closeOnExec(outPipe[0]);
+        closeOnExec(outPipe[1]);
+    }
+
+    posix_spawn_file_actions_init(&actions);
+    if (nil != standardInput) {
+        posix_spawn_file_actions_adddup2(&actions,
+                            childDescriptor(standardInput, YES), 0);
+    }
+    if (nil != standardOutput) {
+        posix_spawn_file_actions_adddup2(&actions,
+                            childDescriptor(standardOutput, NO), 1);
+    } else {
+        posix_spawn_file_actions_adddup2(&actions, outPipe[1], 1);
+    }
+    posix_spawn_file_actions_adddup2(&actions, errPipe[1], 2);
+    [self addCloseActions: &actions];
+
+    argv = malloc((count + 2) * sizeof(char *));
+    argv[0] = (char *)[launchPath fileSystemRepresentation];
+    for (i = 0; i < count; i++) {
+        argv[i + 1] = (char *)[[arguments objectAtIndex: i] UTF8String];
+    }
+    argv[count + 1] = NULL;
+
+    /*
+     * Start the program while holding the lock, so that -cancel
+     * either sees the program or prevents it from being started.
+     */
+    [lock lock];
+    wasCancelled = cancelled;
+    if (!wasCancelled) {
+        rc = posix_spawn(&pid, argv[0], &actions, NULL, argv, environ);
+        running = (rc == 0);
+    }
+    [lock unlock];
+
+    free(argv);
+    posix_spawn_file_actions_destroy(&actions);
+
+    // The child's ends of the pipes are not ours.
+    close(errPipe[1]);
+    if (outPipe[1] >= 0) {
+        close(outPipe[1]);
+    }
+    closeParentSide(standardInput, YES);
+    closeParentSide(standardOutput, NO);
+
+    if (wasCancelled || (rc != 0)) {
+        if (!wasCancelled) {
+            logToConsole(MessageStatusError, [NSString stringWithFormat:
+                                @"Could not launch %@: %s",
+                                launchPath, strerror(rc)]);
+        }
+        close(errPipe[0]);
+        if (outPipe[0] >= 0) {
+            close(outPipe[0]);
+        }
+        return NO;
+    }
+
+    errFd = errPipe[0];
+    outFd = outPipe[0];
+    return YES;
+}
+
+- (BOOL) waitUntilExit
+{
+    NSMutableData *outBuffer = [NSMutableData dataWithCapacity: READ_SIZE];
+    NSMutableData *errBuffer = [NSMutableData dataWithCapacity: READ_SIZE];
+    NSTimeInterval lastCheck = [NSDate timeIntervalSinceReferenceDate];
+    NSTimeInterval exitTime = 0.;
+
+    if (pid == 0) {
+        return NO;
+    }
+
+    while ((outFd >= 0) || (errFd >= 0)) {
+        id pool = [NSAutoreleasePool new];
+        struct pollfd fds[2];
+        NSTimeInterval now;
+        int n = 0;
+
+        if (outFd >= 0) {
+            fds[n].fd = outFd;
+            fds[n].events = POLLIN;
+            fds[n].revents = 0;
+            n++;
+        }
+        if (errFd >= 0) {
+            fds[n].fd = errFd;
+            fds[n].events = POLLIN;
+            fds[n].revents = 0;
+            n++;
+        }
+
+        if (poll(fds, n, CHECK_INTERVAL) < 0) {
+            if (errno != EINTR) {
+                RELEASE(pool);
+                break;
+            }
+            n = 0;
+        }
+
+        /*
+         * A cancelled program which ignores SIGTERM is killed. Once the
+         * program is gone, we only wait a short time for the end of its
+         * output, because a child it left behind may keep the pipes open.
+         */
+        now = [NSDate timeIntervalSinceReferenceDate];
+        if (now - lastCheck >= CHECK_INTERVAL / 1000.) {
+            lastCheck = now;
+            [self killIfStuck];
+            if ((exitTime == 0.) && [self reapIfExited]) {
+                exitTime = now;
+            }
+            if ((exitTime > 0.) && (now - exitTime >= DRAIN_TIMEOUT)) {
+                RELEASE(pool);
+                break;
+            }
+        }
+
+        while (n-- > 0) {
+            if (fds[n].revents == 0) {
+                continue;
+            }
+            if (fds[n].fd == outFd) {
+                if (![self readFrom: outFd into: outBuffer]) {
+                    [self deliverLinesFrom: outBuffer final: YES];
+                    close(outFd);
+                    outFd = -1;
+                }
+            } else {
+                if (![self readFrom: errFd into: errBuffer]) {
+                    [self deliverLinesFrom: errBuffer final: YES];
+                    close(errFd);
+                    errFd = -1;
+                }
+            }
+        }
+        RELEASE(pool);
+    }
+
+    /*
+     * Should poll() have failed or the output not have ended, do not
+     * leave the descriptors open.
+     */
+    if (outFd >= 0) {
+        [self deliverLinesFrom: outBuffer final: YES];
+        close(outFd);
+        outFd = -1;
+    }
+    if (errFd >= 0) {
+        [self deliverLinesFrom: errBuffer final: YES];
+        close(errFd);
+        errFd = -1;
+    }
+
+    [self reap];
+
+    return exitedNormally && (terminationStatus == 0) && ![self isCancelled];
+}
+
+- (BOOL) run
+{
+    if (![self launch]) {
+        return NO;
+    }
+    return [self waitUntilExit];
+}
+
+- (void) cancel
+{
+    [lock lock];
+    if (!cancelled) {
+        cancelled = YES;
+        cancelTime = [NSDate timeIntervalSinceReferenceDate];
+    }
+    if (running) {
+        kill(pid, SIGTERM);
+    }
+    [lock unlock];
+}
+
+- (BOOL) isRunning
+{
+    BOOL result;
+
+    [lock lock];
+    result = running;
+    [lock unlock];
+    return result;
+}
+
+- (BOOL) isCancelled
+{
+    BOOL result;
+
+    [lock lock];
+    result = cancelled;
+    [lock unlock];
+    return result;
+}
+
+- (BOOL) exitedNormally
+{
+    return exitedNormally;
+}
+
+- (int) terminationStatus
+{
+    return terminationStatus;
+}
+
+- (pid_t) processIdentifier
+{
+    return pid;
+}
+
+- (NSArray *) outputLines
+{
+    return outputLines;
+}
+
+@end
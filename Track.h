@@ -44,6 +44,7 @@
 
 - (id) initWithFile: (NSString *)file;
 - (id) initWithAudioFile: (NSString *)file;
+- (id) initWithAudioFile: (NSString *)file duration: (long)duration;
 - (id) initWithDataFile: (NSString *)file;
 
 - (void) dealloc;
@@ -79,6 +80,21 @@
 - (long) duration;
 - (void) setDuration: (long)duration;
 
+/*
+ * The integrated loudness in LUFS and the sample peak, measured
+ * while the track was converted. Setting them stores them in the
+ * MetadataCache, too.
+ */
+- (BOOL) hasLoudness;
+- (double) loudness;
+- (double) peak;
+- (void) setLoudness: (double)loudness peak: (double)peak;
+
+/*
+ * The ReplayGain 2.0 track gain in dB.
+ */
+- (double) replayGain;
+
 //
 // class methods
 //
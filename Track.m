@@ -27,36 +27,20 @@
 #include "Constants.h"
 #include "Functions.h"
 #include "AppController.h"
+#include "LoudnessMeter.h"
+#include "MetadataCache.h"
+#include "PCMFile.h"
+#include "Resampler.h"
 #include "Burn/ExternalTools.h"
 
 
-// recognized .au encodings (bytes per sample)
-static short auEncodings[] = {
-	0, 1, 1, 2, 3, 4, 4, 8
-};
-
 static NSString *version = @"2.0";
 
 
-//
-// AU file header, all values are big endian (Motorola byte order)
-//
-typedef struct {
-	char magicNum[4];			// .snd
-	unsigned int hdrSize;		// offset from file start to audio data
-	unsigned int dataLength;	// data length n bytes, maybe -1
-	unsigned int encoding;		// we only accept encoding 3, 16-bit PCM
-	unsigned int smplSec;		// samples per second
-	unsigned int numChannels;	// number of channels (0x01=Mono, 0x02=Stereo)
-} AuHeader;
-
-
-
 @interface Track (Private)
 
-- (BOOL) loadFromAudioFile: (NSString *)file;
-- (BOOL) loadFromWavFile: (NSString *)file;
-- (BOOL) loadFromAuFile: (NSString *)file;
+- (BOOL) loadFromAudioFile: (NSString *)file duration: (long)duration;
+- (BOOL) loadFromPCMFile: (NSString *)file;
 
 @end
 
@@ -106,6 +90,15 @@ typedef struct {
 
 
 - (id) initWithAudioFile: (NSString *)file
+{
+	return [self initWithAudioFile: file duration: -1];
+}
+
+/*
+ * A duration >= 0 has been determined beforehand for a file which is
+ * converted by a bundle. It saves us asking the bundle again.
+ */
+- (id) initWithAudioFile: (NSString *)file duration: (long)duration
 {
 	NSFileManager *fileMgr = [NSFileManager defaultManager];
 	BOOL isdir;
@@ -124,7 +117,7 @@ typedef struct {
 
 	if (self) {
 		properties = [NSMutableDictionary new];
-		if ([self loadFromAudioFile: file] == NO) {
+		if ([self loadFromAudioFile: file duration: duration] == NO) {
 			RELEASE(self);
 			return nil;
 		}
@@ -383,6 +376,38 @@ typedef struct {
 	[self setProperty: [NSNumber numberWithUnsignedLong: size] forKey: @"size"];
 }
 
+- (BOOL) hasLoudness
+{
+	return ([self propertyForKey: @"loudness"] != nil);
+}
+
+- (double) loudness
+{
+	return [[self propertyForKey: @"loudness"] doubleValue];
+}
+
+- (double) peak
+{
+	return [[self propertyForKey: @"peak"] doubleValue];
+}
+
+- (void) setLoudness: (double)loudness peak: (double)peak
+{
+	[self setProperty: [NSNumber numberWithDouble: loudness] forKey: @"loudness"];
+	[self setProperty: [NSNumber numberWithDouble: peak] forKey: @"peak"];
+
+	if (![[self type] isEqualToString: @"audio:cd"]) {
+		[[MetadataCache sharedCache] setLoudness: loudness
+											peak: peak
+										 forFile: [self source]];
+	}
+}
+
+- (double) replayGain
+{
+	return REPLAYGAIN_REFERENCE - [self loudness];
+}
+
 
 //
 // class methods
@@ -400,13 +425,11 @@ typedef struct {
  * RedBook says that audio data must be 16-bit stereo at 44100 Hz.
  * We reject all file containing something else.
  */
-- (BOOL) loadFromAudioFile: (NSString *)file;
+- (BOOL) loadFromAudioFile: (NSString *)file duration: (long)duration;
 {
 	BOOL	success = NO;
 
-	if ([self loadFromWavFile: file]) {
-		success = YES;
-	} else if ([self loadFromAuFile: file]) {
+	if ([self loadFromPCMFile: file]) {
 		success = YES;
 	} else {
 		// if the file is supposed be an audio file, but neither
@@ -414,24 +437,55 @@ typedef struct {
 		if (isAudioFile(file)) {
 			NSString *ext = [[file pathExtension] lowercaseString];
 			NSString *type = [NSString stringWithFormat: @"audio:%@", ext];
-			id<AudioConverter> converter = [[AppController appController] currentAudioConverterBundle];
+			MetadataCache *cache = [MetadataCache sharedCache];
+			NSString *cachedType;
+			unsigned size;
 
-			[self setType: type];
-			if (converter != nil) {
-                long duration = [converter duration: file];
+			/*
+			 * Asking the converter may mean scanning the whole file
+			 * or running an external program. Thus, we remember
+			 * what it told us.
+			 */
+			if ((duration < 0)
+					&& [cache getType: &cachedType duration: &duration size: &size forFile: file]) {
+				[self setType: cachedType];
 				[self setDuration: duration];
-				[self setSize: framesToAudioSize(duration)];
+				[self setSize: size];
 			} else {
-				[self setDuration: 0];
-				[self setSize: 0];
+				id<AudioConverter> converter = [[AppController appController] audioConverterBundleForType: ext];
+
+				[self setType: type];
+				if ((converter != nil) || (duration >= 0)) {
+					if (duration < 0) {
+						duration = [converter duration: file];
+					}
+					[self setDuration: duration];
+					[self setSize: framesToAudioSize(duration)];
+					if (duration > 0) {
+						[cache setType: type
+							  duration: duration
+								  size: framesToAudioSize(duration)
+							   forFile: file];
+					}
+				} else {
+					[self setDuration: 0];
+					[self setSize: 0];
+				}
 			}
 			success = YES;
 		}
 	}
 
 	if (success) {
+		double loudness, peak;
+
 		[self setSource: file];
 
+		if ([[MetadataCache sharedCache] getLoudness: &loudness peak: &peak forFile: file]) {
+			[self setProperty: [NSNumber numberWithDouble: loudness] forKey: @"loudness"];
+			[self setProperty: [NSNumber numberWithDouble: peak] forKey: @"peak"];
+		}
+
 		if ([self propertyForKey: @"description"] == nil) {
 			[self setDescription: [file lastPathComponent]];
 		}
@@ -440,124 +494,44 @@ typedef struct {
 	return success;
 }
 
-- (BOOL) loadFromWavFile: (NSString *)file
+/*
+ * WAV and AU files holding CD audio are passed to the burning
+ * programs as they are. Other uncompressed files are of type
+ * audio:pcm and are converted by the PCMToWav bundle, which reads
+ * them in process and resamples them to 44100 Hz if necessary. For
+ * anything else we return NO, so that the file is handed to the
+ * audio converters like compressed files.
+ */
+- (BOOL) loadFromPCMFile: (NSString *)file
 {
-	BOOL success = NO;
-	NSFileHandle *fileHdl;
-	NSData *rawData;
-	char buffer[17];
-	unsigned int fmtLength = 0;
-	unsigned int dataLength = 0;
-	unsigned int byteSec = 0;
-	unsigned int sampleRate = 0;
-	unsigned short byteSample = 0;
-
-	memset(buffer, 0, sizeof(buffer));
-
-	/*
-	 * Read the potential .wav header data from the file.
-	 */
-	fileHdl = [NSFileHandle fileHandleForReadingAtPath: file];
-	rawData = [fileHdl readDataOfLength: 64];
-	[fileHdl closeFile];
-
-	[rawData getBytes: buffer length: 16];
-
-	if ((strncmp(buffer, "RIFF", 4) == 0)
-		   && (strncmp(buffer+8, "WAVE", 4) == 0))	{
-
-		// format length field is at position 16
-		[rawData getBytes: &fmtLength range: NSMakeRange(16, 4)];
-		fmtLength = GSSwapLittleI32ToHost(fmtLength);
-		// sample rate field is at position 24
-		[rawData getBytes: &sampleRate range: NSMakeRange(24, 4)];
-		sampleRate = GSSwapLittleI32ToHost(sampleRate);
-		// bytes per sec field is at position 28
-		[rawData getBytes: &byteSec range: NSMakeRange(28, 4)];
-		byteSec = GSSwapLittleI32ToHost(byteSec);
-		// bytes per sample field is at position 32
-		[rawData getBytes: &byteSample range: NSMakeRange(32, 2)];
-		byteSample = GSSwapLittleI16ToHost(byteSample);
-		// data length field is at position 24 + format data length
-		// 24: RIFF header (12) + fmt header (8) + data header (4)
-		[rawData getBytes: &dataLength range: NSMakeRange(24+fmtLength, 4)];
-		dataLength = GSSwapLittleI32ToHost(dataLength);
-
-		/* check sample rate and sample size */
-		if (sampleRate == 44100
-			&& byteSample == 4) {
+	PCMFile *pcm;
+	NSString *type;
 
-			success = YES;
-
-			// set the duration in frames
-			[self setDuration: (double)dataLength * 75. /
-							   (double)byteSec];
+	pcm = AUTORELEASE([[PCMFile alloc] initWithPath: file]);
+	if (nil == pcm) {
+		return NO;
+	}
 
-			[self setType: @"audio:wav"];
-			[self setSize: dataLength];
-		} else {
+	if ([pcm isBurnable]) {
+		type = ([pcm container] == PCMContainerAU) ? @"audio:au" : @"audio:wav";
+	} else if ([pcm canRead] && (([pcm sampleRate] == RESAMPLE_OUTPUT_RATE)
+					|| [Resampler canResampleFrom: [pcm sampleRate]])) {
+		type = @"audio:pcm";
+	} else {
+		if (nil == [[AppController appController]
+						audioConverterBundleForType: [[file pathExtension] lowercaseString]]) {
 			logToConsole(MessageStatusError, [NSString stringWithFormat:
 							_(@"Track.no16BitStereo"), file]);
 		}
+		return NO;
 	}
-	return success;
-}
 
+	[self setType: type];
+	[self setDuration: [pcm duration]];
+	[self setSize: (unsigned)(([pcm frames] * RESAMPLE_OUTPUT_RATE + [pcm sampleRate] - 1)
+								/ [pcm sampleRate] * 4)];
 
-- (BOOL) loadFromAuFile: (NSString *)file
-{
-	BOOL success = NO;
-	AuHeader  auHdr;
-	NSFileHandle *fileHdl;
-	NSData *rawData;
-	NSFileManager *fileMgr = [NSFileManager defaultManager];
-
-	memset(&auHdr, 0, sizeof(AuHeader));
-
-	/*
-	 * Read the potential .au header data from the file.
-	 */
-	fileHdl = [NSFileHandle fileHandleForReadingAtPath: file];
-	rawData = [fileHdl readDataOfLength: sizeof(AuHeader)];
-	[fileHdl closeFile];
-
-	[rawData getBytes: &auHdr length: sizeof(AuHeader)];
-	if (auHdr.magicNum[0] == '.'
-			&& auHdr.magicNum[1] == 's'
-			&& auHdr.magicNum[2] == 'n'
-			&& auHdr.magicNum[3] == 'd') {
-
-		/* check sample rate and sample size */
-		if (GSSwapBigI32ToHost(auHdr.smplSec) == 44100
-				&& auEncodings[GSSwapBigI32ToHost(auHdr.encoding)] == 2
-				&& GSSwapBigI32ToHost(auHdr.numChannels) == 2) {
-
-			success = YES;
-
-			/*
-			 * The field dataLangth maybe -1. In this case we must calculate
-			 * the size of the audio part without theheader.
-			 */
-			if (auHdr.dataLength == 0xffffffff) {
-				auHdr.dataLength = [[fileMgr fileAttributesAtPath: file
-													 traverseLink: YES] fileSize] -
-										GSSwapBigI32ToHost(auHdr.hdrSize);
-			}
-
-			// swap dataLength to host endianness
-			auHdr.dataLength = GSSwapBigI32ToHost(auHdr.dataLength);
-
-			// set the duration in frames
-			[self setDuration: auHdr.dataLength * 75. / (44100.*2.*2.)];
-
-			[self setType: @"audio:au"];
-			[self setSize: auHdr.dataLength];
-		} else {
-			logToConsole(MessageStatusError, [NSString stringWithFormat:
-							_(@"Track.no16BitStereo"), file]);
-		}
-	}
-	return success;
+	return YES;
 }
 
 @end
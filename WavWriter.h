@@ -0,0 +1,114 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  WavWriter.h
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef WAVWRITER_H_INC
+#define WAVWRITER_H_INC
+
+#include <sys/types.h>
+
+#include <Foundation/Foundation.h>
+
+@class LoudnessMeter;
+
+/* The size of the output buffer */
+#define WAV_BUFFER_SIZE (1024*1024)
+
+/* The size of the RIFF header */
+#define WAV_HEADER_SIZE 44
+
+/**
+ * <p>WavWriter writes 16 bit PCM data to a WAV file. The data is
+ * collected in a large buffer, so that there are only few write()
+ * calls. Space for the expected amount of data is reserved in advance
+ * to keep the file in one piece. The RIFF header is written when the
+ * file is closed and the size of the data is known.</p>
+ * <p>The samples may be passed through a LoudnessMeter and multiplied
+ * with a gain while they are appended.</p>
+ */
+@interface WavWriter : NSObject
+{
+    int fd;
+    NSString *path;
+    unsigned sampleRate;
+    unsigned channels;
+
+    unsigned char *buffer;
+    unsigned fill;
+    unsigned long long dataSize;
+    unsigned long long written;
+    BOOL failed;
+
+    LoudnessMeter *meter;
+    float gain;
+}
+
+/**
+ * <p>Creates the file at <var>aPath</var>. <var>frames</var> is the
+ * expected number of sample frames, or 0 if it is not known.
+ * Returns nil if the file could not be created.</p>
+ */
+- (id) initWithPath: (NSString *) aPath
+         sampleRate: (unsigned) rate
+           channels: (unsigned) numChannels
+     expectedFrames: (unsigned long) frames;
+
+/**
+ * <p>Returns room for <var>length</var> bytes of samples in native
+ * byte order, at most WAV_BUFFER_SIZE - WAV_HEADER_SIZE. The caller
+ * fills it and calls -appendedBytes: with the number of bytes it
+ * used. Returns NULL if writing the file has failed.</p>
+ */
+- (unsigned char *) bytesForAppending: (unsigned) length;
+- (void) appendedBytes: (unsigned) length;
+
+/**
+ * <p>Makes <var>aMeter</var> measure the samples appended from now on,
+ * before the gain is applied. Only for 16 bit stereo files.</p>
+ */
+- (void) setLoudnessMeter: (LoudnessMeter *) aMeter;
+- (LoudnessMeter *) loudnessMeter;
+
+/**
+ * <p>Multiplies the samples appended from now on with
+ * <var>aGain</var>. The results are rounded and clipped.</p>
+ */
+- (void) setGain: (float) aGain;
+
+/**
+ * <p>Multiplies the samples appended so far with <var>aGain</var>.
+ * The samples which have been written to the file already are read
+ * back for this. Returns NO if this fails.</p>
+ */
+- (BOOL) applyGainToWrittenSamples: (float) aGain;
+
+/**
+ * <p>Writes the remaining data and the header and closes the file.
+ * Returns NO if any of the data could not be written.</p>
+ */
+- (BOOL) close;
+
+- (NSString *) path;
+
+@end
+
+#endif
@@ -0,0 +1,369 @@
+/* vim: set ft=objc ts=4 et sw=4 nowrap: */
+/*
+ *  WavWriter.m
+ *
+ *  Copyright (c) 2026
+ *
+ *  Author: Andreas Schik <andreas@schik.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     /* for fallocate() */
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "WavWriter.h"
+#include "LoudnessMeter.h"
+
+
+static void putLE16(unsigned char *p, unsigned value)
+{
+    p[0] = value & 0xff;
+    p[1] = (value >> 8) & 0xff;
+}
+
+static void putLE32(unsigned char *p, unsigned long value)
+{
+    p[0] = value & 0xff;
+    p[1] = (value >> 8) & 0xff;
+    p[2] = (value >> 16) & 0xff;
+    p[3] = (value >> 24) & 0xff;
+}
+
+/*
+ * Writes all of the data, even if write() is interrupted or
+ * writes only part of it.
+ */
+static BOOL writeAll(int fd, const unsigned char *data, size_t length)
+{
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return NO;
+        }
+        data += n;
+        length -= n;
+    }
+    return YES;
+}
+
+/*
+ * The same for pwrite(), which leaves the file offset alone.
+ */
+static BOOL writeAllAt(int fd, const unsigned char *data, size_t length, off_t offset)
+{
+    while (length > 0) {
+        ssize_t n = pwrite(fd, data, length, offset);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return NO;
+        }
+        data += n;
+        length -= n;
+        offset += n;
+    }
+    return YES;
+}
+
+#ifdef WORDS_BIGENDIAN
+static void swapBytes(unsigned char *data, size_t length)
+{
+    size_t i;
+
+    for (i = 0; i + 1 < length; i += 2) {
+        unsigned char c = data[i];
+        data[i] = data[i+1];
+        data[i+1] = c;
+    }
+}
+#endif
+
+static void scaleSamples(int16_t *samples, size_t count, float gain)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        float value = samples[i] * gain;
+
+        if (value >= 32767.f)
+            samples[i] = 32767;
+        else if (value <= -32768.f)
+            samples[i] = -32768;
+        else
+            samples[i] = (int16_t)lrintf(value);
+    }
+}
+
+
+@interface WavWriter (Private)
+- (BOOL) flush;
+@end
+
+@implementation WavWriter (Private)
+
+- (BOOL) flush
+{
+    if (failed)
+        return NO;
+    if (fill == 0)
+        return YES;
+
+#ifdef WORDS_BIGENDIAN
+    {
+        /* WAV data is little endian. The header is written later. */
+        unsigned start = (written == 0) ? WAV_HEADER_SIZE : 0;
+        swapBytes(buffer + start, fill - start);
+    }
+#endif
+
+    if (!writeAll(fd, buffer, fill)) {
+        failed = YES;
+        return NO;
+    }
+    written += fill;
+    fill = 0;
+    return YES;
+}
+
+@end
+
+
+@implementation WavWriter
+
+- (id) initWithPath: (NSString *) aPath
+         sampleRate: (unsigned) rate
+           channels: (unsigned) numChannels
+     expectedFrames: (unsigned long) frames
+{
+    self = [super init];
+    if (self != nil) {
+        buffer = NULL;
+        /*
+         * The file is opened for reading, too, for
+         * -applyGainToWrittenSamples:.
+         */
+        fd = open([aPath fileSystemRepresentation], O_RDWR|O_CREAT|O_TRUNC, 0644);
+        if (fd < 0) {
+            RELEASE(self);
+            return nil;
+        }
+
+        /*
+         * The buffer is page aligned, so that the kernel can
+         * copy it efficiently.
+         */
+        if (posix_memalign((void **)&buffer, 4096, WAV_BUFFER_SIZE) != 0) {
+            buffer = NULL;
+            RELEASE(self);
+            return nil;
+        }
+
+#ifdef FALLOC_FL_KEEP_SIZE
+        /*
+         * Reserve the space without changing the file's size. If the
+         * estimate is too large, the rest is released when the file
+         * is closed. Not all file systems support this, which is fine.
+         */
+        if (frames > 0) {
+            fallocate(fd, FALLOC_FL_KEEP_SIZE, 0,
+                      WAV_HEADER_SIZE + (off_t)frames * numChannels * 2);
+        }
+#endif
+
+        ASSIGN(path, aPath);
+        sampleRate = rate;
+        channels = numChannels;
+        dataSize = 0;
+        written = 0;
+        failed = NO;
+        meter = nil;
+        gain = 1.f;
+
+        /* Leave room for the header, which we do not know, yet. */
+        memset(buffer, 0, WAV_HEADER_SIZE);
+        fill = WAV_HEADER_SIZE;
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    if (fd >= 0)
+        close(fd);
+    free(buffer);
+    RELEASE(path);
+    RELEASE(meter);
+    [super dealloc];
+}
+
+- (NSString *) path
+{
+    return path;
+}
+
+- (unsigned char *) bytesForAppending: (unsigned) length
+{
+    if (fill + length > WAV_BUFFER_SIZE) {
+        if (![self flush])
+            return NULL;
+    }
+    if (failed || (fill + length > WAV_BUFFER_SIZE))
+        return NULL;
+    return buffer + fill;
+}
+
+- (void) appendedBytes: (unsigned) length
+{
+    int16_t *samples = (int16_t *)(buffer + fill);
+
+    if (nil != meter) {
+        [meter addSamples: samples frames: length / 4];
+    }
+    if (gain != 1.f) {
+        scaleSamples(samples, length / 2, gain);
+    }
+    fill += length;
+    dataSize += length;
+}
+
+- (void) setLoudnessMeter: (LoudnessMeter *) aMeter
+{
+    ASSIGN(meter, aMeter);
+}
+
+- (LoudnessMeter *) loudnessMeter
+{
+    return meter;
+}
+
+- (void) setGain: (float) aGain
+{
+    gain = aGain;
+}
+
+- (BOOL) applyGainToWrittenSamples: (float) aGain
+{
+    off_t pos = WAV_HEADER_SIZE;
+
+    if (aGain == 1.f)
+        return !failed;
+
+    /*
+     * Everything goes to the file first, so that the buffer is free
+     * to read the samples back into. They are most likely still in
+     * the page cache.
+     */
+    if ((fd < 0) || ![self flush])
+        return NO;
+
+    while (pos < (off_t)written) {
+        size_t length = WAV_BUFFER_SIZE;
+        ssize_t n;
+
+        if ((off_t)written - pos < (off_t)length)
+            length = (off_t)written - pos;
+        n = pread(fd, buffer, length, pos);
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            failed = YES;
+            return NO;
+        }
+        n &= ~1;
+        if (n == 0) {
+            failed = YES;
+            return NO;
+        }
+
+#ifdef WORDS_BIGENDIAN
+        swapBytes(buffer, n);
+        scaleSamples((int16_t *)buffer, n / 2, aGain);
+        swapBytes(buffer, n);
+#else
+        scaleSamples((int16_t *)buffer, n / 2, aGain);
+#endif
+        if (!writeAllAt(fd, buffer, n, pos)) {
+            failed = YES;
+            return NO;
+        }
+        pos += n;
+    }
+    return YES;
+}
+
+- (BOOL) close
+{
+    unsigned char header[WAV_HEADER_SIZE];
+    unsigned long size = (unsigned long)dataSize;
+    off_t end;
+
+    if (fd < 0)
+        return !failed;
+
+    [self flush];
+
+    /*
+     * The sizes in the header are 32 bit values.
+     */
+    if (dataSize > 0xffffffffULL - WAV_HEADER_SIZE)
+        failed = YES;
+
+    memcpy(header, "RIFF", 4);
+    putLE32(header + 4, size + WAV_HEADER_SIZE - 8);
+    memcpy(header + 8, "WAVE", 4);
+    memcpy(header + 12, "fmt ", 4);
+    putLE32(header + 16, 16);
+    putLE16(header + 20, 1);                /* PCM */
+    putLE16(header + 22, channels);
+    putLE32(header + 24, sampleRate);
+    putLE32(header + 28, sampleRate * channels * 2);
+    putLE16(header + 32, channels * 2);
+    putLE16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    putLE32(header + 40, size);
+
+    if (!failed) {
+        if ((lseek(fd, 0, SEEK_SET) < 0) || !writeAll(fd, header, WAV_HEADER_SIZE))
+            failed = YES;
+    }
+
+    /* Give back the space we reserved too much. */
+    end = WAV_HEADER_SIZE + (off_t)dataSize;
+    if (!failed && (ftruncate(fd, end) < 0))
+        failed = YES;
+
+    if (close(fd) < 0)
+        failed = YES;
+    fd = -1;
+
+    return !failed;
+}
+
+@end
@@ -3,6 +3,8 @@
 #include <AppKit/NSHelpManager.h>
 #include "AppController.h"
 #include "ProjectWindowController.h"
+#include "Functions.h"
+#include "LogBus.h"
 
 @interface BurnApplication : NSApplication
 {
@@ -47,6 +49,9 @@ int main(int argc, const char *argv[])
   
     [BurnApplication sharedApplication];
 
+    // open the console with the first message
+    setLogBusListener(openSharedConsole);
+
     controller = [AppController appController];
     [NSApp setDelegate:controller];
 